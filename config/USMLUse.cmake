@@ -93,12 +93,14 @@ if( MSVC )
         system
         chrono
 	    regex
+        iostreams	# for memory mapped wavefront_cache files
     )
 else ( MSVC )
     find_package( Boost 1.41 REQUIRED COMPONENTS
         unit_test_framework	# for usml_test.exe
         thread
         system
+        iostreams	# for memory mapped wavefront_cache files
     )
 endif ( MSVC )
 
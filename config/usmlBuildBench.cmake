@@ -0,0 +1,20 @@
+######################################################################
+# USML_BENCH benchmark suite
+#
+# Collects usml_bench.cc and the benchmarks in the bench sub-directory of
+# each module into the usml_bench target.  Each benchmark uses a synthetic
+# environment, so this target does not need any of the USML data files.
+
+    unset( HEADERS )
+    file( GLOB SOURCES usml_bench.h usml_bench.cc )
+    source_group( main FILES ${SOURCES} )
+    FIND_SOURCES( "${PACKAGE_MODULES}" "/bench" )
+
+    add_executable( usml_bench ${HEADERS} ${SOURCES} )
+    target_link_libraries( usml_bench usml )
+    set_property(
+       TARGET usml_bench
+       PROPERTY COMPILE_DEFINITIONS
+        USML_VERSION="${PACKAGE_VERSION}"
+        USML_BUILD_TYPE="${CMAKE_BUILD_TYPE}"
+   )
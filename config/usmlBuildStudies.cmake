@@ -9,6 +9,9 @@
     
     add_executable( ray_speed studies/ray_speed/ray_speed.cc )
     target_link_libraries( ray_speed usml )
+
+    add_executable( update_speed studies/update_speed/update_speed.cc )
+    target_link_libraries( update_speed usml )
     
     add_executable( eigenray_extra_test studies/eigenray_extra/eigenray_extra_test.cc )
     target_link_libraries( eigenray_extra_test usml )
@@ -35,7 +38,7 @@
     target_link_libraries( simple_wedge usml )
     
     set_property(
-        TARGET cmp_speed ray_speed eigenray_extra_test pedersen_test 
+        TARGET cmp_speed ray_speed update_speed eigenray_extra_test pedersen_test 
         malta_movie malta_rays reverb_extra_test reverb_analytic_test dead_reckon_test simple_wedge
         PROPERTY COMPILE_DEFINITIONS
         USML_DATA_DIR="${USML_DATA_DIR}"
@@ -0,0 +1,172 @@
+/**
+ * @file eigenverb_bench.cc
+ * Benchmarks for the eigenverb rtree and the envelope_generator.
+ *
+ * Uses synthetic bottom eigenverbs, scattered randomly over an area
+ * about 11 km on each side, with lengths and widths from 500 to 1000
+ * meters, so that each receiver eigenverb overlaps with a few percent of
+ * the source eigenverbs.  The ocean has a flat 200 meter bottom with
+ * Lambert scattering, so the results do not depend on any external data.
+ */
+#include <usml/usml_bench.h>
+#include <usml/eigenverb/envelope_generator.h>
+#include <usml/ocean/ocean.h>
+#include <usml/sensors/sensor_model.h>
+#include <usml/sensors/sensor_pair.h>
+#include <usml/sensors/source_params_map.h>
+#include <usml/sensors/receiver_params_map.h>
+#include <usml/threads/thread_controller.h>
+#include <usml/ublas/randgen.h>
+
+using namespace usml::bench ;
+using namespace usml::eigenverb ;
+using namespace usml::ocean ;
+using namespace usml::sensors ;
+using usml::ublas::randgen ;
+
+namespace {
+
+/** Number of receiver azimuths in the reverberation envelopes. */
+const size_t num_azimuths = 16 ;
+
+/** Parameters ID for the synthetic monostatic sensor. */
+const sensor_params::id_type bench_params = 9001 ;
+
+/**
+ * Builds a collection of synthetic bottom eigenverbs.
+ *
+ * @param   num_verbs   Number of eigenverbs to create.
+ * @param   freq        Frequencies of the eigenverb powers.
+ * @return              Collection of eigenverbs, without rtrees.
+ */
+eigenverb_collection::reference build_eigenverbs( size_t num_verbs,
+    const seq_vector* freq )
+{
+    eigenverb_collection::reference collection( new eigenverb_collection(0) ) ;
+    eigenverb verb ;
+    verb.frequencies = freq ;
+    verb.power = vector<double>( freq->size(), 1e-6 ) ;
+    verb.sound_speed = 1500.0 ;
+    verb.surface = verb.bottom = verb.caustic = verb.upper = verb.lower = 0 ;
+    for ( size_t n=0 ; n < num_verbs ; ++n ) {
+        verb.time = 0.5 + 6.0 * randgen::uniform() ;
+        verb.length = 500.0 + 500.0 * randgen::uniform() ;
+        verb.width = 500.0 + 500.0 * randgen::uniform() ;
+        verb.length2 = verb.length * verb.length ;
+        verb.width2 = verb.width * verb.width ;
+        verb.position = wposition1(
+            36.0 + 0.1 * randgen::uniform() - 0.05,
+            16.0 + 0.1 * randgen::uniform() - 0.05, -200.0 ) ;
+        verb.direction = M_PI * ( 2.0 * randgen::uniform() - 1.0 ) ;
+        verb.grazing = 0.1 + 0.9 * randgen::uniform() ;
+        verb.de_index = n / num_azimuths ;
+        verb.az_index = n % num_azimuths ;
+        verb.source_de = -verb.grazing ;
+        verb.source_az = verb.direction ;
+        collection->add_eigenverb( verb, eigenverb::BOTTOM ) ;
+    }
+    return collection ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Time to build the rtrees for a collection of eigenverbs, as a function
+ * of the number of eigenverbs.  The time to fill the collection is not
+ * included.
+ */
+static const size_t rtree_sizes[] = { 1000, 10000, 100000 } ;
+USML_BENCH_ARGS( eigenverb_rtree_build, "num_verbs", rtree_sizes ) {
+    seq_linear freq( 3000.0, 1.0, 1 ) ;
+    eigenverb_collection::reference verbs ;
+    while ( state.keep_running() ) {
+        state.pause_timing() ;
+        randgen::seed( 0 ) ;
+        verbs = build_eigenverbs( state.arg(), &freq ) ;
+        state.resume_timing() ;
+        verbs->generate_rtrees() ;
+    }
+    state.items_processed( state.arg() ) ;
+}
+
+/**
+ * Time to query the rtrees once for every eigenverb in the collection,
+ * as a function of the number of eigenverbs.
+ */
+USML_BENCH_ARGS( eigenverb_rtree_query, "num_verbs", rtree_sizes ) {
+    seq_linear freq( 3000.0, 1.0, 1 ) ;
+    eigenverb_collection::reference verbs =
+        build_eigenverbs( state.arg(), &freq ) ;
+    verbs->generate_rtrees() ;
+    const eigenverb_list& list = verbs->eigenverbs( eigenverb::BOTTOM ) ;
+    std::vector<value_pair> result ;
+    size_t found = 0 ;
+    while ( state.keep_running() ) {
+        found = 0 ;
+        for ( eigenverb_list::const_iterator iter = list.begin() ;
+              iter != list.end() ; ++iter )
+        {
+            result.clear() ;
+            verbs->query_rtree( eigenverb::BOTTOM, *iter, result ) ;
+            found += result.size() ;
+        }
+    }
+    state.items_processed( state.arg() ) ;
+    state.counter( "mean_matches", (double) found / state.arg() ) ;
+}
+
+/**
+ * Time for envelope_generator::run() on a monostatic sensor, as a
+ * function of the number of eigenverbs.  Uses the thread_controller
+ * pool to process the receiver azimuths in parallel.  The time to
+ * construct the generator, and its envelope_collection, is not included.
+ */
+static const size_t envelope_sizes[] = { 250, 1000, 4000 } ;
+USML_BENCH_ARGS( envelope_generator_run, "num_verbs", envelope_sizes ) {
+
+    // ocean with Lambert scattering from a flat bottom
+
+    boundary_model* bottom = new boundary_flat( 200.0 ) ;
+    bottom->scattering( new scattering_lambert() ) ;
+    ocean_shared::reference ocean( new ocean_model(
+        new boundary_flat(), bottom, new profile_linear(1500.0) ) ) ;
+    ocean_shared::update( ocean ) ;
+
+    // omni-directional monostatic sensor
+
+    seq_linear freq( 3000.0, 1.0, 1 ) ;
+    std::list<beam_pattern_model::id_type> beam_list ;
+    beam_list.push_back( 0 ) ;      // omni
+    source_params::reference source( new source_params( bench_params,
+        vector<double>( 1, 200.0 ), 0.250, 7.0, 3000.0, 3000.0,
+        freq, beam_list, false ) ) ;
+    source_params_map::instance()->insert( bench_params, source ) ;
+    receiver_params::reference receiver( new receiver_params( bench_params,
+        3000.0, 3000.0, freq, beam_list, false ) ) ;
+    receiver_params_map::instance()->insert( bench_params, receiver ) ;
+
+    sensor_model sensor( bench_params, bench_params ) ;
+    const sensor_model& info = sensor ;
+    eigenray_collection::reference eigenrays ;
+    eigenverb_collection::reference verbs =
+        build_eigenverbs( state.arg(), info.frequencies() ) ;
+    sensor.update_wavefront_data( eigenrays, verbs ) ;
+    sensor_pair pair( &sensor, &sensor ) ;
+
+    thread_task::reference generator ;
+    while ( state.keep_running() ) {
+        state.pause_timing() ;
+        generator.reset( new envelope_generator(
+            &pair, 0.0, 0, num_azimuths ) ) ;
+        state.resume_timing() ;
+        generator->run() ;
+    }
+    generator.reset() ;
+    state.items_processed( state.arg() ) ;
+    state.counter( "num_azimuths", num_azimuths ) ;
+    state.counter( "num_threads", thread_controller::instance()->num_threads() ) ;
+
+    source_params_map::instance()->erase( bench_params ) ;
+    receiver_params_map::instance()->erase( bench_params ) ;
+    ocean_shared::reset() ;
+}
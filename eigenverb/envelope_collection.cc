@@ -4,15 +4,14 @@
  * receiver azimuth, source beam number, receiver beam number.
  */
 #include <usml/eigenverb/envelope_collection.h>
-#include <boost/numeric/ublas/matrix_proxy.hpp>
 #include <boost/foreach.hpp>
 #include <netcdfcpp.h>
 
 using namespace usml::eigenverb;
 
 /**
- * Reserve memory in which to store results as a series of
- * nested dynamic arrays.
+ * Reserve memory in which to store results as a single,
+ * contiguous buffer.
  */
 envelope_collection::envelope_collection(
 	const seq_vector* envelope_freq,
@@ -44,49 +43,60 @@ envelope_collection::envelope_collection(
 	_source_position(src_position),
 	_receiver_position(rcv_position),
 	_envelope_model( _envelope_freq, src_freq_first, _travel_time,
-	                        _initial_time, _pulse_length, _threshold)
+	                        _initial_time, _pulse_length, _threshold),
+	_time_stride( ( _travel_time->size() + 3 ) & ~(size_t) 3 ),
+	_envelopes( _num_azimuths * _num_src_beams * _num_rcv_beams
+	            * _envelope_freq->size() * _time_stride, 0.0 )
 {
     // Store range from source to receiver when eigenverbs were obtained.
     _slant_range = _receiver_position.distance(_source_position);
-
-	_envelopes = new matrix<double>***[_num_azimuths];
-	matrix<double>**** pa = _envelopes;
-	for (size_t a = 0; a < _num_azimuths; ++a, ++pa) {
-		*pa = new matrix<double>**[_num_src_beams];
-		matrix<double>*** ps = *pa;
-		for (size_t s = 0; s < _num_src_beams; ++s, ++ps) {
-			*ps = new matrix<double>*[_num_rcv_beams];
-			matrix<double>** pr = *ps;
-			for (size_t r = 0; r < _num_rcv_beams; ++r, ++pr) {
-				*pr = new matrix< double >(
-						_envelope_freq->size(), _travel_time->size() ) ;
-				(*pr)->clear();
-			}
-		}
-	}
 }
 
 /**
- * Delete dynamic memory in each of the nested dynamic arrays.
+ * Delete dynamic memory for the axes.
  */
 envelope_collection::~envelope_collection() {
-	matrix<double>**** pa = _envelopes;
-	for (size_t a = 0; a < _num_azimuths; ++a, ++pa) {
-		matrix<double>*** ps = *pa;
-		for (size_t s = 0; s < _num_src_beams; ++s, ++ps) {
-			matrix<double>** pr = *ps;
-			for (size_t r = 0; r < _num_rcv_beams; ++r, ++pr) {
-				delete *pr ;
-			}
-			delete[] *ps ;
-		}
-		delete[] *pa ;
+	BOOST_FOREACH( envelope_model* model, _workspaces ) {
+		delete model ;
 	}
-	delete[] _envelopes ;
 	delete _envelope_freq ;
 	delete _travel_time ;
 }
 
+/**
+ * Intensity time series for one combination of parameters.
+ */
+matrix< double > envelope_collection::envelope(
+	size_t azimuth, size_t src_beam, size_t rcv_beam ) const
+{
+	const size_t num_freq = _envelope_freq->size() ;
+	const size_t num_time = _travel_time->size() ;
+	matrix< double > result( num_freq, num_time ) ;
+	read_lock_guard guard(_envelopes_mutex);
+	const double* envelope = &_envelopes[ offset(azimuth,src_beam,rcv_beam) ] ;
+	for ( size_t f=0 ; f < num_freq ; ++f, envelope += _time_stride ) {
+		std::copy( envelope, envelope + num_time, &result(f,0) ) ;
+	}
+	return result ;
+}
+
+/**
+ * Sets the intensity time series for one combination of parameters.
+ */
+void envelope_collection::envelope( const matrix< double >& intensities,
+	size_t azimuth, size_t src_beam, size_t rcv_beam )
+{
+	const size_t num_freq = _envelope_freq->size() ;
+	const size_t num_time = _travel_time->size() ;
+	write_lock_guard guard(_envelopes_mutex);
+	double* envelope = &_envelopes[ offset(azimuth,src_beam,rcv_beam) ] ;
+	for ( size_t f=0 ; f < num_freq ; ++f, envelope += _time_stride ) {
+		for ( size_t t=0 ; t < num_time ; ++t ) {
+			envelope[t] = intensities(f,t) ;
+		}
+	}
+}
+
 /**
  * Adds the intensity contribution for a single combination of source
  * and receiver eigenverbs.
@@ -94,23 +104,47 @@ envelope_collection::~envelope_collection() {
 void envelope_collection::add_contribution(
 	const eigenverb& src_verb, const eigenverb& rcv_verb,
 	const matrix<double>& src_beam, const matrix<double>& rcv_beam,
-	const vector<double>& scatter, double xs2, double ys2 )
+	const vector<double>& scatter, double xs2, double ys2,
+	size_t workspace )
 {
 	size_t azimuth = rcv_verb.az_index ;
-	bool ok = _envelope_model.compute_intensity(src_verb,rcv_verb,scatter,xs2,ys2) ;
+	envelope_model& model = ( workspace == 0 ) ?
+		_envelope_model : *_workspaces[workspace-1] ;
+	bool ok = model.compute_intensity(src_verb,rcv_verb,scatter,xs2,ys2) ;
 	if ( ok ) {
-		for ( size_t s=0 ; s < src_beam.size2() ; ++s ) {
-			for ( size_t r=0 ; r < rcv_beam.size2() ; ++r ) {
-				for ( size_t f=0 ; f < _envelope_freq->size() ; ++f ) {
-					matrix_row< matrix<double> > intensity(_envelope_model.intensity(), f);
-					matrix_row< matrix<double> > envelope(*_envelopes[azimuth][s][r], f);
-					envelope += src_beam(f, s) * rcv_beam(f, r) * intensity;
+		const size_t num_freq = _envelope_freq->size() ;
+		const size_t beam_stride = num_freq * _time_stride ;
+		const size_t first = model.window_first() ;
+		const size_t last = model.window_last() ;
+		for ( size_t f=0 ; f < num_freq ; ++f ) {
+			const double* intensity = &model.intensity()(f,0) ;
+			double* envelope = &_envelopes[ offset(azimuth,0,0)
+				+ f * _time_stride ] ;
+			for ( size_t s=0 ; s < src_beam.size2() ; ++s ) {
+				for ( size_t r=0 ; r < rcv_beam.size2() ;
+				      ++r, envelope += beam_stride )
+				{
+					const double gain = src_beam(f, s) * rcv_beam(f, r) ;
+					for ( size_t t=first ; t < last ; ++t ) {
+						envelope[t] += gain * intensity[t] ;
+					}
 				}
 			}
 		}
 	}
 }
 
+/**
+ * Reserves workspaces for adding contributions in parallel.
+ */
+void envelope_collection::num_workspaces( size_t count ) {
+	while ( num_workspaces() < count ) {
+		_workspaces.push_back( new envelope_model( _envelope_freq,
+			_envelope_model.src_freq_first(), _travel_time,
+			_initial_time, _pulse_length, _threshold ) ) ;
+	}
+}
+
 /**
  * Updates the envelope_collection data with the parameters provided.
  */
@@ -120,32 +154,20 @@ void envelope_collection::dead_reckon(double delta_time,
     _slant_range = slant_range;
 
     // Shift the time series
-    delete _travel_time;
     boost::numeric::ublas::vector<double> temp_data = (*_travel_time);
     temp_data = temp_data + delta_time;
+    delete _travel_time;
     _travel_time = new seq_data( temp_data );
 
     { // Scope for lock
 
-        // Perform copy and intensity update
+        // Perform intensity update
         double gain = slant_range/prev_range;
         gain *= gain ;
 
         write_lock_guard guard(this->_envelopes_mutex);
-        // Copy "this" envelopes to new_collection
-        matrix<double>**** pa = _envelopes;
-        for (size_t a = 0; a < _num_azimuths; ++a, ++pa)
-        {
-            matrix<double>*** ps = *pa;
-            for (size_t s = 0; s < _num_src_beams; ++s, ++ps)
-            {
-                matrix<double>** pr = *ps;
-                for (size_t r = 0; r < _num_rcv_beams; ++r, ++pr)
-                {
-                    (**pr) = this->envelope(a, s, r);
-                    (**pr) *= gain;
-                }
-            }
+        for ( size_t n=0 ; n < _envelopes.size() ; ++n ) {
+            _envelopes[n] *= gain ;
         }
     }
 }
@@ -191,15 +213,19 @@ void envelope_collection::write_netcdf(const char* filename) const {
 	freq_var->put( _envelope_freq->data().begin(), (long) _envelope_freq->size());
 	time_var->put( _travel_time->data().begin(), (long) _travel_time->size());
 
+	const size_t num_time = _travel_time->size() ;
+	std::vector<double> envelope( num_time ) ;
 	for (size_t a = 0; a < _num_azimuths; ++a) {
 		for (size_t s = 0; s < _num_src_beams; ++s) {
 			for (size_t r = 0; r < _num_rcv_beams; ++r) {
-				for (size_t f = 0; f < _envelope_freq->size(); ++f) {
-					matrix_row< matrix<double> > row(*_envelopes[a][s][r], f);
-					vector<double> envelope = 10.0*log10(max(row, 1e-30));
+				const double* row = envelope_data(a, s, r) ;
+				for (size_t f = 0; f < _envelope_freq->size(); ++f, row += _time_stride) {
+					for (size_t t = 0; t < num_time; ++t) {
+						envelope[t] = 10.0*log10(max(row[t], 1e-30));
+					}
 					envelopes_var->set_cur((long)a, (long)s, (long)r, (long) f, 0L );
-					envelopes_var->put(envelope.data().begin(), 1L, 1L, 1L, 1L,
-						(long) _travel_time->size() );
+					envelopes_var->put(&envelope[0], 1L, 1L, 1L, 1L,
+						(long) num_time );
 				}
 			}
 		}
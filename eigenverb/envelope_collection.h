@@ -8,6 +8,8 @@
 #include <usml/eigenverb/envelope_model.h>
 #include <usml/sensors/sensor_model.h>
 #include <usml/types/seq_linear.h>
+#include <boost/align/aligned_allocator.hpp>
+#include <vector>
 
 namespace usml {
 namespace eigenverb {
@@ -19,9 +21,17 @@ using namespace usml::types;
  * Computes and stores the reverberation envelope time series for all
  * combinations of receiver azimuth, source beam number, receiver beam number.
  * Relies on envelope_model to calculate the actual time series for each
- * envelope frequency.  Each envelope is stored as a matrix that represents
- * the results as a function of the sensor_pair's envelope frequency (rows)
- * and two-way travel time (columns).
+ * envelope frequency.  Each envelope represents the results as a function
+ * of the sensor_pair's envelope frequency (rows) and two-way travel
+ * time (columns).
+ *
+ * All of the envelopes are stored in a single, contiguous buffer, in
+ * azimuth, source beam, receiver beam, frequency, travel time order.
+ * Each time series is padded out to a multiple of four samples, and the
+ * buffer is aligned on a 32 byte boundary, so that every time series
+ * starts on a SIMD friendly boundary.  Each eigenverb contribution only
+ * covers a few pulse lengths of the time axis, so add_contribution()
+ * only updates the window of travel times computed by envelope_model.
  */
 class USML_DECLSPEC envelope_collection {
 
@@ -38,8 +48,8 @@ public:
     typedef boost::shared_ptr<envelope_collection> reference;
 
     /**
-     * Reserve memory in which to store results as a series of
-     * nested dynamic arrays.
+     * Reserve memory in which to store results as a single,
+     * contiguous buffer.
      *
      * @param envelope_freq     Frequencies at which the source and receiver
      *                          eigenverbs overlap (Hz).  Frequencies at which
@@ -80,7 +90,7 @@ public:
         wposition1 rcv_position) ;
 
     /**
-     * Delete dynamic memory in each of the nested dynamic arrays.
+     * Delete dynamic memory for the axes.
      */
     ~envelope_collection();
 
@@ -203,6 +213,7 @@ public:
 
     /**
      * Intensity time series for one combination of parameters.
+     * Copies the time series out of the contiguous buffer.
      *
      * @param azimuth     Receiver azimuth number.
      * @param src_beam    Source beam number.
@@ -211,35 +222,58 @@ public:
      *                      Each row represents a specific envelope frequency.
      *                      Each column represents a specific travel time.
      */
-    const matrix< double >& envelope(
-        size_t azimuth, size_t src_beam, size_t rcv_beam ) const
-    {
-        read_lock_guard guard(_envelopes_mutex);
-        return *_envelopes[azimuth][src_beam][rcv_beam];
-    }
+    matrix< double > envelope(
+        size_t azimuth, size_t src_beam, size_t rcv_beam ) const ;
 
     /**
      * Sets the intensity time series for one combination of parameters.
      *
-     * @param intensities Matrix of
+     * @param intensities Reverberation intensity at each point the time series.
+     *                      Each row represents a specific envelope frequency.
+     *                      Each column represents a specific travel time.
      * @param azimuth     Receiver azimuth number.
      * @param src_beam    Source beam number.
      * @param rcv_beam    Receiver beam number
-     * @return            Reverberation intensity at each point the time series.
-     *                      Each row represents a specific envelope frequency.
-     *                      Each column represents a specific travel time.
      */
-    void envelope( matrix< double >& intensities,
+    void envelope( const matrix< double >& intensities,
+        size_t azimuth, size_t src_beam, size_t rcv_beam ) ;
+
+    /**
+     * Direct access to the intensity time series for one combination of
+     * parameters, without copying it.  The time series for each envelope
+     * frequency is a row of travel_time()->size() values, and the start
+     * of each row is time_stride() values after the start of the
+     * previous row.  Callers must not hold onto this pointer while
+     * contributions are being added or dead reckoned.
+     *
+     * @param azimuth     Receiver azimuth number.
+     * @param src_beam    Source beam number.
+     * @param rcv_beam    Receiver beam number
+     * @return            Intensity at the first travel time of the first
+     *                    envelope frequency.
+     */
+    const double* envelope_data(
         size_t azimuth, size_t src_beam, size_t rcv_beam ) const
     {
-        write_lock_guard guard(_envelopes_mutex);
-        *_envelopes[azimuth][src_beam][rcv_beam] = intensities;
+        return &_envelopes[ offset(azimuth,src_beam,rcv_beam) ] ;
+    }
+
+    /**
+     * Distance between the start of the time series for adjacent
+     * envelope frequencies in envelope_data().  Padded to a multiple of
+     * four samples, so this may be larger than travel_time()->size().
+     */
+    size_t time_stride() const {
+        return _time_stride ;
     }
 
     /**
      * Adds the intensity contribution for a single combination of source
      * and receiver eigenverbs.  Loops over source and receiver beams to
-     * apply beam pattern to each contribution.
+     * apply beam pattern to each contribution.  Only updates the travel
+     * times within the window of the Gaussian contribution, and computes
+     * all of the beam combinations for each frequency in a single pass,
+     * while the contribution is still in cache.
      *
      * Assumes that the source and receiver eigenverbs have been interpolated
      * onto the sensor_pair's frequency domain before this routine is called.
@@ -261,11 +295,34 @@ public:
      * @param ys2        Square of the relative distance from the
      *                     receiver to the target along the direction
      *                     of the receiver's width.
+     * @param workspace  Index of the envelope_model workspace used to
+     *                     compute this contribution.  Must be less than
+     *                     num_workspaces().
      */
     void add_contribution(
             const eigenverb& src_verb, const eigenverb& rcv_verb,
             const matrix<double>& src_beam, const matrix<double>& rcv_beam,
-            const vector<double>& scatter, double xs2, double ys2 ) ;
+            const vector<double>& scatter, double xs2, double ys2,
+            size_t workspace = 0 ) ;
+
+    /**
+     * Number of envelope_model workspaces available to add_contribution().
+     */
+    size_t num_workspaces() const {
+        return _workspaces.size() + 1 ;
+    }
+
+    /**
+     * Reserves workspaces so that contributions can be added by more than
+     * one thread at the same time.  Each thread must use a different
+     * workspace, and must add contributions to a different set of
+     * receiver azimuths, because add_contribution() does not lock the
+     * envelopes.  Not thread safe itself; call it before starting
+     * the threads.
+     *
+     * @param count     Number of workspaces needed.
+     */
+    void num_workspaces( size_t count ) ;
 
     /**
      * Updates the current envelope_collection
@@ -364,19 +421,46 @@ private:
      */
     envelope_model _envelope_model ;
 
+    /**
+     * Extra engines for computing Gaussian envelope contributions,
+     * used by threads that add contributions in parallel.  Workspace
+     * zero is always #_envelope_model, so this list starts at one.
+     */
+    std::vector< envelope_model* > _workspaces ;
+
+    /**
+     * Distance between the time series for adjacent frequencies
+     * in the _envelopes buffer.
+     */
+    const size_t _time_stride ;
+
     /**
      * Reverberation envelopes for each combination of parameters.
      * The order of indices is azimuth number, source beam number,
-     * and then receiver beam number.  Each envelope is stored as a
-     * matrix that represents the results a function of the sensor_pair's
-     * envelope frequency (rows) and two-way travel time (columns).
+     * receiver beam number, envelope frequency, and then two-way
+     * travel time.  Each time series is padded out to #_time_stride
+     * values.
      */
-    matrix< double >**** _envelopes;
+    std::vector< double, boost::alignment::aligned_allocator<double,32> >
+        _envelopes ;
 
     /**
      * Mutex that locks during envelopes access
      */
     mutable read_write_lock _envelopes_mutex ;
+
+    /**
+     * Location of the first value for one combination of parameters
+     * in the _envelopes buffer.
+     *
+     * @param azimuth     Receiver azimuth number.
+     * @param src_beam    Source beam number.
+     * @param rcv_beam    Receiver beam number
+     */
+    size_t offset( size_t azimuth, size_t src_beam, size_t rcv_beam ) const {
+        return ( ( azimuth * _num_src_beams + src_beam ) * _num_rcv_beams
+            + rcv_beam ) * _envelope_freq->size() * _time_stride ;
+    }
 };
 
 }   // end of namespace eigenverb
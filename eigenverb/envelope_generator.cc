@@ -4,13 +4,14 @@
  */
 #include <usml/eigenverb/envelope_generator.h>
 #include <usml/eigenverb/eigenverb.h>
-#include <usml/sensors/beam_pattern_map.h>
-#include <usml/sensors/beam_pattern_model.h>
+#include <usml/waveq3d/wave_profiler.h>
 #include <usml/threads/smart_ptr.h>
+#include <usml/threads/thread_controller.h>
 #include <boost/foreach.hpp>
 
 using namespace usml::eigenverb ;
 using namespace usml::sensors ;
+using usml::waveq3d::wave_profiler ;
 
 /**
  * Minimum intensity level for valid reverberation contributions (dB).
@@ -22,6 +23,16 @@ double envelope_generator::intensity_threshold = -300.0 ;
  */
 double envelope_generator::distance_threshold = 6.0 ;
 
+/**
+ * Number of source eigenverbs between checks of the abort flag.
+ */
+const size_t envelope_generator::abort_interval ;
+
+/**
+ * Number of receiver azimuth shards processed in parallel.
+ */
+size_t envelope_generator::num_shards = 0 ;
+
 /**
  * The mutex for static properties.
  */
@@ -49,7 +60,7 @@ envelope_generator::envelope_generator(
     _sensor_pair(sensor_pair),
     _src_eigenverbs(sensor_pair->source()->eigenverbs()),
     _rcv_eigenverbs(sensor_pair->receiver()->eigenverbs()),
-    _eigenverb_interpolator(sensor_pair->receiver()->frequencies(),sensor_pair->frequencies())
+    _rcv_frequencies(sensor_pair->receiver()->frequencies()->clone())
 {
     write_lock_guard guard(_property_mutex);
 
@@ -87,6 +98,57 @@ envelope_generator::envelope_generator(
  * Executes the Eigenverb reverberation model.
  */
 void envelope_generator::run() {
+	wave_profiler::scoped_timer timer( wave_profiler::ENVELOPE_TASK ) ;
+
+	// check to see if task has already been aborted
+
+	if (_abort) {
+		release() ;
+		return;
+	}
+
+	// look up beam patterns tabulated for the current sensor orientations
+
+	const seq_vector* freq = _envelopes->envelope_freq() ;
+	_src_beams = _sensor_pair->source()->beam_tables( _src_beam_list, *freq ) ;
+	_rcv_beams = _sensor_pair->receiver()->beam_tables( _rcv_beam_list, *freq ) ;
+
+	// split receiver azimuths into shards
+
+	size_t shards = num_shards ;
+	if ( shards == 0 ) {
+		shards = thread_controller::instance()->num_threads() ;
+	}
+	shards = max( (size_t) 1, min( shards, _envelopes->num_azimuths() ) ) ;
+	_envelopes->num_workspaces( shards ) ;
+
+	// fork all but the first shard, run the first shard in this thread,
+	// then wait for the others
+
+	thread_pool* pool = thread_controller::instance() ;
+	std::vector<thread_task::reference> tasks ;
+	for ( size_t n=1 ; n < shards ; ++n ) {
+		tasks.push_back( thread_task::reference(
+			new shard_task( this, n, shards ) ) ) ;
+		pool->fork( tasks.back() ) ;
+	}
+	accumulate( 0, shards ) ;
+	BOOST_FOREACH( thread_task::reference& task, tasks ) {
+		pool->join( task ) ;
+	}
+
+	if (_abort) {
+		release() ;
+		return;
+	}
+	this->notify_envelope_listeners(_envelopes) ;
+	_done = true;
+}
+
+/**
+ * Adds the contributions for one shard of the receiver azimuths.
+ */
+bool envelope_generator::accumulate( size_t shard, size_t num_shards ) {
 
 	// create memory for work products
 
@@ -100,21 +162,51 @@ void envelope_generator::run() {
 	eigenverb rcv_verb ;
 	rcv_verb.frequencies = freq ;
 	rcv_verb.power = vector<double>( num_freq ) ;
+	eigenverb_interpolator interpolator( _rcv_frequencies.get(), freq ) ;
+	std::vector<double> level( num_freq ) ;
+
+	// candidate source eigenverbs for each receiver eigenverb,
+	// re-used so that their memory is only allocated once per shard
+
+	std::vector<const eigenverb*> candidates ;
+	std::vector<double> xs2_list ;
+	std::vector<double> ys2_list ;
+	std::vector<wposition1> location ;
+	std::vector<double> de_incident ;
+	std::vector<double> de_scattered ;
+	std::vector<double> az_incident ;
+	std::vector<double> az_scattered ;
+	matrix<double> amplitude ;
+	const double threshold = pow( 10.0, intensity_threshold / 10.0 ) ;
+	size_t contributions = 0 ;
 
 	// loop through eigenrays for each interface
 
 	for ( size_t interface=0 ; interface < _rcv_eigenverbs->num_interfaces() ; ++interface) {
 
-		BOOST_FOREACH( eigenverb verb, _rcv_eigenverbs->eigenverbs(interface) ) {
-			_eigenverb_interpolator.interpolate(verb,&rcv_verb) ;
+		BOOST_FOREACH( const eigenverb& verb, _rcv_eigenverbs->eigenverbs(interface) ) {
+
+			// stop work on stale results if superseded or aborted
+
+			if (_abort) return false ;
+			if ( verb.az_index % num_shards != shard ) continue ;
+			interpolator.interpolate(verb,&rcv_verb) ;
 
 			// Cull eigenverbs down with rtree.query
 			std::vector<value_pair> result_s;
 			_src_eigenverbs->query_rtree(interface, rcv_verb, result_s);
 
+			candidates.clear() ;
+			xs2_list.clear() ;
+			ys2_list.clear() ;
+			de_incident.clear() ;
+			az_incident.clear() ;
+
+			size_t count = 0 ;
 			BOOST_FOREACH( value_pair const& vp, result_s ) {
+				if ( ++count % abort_interval == 0 && _abort ) return false ;
 
-				eigenverb src_verb = *(vp.second);
+				const eigenverb& src_verb = *(vp.second);
 
 				// determine relative range and bearing between the projected Gaussians
 				// skip this combo if source peak too far away
@@ -127,65 +219,100 @@ void envelope_generator::run() {
 			    bearing -= rcv_verb.direction ;		// relative bearing
 
 			    const double ys = range * cos( bearing ) ;
-			    const double ys2 = ys * ys ;
 			    if ( abs(ys) > distance_threshold * rcv_verb.length ) continue ;
 
 			    const double xs = range * sin( bearing ) ;
-			    const double xs2 = xs * xs ;
 			    if ( abs(xs) > distance_threshold * rcv_verb.width ) continue ;
 
-				// compute interface scattering strength
-			    // skip this combo if scattering strength is trivial
+			    candidates.push_back( &src_verb ) ;
+			    xs2_list.push_back( xs * xs ) ;
+			    ys2_list.push_back( ys * ys ) ;
+			    de_incident.push_back( src_verb.grazing ) ;
+			    az_incident.push_back( src_verb.direction ) ;
+			}
+			const size_t num_candidates = candidates.size() ;
+			if ( num_candidates == 0 ) continue ;
+
+			// compute interface scattering strength for all candidates at once
+
+			location.assign( num_candidates, rcv_verb.position ) ;
+			de_scattered.assign( num_candidates, rcv_verb.grazing ) ;
+			az_scattered.assign( num_candidates, rcv_verb.direction ) ;
+			scattering( interface, location, *freq,
+				de_incident, de_scattered, az_incident, az_scattered,
+				&amplitude ) ;
+
+			// compute receiver beam levels, which are the same for all candidates
+
+			beam_gain( _rcv_beams, rcv_verb.source_de,
+				rcv_verb.source_az, &rcv_beam, &level ) ;
+
+			for ( size_t n=0 ; n < num_candidates ; ++n ) {
+				if ( (n+1) % abort_interval == 0 && _abort ) return false ;
+				const eigenverb& src_verb = *candidates[n] ;
+
+				// skip this combo if scattering strength is trivial
 
-				if ( ! scattering( interface,
-					 rcv_verb.position, *freq,
-					 src_verb.grazing, rcv_verb.grazing,
-					 src_verb.direction, rcv_verb.direction,
-					 &scatter ) ) continue ;
+				const double* amp = &amplitude.data()[n * num_freq] ;
+				if ( *std::max_element( amp, amp + num_freq ) < threshold ) continue ;
+				std::copy( amp, amp + num_freq, scatter.begin() ) ;
 
-				// compute beam levels
+				// compute source beam levels
 
-				src_beam = beam_gain(_src_beam_list, freq, src_verb.source_de,
-					src_verb.source_az, _sensor_pair->source()->orient());
-				rcv_beam = beam_gain(_rcv_beam_list, freq, rcv_verb.source_de,
-					rcv_verb.source_az, _sensor_pair->receiver()->orient());
+				beam_gain( _src_beams, src_verb.source_de,
+					src_verb.source_az, &src_beam, &level ) ;
 
 				// create envelope contribution
 
 				_envelopes->add_contribution( src_verb, rcv_verb,
-						src_beam, rcv_beam, scatter, xs2, ys2 ) ;
+						src_beam, rcv_beam, scatter,
+						xs2_list[n], ys2_list[n], shard ) ;
+				++contributions ;
 			}
 		}
 	}
-	this->notify_envelope_listeners(_envelopes) ;
+	wave_profiler::add_event( wave_profiler::ENVELOPE_CONTRIBUTIONS,
+		contributions ) ;
+	return true ;
+}
+
+/**
+ * Releases the partial envelopes and the eigenverbs used to build them.
+ */
+void envelope_generator::release() {
+	_envelopes.reset() ;
+	_src_eigenverbs.reset() ;
+	_rcv_eigenverbs.reset() ;
+	_ocean.reset() ;
 }
 
 /**
  * Computes the beam_gain
  */
-matrix<double> envelope_generator::beam_gain(
-    sensor_params::beam_pattern_list beam_list,
-    const seq_vector* freq, double de_rad, double az_rad, orientation orient)
+void envelope_generator::beam_gain(
+    const std::vector<beam_pattern_table::reference>& tables,
+    double de_rad, double az_rad, matrix<double>* gain,
+    std::vector<double>* level )
 {
-    const vector<double> frequencies = *freq;	// beam_level requires ublas vector
-    matrix<double> beam_matrix( freq->size(), beam_list.size() ) ;
-    vector<double> level( freq->size(), 0.0 ) ;
-    BOOST_FOREACH( beam_pattern_model::id_type id, beam_list) {
-        beam_pattern_model::reference bp = beam_pattern_map::instance()->find(id);
-        bp->beam_level(de_rad, az_rad, orient, frequencies, &level ) ;
-
-        std::copy(level.begin(), level.end(), beam_matrix.begin1());
+    for ( size_t b=0 ; b < tables.size() ; ++b ) {
+        tables[b]->beam_level( de_rad, az_rad, &(*level)[0] ) ;
+        for ( size_t f=0 ; f < gain->size1() ; ++f ) {
+            (*gain)(f,b) = (*level)[f] ;
+        }
     }
-    return beam_matrix;
 }
 
 /**
  * Computes the broadband scattering strength for a specific interface.
  */
-bool envelope_generator::scattering( size_t interface, const wposition1& location,
-		const seq_vector& frequencies, double de_incident,
-		double de_scattered, double az_incident, double az_scattered,
-		vector<double>* amplitude)
+void envelope_generator::scattering( size_t interface,
+		const std::vector<wposition1>& location,
+		const seq_vector& frequencies,
+		const std::vector<double>& de_incident,
+		const std::vector<double>& de_scattered,
+		const std::vector<double>& az_incident,
+		const std::vector<double>& az_scattered,
+		matrix<double>* amplitude )
 {
 	switch ( interface ) {
 	case eigenverb::BOTTOM:
@@ -205,13 +332,4 @@ bool envelope_generator::scattering( size_t interface, const wposition1& locatio
 				amplitude) ;
 		break;
 	}
-
-	// check to see that scattering strenght is not trivial
-
-	BOOST_FOREACH (double amp, *amplitude){
-        if (amp >= intensity_threshold ) {
-            return true;
-        }
-    }
-    return true;
 }
@@ -41,9 +41,20 @@ using namespace usml::threads;
  *
  * Invoked as a background thread_task by the sensor_pair for
  * a specific source/receiver combination, whenever one of the sensors
- * updates its eigenverbs. If an existing envelope_generator is running for
- * this sensor_pair, that task is aborted before the new envelope_generator
- * is created.
+ * updates its eigenverbs. Each task uses the IDs of the source and receiver
+ * as its supersede key, so the thread_pool aborts any existing
+ * envelope_generator for this sensor_pair when a new one is added.
+ * The receiver eigenverbs can be split into shards by receiver azimuth,
+ * and processed in parallel by sub-tasks forked onto the thread_pool.
+ * Each azimuth is owned by exactly one shard, and each shard processes its
+ * eigenverbs in the same order as the serial calculation, so the parallel
+ * results are bit-for-bit identical to the serial ones, without
+ * any locks or reduction step.
+ *
+ * The run() method checks for an abort between receiver eigenverbs,
+ * and every #abort_interval source eigenverbs, so that stale work stops
+ * quickly.  An aborted task releases its partial envelopes, and its
+ * references to the eigenverbs, without notifying the listeners.
  */
 class USML_DECLSPEC envelope_generator: public thread_task, public envelope_notifier {
 public:
@@ -61,6 +72,21 @@ public:
      */
     static double distance_threshold;
 
+    /**
+     * Number of source eigenverbs, for each receiver eigenverb,
+     * between checks of the abort flag.
+     */
+    static const size_t abort_interval = 64 ;
+
+    /**
+     * Number of receiver azimuth shards processed in parallel.
+     * Set to one to run the whole calculation in the thread that
+     * runs this task.  Defaults to zero, which uses one shard for each
+     * thread in the thread_controller's pool.  Limited to the
+     * number of receiver azimuths.
+     */
+    static size_t num_shards;
+
     /**
      * Constructor - Initialize model parameters and reserve memory.
      *
@@ -126,40 +152,96 @@ public:
 private:
 
     /**
-     * Computes the beam_gain matrix
+     * Sub-task that processes the receiver eigenverbs for one shard
+     * of the receiver azimuths.
+     */
+    class shard_task : public thread_task {
+    public:
+
+        /**
+         * Defines the work for this shard.
+         *
+         * @param generator     Task that owns the eigenverbs and envelopes.
+         * @param shard         Index of this shard, also used as the
+         *                      envelope_collection workspace number.
+         * @param num_shards    Total number of shards.
+         */
+        shard_task( envelope_generator* generator,
+                    size_t shard, size_t num_shards ) :
+            _generator(generator), _shard(shard), _num_shards(num_shards)
+        {}
+
+        /** Process the receiver eigenverbs for this shard. */
+        virtual void run() {
+            _generator->accumulate( _shard, _num_shards ) ;
+        }
+
+    private:
+        envelope_generator* _generator ;
+        size_t _shard ;
+        size_t _num_shards ;
+    } ;
+
+    /**
+     * Adds the contributions of the receiver eigenverbs whose azimuth
+     * index modulo num_shards is equal to shard.  Uses the shard number
+     * as the envelope_collection workspace, so that shards can run
+     * in parallel.
      *
-     * @param beam_list Location at which to compute attenuation.
-     * @param freq      Frequencies to get beam levels (Hz)
+     * @param shard         Index of this shard.
+     * @param num_shards    Total number of shards.
+     * @return              False if the task was aborted.
+     */
+    bool accumulate( size_t shard, size_t num_shards ) ;
+
+    /**
+     * Releases the partial envelopes, and the eigenverbs used to
+     * build them, when the task is aborted.
+     */
+    void release() ;
+
+    /**
+     * Computes the beam_gain matrix by interpolating the tabulated
+     * beam patterns for a sensor.
+     *
+     * @param tables    Tabulated beam pattern for each beam number.
      * @param de_rad    Depression incident angle (radians).
      * @param az_rad    Azimuthal incident angle  (radians).
-     * @param orient    orientation
+     * @param gain      Beam level at each envelope frequency (output).
+     *                  Each row represents a specific envelope frequency.
+     *                  Each column represents a beam number.
+     * @param level     Workspace with room for one level per frequency.
      */
-    matrix<double> beam_gain( sensor_params::beam_pattern_list beam_list,
-            const seq_vector* freq, double de_rad, double az_rad,
-            orientation orient);
+    static void beam_gain(
+            const std::vector<beam_pattern_table::reference>& tables,
+            double de_rad, double az_rad, matrix<double>* gain,
+            std::vector<double>* level ) ;
 
     /**
-     * Computes the broadband scattering strength for a specific interface.
-     * Checks that the scattering strength is greater than the
-     * intensity_threshold.  This check allows the model to skip interfaces
-     * with trivial scattering strengths.
+     * Computes the broadband scattering strength for a batch of
+     * source/receiver eigenverb pairs on a specific interface,
+     * using a single call to the ocean's scattering model.
      *
      * @param interface_num Interface number of ocean component that is doing
      *                      the scattering. See the eigenverb class header
      *                      for documentation on interpreting this number.
-     * @param location      Location at which to compute attenuation.
+     * @param location      Location of each scattering.
      * @param frequencies   Frequencies over which to compute loss. (Hz)
-     * @param de_incident   Depression incident angle (radians).
-     * @param de_scattered  Depression scattered angle (radians).
-     * @param az_incident   Azimuthal incident angle (radians).
-     * @param az_scattered  Azimuthal scattered angle (radians).
-     * @param amplitude     Change in ray strength in dB (output).
-     * @return              True if any scattering strength is above the threshold.
+     * @param de_incident   Depression incident angle of each pair (radians).
+     * @param de_scattered  Depression scattered angle of each pair (radians).
+     * @param az_incident   Azimuthal incident angle of each pair (radians).
+     * @param az_scattered  Azimuthal scattered angle of each pair (radians).
+     * @param amplitude     Scattering strength ratio (output).  One row
+     *                      for each pair, and one column for each frequency.
      */
-    bool scattering( size_t interface_num, const wposition1& location,
-            const seq_vector& frequencies, double de_incident,
-            double de_scattered, double az_incident, double az_scattered,
-            vector<double>* amplitude);
+    void scattering( size_t interface_num,
+            const std::vector<wposition1>& location,
+            const seq_vector& frequencies,
+            const std::vector<double>& de_incident,
+            const std::vector<double>& de_scattered,
+            const std::vector<double>& az_incident,
+            const std::vector<double>& az_scattered,
+            matrix<double>* amplitude ) ;
 
     /**
      * The mutex for static properties.
@@ -195,6 +277,18 @@ private:
      * Receiver Beam Pattern List.
      */
     sensor_params::beam_pattern_list _rcv_beam_list;
+
+    /**
+     * Source beam patterns, tabulated at the envelope frequencies.
+     * Built by the source sensor, and shared with its other pairs.
+     */
+    std::vector<beam_pattern_table::reference> _src_beams ;
+
+    /**
+     * Receiver beam patterns, tabulated at the envelope frequencies.
+     * Built by the receiver sensor, and shared with its other pairs.
+     */
+    std::vector<beam_pattern_table::reference> _rcv_beams ;
     
 
     /**
@@ -208,9 +302,10 @@ private:
     eigenverb_collection::reference _rcv_eigenverbs;
 
     /**
-     * Utility used to interpolate eigenrays.
+     * Frequencies of the receiver eigenverbs (Hz).
+     * Each shard uses these to build its own eigenverb_interpolator.
      */
-    eigenverb_interpolator _eigenverb_interpolator ;
+    unique_ptr<const seq_vector> _rcv_frequencies ;
 
     /**
      * Collection of envelopes generated by this calculation.
@@ -5,7 +5,6 @@
  */
 #include <boost/foreach.hpp>
 #include <boost/numeric/ublas/vector_proxy.hpp>
-#include <boost/numeric/ublas/matrix_proxy.hpp>
 #include <usml/eigenverb/envelope_model.h>
 
 using namespace usml::eigenverb;
@@ -29,7 +28,8 @@ envelope_model::envelope_model(
 	_initial_time(initial_time),
 	_pulse_length(pulse_length),
 	_threshold(threshold),
-	_level(travel_time->size()),
+	_window_first(0),
+	_window_last(0),
 	_power(envelope_freq->size()),
 	_duration(envelope_freq->size()),
 	_intensity(envelope_freq->size(), travel_time->size())
@@ -181,30 +181,25 @@ bool envelope_model::compute_overlap(
 void envelope_model::compute_time_series(
 		double src_verb_time, double rcv_verb_time )
 {
-	_intensity.clear() ;
+	// compute the peak time, which is the same for all frequencies
 
-	for ( size_t f = 0 ;f < _envelope_freq->size(); ++f ) {
-
-		// compute the peak time and intensity
+	const double delay = src_verb_time + rcv_verb_time + _duration - _initial_time;
 
-		const double delay = src_verb_time + rcv_verb_time + _duration - _initial_time;
-		const double scale = _power[f] / _duration;
+	// only compute the portion of the time series within +/- five (5)
+	// times the duration, all other times are skipped by the caller
 
-		// compute Gaussian intensity as a function of time
+	_window_first = _travel_time->find_index(delay - 5.0 * _duration);
+	_window_last = _travel_time->find_index(delay + 5.0 * _duration) + 1;
 
-		matrix_row< matrix<double> > intensity( _intensity, f ) ;
+	for ( size_t f = 0 ;f < _envelope_freq->size(); ++f ) {
 
-		// use uBLAS vector proxies to only compute the portion of the
-		// time series within +/- five (5) times the duration
-		// speeds up the computation by over a factor of 3
+		// compute Gaussian intensity as a function of time
 
-		_level.clear() ;
-		size_t first = _travel_time->find_index(delay - 5.0 * _duration);
-		size_t last = _travel_time->find_index(delay + 5.0 * _duration) + 1;
-		range window(first, last);
-		vector_range< seq_vector > time(*_travel_time, window);
-		vector_range< vector<double> > level(_level, window);
-		level = scale * exp(-0.5 * abs2((time - delay) / _duration)) ;
-		intensity = _level ;
+		const double scale = _power[f] / _duration ;
+		double* level = &_intensity(f,0) ;
+		for ( size_t t = _window_first ; t < _window_last ; ++t ) {
+			const double x = ( (*_travel_time)[t] - delay ) / _duration ;
+			level[t] = scale * exp( -0.5 * ( x * x ) ) ;
+		}
 	}
 }
@@ -108,13 +108,32 @@ private:
      * Reverberation intensity at each point the time series.
      * Each row represents a specific envelope frequency.
      * Each column represents a specific travel time.
-     * Passing this back as a non-const reference allows it to be accessed
-     * by a matrix_row<> proxy in the calling program.
+     * Only the columns in [window_first(),window_last()) are
+     * valid for each row; the rest are left over from earlier
+     * contributions.  Passing this back as a non-const reference
+     * allows it to be accessed by a matrix_row<> proxy in the
+     * calling program.
      */
     matrix< double >& intensity() {
         return _intensity ;
     }
 
+    /**
+     * First travel time index of the Gaussian contribution.
+     * The same for all envelope frequencies.
+     */
+    size_t window_first() const {
+        return _window_first ;
+    }
+
+    /**
+     * One past the last travel time index of the Gaussian contribution.
+     * The same for all envelope frequencies.
+     */
+    size_t window_last() const {
+        return _window_last ;
+    }
+
 private:
 
     /**
@@ -148,9 +167,10 @@ private:
      * values previously held by the _intensity member variable.
      *
      * In an effort to speed up the calculation of the Gaussian, this
-     * routine uses uBLAS vector and matrix proxies to only compute the
-     * portion of the time series within +/- five (5) times the duration
-     * of each pulse.
+     * routine only computes the portion of the time series within
+     * +/- five (5) times the duration of each pulse.  The limits of
+     * this window are saved for each frequency, so that the caller
+     * can skip the rest of the time series.
      *
      * @param src_verb_time		One way travel time for source eigenverb.
      * @param rcv_verb_time     One way travel time for receiver eigenverb.
@@ -195,14 +215,11 @@ private:
      */
     const double _threshold ;
 
-    /**
-     * Workspace for storing a single eigenverb overlap contribution
-     * as a function of two way travel time. Used to build the intensity
-     * for an individual frequency in the compute_time_serie() method.
-     * Building this as a member variable allows the allocation of memory
-     * to be re-used across eigenverb pairs.
-     */
-    vector<double> _level ;
+    /** First travel time index of the Gaussian contribution. */
+    size_t _window_first ;
+
+    /** One past the last travel time index of the Gaussian contribution. */
+    size_t _window_last ;
 
     /**
      * Workspace for storing total power of eigenverb overlap,
@@ -6,10 +6,12 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/foreach.hpp>
 #include <boost/progress.hpp>
+#include <boost/thread.hpp>
 #include <usml/waveq3d/waveq3d.h>
 #include <usml/eigenverb/eigenverb_collection.h>
 #include <usml/eigenverb/envelope_collection.h>
 #include <usml/eigenverb/eigenverb_interpolator.h>
+#include <usml/eigenverb/wavefront_cache.h>
 #include <boost/numeric/ublas/vector_proxy.hpp>
 #include <iostream>     // std::cout, std::fixed
 #include <iomanip>      // std::setprecision
@@ -462,6 +464,114 @@ BOOST_AUTO_TEST_CASE( envelope_basic ) {
 		cout << "theory=" << theory[f] << " model=" << model << endl;
 		BOOST_CHECK_SMALL( abs(model-theory[f]), 1e-4);
 	}
+
+	// check that direct access to the contiguous buffer
+	// gives the same answers as the copied envelopes
+
+	BOOST_CHECK_EQUAL( envelopes.time_stride() % 4, 0u );
+	BOOST_CHECK( envelopes.time_stride() >= envelopes.travel_time()->size() );
+	const matrix<double> copy = envelopes.envelope(0,0,0) ;
+	const double* data = envelopes.envelope_data(0,0,0) ;
+	for (size_t f = 0; f < freq.size(); ++f) {
+		BOOST_CHECK_EQUAL( data[f*envelopes.time_stride()+index], copy(f,index) );
+	}
+}
+
+/**
+ * Adds the contributions for one receiver azimuth to an envelope_collection,
+ * using the azimuth number as the workspace number.
+ */
+struct envelope_adder {
+	envelope_collection* collection ;
+	std::vector<eigenverb>* verbs ;
+	vector<double>* scatter ;
+	matrix<double>* src_beam ;
+	matrix<double>* rcv_beam ;
+	size_t azimuth ;
+	void operator()() {
+		for ( size_t n=0 ; n < verbs->size() ; ++n ) {
+			const eigenverb& v = (*verbs)[n] ;
+			if ( v.az_index != azimuth ) continue ;
+			collection->add_contribution( v, v, *src_beam, *rcv_beam,
+				*scatter, 10.0 * n, 5.0, azimuth ) ;
+		}
+	}
+} ;
+
+/**
+ * Adds contributions to one envelope_collection in a single thread, and to
+ * another using a separate thread and workspace for each receiver azimuth.
+ * Automatically checks that the envelopes are identical, which is what
+ * allows envelope_generator to split its work into azimuth shards.
+ */
+BOOST_AUTO_TEST_CASE( envelope_workspace ) {
+    cout << "=== eigenverb_test: envelope_workspace ===" << endl;
+    const size_t num_azimuths = 2 ;
+    double angle = M_PI / 6.0 ;
+
+	eigenverb verb ;
+	verb.position = wposition1(0.0,0.0,-1000.0) ;
+	verb.direction = 0.0 ;
+	verb.grazing = angle ;
+	verb.sound_speed = c0 ;
+	verb.de_index = 0 ;
+	verb.source_de = -angle ;
+	verb.source_az = 0.0 ;
+	verb.surface = 0 ;
+	verb.bottom = 0 ;
+	verb.caustic = 0 ;
+	verb.upper = 0 ;
+	verb.lower = 0 ;
+	seq_linear freq(1000.0,1000.0,3) ;
+	verb.frequencies = &freq ;
+	verb.power = vector<double>( freq.size(), 0.2 ) ;
+	verb.length2 = 400.0 ;
+	verb.width2 = 100.0 ;
+
+	const seq_vector* travel_time = new seq_linear(0.0,0.1,400.0) ;
+	envelope_collection serial( &freq, 0, travel_time, 40.0, 1.0, 1e-30,
+		num_azimuths, 2, 3, 0.0, 1, 1,
+		wposition1(0.0,0.0), wposition1(0.0,0.0) ) ;
+	envelope_collection parallel( &freq, 0, travel_time, 40.0, 1.0, 1e-30,
+		num_azimuths, 2, 3, 0.0, 1, 1,
+		wposition1(0.0,0.0), wposition1(0.0,0.0) ) ;
+	delete travel_time ;
+	parallel.num_workspaces( num_azimuths ) ;
+	BOOST_CHECK_EQUAL( parallel.num_workspaces(), num_azimuths ) ;
+
+	vector<double> scatter( freq.size(), 0.1 ) ;
+	matrix<double> src_beam( freq.size(), 2, 0.5 ) ;
+	matrix<double> rcv_beam( freq.size(), 3, 0.25 ) ;
+
+	// many overlapping contributions for each azimuth
+
+	std::vector<eigenverb> verbs ;
+	for ( size_t n=0 ; n < 200 ; ++n ) {
+		verb.time = 1.0 + 0.07 * n ;
+		verb.az_index = n % num_azimuths ;
+		verbs.push_back( verb ) ;
+		serial.add_contribution( verb, verb, src_beam, rcv_beam,
+			scatter, 10.0 * n, 5.0 ) ;
+	}
+
+	boost::thread_group threads ;
+	for ( size_t a=0 ; a < num_azimuths ; ++a ) {
+		envelope_adder work = { &parallel, &verbs, &scatter, &src_beam, &rcv_beam, a } ;
+		threads.create_thread( work ) ;
+	}
+	threads.join_all() ;
+
+	for ( size_t a=0 ; a < num_azimuths ; ++a ) {
+		for ( size_t s=0 ; s < 2 ; ++s ) {
+			for ( size_t r=0 ; r < 3 ; ++r ) {
+				const matrix<double> expected = serial.envelope(a,s,r) ;
+				const matrix<double> actual = parallel.envelope(a,s,r) ;
+				BOOST_CHECK( std::equal( expected.data().begin(),
+					expected.data().end(), actual.data().begin() ) ) ;
+			}
+		}
+	}
+	BOOST_CHECK( serial.envelope(1,1,2)(0,200) > 0.0 ) ;
 }
 
 /**
@@ -717,6 +827,134 @@ BOOST_AUTO_TEST_CASE( rtree_basic ) {
 
 }
 
+/**
+ * Stores a small set of eigenverbs and eigenrays in the wavefront_cache,
+ * and then loads them back into new collections.  Automatically checks
+ * that every field survives the round trip unchanged, that a run with
+ * a different source position misses the cache, and that oceans without
+ * a fingerprint are never cached.
+ */
+BOOST_AUTO_TEST_CASE( wavefront_cache_basic ) {
+    cout << "=== eigenverb_test: wavefront_cache_basic ===" << endl;
+    wavefront_cache::directory = USML_TEST_DIR "/eigenverb/test" ;
+
+    ocean_model ocean( new boundary_flat(), new boundary_flat(1000.0),
+                       new profile_linear(c0) ) ;
+    ocean.fingerprint( "wavefront_cache_basic" ) ;
+    seq_linear freq( 1000.0, 500.0, 3 ) ;
+    seq_rayfan de( -90.0, 90.0, 11 ) ;
+    seq_linear az( 0.0, 90.0, 4 ) ;
+    wposition1 source( src_lat, src_lng, -10.0 ) ;
+    wposition targets( 1, 2, src_lat, src_lng, -20.0 ) ;
+
+    const std::string key = wavefront_cache::key( ocean, source, &targets,
+        freq, de, az, time_step, 10.0, -300.0, 999, 999 ) ;
+    BOOST_CHECK( ! key.empty() ) ;
+
+    // build and store results
+
+    eigenverb_collection verbs( ocean.num_volume() ) ;
+    eigenverb verb ;
+    verb.frequencies = &freq ;
+    verb.power = vector<double>( freq.size() ) ;
+    for ( size_t n=0 ; n < 5 ; ++n ) {
+        verb.time = 0.1 * n + 1.0 / 3.0 ;
+        verb.length = 100.0 + n ;
+        verb.length2 = verb.length * verb.length ;
+        verb.width = 50.0 + n ;
+        verb.width2 = verb.width * verb.width ;
+        verb.position = wposition1( src_lat + 0.01 * n, src_lng, -1000.0 ) ;
+        verb.direction = M_PI / 7.0 * n ;
+        verb.grazing = M_PI / 11.0 ;
+        verb.sound_speed = c0 ;
+        verb.de_index = n ;
+        verb.az_index = n % az.size() ;
+        verb.source_de = -M_PI / 13.0 ;
+        verb.source_az = M_PI / 17.0 * n ;
+        verb.surface = (int) n ;
+        verb.bottom = (int) n + 1 ;
+        verb.caustic = 0 ;
+        verb.upper = 1 ;
+        verb.lower = 2 ;
+        for ( size_t f=0 ; f < freq.size() ; ++f ) {
+            verb.power(f) = 1e-3 / ( n + f + 1.0 ) ;
+        }
+        verbs.add_eigenverb( verb, n % verbs.num_interfaces() ) ;
+    }
+
+    eigenray_collection rays( freq, source, de, az, time_step, &targets ) ;
+    eigenray ray ;
+    ray.frequencies = &freq ;
+    ray.intensity = vector<double>( freq.size(), 42.0 ) ;
+    ray.phase = vector<double>( freq.size(), -M_PI / 3.0 ) ;
+    ray.time = 1.5 ;
+    ray.source_de = 0.25 ;
+    ray.source_az = 0.5 ;
+    ray.target_de = -0.25 ;
+    ray.target_az = 1.0 ;
+    ray.surface = 1 ;
+    ray.bottom = 2 ;
+    ray.caustic = 3 ;
+    ray.upper = 4 ;
+    ray.lower = 5 ;
+    rays.add_eigenray( 0, 1, ray, 0 ) ;
+    wavefront_cache::store( key, verbs, &rays ) ;
+
+    // load results and compare to the originals
+
+    eigenverb_collection loaded_verbs( ocean.num_volume() ) ;
+    eigenray_collection loaded_rays( freq, source, de, az, time_step, &targets ) ;
+    BOOST_REQUIRE( wavefront_cache::load( key, &freq,
+        &loaded_verbs, &loaded_rays ) ) ;
+
+    for ( size_t i=0 ; i < verbs.num_interfaces() ; ++i ) {
+        const eigenverb_list& expected = verbs.eigenverbs(i) ;
+        const eigenverb_list& actual = loaded_verbs.eigenverbs(i) ;
+        BOOST_REQUIRE_EQUAL( actual.size(), expected.size() ) ;
+        eigenverb_list::const_iterator e = expected.begin() ;
+        BOOST_FOREACH( const eigenverb& a, actual ) {
+            BOOST_CHECK( a.frequencies == &freq ) ;
+            BOOST_CHECK_EQUAL( a.time, e->time ) ;
+            BOOST_CHECK_EQUAL( a.length2, e->length2 ) ;
+            BOOST_CHECK_EQUAL( a.width2, e->width2 ) ;
+            BOOST_CHECK_EQUAL( a.position.rho(), e->position.rho() ) ;
+            BOOST_CHECK_EQUAL( a.position.theta(), e->position.theta() ) ;
+            BOOST_CHECK_EQUAL( a.position.phi(), e->position.phi() ) ;
+            BOOST_CHECK_EQUAL( a.direction, e->direction ) ;
+            BOOST_CHECK_EQUAL( a.az_index, e->az_index ) ;
+            BOOST_CHECK_EQUAL( a.source_az, e->source_az ) ;
+            BOOST_CHECK_EQUAL( a.bottom, e->bottom ) ;
+            BOOST_CHECK_EQUAL( a.lower, e->lower ) ;
+            for ( size_t f=0 ; f < freq.size() ; ++f ) {
+                BOOST_CHECK_EQUAL( a.power(f), e->power(f) ) ;
+            }
+            ++e ;
+        }
+    }
+    BOOST_CHECK_EQUAL( loaded_rays.eigenrays(0,0)->size(), 0 ) ;
+    BOOST_REQUIRE_EQUAL( loaded_rays.eigenrays(0,1)->size(), 1 ) ;
+    const eigenray& loaded_ray = loaded_rays.eigenrays(0,1)->front() ;
+    BOOST_CHECK_EQUAL( loaded_ray.time, ray.time ) ;
+    BOOST_CHECK_EQUAL( loaded_ray.target_az, ray.target_az ) ;
+    BOOST_CHECK_EQUAL( loaded_ray.lower, ray.lower ) ;
+    BOOST_CHECK_EQUAL( loaded_ray.intensity(2), ray.intensity(2) ) ;
+    BOOST_CHECK_EQUAL( loaded_ray.phase(2), ray.phase(2) ) ;
+
+    // check keys that should miss the cache
+
+    wposition1 moved( src_lat + 0.1, src_lng, -10.0 ) ;
+    const std::string other = wavefront_cache::key( ocean, moved, &targets,
+        freq, de, az, time_step, 10.0, -300.0, 999, 999 ) ;
+    eigenverb_collection missed( ocean.num_volume() ) ;
+    BOOST_CHECK( other != key ) ;
+    BOOST_CHECK( ! wavefront_cache::load( other, &freq, &missed, NULL ) ) ;
+
+    ocean.fingerprint( "" ) ;
+    BOOST_CHECK( wavefront_cache::key( ocean, source, &targets,
+        freq, de, az, time_step, 10.0, -300.0, 999, 999 ).empty() ) ;
+    wavefront_cache::directory.clear() ;
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
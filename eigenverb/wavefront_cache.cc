@@ -0,0 +1,399 @@
+/**
+ * @file wavefront_cache.cc
+ * Persistent, on-disk cache of wavefront_generator results.
+ */
+#include <usml/eigenverb/wavefront_cache.h>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/thread.hpp>
+#include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace usml::eigenverb ;
+
+namespace {
+
+/** Identifies the format of a cache entry, including its byte order. */
+const char cache_magic[8] = { 'U', 'S', 'M', 'L', 'W', 'F', 'C', '1' } ;
+
+/** Detects cache entries written on a machine with a different byte order. */
+const boost::uint64_t cache_endian = 0x0102030405060708ULL ;
+
+/** Number of fixed fields in each eigenverb record. */
+const size_t verb_fields = 20 ;
+
+/** Number of fixed fields in each eigenray record. */
+const size_t ray_fields = 10 ;
+
+/**
+ * Appends the binary representation of a value to a buffer.
+ */
+template<class T> void append( std::string* buffer, T value ) {
+	buffer->append( (const char*) &value, sizeof(T) ) ;
+}
+
+/**
+ * Appends the values of a sequence, preceded by its size, to a buffer.
+ */
+void append( std::string* buffer, const seq_vector& seq ) {
+	append( buffer, (boost::uint64_t) seq.size() ) ;
+	for ( size_t n=0 ; n < seq.size() ; ++n ) {
+		append( buffer, seq(n) ) ;
+	}
+}
+
+/**
+ * Appends the values of a vector to a buffer.
+ */
+void append( std::string* buffer, const vector<double>& data ) {
+	if ( data.size() > 0 ) {
+		buffer->append( (const char*) &data(0), data.size() * sizeof(double) ) ;
+	}
+}
+
+/**
+ * Sequential, bounds checked reader for a memory mapped cache entry.
+ * Sets the failed flag, and returns zeros, if it runs off the end.
+ */
+class cache_reader {
+public:
+	cache_reader( const char* data, size_t size ) :
+		_data(data), _size(size), _offset(0), _failed(false)
+	{}
+
+	bool failed() const {
+		return _failed ;
+	}
+
+	const char* read( size_t size ) {
+		if ( _failed || size > _size - _offset ) {
+			_failed = true ;
+			return NULL ;
+		}
+		const char* result = _data + _offset ;
+		_offset += size ;
+		return result ;
+	}
+
+	template<class T> T get() {
+		T value = T() ;
+		const char* ptr = read( sizeof(T) ) ;
+		if ( ptr ) std::memcpy( &value, ptr, sizeof(T) ) ;
+		return value ;
+	}
+
+	void get( vector<double>* data ) {
+		const size_t size = data->size() * sizeof(double) ;
+		const char* ptr = read( size ) ;
+		if ( ptr && size > 0 ) std::memcpy( &(*data)(0), ptr, size ) ;
+	}
+
+private:
+	const char* _data ;
+	size_t _size ;
+	size_t _offset ;
+	bool _failed ;
+} ;
+
+}	// end of anonymous namespace
+
+/**
+ * Directory in which cache entries are stored.
+ */
+std::string wavefront_cache::directory ;
+
+/**
+ * Builds the key that identifies a propagation run.
+ */
+std::string wavefront_cache::key( const ocean_model& ocean,
+	const wposition1& source, const wposition* targets,
+	const seq_vector& frequencies,
+	const seq_vector& de, const seq_vector& az,
+	double time_step, double time_maximum,
+	double intensity_threshold, int max_bottom, int max_surface )
+{
+	std::string result ;
+	if ( ocean.fingerprint().empty() ) return result ;
+
+	append( &result, (boost::uint64_t) ocean.fingerprint().size() ) ;
+	result += ocean.fingerprint() ;
+	append( &result, (boost::uint64_t) ocean.num_volume() ) ;
+
+	append( &result, source.latitude() ) ;
+	append( &result, source.longitude() ) ;
+	append( &result, source.altitude() ) ;
+	if ( targets ) {
+		append( &result, (boost::uint64_t) targets->size1() ) ;
+		append( &result, (boost::uint64_t) targets->size2() ) ;
+		for ( size_t r=0 ; r < targets->size1() ; ++r ) {
+			for ( size_t c=0 ; c < targets->size2() ; ++c ) {
+				append( &result, targets->latitude(r,c) ) ;
+				append( &result, targets->longitude(r,c) ) ;
+				append( &result, targets->altitude(r,c) ) ;
+			}
+		}
+	} else {
+		append( &result, (boost::uint64_t) 0 ) ;
+		append( &result, (boost::uint64_t) 0 ) ;
+	}
+
+	append( &result, frequencies ) ;
+	append( &result, de ) ;
+	append( &result, az ) ;
+	append( &result, time_step ) ;
+	append( &result, time_maximum ) ;
+	append( &result, intensity_threshold ) ;
+	append( &result, (boost::int64_t) max_bottom ) ;
+	append( &result, (boost::int64_t) max_surface ) ;
+	return result ;
+}
+
+/**
+ * Full path of the cache entry for a specific key,
+ * named after the 64 bit FNV-1a hash of the key.
+ */
+std::string wavefront_cache::filename( const std::string& key ) {
+	boost::uint64_t hash = 0xcbf29ce484222325ULL ;
+	for ( size_t n=0 ; n < key.size() ; ++n ) {
+		hash ^= (unsigned char) key[n] ;
+		hash *= 0x100000001b3ULL ;
+	}
+	std::ostringstream path ;
+	path << directory << "/wavefront_" << std::hex
+		 << std::setw(16) << std::setfill('0') << hash << ".bin" ;
+	return path.str() ;
+}
+
+/**
+ * Loads the results of a propagation run from the cache.
+ */
+bool wavefront_cache::load( const std::string& key,
+	const seq_vector* frequencies,
+	eigenverb_collection* eigenverbs,
+	eigenray_collection* eigenrays )
+{
+	if ( directory.empty() || key.empty() ) return false ;
+
+	boost::iostreams::mapped_file_source file ;
+	try {
+		file.open( filename(key) ) ;
+	} catch ( const std::exception& ) {
+		return false ;
+	}
+	if ( ! file.is_open() ) return false ;
+	cache_reader reader( file.data(), file.size() ) ;
+
+	// check that this entry was written with this format and key
+
+	const char* magic = reader.read( sizeof(cache_magic) ) ;
+	if ( ! magic || std::memcmp( magic, cache_magic, sizeof(cache_magic) ) ) {
+		return false ;
+	}
+	if ( reader.get<boost::uint64_t>() != cache_endian ) return false ;
+	const boost::uint64_t key_size = reader.get<boost::uint64_t>() ;
+	if ( key_size != key.size() ) return false ;
+	const char* stored_key = reader.read( key.size() ) ;
+	if ( ! stored_key || std::memcmp( stored_key, key.data(), key.size() ) ) {
+		return false ;
+	}
+	const size_t num_freq = (size_t) reader.get<boost::uint64_t>() ;
+	if ( num_freq != frequencies->size() ) return false ;
+
+	// read eigenverbs for each interface into temporary storage,
+	// so that a truncated file has no effect on the collections
+
+	const size_t num_interfaces = (size_t) reader.get<boost::uint64_t>() ;
+	if ( num_interfaces != eigenverbs->num_interfaces() ) return false ;
+	std::vector< std::vector<eigenverb> > verbs( num_interfaces ) ;
+	for ( size_t i=0 ; i < num_interfaces && ! reader.failed() ; ++i ) {
+		const size_t count = (size_t) reader.get<boost::uint64_t>() ;
+		if ( count > file.size() / sizeof(double) ) return false ;
+		verbs[i].resize( count ) ;
+		BOOST_FOREACH( eigenverb& verb, verbs[i] ) {
+			verb.frequencies = frequencies ;
+			verb.time = reader.get<double>() ;
+			verb.length = reader.get<double>() ;
+			verb.length2 = reader.get<double>() ;
+			verb.width = reader.get<double>() ;
+			verb.width2 = reader.get<double>() ;
+			verb.position.rho( reader.get<double>() ) ;
+			verb.position.theta( reader.get<double>() ) ;
+			verb.position.phi( reader.get<double>() ) ;
+			verb.direction = reader.get<double>() ;
+			verb.grazing = reader.get<double>() ;
+			verb.sound_speed = reader.get<double>() ;
+			verb.de_index = (size_t) reader.get<double>() ;
+			verb.az_index = (size_t) reader.get<double>() ;
+			verb.source_de = reader.get<double>() ;
+			verb.source_az = reader.get<double>() ;
+			verb.surface = (int) reader.get<double>() ;
+			verb.bottom = (int) reader.get<double>() ;
+			verb.caustic = (int) reader.get<double>() ;
+			verb.upper = (int) reader.get<double>() ;
+			verb.lower = (int) reader.get<double>() ;
+			verb.power.resize( num_freq ) ;
+			reader.get( &verb.power ) ;
+		}
+	}
+
+	// read eigenrays for each target
+
+	const size_t rows = (size_t) reader.get<boost::uint64_t>() ;
+	const size_t cols = (size_t) reader.get<boost::uint64_t>() ;
+	if ( eigenrays ) {
+		if ( rows != eigenrays->size1() || cols != eigenrays->size2() ) {
+			return false ;
+		}
+	} else if ( rows != 0 || cols != 0 ) {
+		return false ;
+	}
+	matrix< std::vector<eigenray> > rays( rows, cols ) ;
+	for ( size_t r=0 ; r < rows && ! reader.failed() ; ++r ) {
+		for ( size_t c=0 ; c < cols && ! reader.failed() ; ++c ) {
+			const size_t count = (size_t) reader.get<boost::uint64_t>() ;
+			if ( count > file.size() / sizeof(double) ) return false ;
+			rays(r,c).resize( count ) ;
+			BOOST_FOREACH( eigenray& ray, rays(r,c) ) {
+				ray.frequencies = frequencies ;
+				ray.time = reader.get<double>() ;
+				ray.source_de = reader.get<double>() ;
+				ray.source_az = reader.get<double>() ;
+				ray.target_de = reader.get<double>() ;
+				ray.target_az = reader.get<double>() ;
+				ray.surface = (int) reader.get<double>() ;
+				ray.bottom = (int) reader.get<double>() ;
+				ray.caustic = (int) reader.get<double>() ;
+				ray.upper = (int) reader.get<double>() ;
+				ray.lower = (int) reader.get<double>() ;
+				ray.intensity.resize( num_freq ) ;
+				ray.phase.resize( num_freq ) ;
+				reader.get( &ray.intensity ) ;
+				reader.get( &ray.phase ) ;
+			}
+		}
+	}
+	if ( reader.failed() ) return false ;
+
+	// copy results into the collections
+
+	for ( size_t i=0 ; i < num_interfaces ; ++i ) {
+		BOOST_FOREACH( const eigenverb& verb, verbs[i] ) {
+			eigenverbs->add_eigenverb( verb, i ) ;
+		}
+	}
+	for ( size_t r=0 ; r < rows ; ++r ) {
+		for ( size_t c=0 ; c < cols ; ++c ) {
+			BOOST_FOREACH( const eigenray& ray, rays(r,c) ) {
+				eigenrays->add_eigenray( r, c, ray, 0 ) ;
+			}
+		}
+	}
+	return true ;
+}
+
+/**
+ * Stores the results of a propagation run in the cache.
+ */
+void wavefront_cache::store( const std::string& key,
+	const eigenverb_collection& eigenverbs,
+	eigenray_collection* eigenrays )
+{
+	if ( directory.empty() || key.empty() ) return ;
+
+	// find the number of frequencies from the first result
+
+	size_t num_freq = 0 ;
+	if ( eigenrays ) {
+		num_freq = eigenrays->frequencies()->size() ;
+	} else {
+		for ( size_t i=0 ; i < eigenverbs.num_interfaces() ; ++i ) {
+			if ( ! eigenverbs.eigenverbs(i).empty() ) {
+				num_freq = eigenverbs.eigenverbs(i).front().power.size() ;
+				break ;
+			}
+		}
+	}
+
+	// build entry in memory
+
+	std::string buffer ;
+	buffer.append( cache_magic, sizeof(cache_magic) ) ;
+	append( &buffer, cache_endian ) ;
+	append( &buffer, (boost::uint64_t) key.size() ) ;
+	buffer += key ;
+	append( &buffer, (boost::uint64_t) num_freq ) ;
+
+	append( &buffer, (boost::uint64_t) eigenverbs.num_interfaces() ) ;
+	for ( size_t i=0 ; i < eigenverbs.num_interfaces() ; ++i ) {
+		const eigenverb_list& list = eigenverbs.eigenverbs(i) ;
+		append( &buffer, (boost::uint64_t) list.size() ) ;
+		BOOST_FOREACH( const eigenverb& verb, list ) {
+			if ( verb.power.size() != num_freq ) return ;
+			const double fields[verb_fields] = {
+				verb.time, verb.length, verb.length2, verb.width, verb.width2,
+				verb.position.rho(), verb.position.theta(),
+				verb.position.phi(), verb.direction, verb.grazing,
+				verb.sound_speed, (double) verb.de_index,
+				(double) verb.az_index, verb.source_de, verb.source_az,
+				(double) verb.surface, (double) verb.bottom,
+				(double) verb.caustic, (double) verb.upper,
+				(double) verb.lower } ;
+			buffer.append( (const char*) fields, sizeof(fields) ) ;
+			append( &buffer, verb.power ) ;
+		}
+	}
+
+	if ( eigenrays ) {
+		append( &buffer, (boost::uint64_t) eigenrays->size1() ) ;
+		append( &buffer, (boost::uint64_t) eigenrays->size2() ) ;
+		for ( size_t r=0 ; r < eigenrays->size1() ; ++r ) {
+			for ( size_t c=0 ; c < eigenrays->size2() ; ++c ) {
+				const eigenray_list& list = *eigenrays->eigenrays(r,c) ;
+				append( &buffer, (boost::uint64_t) list.size() ) ;
+				BOOST_FOREACH( const eigenray& ray, list ) {
+					if ( ray.intensity.size() != num_freq
+					  || ray.phase.size() != num_freq ) return ;
+					const double fields[ray_fields] = {
+						ray.time, ray.source_de, ray.source_az,
+						ray.target_de, ray.target_az,
+						(double) ray.surface, (double) ray.bottom,
+						(double) ray.caustic, (double) ray.upper,
+						(double) ray.lower } ;
+					buffer.append( (const char*) fields, sizeof(fields) ) ;
+					append( &buffer, ray.intensity ) ;
+					append( &buffer, ray.phase ) ;
+				}
+			}
+		}
+	} else {
+		append( &buffer, (boost::uint64_t) 0 ) ;
+		append( &buffer, (boost::uint64_t) 0 ) ;
+	}
+
+	// write to a temporary file, then rename it into place,
+	// so that readers never see a partial entry
+
+	const std::string path = filename( key ) ;
+	std::ostringstream temp ;
+	temp << path << "." << boost::this_thread::get_id() << ".tmp" ;
+	{
+		std::ofstream os( temp.str().c_str(), std::ios::binary ) ;
+		if ( ! os ) return ;
+		os.write( buffer.data(), (std::streamsize) buffer.size() ) ;
+		if ( ! os ) {
+			os.close() ;
+			std::remove( temp.str().c_str() ) ;
+			return ;
+		}
+	}
+	if ( std::rename( temp.str().c_str(), path.c_str() ) != 0 ) {
+		std::remove( path.c_str() ) ;
+		if ( std::rename( temp.str().c_str(), path.c_str() ) != 0 ) {
+			std::remove( temp.str().c_str() ) ;
+		}
+	}
+}
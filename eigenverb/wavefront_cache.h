@@ -0,0 +1,130 @@
+/**
+ * @file wavefront_cache.h
+ * Persistent, on-disk cache of wavefront_generator results.
+ */
+#pragma once
+
+#include <usml/ocean/ocean_model.h>
+#include <usml/waveq3d/eigenray_collection.h>
+#include <usml/eigenverb/eigenverb_collection.h>
+#include <string>
+
+namespace usml {
+namespace eigenverb {
+
+using namespace usml::ocean ;
+using namespace usml::waveq3d ;
+using namespace usml::types ;
+
+/// @ingroup eigenverb
+/// @{
+
+/**
+ * Persistent, on-disk cache of the eigenverbs and eigenrays computed by
+ * the wavefront_generator.  Allows a restarted service to reload the
+ * results of earlier propagations, instead of re-computing them,
+ * when the ocean and sensor geometry have not changed.
+ *
+ * Each entry is addressed by a key that records every input to the
+ * propagation: the ocean's fingerprint and number of volume layers,
+ * the source and target positions, the frequencies, the launch angles
+ * of the ray fan, and the time step, duration, and threshold settings.
+ * The file name is a 64 bit hash of this key, and the full key is also
+ * stored in the file, so that a hash collision is treated as a miss.
+ * Oceans without a fingerprint() are never cached, because there
+ * is no way to tell if their inputs have changed.
+ *
+ * Entries are stored in a compact binary format made up of 64 bit
+ * integers and doubles, in native byte order, with fixed size records
+ * for each eigenverb and eigenray.  Files are read through a read-only
+ * memory map, so that loading is limited by I/O instead of parsing.
+ * Entries are written to a temporary file and then renamed into place,
+ * so readers never see a partial entry.  Unreadable, truncated,
+ * or mismatched files are treated as misses.
+ *
+ * The cache is disabled until a directory is defined.  The directory
+ * should be set before any wavefront_generator tasks are started.
+ */
+class USML_DECLSPEC wavefront_cache {
+
+public:
+
+    /**
+     * Directory in which cache entries are stored.  Caching is
+     * disabled if this is empty, which is the default.
+     */
+    static std::string directory ;
+
+    /**
+     * Builds the key that identifies a propagation run.
+     *
+     * @param ocean         Ocean used to propagate the wavefront.
+     * @param source        Location of the source.
+     * @param targets       Location of the targets, NULL if none.
+     * @param frequencies   Frequencies used to compute eigenrays
+     *                      and eigenverbs (Hz).
+     * @param de            Launch D/E angles of the ray fan (degrees).
+     * @param az            Launch AZ angles of the ray fan (degrees).
+     * @param time_step     Propagation step size (sec).
+     * @param time_maximum  Duration of the propagation (sec).
+     * @param intensity_threshold   Minimum intensity of results (dB).
+     * @param max_bottom    Maximum number of bottom bounces.
+     * @param max_surface   Maximum number of surface bounces.
+     * @return              Binary key, or an empty string if this
+     *                      run can not be cached.
+     */
+    static std::string key( const ocean_model& ocean,
+        const wposition1& source, const wposition* targets,
+        const seq_vector& frequencies,
+        const seq_vector& de, const seq_vector& az,
+        double time_step, double time_maximum,
+        double intensity_threshold, int max_bottom, int max_surface ) ;
+
+    /**
+     * Loads the results of a propagation run from the cache.
+     * The collections must be newly constructed with the same
+     * targets and number of volume layers used to build the key.
+     *
+     * @param key           Key built by the key() method.
+     * @param frequencies   Frequencies to attach to each eigenray and
+     *                      eigenverb.  Must outlive the results.
+     * @param eigenverbs    Collection that stores eigenverbs (output).
+     * @param eigenrays     Collection that stores eigenrays (output),
+     *                      NULL if the run has no targets.
+     * @return              False if this key is not in the cache.
+     */
+    static bool load( const std::string& key,
+        const seq_vector* frequencies,
+        eigenverb_collection* eigenverbs,
+        eigenray_collection* eigenrays ) ;
+
+    /**
+     * Stores the results of a propagation run in the cache.
+     * Failures are silently ignored, because the results can
+     * always be re-computed.
+     *
+     * @param key           Key built by the key() method.
+     * @param eigenverbs    Eigenverbs computed by this run.
+     * @param eigenrays     Eigenrays computed by this run,
+     *                      NULL if the run has no targets.
+     */
+    static void store( const std::string& key,
+        const eigenverb_collection& eigenverbs,
+        eigenray_collection* eigenrays ) ;
+
+private:
+
+    /**
+     * Full path of the cache entry for a specific key.
+     */
+    static std::string filename( const std::string& key ) ;
+
+    /**
+     * Hide constructor because this class only has static members.
+     */
+    wavefront_cache() {}
+} ;
+
+/// @}
+}   // end of namespace eigenverb
+}   // end of namespace usml
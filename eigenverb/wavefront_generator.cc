@@ -4,6 +4,8 @@
  */
 
 #include <usml/eigenverb/wavefront_generator.h>
+#include <usml/eigenverb/wavefront_cache.h>
+#include <usml/waveq3d/wave_profiler.h>
 
 using namespace usml::eigenverb;
 
@@ -43,6 +45,7 @@ wavefront_generator::wavefront_generator(shared_ptr<ocean_model> ocean,
  * Executes the WaveQ3D propagation model.
  */
 void wavefront_generator::run() {
+	wave_profiler::scoped_timer timer( wave_profiler::WAVEFRONT_TASK ) ;
 
 	// check to see if task has already been aborted
 
@@ -59,13 +62,6 @@ void wavefront_generator::run() {
 	double az_increment = 360.0 / _number_az;
 	seq_linear az(0.0, az_increment, 359.9);
 
-	wave_queue wave(
-		*(_ocean.get()), *(_frequencies), _source_position, de, az,
-		_time_step, _target_positions, _run_id);
-	wave.intensity_threshold(intensity_threshold);
-	wave.max_bottom(max_bottom);
-	wave.max_surface(max_surface);
-
 	// create listener to store eigenrays
 
 	eigenray_collection::reference eigenrays ;
@@ -73,23 +69,40 @@ void wavefront_generator::run() {
 		eigenrays.reset( new eigenray_collection(
 			*_frequencies, _source_position,
 			de, az, _time_step, _target_positions) ) ;
-		wave.add_eigenray_listener(eigenrays.get());
 	}
 
 	// create listener to store eigenverbs
 
 	eigenverb_collection::reference eigenverbs(
 			new eigenverb_collection(_ocean.get()->num_volume()) ) ;
-	wave.add_eigenverb_listener( eigenverbs.get() );
-
-	// propagate wavefront to build eigenrays and eigenverbs
 
-	while (wave.time() < _time_maximum) {
-		wave.step();
-		if (_abort) {
-			cout << id() << " WaveQ3D   *** aborted during execution ***" << endl;
-			return;
+	// re-use results from an earlier run with the same inputs,
+	// otherwise propagate wavefront to build eigenrays and eigenverbs
+
+	const std::string cache_key = wavefront_cache::key( *_ocean,
+		_source_position, _target_positions, *_frequencies, de, az,
+		_time_step, _time_maximum, intensity_threshold,
+		max_bottom, max_surface ) ;
+	if ( ! wavefront_cache::load( cache_key, _frequencies,
+			eigenverbs.get(), eigenrays.get() ) )
+	{
+		wave_queue wave(
+			*(_ocean.get()), *(_frequencies), _source_position, de, az,
+			_time_step, _target_positions, _run_id);
+		wave.intensity_threshold(intensity_threshold);
+		wave.max_bottom(max_bottom);
+		wave.max_surface(max_surface);
+		if ( eigenrays ) wave.add_eigenray_listener(eigenrays.get());
+		wave.add_eigenverb_listener( eigenverbs.get() );
+
+		while (wave.time() < _time_maximum) {
+			wave.step();
+			if (_abort) {
+				cout << id() << " WaveQ3D   *** aborted during execution ***" << endl;
+				return;
+			}
 		}
+		wavefront_cache::store( cache_key, *eigenverbs, eigenrays.get() ) ;
 	}
 	if ( eigenrays != NULL ) eigenrays->sum_eigenrays();
 
@@ -48,6 +48,11 @@ using namespace usml::types ;
  *  wavefront_generator::max_bottom = 999;             // Max number of bottom bounces.
  *  wavefront_generator::max_surface = 999;            // Max number of surface bounces.
  * </pre>
+ *
+ * If the wavefront_cache is enabled, and the ocean has a fingerprint,
+ * the run() method re-uses the results of an earlier run with the
+ * same inputs instead of propagating a new wavefront.  New results
+ * are stored in this cache when the propagation completes.
  */
 
 class USML_DECLSPEC wavefront_generator : public thread_task
@@ -25,3 +25,25 @@ void attenuation_constant::attenuation(
         }
     }
 }
+
+/**
+ * Computes the broadband absorption loss of sea water into a
+ * contiguous spectral_matrix.
+ */
+void attenuation_constant::attenuation(
+    const wposition& location,
+    const seq_vector& frequencies,
+    const matrix<double>& distance,
+    spectral_matrix* attenuation )
+{
+    const size_t num_freq = frequencies.size() ;
+    double* out = attenuation->data().data().begin() ;
+    for ( size_t row=0 ; row < location.size1() ; ++row ) {
+        for ( size_t col=0 ; col < location.size2() ; ++col ) {
+            const double scale = _coefficient * distance(row,col) ;
+            for ( size_t f=0 ; f < num_freq ; ++f ) {
+                *out++ = scale * frequencies(f) ;
+            }
+        }
+    }
+}
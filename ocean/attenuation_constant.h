@@ -47,6 +47,21 @@ class USML_DECLSPEC attenuation_constant : public attenuation_model {
         const seq_vector& frequencies,
         const matrix<double>& distance,
         matrix< vector<double> >* attenuation ) ;
+
+    /**
+     * Computes the broadband absorption loss of sea water into a
+     * contiguous spectral_matrix.
+     *
+     * @param location      Location at which to compute attenuation.
+     * @param frequencies   Frequencies over which to compute loss. (Hz)
+     * @param distance      Distance travelled through the water (meters).
+     * @param attenuation   Absorption loss of sea water in dB (output).
+     */
+    virtual void attenuation( 
+        const wposition& location, 
+        const seq_vector& frequencies,
+        const matrix<double>& distance,
+        spectral_matrix* attenuation ) ;
         
 } ;
 
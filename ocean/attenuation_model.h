@@ -43,6 +43,41 @@ public:
         const matrix<double>& distance,
         matrix< vector<double> >* attenuation ) = 0 ;
 
+    /**
+     * Computes the broadband absorption loss of sea water into a
+     * contiguous spectral_matrix.  Used by the wavefront propagator
+     * to avoid one heap allocation per ray.  The default implementation
+     * copies the results of the matrix of vectors form, so that older
+     * models continue to work.  Models should override it
+     * to write directly into the spectral_matrix.
+     *
+     * @param location      Location at which to compute attenuation.
+     * @param frequencies   Frequencies over which to compute loss. (Hz)
+     * @param distance      Distance travelled through the water (meters).
+     * @param attenuation   Absorption loss of sea water in dB (output).
+     */
+    virtual void attenuation(
+        const wposition& location,
+        const seq_vector& frequencies,
+        const matrix<double>& distance,
+        spectral_matrix* attenuation )
+    {
+        const size_t rows = location.size1() ;
+        const size_t cols = location.size2() ;
+        matrix< vector<double> > loss( rows, cols ) ;
+        for ( size_t row=0 ; row < rows ; ++row ) {
+            for ( size_t col=0 ; col < cols ; ++col ) {
+                loss(row,col).resize( frequencies.size() ) ;
+            }
+        }
+        this->attenuation( location, frequencies, distance, &loss ) ;
+        for ( size_t row=0 ; row < rows ; ++row ) {
+            for ( size_t col=0 ; col < cols ; ++col ) {
+                (*attenuation)(row,col) = loss(row,col) ;
+            }
+        }
+    }
+
     /**
      * Virtual destructor
      */
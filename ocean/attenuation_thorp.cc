@@ -8,15 +8,9 @@
 using namespace usml::ocean;
 
 /**
- * Computes the broadband absorption loss of sea water.
+ * Computes Thorp attenuation coefficients at the reference depth.
  */
-void attenuation_thorp::attenuation(
-        const wposition& location,
-        const seq_vector& frequencies,
-        const matrix<double>& distance,
-        matrix< vector<double> >* attenuation) {
-
-	// initialize the cache for the attenuation coefficients
+vector<double> attenuation_thorp::coefficients( const seq_vector& frequencies ) {
     vector <double> alpha(frequencies.size());
     for (size_t f = 0; f < frequencies.size(); ++f) {
 		double F2 = frequencies(f);
@@ -26,6 +20,21 @@ void attenuation_thorp::attenuation(
 			+ 44.0 / (4100.0 + F2) + 3.0e-4))
 			/ (1.0 - 5.88264e-6 * 1000.0);
     }
+    return alpha ;
+}
+
+/**
+ * Computes the broadband absorption loss of sea water.
+ */
+void attenuation_thorp::attenuation(
+        const wposition& location,
+        const seq_vector& frequencies,
+        const matrix<double>& distance,
+        matrix< vector<double> >* attenuation) {
+
+	// initialize the cache for the attenuation coefficients
+    const vector<double> alpha = coefficients( frequencies ) ;
+
     // apply attenuation coefficients and depth corrections
     for (size_t row = 0; row < location.size1(); ++row) {
         for (size_t col = 0; col < location.size2(); ++col) {
@@ -36,3 +45,29 @@ void attenuation_thorp::attenuation(
         }
     }
 }
+
+/**
+ * Computes the broadband absorption loss of sea water into a
+ * contiguous spectral_matrix.
+ */
+void attenuation_thorp::attenuation(
+        const wposition& location,
+        const seq_vector& frequencies,
+        const matrix<double>& distance,
+        spectral_matrix* attenuation) {
+
+    const vector<double> alpha = coefficients( frequencies ) ;
+    const size_t num_freq = frequencies.size() ;
+    double* out = attenuation->data().data().begin() ;
+
+    // apply attenuation coefficients and depth corrections
+    for (size_t row = 0; row < location.size1(); ++row) {
+        for (size_t col = 0; col < location.size2(); ++col) {
+            const double dist = distance(row, col) ;
+            const double depth = 1.0 + 5.88264e-6 * location.altitude(row, col) ;
+            for (size_t f = 0; f < num_freq; ++f) {
+                *out++ = dist * alpha(f) * depth ;
+            }
+        }
+    }
+}
@@ -0,0 +1,399 @@
+/**
+ * @file bathy_tile_cache.cc
+ * Bathymetry grid that loads fixed-size tiles on demand from a
+ * memory mapped file.
+ */
+#include <usml/ocean/bathy_tile_cache.h>
+#include <boost/cstdint.hpp>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace usml::ocean ;
+
+namespace {
+
+/** Identifies the format of a tiled bathymetry file. */
+const char tile_magic[8] = { 'U', 'S', 'M', 'L', 'B', 'T', 'Y', '1' } ;
+
+/** Detects files written on a machine with a different byte order. */
+const boost::uint64_t tile_endian = 0x0102030405060708ULL ;
+
+/** Number of bytes in the file header. */
+const size_t header_size = 72 ;
+
+/** Number of bicubic coefficients in each cell. */
+const size_t cell_size = 16 ;
+
+}	// end of anonymous namespace
+
+/**
+ * Number of nodes along each side of a tile.
+ */
+size_t bathy_tile_cache::default_tile_size = 128 ;
+
+/**
+ * Maximum memory used for tile coefficients (bytes).
+ */
+size_t bathy_tile_cache::default_memory_budget = 256 * 1024 * 1024 ;
+
+/**
+ * Writes a bathymetry grid to a tiled file.
+ */
+void bathy_tile_cache::write( const char* filename,
+	const data_grid<double,2>& grid, size_t tile_size )
+{
+	// check that axes are uniformly spaced
+
+	size_t size[2] ;
+	double first[2] ;
+	double inc[2] ;
+	for ( size_t dim=0 ; dim < 2 ; ++dim ) {
+		const seq_vector& ax = *grid.axis(dim) ;
+		size[dim] = ax.size() ;
+		if ( size[dim] < 2 ) {
+			throw std::invalid_argument( "bathymetry axis too short" ) ;
+		}
+		first[dim] = ax(0) ;
+		inc[dim] = ( ax(size[dim]-1) - ax(0) ) / ( size[dim] - 1 ) ;
+		for ( size_t n=0 ; n < size[dim]-1 ; ++n ) {
+			if ( abs( ax.increment(n) - inc[dim] ) > 1e-6 * abs(inc[dim]) ) {
+				throw std::invalid_argument(
+					"bathymetry axis must be uniformly spaced" ) ;
+			}
+		}
+	}
+	if ( tile_size < 2 ) tile_size = 2 ;
+
+	// write header
+
+	std::ofstream os( filename, std::ios::binary ) ;
+	if ( ! os ) {
+		throw std::invalid_argument( "can not create tiled bathymetry file" ) ;
+	}
+	const boost::uint64_t header_ints[4] = {
+		tile_endian, size[0], size[1], tile_size } ;
+	const double header_axes[4] = { first[0], inc[0], first[1], inc[1] } ;
+	os.write( tile_magic, sizeof(tile_magic) ) ;
+	os.write( (const char*) header_ints, sizeof(header_ints) ) ;
+	os.write( (const char*) header_axes, sizeof(header_axes) ) ;
+
+	// write nodes one tile at a time, replicating the last row and column
+	// of the grid into the unused part of the tiles along the edges
+
+	const size_t num_tiles0 = ( size[0] + tile_size - 1 ) / tile_size ;
+	const size_t num_tiles1 = ( size[1] + tile_size - 1 ) / tile_size ;
+	std::vector<double> buffer( tile_size * tile_size ) ;
+	size_t index[2] ;
+	for ( size_t t0=0 ; t0 < num_tiles0 ; ++t0 ) {
+		for ( size_t t1=0 ; t1 < num_tiles1 ; ++t1 ) {
+			double* ptr = &buffer[0] ;
+			for ( size_t r=0 ; r < tile_size ; ++r ) {
+				index[0] = min( t0 * tile_size + r, size[0]-1 ) ;
+				for ( size_t c=0 ; c < tile_size ; ++c ) {
+					index[1] = min( t1 * tile_size + c, size[1]-1 ) ;
+					*ptr++ = grid.data( index ) ;
+				}
+			}
+			os.write( (const char*) &buffer[0],
+				(std::streamsize) ( buffer.size() * sizeof(double) ) ) ;
+		}
+	}
+	if ( ! os ) {
+		throw std::invalid_argument( "can not write tiled bathymetry file" ) ;
+	}
+}
+
+/**
+ * Maps a tiled bathymetry file into memory.
+ */
+bathy_tile_cache::bathy_tile_cache( const char* filename, size_t memory_budget ) :
+	_data(NULL), _num_loaded(0), _clock(0)
+{
+	try {
+		_file.open( filename ) ;
+	} catch ( const std::exception& ) {
+		throw std::invalid_argument( "can not open tiled bathymetry file" ) ;
+	}
+
+	// decode header
+
+	const char* ptr = _file.data() ;
+	boost::uint64_t header_ints[4] ;
+	double header_axes[4] ;
+	if ( _file.size() < header_size
+	  || std::memcmp( ptr, tile_magic, sizeof(tile_magic) ) )
+	{
+		throw std::invalid_argument( "not a tiled bathymetry file" ) ;
+	}
+	std::memcpy( header_ints, ptr + sizeof(tile_magic), sizeof(header_ints) ) ;
+	std::memcpy( header_axes, ptr + sizeof(tile_magic) + sizeof(header_ints),
+		sizeof(header_axes) ) ;
+	if ( header_ints[0] != tile_endian ) {
+		throw std::invalid_argument( "tiled bathymetry has wrong byte order" ) ;
+	}
+	_size[0] = (size_t) header_ints[1] ;
+	_size[1] = (size_t) header_ints[2] ;
+	_tile_size = (size_t) header_ints[3] ;
+	if ( _size[0] < 2 || _size[1] < 2 || _tile_size < 2 ) {
+		throw std::invalid_argument( "tiled bathymetry header is corrupt" ) ;
+	}
+	for ( size_t dim=0 ; dim < 2 ; ++dim ) {
+		_num_tiles[dim] = ( _size[dim] + _tile_size - 1 ) / _tile_size ;
+		_axis[dim].reset( new seq_linear( header_axes[2*dim],
+			header_axes[2*dim+1], (int) _size[dim] ) ) ;
+	}
+	const size_t tile_nodes = _tile_size * _tile_size ;
+	if ( _file.size() < header_size
+		+ _num_tiles[0] * _num_tiles[1] * tile_nodes * sizeof(double) )
+	{
+		throw std::invalid_argument( "tiled bathymetry file is truncated" ) ;
+	}
+	_data = (const double*) ( ptr + header_size ) ;
+
+	// size the cache
+
+	_max_tiles = max( (size_t) 1,
+		memory_budget / ( tile_nodes * cell_size * sizeof(double) ) ) ;
+	_tiles.resize( _num_tiles[0] * _num_tiles[1] ) ;
+}
+
+/**
+ * Number of tiles currently in memory.
+ */
+size_t bathy_tile_cache::num_tiles() const {
+	read_lock_guard guard( _mutex ) ;
+	return _num_loaded ;
+}
+
+/**
+ * Value of a node in the grid.
+ */
+double bathy_tile_cache::node( size_t row, size_t col ) const {
+	const size_t t0 = row / _tile_size ;
+	const size_t t1 = col / _tile_size ;
+	return _data[ ( t0 * _num_tiles[1] + t1 ) * _tile_size * _tile_size
+		+ ( row - t0 * _tile_size ) * _tile_size + ( col - t1 * _tile_size ) ] ;
+}
+
+/**
+ * Finds the interval that contains a location.
+ */
+size_t bathy_tile_cache::find_cell( size_t dim, double location,
+	double* offset ) const
+{
+	const seq_linear& ax = *_axis[dim] ;
+	double u = ( location - ax(0) ) / ax.increment(0) ;
+	const double last = (double) ( _size[dim] - 1 ) ;
+	if ( u <= 0.0 ) {
+		u = 0.0 ;
+	} else if ( u >= last ) {
+		u = last ;
+	}
+	size_t cell = (size_t) floor( u ) ;
+	if ( cell > _size[dim] - 2 ) cell = _size[dim] - 2 ;
+	*offset = u - (double) cell ;
+	return cell ;
+}
+
+/**
+ * Interpolates the bathymetry at a single location.
+ */
+double bathy_tile_cache::interpolate( enum GRID_INTERP_TYPE type,
+	const double* location, double* derivative ) const
+{
+	double u[2] ;
+	const size_t k0 = find_cell( 0, location[0], &u[0] ) ;
+	const size_t k1 = find_cell( 1, location[1], &u[1] ) ;
+
+	switch ( type ) {
+
+	case GRID_INTERP_NEAREST:
+		if ( derivative ) derivative[0] = derivative[1] = 0.0 ;
+		return node( ( u[0] < 0.5 ) ? k0 : k0+1, ( u[1] < 0.5 ) ? k1 : k1+1 ) ;
+
+	case GRID_INTERP_LINEAR:
+		{
+			const double f11 = node( k0, k1 ) ;
+			const double f21 = node( k0+1, k1 ) ;
+			const double f12 = node( k0, k1+1 ) ;
+			const double f22 = node( k0+1, k1+1 ) ;
+			if ( derivative ) {
+				derivative[0] = ( ( f21 - f11 ) * ( 1.0 - u[1] )
+					+ ( f22 - f12 ) * u[1] ) / _axis[0]->increment(0) ;
+				derivative[1] = ( ( f12 - f11 ) * ( 1.0 - u[0] )
+					+ ( f22 - f21 ) * u[0] ) / _axis[1]->increment(0) ;
+			}
+			return f11 * ( 1.0 - u[0] ) * ( 1.0 - u[1] )
+				+ f21 * u[0] * ( 1.0 - u[1] )
+				+ f12 * ( 1.0 - u[0] ) * u[1]
+				+ f22 * u[0] * u[1] ;
+		}
+
+	case GRID_INTERP_PCHIP:
+		{
+			const size_t t0 = k0 / _tile_size ;
+			const size_t t1 = k1 / _tile_size ;
+			tile_reference t = find_tile( t0, t1 ) ;
+			const double* a = &t->coeff[ cell_size * (
+				( k0 - t0 * _tile_size ) * _tile_size + ( k1 - t1 * _tile_size ) ) ] ;
+
+			// powers of the location within this cell
+
+			const double x[4] = { 1.0, u[0], u[0]*u[0], u[0]*u[0]*u[0] } ;
+			const double y[4] = { 1.0, u[1], u[1]*u[1], u[1]*u[1]*u[1] } ;
+
+			double result = 0.0 ;
+			for ( size_t i=0 ; i < 4 ; ++i ) {
+				for ( size_t j=0 ; j < 4 ; ++j ) {
+					result += a[4*i+j] * x[i] * y[j] ;
+				}
+			}
+			if ( derivative ) {
+				derivative[0] = derivative[1] = 0.0 ;
+				for ( size_t i=1 ; i < 4 ; ++i ) {
+					for ( size_t j=0 ; j < 4 ; ++j ) {
+						derivative[0] += i * a[4*i+j] * x[i-1] * y[j] ;
+					}
+				}
+				for ( size_t i=0 ; i < 4 ; ++i ) {
+					for ( size_t j=1 ; j < 4 ; ++j ) {
+						derivative[1] += j * a[4*i+j] * x[i] * y[j-1] ;
+					}
+				}
+				derivative[0] /= _axis[0]->increment(0) ;
+				derivative[1] /= _axis[1]->increment(0) ;
+			}
+			return result ;
+		}
+
+	default:
+		throw std::invalid_argument( "Interp must be NEAREST, LINEAR, or PCHIP" ) ;
+	}
+}
+
+/**
+ * Retrieves the coefficient table for a tile.
+ */
+bathy_tile_cache::tile_reference bathy_tile_cache::find_tile(
+	size_t tile_row, size_t tile_col ) const
+{
+	const size_t index = tile_row * _num_tiles[1] + tile_col ;
+
+	// cache hits only need a shared lock
+
+	{
+		read_lock_guard guard( _mutex ) ;
+		tile_reference t = _tiles[index] ;
+		if ( t ) {
+			t->last_used = ++_clock ;
+			return t ;
+		}
+	}
+
+	// build the new tile without holding the lock, so that other
+	// threads can continue to use the tiles that are already loaded
+
+	tile_reference t = build_tile( tile_row, tile_col ) ;
+
+	write_lock_guard guard( _mutex ) ;
+	if ( _tiles[index] ) {		// another thread got here first
+		t = _tiles[index] ;
+		t->last_used = ++_clock ;
+		return t ;
+	}
+	if ( _num_loaded >= _max_tiles ) {
+		size_t oldest = 0 ;
+		size_t oldest_time = 0 ;
+		bool found = false ;
+		for ( size_t n=0 ; n < _tiles.size() ; ++n ) {
+			if ( _tiles[n] && ( ! found || _tiles[n]->last_used < oldest_time ) ) {
+				oldest = n ;
+				oldest_time = _tiles[n]->last_used ;
+				found = true ;
+			}
+		}
+		if ( found ) {
+			_tiles[oldest].reset() ;
+			--_num_loaded ;
+		}
+	}
+	t->last_used = ++_clock ;
+	_tiles[index] = t ;
+	++_num_loaded ;
+	return t ;
+}
+
+/**
+ * Builds the coefficient table for a tile.  Uses centered differences,
+ * in units of the axis increment, for the derivatives at each node,
+ * and one-sided differences along the edges of the grid, like
+ * data_grid_bathy.  Converts the values and derivatives at the corners
+ * of each cell into bicubic coefficients using \f$ a = A F A^T \f$, where
+ * A is the matrix of cubic Hermite basis coefficients.
+ */
+bathy_tile_cache::tile_reference bathy_tile_cache::build_tile(
+	size_t tile_row, size_t tile_col ) const
+{
+	static const double A[4][4] = {
+		{ 1.0,  0.0,  0.0,  0.0 },
+		{ 0.0,  0.0,  1.0,  0.0 },
+		{-3.0,  3.0, -2.0, -1.0 },
+		{ 2.0, -2.0,  1.0,  1.0 } } ;
+
+	tile* result = new tile ;
+	result->coeff.resize( _tile_size * _tile_size * cell_size, 0.0 ) ;
+
+	const size_t first0 = tile_row * _tile_size ;
+	const size_t first1 = tile_col * _tile_size ;
+	const size_t last0 = min( first0 + _tile_size, _size[0] - 1 ) ;
+	const size_t last1 = min( first1 + _tile_size, _size[1] - 1 ) ;
+
+	for ( size_t k0=first0 ; k0 < last0 ; ++k0 ) {
+		for ( size_t k1=first1 ; k1 < last1 ; ++k1 ) {
+
+			// values and derivatives at the corners of this cell
+
+			double F[4][4] ;
+			for ( size_t i=0 ; i < 2 ; ++i ) {
+				const size_t r = k0 + i ;
+				const size_t rm = ( r > 0 ) ? r-1 : r ;
+				const size_t rp = ( r < _size[0]-1 ) ? r+1 : r ;
+				for ( size_t j=0 ; j < 2 ; ++j ) {
+					const size_t c = k1 + j ;
+					const size_t cm = ( c > 0 ) ? c-1 : c ;
+					const size_t cp = ( c < _size[1]-1 ) ? c+1 : c ;
+					F[i][j] = node( r, c ) ;
+					F[i+2][j] = ( node(rp,c) - node(rm,c) ) / 2.0 ;
+					F[i][j+2] = ( node(r,cp) - node(r,cm) ) / 2.0 ;
+					F[i+2][j+2] = ( node(rp,cp) - node(rp,cm)
+						- node(rm,cp) + node(rm,cm) ) / 4.0 ;
+				}
+			}
+
+			// bicubic coefficients a = A * F * A'
+
+			double AF[4][4] ;
+			for ( size_t i=0 ; i < 4 ; ++i ) {
+				for ( size_t j=0 ; j < 4 ; ++j ) {
+					AF[i][j] = 0.0 ;
+					for ( size_t k=0 ; k < 4 ; ++k ) {
+						AF[i][j] += A[i][k] * F[k][j] ;
+					}
+				}
+			}
+			double* a = &result->coeff[ cell_size * (
+				( k0 - first0 ) * _tile_size + ( k1 - first1 ) ) ] ;
+			for ( size_t i=0 ; i < 4 ; ++i ) {
+				for ( size_t j=0 ; j < 4 ; ++j ) {
+					double sum = 0.0 ;
+					for ( size_t k=0 ; k < 4 ; ++k ) {
+						sum += AF[i][k] * A[j][k] ;
+					}
+					a[4*i+j] = sum ;
+				}
+			}
+		}
+	}
+	return tile_reference( result ) ;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file bathy_tile_cache.h
+ * Bathymetry grid that loads fixed-size tiles on demand from a
+ * memory mapped file.
+ */
+#pragma once
+
+#include <usml/types/data_grid.h>
+#include <usml/types/seq_linear.h>
+#include <usml/threads/read_write_lock.h>
+#include <usml/threads/smart_ptr.h>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace usml {
+namespace ocean {
+
+using namespace usml::types ;
+using namespace usml::threads ;
+
+/// @ingroup boundaries
+/// @{
+
+/**
+ * Bathymetry grid that loads fixed-size tiles on demand from a
+ * memory mapped file.  Designed for world-wide databases, like ETOPO1
+ * at 1 arc-minute resolution, that are too large to load into a
+ * data_grid_bathy.  Startup only maps the file, and memory use is
+ * bounded by a configurable budget, no matter how large the database is.
+ *
+ * The file is written once, using the write() method, from an existing
+ * 2-D data_grid in the same (colatitude, longitude) spherical earth
+ * coordinates that netcdf_bathy produces.  Both axes must be uniformly
+ * spaced.  The grid is broken into square tiles of nodes, and each tile
+ * is stored contiguously, so that the nodes of a tile share a few pages
+ * of the memory mapped file.
+ *
+ * The first query in each tile converts the tile into a table of bicubic
+ * coefficients for every cell in that tile, using the same finite
+ * difference derivatives, and Hermite polynomials, as the
+ * GRID_INTERP_PCHIP method of data_grid_bathy.  After that, each PCHIP
+ * interpolation is a single polynomial evaluation.  Coefficient tables
+ * are kept in a cache with a least recently used replacement policy,
+ * and the number of tables is limited by the memory budget.
+ * The GRID_INTERP_LINEAR and GRID_INTERP_NEAREST methods read nodes
+ * directly from the memory mapped file.
+ *
+ * Queries outside of the grid are limited to the values at the grid
+ * edge, like a data_grid with edge_limit() turned on.  The interpolate()
+ * method can be called from multiple threads at the same time.  Cache hits
+ * only take a shared lock, and tiles remain valid for the callers that are
+ * using them, even if they are evicted from the cache.
+ */
+class USML_DECLSPEC bathy_tile_cache {
+
+public:
+
+    /**
+     * Number of nodes along each side of a tile, used
+     * when write() is called without a tile size.  Defaults to 128.
+     */
+    static size_t default_tile_size ;
+
+    /**
+     * Maximum memory used for tile coefficients (bytes), used when
+     * the constructor is called without a budget.  Defaults to 256 MB.
+     */
+    static size_t default_memory_budget ;
+
+    /**
+     * Writes a bathymetry grid to a tiled file.
+     *
+     * @param filename      Name of the file to create.
+     * @param grid          Bathymetry in spherical earth coordinates.
+     *                      Both axes must be uniformly spaced,
+     *                      with at least two nodes.
+     * @param tile_size     Number of nodes along each side of a tile.
+     * @throws              std::invalid_argument if the axes are not
+     *                      uniform or the file can not be written.
+     */
+    static void write( const char* filename,
+        const data_grid<double,2>& grid,
+        size_t tile_size = default_tile_size ) ;
+
+    /**
+     * Maps a tiled bathymetry file into memory.  Does not
+     * read any of the bathymetry until it is needed.
+     *
+     * @param filename      Name of file created by write().
+     * @param memory_budget Maximum memory used for tile coefficients (bytes).
+     *                      At least one tile is always kept in memory.
+     * @throws              std::invalid_argument if the file can not be
+     *                      opened or has the wrong format.
+     */
+    bathy_tile_cache( const char* filename,
+        size_t memory_budget = default_memory_budget ) ;
+
+    /**
+     * Uniformly spaced axis of the grid.  The first axis is colatitude
+     * and the second axis is longitude, both in radians.
+     *
+     * @param dim       Dimension number.
+     */
+    const seq_linear& axis( size_t dim ) const {
+        return *_axis[dim] ;
+    }
+
+    /**
+     * Interpolates the bathymetry at a single location.
+     *
+     * @param type          Type of interpolation in both dimensions.
+     * @param location      Location in (colatitude,longitude) order (radians).
+     *                      Limited to the edge of the grid.
+     * @param derivative    Derivative of the field with respect to
+     *                      each axis at this location (output).
+     *                      Not computed if this is NULL.
+     * @return              Interpolated value at this location.
+     */
+    double interpolate( enum GRID_INTERP_TYPE type,
+        const double* location, double* derivative = NULL ) const ;
+
+    /** Maximum number of tiles kept in memory. */
+    size_t max_tiles() const {
+        return _max_tiles ;
+    }
+
+    /** Number of tiles currently in memory. */
+    size_t num_tiles() const ;
+
+private:
+
+    /**
+     * Bicubic coefficients for every cell in one tile.  The 16
+     * coefficients of each cell are stored contiguously, in the same
+     * order as the bicubic coefficients in data_grid_bathy.
+     */
+    struct tile {
+        /** Coefficients for each cell, in row-major order. */
+        std::vector<double> coeff ;
+        /** Value of the cache clock when this tile was last used. */
+        mutable boost::atomic<size_t> last_used ;
+    } ;
+
+    /** Reference to a tile that stays valid if it is evicted. */
+    typedef boost::shared_ptr<const tile> tile_reference ;
+
+    /** Value of a node in the grid, read from the memory mapped file. */
+    double node( size_t row, size_t col ) const ;
+
+    /**
+     * Finds the interval that contains a location, and the
+     * location's offset within that interval.  Limits the location
+     * to the edges of the axis.
+     *
+     * @param dim       Dimension number.
+     * @param location  Location along this axis.
+     * @param offset    Distance from the start of the interval,
+     *                  in units of the axis increment (output).
+     * @return          Index of the interval.
+     */
+    size_t find_cell( size_t dim, double location, double* offset ) const ;
+
+    /**
+     * Retrieves the coefficient table for a tile, building it, and
+     * evicting the least recently used table, if needed.
+     */
+    tile_reference find_tile( size_t tile_row, size_t tile_col ) const ;
+
+    /** Builds the coefficient table for a tile. */
+    tile_reference build_tile( size_t tile_row, size_t tile_col ) const ;
+
+    /** Memory map of the tiled bathymetry file. */
+    boost::iostreams::mapped_file_source _file ;
+
+    /** Start of the bathymetry data in the memory map. */
+    const double* _data ;
+
+    /** Number of nodes along each axis. */
+    size_t _size[2] ;
+
+    /** Number of nodes along each side of a tile. */
+    size_t _tile_size ;
+
+    /** Number of tiles along each axis. */
+    size_t _num_tiles[2] ;
+
+    /** Axes of the grid. */
+    unique_ptr<seq_linear> _axis[2] ;
+
+    /** Maximum number of tiles kept in memory. */
+    size_t _max_tiles ;
+
+    /** Coefficient tables indexed by tile number, NULL if not loaded. */
+    mutable std::vector<tile_reference> _tiles ;
+
+    /** Number of tiles currently in memory. */
+    mutable size_t _num_loaded ;
+
+    /** Incremented each time a tile is used. */
+    mutable boost::atomic<size_t> _clock ;
+
+    /** Shared lock for cache hits, exclusive lock for changes. */
+    mutable read_write_lock _mutex ;
+} ;
+
+/// @}
+}  // end of namespace ocean
+}  // end of namespace usml
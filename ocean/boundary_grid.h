@@ -26,6 +26,10 @@ namespace ocean {
  * to reduce sudden changes in surface normal direction.  Values outside of the
  * latitude/longitude axes defined by the data grid at limited to the values
  * at the grid edge.
+ *
+ * The height() methods pass the interpolation type to the grid on each
+ * call, instead of changing its settings, so a single instance can be
+ * shared by multiple threads without a boundary_lock.
  */
 template< class DATA_TYPE, int NUM_DIMS > class boundary_grid
     : public boundary_model
@@ -38,6 +42,12 @@ private:
     /** Boundary for all locations. */
     data_grid<DATA_TYPE, NUM_DIMS>* _height;
 
+    /** Interpolation types used for normal lookups. */
+    enum GRID_INTERP_TYPE _pchip[NUM_DIMS];
+
+    /** Interpolation types used when quick_interp is true. */
+    enum GRID_INTERP_TYPE _linear[NUM_DIMS];
+
 public:
 
     /**
@@ -51,26 +61,40 @@ public:
      */
     virtual void height(const wposition& location, matrix<double>* rho,
         wvector* normal = NULL, bool quick_interp = false) {
+        const enum GRID_INTERP_TYPE* type = quick_interp ? _linear : _pchip ;
+        data_grid_cursor<NUM_DIMS> cursor ;
+        double loc[2] ;
+        DATA_TYPE grad[2] ;
         switch (NUM_DIMS) {
 
         //***************
         // 1-D grids
 
         case 1:
-            if(quick_interp) { this->_height->interp_type(0, GRID_INTERP_LINEAR); }
-            else{ this->_height->interp_type(0, GRID_INTERP_PCHIP); }
             if (normal) {
-
                 matrix<double> gtheta(location.size1(), location.size2());
                 matrix<double> t(location.size1(), location.size2());
-                this->_height->interpolate(location.theta(), rho, &gtheta);
+                for (size_t n = 0; n < location.size1(); ++n) {
+                    for (size_t m = 0; m < location.size2(); ++m) {
+                        loc[0] = location.theta(n, m);
+                        (*rho)(n, m) = (double) this->_height->interpolate(
+                            loc, grad, cursor, type);
+                        gtheta(n, m) = (double) grad[0];
+                    }
+                }
                 t = min(element_div(gtheta,*rho),1.0);  // slope = tan(angle)
                 normal->theta(                          // normal = -sin(angle)
                     element_div( -t, sqrt(1.0+abs2(t)) ));
                 normal->phi(scalar_matrix<double>(location.size1(),location.size2(),0.0));
                 normal->rho( sqrt(1.0-abs2(normal->theta())) ) ; // r=sqrt(1-t^2)
             } else {
-                this->_height->interpolate(location.theta(), rho);
+                for (size_t n = 0; n < location.size1(); ++n) {
+                    for (size_t m = 0; m < location.size2(); ++m) {
+                        loc[0] = location.theta(n, m);
+                        (*rho)(n, m) = (double) this->_height->interpolate(
+                            loc, NULL, cursor, type);
+                    }
+                }
             }
             break;
 
@@ -78,20 +102,21 @@ public:
             // 2-D grids
 
         case 2:
-            if(quick_interp) {
-                this->_height->interp_type(0, GRID_INTERP_LINEAR);
-                this->_height->interp_type(1, GRID_INTERP_LINEAR);
-            } else{
-                this->_height->interp_type(0, GRID_INTERP_PCHIP);
-                this->_height->interp_type(1, GRID_INTERP_PCHIP);
-            }
             if (normal) {
                 matrix<double> gtheta(location.size1(), location.size2());
                 matrix<double> gphi(location.size1(), location.size2());
                 matrix<double> t(location.size1(), location.size2());
                 matrix<double> p(location.size1(), location.size2());
-                this->_height->interpolate(location.theta(), location.phi(),
-                    rho, &gtheta, &gphi);
+                for (size_t n = 0; n < location.size1(); ++n) {
+                    for (size_t m = 0; m < location.size2(); ++m) {
+                        loc[0] = location.theta(n, m);
+                        loc[1] = location.phi(n, m);
+                        (*rho)(n, m) = (double) this->_height->interpolate(
+                            loc, grad, cursor, type);
+                        gtheta(n, m) = (double) grad[0];
+                        gphi(n, m) = (double) grad[1];
+                    }
+                }
 
                 t = element_div(gtheta, *rho);  // slope = tan(angle)
                 p = element_div(gphi, element_prod(*rho, sin(location.theta())));
@@ -102,8 +127,14 @@ public:
                 normal->rho(sqrt(               // r=sqrt(1-t^2-p^2)
                         1.0 - abs2(normal->theta()) - abs2(normal->phi()) ));
             } else {
-                this->_height->interpolate(location.theta(), location.phi(),
-                    rho);
+                for (size_t n = 0; n < location.size1(); ++n) {
+                    for (size_t m = 0; m < location.size2(); ++m) {
+                        loc[0] = location.theta(n, m);
+                        loc[1] = location.phi(n, m);
+                        (*rho)(n, m) = (double) this->_height->interpolate(
+                            loc, NULL, cursor, type);
+                    }
+                }
             }
             break;
 
@@ -127,18 +158,18 @@ public:
      */
     virtual void height(const wposition1& location, double* rho,
         wvector1* normal = NULL, bool quick_interp = false) {
+        const enum GRID_INTERP_TYPE* type = quick_interp ? _linear : _pchip ;
+        data_grid_cursor<NUM_DIMS> cursor ;
         switch (NUM_DIMS) {
 
         //***************
         // 1-D grids
 
         case 1:
-            if(quick_interp) { this->_height->interp_type(0, GRID_INTERP_LINEAR); }
-            else{ this->_height->interp_type(0, GRID_INTERP_PCHIP); }
             if (normal) {
                 double theta = location.theta();
-                double gtheta;
-                *rho = this->_height->interpolate(&theta, &gtheta);
+                DATA_TYPE gtheta;
+                *rho = this->_height->interpolate(&theta, &gtheta, cursor, type);
                 const double t = gtheta / (*rho);       // slope = tan(angle)
                 normal->theta(-t / sqrt(1.0 + t * t));  // normal = -sin(angle)
                 normal->phi(0.0);
@@ -146,7 +177,7 @@ public:
                 normal->rho( sqrt(1.0-N) );                // r=sqrt(1-t^2)
             } else {
                 double theta = location.theta();
-                *rho = this->_height->interpolate(&theta);
+                *rho = this->_height->interpolate(&theta, NULL, cursor, type);
             }
             break;
 
@@ -154,17 +185,10 @@ public:
             // 2-D grids
 
         case 2:
-            if(quick_interp) {
-                this->_height->interp_type(0, GRID_INTERP_LINEAR);
-                this->_height->interp_type(1, GRID_INTERP_LINEAR);
-            } else{
-                this->_height->interp_type(0, GRID_INTERP_PCHIP);
-                this->_height->interp_type(1, GRID_INTERP_PCHIP);
-            }
             if (normal) {
                 double loc[2] = { location.theta(), location.phi() };
-                double grad[2];
-                *rho = this->_height->interpolate(loc, grad);
+                DATA_TYPE grad[2];
+                *rho = this->_height->interpolate(loc, grad, cursor, type);
                 const double t = grad[0] / (*rho);      // slope = tan(angle)
                 const double p = grad[1] / ((*rho) * sin(location.theta()));
                 normal->theta(-t / sqrt(1.0 + t * t));  // normal = -sin(angle)
@@ -174,7 +198,7 @@ public:
                 normal->rho( sqrt(1.0-N) );                // r=sqrt(1-t^2-p^2)
             } else {
                 double loc[2] = { location.theta(), location.phi() };
-                *rho = this->_height->interpolate(loc);
+                *rho = this->_height->interpolate(loc, NULL, cursor, type);
             }
             break;
 
@@ -204,10 +228,12 @@ public:
     boundary_grid(data_grid<DATA_TYPE, NUM_DIMS>* height,
         reflect_loss_model* reflect_loss = NULL) :
         boundary_model(reflect_loss), _height(height) {
-        this->_height->interp_type(0,GRID_INTERP_PCHIP);
-        this->_height->interp_type(1,GRID_INTERP_PCHIP);
-        this->_height->edge_limit(0,true);
-        this->_height->edge_limit(1,true);
+        for (int n = 0; n < NUM_DIMS; ++n) {
+            this->_height->interp_type(n,GRID_INTERP_PCHIP);
+            this->_height->edge_limit(n,true);
+            _pchip[n] = GRID_INTERP_PCHIP ;
+            _linear[n] = GRID_INTERP_LINEAR ;
+        }
         if ( reflect_loss == NULL ) {
             this->reflect_loss( new reflect_loss_rayleigh(
                 reflect_loss_rayleigh::SAND) ) ;
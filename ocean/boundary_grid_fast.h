@@ -23,6 +23,9 @@ namespace ocean {
  * to reduce sudden changes in surface normal direction.  Values outside of the
  * latitude/longitude axes defined by the data grid at limited to the values
  * at the grid edge.
+ *
+ * The height() methods do not modify the underlying grid, so a single
+ * instance can be shared by multiple threads without a boundary_lock.
  */
 class boundary_grid_fast : public boundary_model {
 
@@ -73,20 +76,15 @@ public:
      */
     virtual void height(const wposition& location, matrix<double>* rho,
             wvector* normal = NULL, bool quick_interp = false) {
-        if (quick_interp) {
-            this->_height->interp_type(0, GRID_INTERP_LINEAR);
-            this->_height->interp_type(1, GRID_INTERP_LINEAR);
-        } else {
-            this->_height->interp_type(0, GRID_INTERP_PCHIP);
-            this->_height->interp_type(1, GRID_INTERP_PCHIP);
-        }
+        const enum GRID_INTERP_TYPE type =
+                quick_interp ? GRID_INTERP_LINEAR : GRID_INTERP_PCHIP;
         if (normal) {
             matrix<double> gtheta(location.size1(), location.size2());
             matrix<double> gphi(location.size1(), location.size2());
             matrix<double> t(location.size1(), location.size2());
             matrix<double> p(location.size1(), location.size2());
-            this->_height->interpolate(location.theta(), location.phi(), rho,
-                    &gtheta, &gphi);
+            this->_height->interpolate(type, location.theta(), location.phi(),
+                    rho, &gtheta, &gphi);
 
             t = element_div(gtheta, *rho);  // slope = tan(angle)
             p = element_div(gphi, element_prod(*rho, sin(location.theta())));
@@ -96,7 +94,8 @@ public:
             normal->rho(sqrt(               // r=sqrt(1-t^2-p^2)
                     1.0 - abs2(normal->theta()) - abs2(normal->phi())));
         } else {
-            this->_height->interpolate(location.theta(), location.phi(), rho);
+            this->_height->interpolate(type, location.theta(), location.phi(),
+                    rho);
         }
     }
 
@@ -111,17 +110,13 @@ public:
      */
     virtual void height(const wposition1& location, double* rho,
             wvector1* normal = NULL, bool quick_interp = false) {
-        if (quick_interp) {
-            this->_height->interp_type(0, GRID_INTERP_LINEAR);
-            this->_height->interp_type(1, GRID_INTERP_LINEAR);
-        } else {
-            this->_height->interp_type(0, GRID_INTERP_PCHIP);
-            this->_height->interp_type(1, GRID_INTERP_PCHIP);
-        }
+        const enum GRID_INTERP_TYPE type =
+                quick_interp ? GRID_INTERP_LINEAR : GRID_INTERP_PCHIP;
+        data_grid_cursor<2> cursor;
         if (normal) {
             double loc[2] = { location.theta(), location.phi() };
             double grad[2];
-            *rho = this->_height->interpolate(loc, grad);
+            *rho = this->_height->interpolate(type, loc, grad, cursor);
             const double t = grad[0] / (*rho);      // slope = tan(angle)
             const double p = grad[1] / ((*rho) * sin(location.theta()));
             normal->theta(-t / sqrt(1.0 + t * t));  // normal = -sin(angle)
@@ -131,7 +126,7 @@ public:
             normal->rho(sqrt(1.0 - N));                // r=sqrt(1-t^2-p^2)
         } else {
             double loc[2] = { location.theta(), location.phi() };
-            *rho = this->_height->interpolate(loc);
+            *rho = this->_height->interpolate(type, loc, NULL, cursor);
         }
     }
 
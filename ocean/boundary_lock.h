@@ -21,6 +21,10 @@ using boost::lock_guard ;
 /**
  * A wrapper for a boundary model that provides each instantiation with its own set
  * of mutex's for the height() and reflect_loss() methods.
+ *
+ * This wrapper is not needed for any of the USML boundary models, because
+ * their height(), reflect_loss(), and scattering() methods do not modify any
+ * state inside the model.  It is only needed for client models that do.
  */
 class USML_DECLSPEC boundary_lock : public boundary_model {
 
@@ -142,6 +146,23 @@ public:
                 az_incident, az_scattered, amplitude ) ;
     }
 
+    /**
+     * Batch form of scattering(); see boundary_model.
+     * Locks the mutex once for the whole batch.
+     */
+    virtual void scattering( const std::vector<wposition1>& location,
+        const seq_vector& frequencies,
+        const std::vector<double>& de_incident,
+        const std::vector<double>& de_scattered,
+        const std::vector<double>& az_incident,
+        const std::vector<double>& az_scattered,
+        matrix<double>* amplitude )
+    {
+        lock_guard<mutex> guard(_scattering_mutex);
+        _other->scattering( location, frequencies, de_incident, de_scattered,
+                az_incident, az_scattered, amplitude ) ;
+    }
+
 private:
 
     /** Prevent simultaneous access/update by multiple threads */
@@ -174,6 +174,35 @@ class USML_DECLSPEC boundary_model : public reflect_loss_model, scattering_model
                 az_incident, az_scattered, amplitude ) ;
     }
 
+    /**
+     * Computes the broadband scattering strength for a batch of
+     * independent scattering geometries.  Each entry has its own
+     * location, incident angles, and scattered angles.  The results
+     * are returned as a single contiguous matrix, so that callers
+     * can evaluate many eigenverb pairs with one virtual call.
+     *
+     * @param location      Location of each scattering.
+     * @param frequencies   Frequencies over which to compute loss. (Hz)
+     * @param de_incident   Depression incident angle of each scattering (radians).
+     * @param de_scattered  Depression scattered angle of each scattering (radians).
+     * @param az_incident   Azimuthal incident angle of each scattering (radians).
+     * @param az_scattered  Azimuthal scattered angle of each scattering (radians).
+     * @param amplitude     Reverberation scattering strength ratio (output).
+     *                      Resized to one row per scattering
+     *                      and one column per frequency.
+     */
+    virtual void scattering( const std::vector<wposition1>& location,
+        const seq_vector& frequencies,
+        const std::vector<double>& de_incident,
+        const std::vector<double>& de_scattered,
+        const std::vector<double>& az_incident,
+        const std::vector<double>& az_scattered,
+        matrix<double>* amplitude )
+    {
+        _scattering->scattering( location, frequencies, de_incident, de_scattered,
+                az_incident, az_scattered, amplitude ) ;
+    }
+
     //**************************************************
     // initialization
 
@@ -0,0 +1,133 @@
+/**
+ * @file boundary_tiled.h
+ * Creates a bottom model from a tiled, memory mapped bathymetry file.
+ */
+#pragma once
+
+#include <usml/ocean/bathy_tile_cache.h>
+#include <usml/ocean/boundary_model.h>
+#include <usml/ocean/reflect_loss_rayleigh.h>
+
+namespace usml {
+namespace ocean {
+
+/// @ingroup boundaries
+/// @{
+
+/**
+ * Bottom model constructed from a bathy_tile_cache.  Replaces
+ * boundary_grid_fast for bathymetry databases that are too large to
+ * load into memory.  Assumes that the order of axes in the file is
+ * (latitude, longitude) and that the geodetic axes have been transformed
+ * to their spherical earth equivalents (theta,phi).
+ *
+ * Uses the GRID_INTERP_PCHIP interpolation in both directions
+ * to reduce sudden changes in surface normal direction.  Values outside of the
+ * latitude/longitude axes defined by the file are limited to the values
+ * at the grid edge.
+ *
+ * The height() methods do not modify the underlying bathymetry, so a single
+ * instance can be shared by multiple threads without a boundary_lock.
+ */
+class boundary_tiled : public boundary_model {
+
+public:
+
+    //**************************************************
+    // height model
+
+    /**
+     * Constructor - Initialize depth and reflection loss components for a boundary.
+     *
+     * @param height            Bottom depth (meters) as a function of position.
+     *                          Assumes control of this cache and deletes
+     *                          it when the class is destroyed.
+     * @param reflect_loss      Reflection loss model.  Defaults to a
+     *                          Rayleigh reflection for "sand" if NULL.
+     *                          The boundary_model takes over ownship of this
+     *                          reference and deletes it as part of its destructor.
+     */
+    boundary_tiled(bathy_tile_cache* height,
+            reflect_loss_model* reflect_loss = NULL) :
+            boundary_model(reflect_loss), _height(height) {
+        if ( reflect_loss == NULL) {
+            this->reflect_loss( new reflect_loss_rayleigh(
+                    reflect_loss_rayleigh::SAND) ) ;
+        }
+    }
+
+    /**
+     * Destructor - Delete bathymetry cache.
+     */
+    virtual ~boundary_tiled() {
+        delete _height;
+    }
+
+    /**
+     * Compute the height of the boundary and it's surface normal at
+     * a series of locations.
+     *
+     * @param location      Location at which to compute boundary.
+     * @param rho           Surface height in spherical earth coords (output).
+     * @param normal        Unit normal relative to location (output).
+     * @param quick_interp  Determines if you want a fast nearest or pchip interp
+     */
+    virtual void height(const wposition& location, matrix<double>* rho,
+            wvector* normal = NULL, bool quick_interp = false) {
+        wposition1 loc;
+        wvector1 norm;
+        for (size_t n = 0; n < location.size1(); ++n) {
+            for (size_t m = 0; m < location.size2(); ++m) {
+                loc.theta(location.theta(n, m));
+                loc.phi(location.phi(n, m));
+                if (normal) {
+                    height(loc, &(*rho)(n, m), &norm, quick_interp);
+                    normal->rho(n, m, norm.rho());
+                    normal->theta(n, m, norm.theta());
+                    normal->phi(n, m, norm.phi());
+                } else {
+                    height(loc, &(*rho)(n, m), NULL, quick_interp);
+                }
+            }
+        }
+    }
+
+    /**
+     * Compute the height of the boundary and it's surface normal at
+     * a single location.  Often used during reflection processing.
+     *
+     * @param location      Location at which to compute boundary.
+     * @param rho           Surface height in spherical earth coords (output).
+     * @param normal        Unit normal relative to location (output).
+     * @param quick_interp  Determines if you want a fast nearest or pchip interp
+     */
+    virtual void height(const wposition1& location, double* rho,
+            wvector1* normal = NULL, bool quick_interp = false) {
+        const enum GRID_INTERP_TYPE type =
+                quick_interp ? GRID_INTERP_LINEAR : GRID_INTERP_PCHIP;
+        double loc[2] = { location.theta(), location.phi() };
+        if (normal) {
+            double grad[2];
+            *rho = this->_height->interpolate(type, loc, grad);
+            const double t = grad[0] / (*rho);      // slope = tan(angle)
+            const double p = grad[1] / ((*rho) * sin(location.theta()));
+            normal->theta(-t / sqrt(1.0 + t * t));  // normal = -sin(angle)
+            normal->phi(-p / sqrt(1.0 + p * p));
+            const double N = normal->theta() * normal->theta()
+                    + normal->phi() * normal->phi();
+            normal->rho(sqrt(1.0 - N));                // r=sqrt(1-t^2-p^2)
+        } else {
+            *rho = this->_height->interpolate(type, loc);
+        }
+    }
+
+private:
+
+    /** Boundary for all locations. */
+    bathy_tile_cache* _height;
+
+}; // end class boundary_tiled
+
+/// @}
+}  // end of namespace ocean
+}  // end of namespace usml
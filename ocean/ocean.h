@@ -76,6 +76,8 @@
 #include <usml/ocean/boundary_slope.h>
 #include <usml/ocean/boundary_grid.h>
 #include <usml/ocean/boundary_grid_fast.h>
+#include <usml/ocean/bathy_tile_cache.h>
+#include <usml/ocean/boundary_tiled.h>
 #include <usml/ocean/boundary_lock.h>
 #include <usml/ocean/ascii_arc_bathy.h>
 #include <usml/ocean/wave_height_pierson.h>
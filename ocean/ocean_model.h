@@ -9,6 +9,7 @@
 #include <usml/ocean/volume_model.h>
 #include <vector>
 #include <iterator>
+#include <string>
 
 namespace usml {
 namespace ocean {
@@ -39,7 +40,7 @@ class USML_DECLSPEC ocean_model {
     }
 
     /** Retrieve number of ocean volume layers. */
-    inline size_t num_volume() {
+    inline size_t num_volume() const {
         return _volume.size() ;
     }
 
@@ -53,6 +54,24 @@ class USML_DECLSPEC ocean_model {
         return *_profile ;
     }
 
+    /**
+     * Identifies the inputs used to build this ocean, like the names and
+     * modification times of its data files.  Used by the wavefront_cache
+     * to decide if stored propagation results are still valid.
+     * Empty if the inputs are unknown, which disables caching.
+     */
+    inline const std::string& fingerprint() const {
+        return _fingerprint ;
+    }
+
+    /**
+     * Defines the string that identifies the inputs used to build this
+     * ocean.  Must be set before the ocean is published to ocean_shared.
+     */
+    inline void fingerprint( const std::string& value ) {
+        _fingerprint = value ;
+    }
+
     /**
       * Associate ocean parts with this model.
      * The ocean model takes over ownership of these models and
@@ -96,6 +115,9 @@ class USML_DECLSPEC ocean_model {
 
     /** Model of the sound speed profile and attenuation. */
     profile_model* _profile ;
+
+    /** Identifies the inputs used to build this ocean. */
+    std::string _fingerprint ;
 };
 
 /// @}
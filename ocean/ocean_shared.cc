@@ -13,22 +13,19 @@ ocean_shared::reference ocean_shared::_current = ocean_shared::reference();
  * Pass a shared reference of current ocean back to client.
  */
 ocean_shared::reference ocean_shared::current() {
-    read_lock_guard(_lock) ;
-    return _current ;
+    return boost::atomic_load( &_current ) ;
 }
 
 /**
  * Update shared ocean with new data.
  */
 void ocean_shared::update( ocean_shared::reference& ocean ) {
-    write_lock_guard(_lock) ;
-    _current = ocean ;
+    boost::atomic_store( &_current, ocean ) ;
 }
 
 /**
 * Reset the shared ocean to empty.
 */
 void ocean_shared::reset() {
-    write_lock_guard(_lock);
-    _current.reset();
+    boost::atomic_store( &_current, reference() ) ;
 }
@@ -26,14 +26,21 @@ using namespace usml::threads ;
  * as a shared pointer so that a new ocean can be defined without 
  * blocking clients that are actively using the previous setting.  
  *
- * Uses mutex locking to control multi-threaded access to the current() and
- * update() methods.  Multiple readers can access the current() simultaneously,
- * but updating the ocean using update() blocks other readers and writers.
+ * Each ocean is an immutable snapshot.  Once published by update(), it
+ * is only read by the clients that hold a reference to it.  The update()
+ * method atomically swaps in the new snapshot, without waiting for
+ * clients that are still using the old one.  The old snapshot is deleted
+ * when the last of these clients releases its reference.  Neither
+ * current() nor update() block on a mutex while the ocean is queried.
  *
  * Warnings:
- * - The shared ocean must be build using the _lock variants of the
- *   profile_model, boundary_model, and volume_model. These variants
- *   use mutex locking when the models are used by multiple execution threads.
+ * - The models in the shared ocean must be reentrant.  All of the
+ *   USML profile, boundary, and volume models meet this requirement,
+ *   because their queries do not modify any state inside the model.
+ *   Models that do have hidden mutable state must be wrapped in the
+ *   profile_lock, boundary_lock, or volume_lock variants.
+ * - Do not modify an ocean after it has been published.  Build a new
+ *   one, and publish it with update(), instead.
  */
 class USML_DECLSPEC ocean_shared {
 
@@ -47,12 +54,14 @@ public:
     /**
      * Pass a shared reference of current ocean back to the client.
      * Returns a null reference if ocean has not yet been
-     * defined using update().
+     * defined using update().  Clients should call this once,
+     * and use the same snapshot for the rest of their calculation.
      */
     static ocean_shared::reference current() ;
 
     /**
-     * Update shared ocean singleton with new data.
+     * Publish a new ocean snapshot.  Clients that are using the
+     * previous snapshot continue to do so until they release it.
      *
      * @param   ocean  Shared pointer to the data used to update this singleton.
      */
@@ -65,15 +74,13 @@ public:
 
 private:
 
-    /** 
+    /**
      * Shared reference to the current ocean. Defined as null
      * reference if ocean has not yet been defined using update().
+     * Only accessed with the atomic shared_ptr operations.
      */
     static reference _current ;
 
-    /** Locks singleton while ocean is being changed. */
-    read_write_lock _lock ;
-
     /**
      * Hide constructors to prevent incorrect use of singleton.
      */
@@ -30,6 +30,9 @@ namespace ocean {
  *             grid axes passed in have already been transformed
  *             to their spherical earth equivalents (altitude -> rho,
  *             theta,phi).
+ *
+ * The sound_speed() method does not modify the underlying grid, so a single
+ * instance can be shared by multiple threads without a profile_lock.
  */
 template< class DATA_TYPE, int NUM_DIMS > class profile_grid
     : public profile_model
@@ -44,6 +47,8 @@ template< class DATA_TYPE, int NUM_DIMS > class profile_grid
 
   public:
 
+    using profile_model::sound_speed ;
+
     /**
      * Compute the speed of sound and it's first derivatives at
      * a series of locations.
@@ -26,6 +26,13 @@ namespace ocean {
  *             grid axes passed in have already been transformed
  *             to their spherical earth equivalents (altitude -> rho,
  *             theta,phi).
+ *
+ * The sound_speed() method does not modify the underlying grid, so a single
+ * instance can be shared by multiple threads without a profile_lock.
+ * It uses the batch form of data_grid_svp::interpolate().  Wavefronts
+ * pass in the interval indices from their last call as search hints,
+ * and because the rays only move a small distance on each time step,
+ * these hints are usually the intervals that they need.
  */
 class profile_grid_fast : public profile_model {
 
@@ -81,6 +88,23 @@ public:
         this->adjust_speed(location, speed, gradient);
     }
 
+    /**
+     * Compute the speed of sound and it's first derivatives at a series
+     * of locations, starting each search from the intervals found on the
+     * last call.
+     *
+     * @param location      Location at which to compute attenuation.
+     * @param speed         Speed of sound (m/s) at each location (output).
+     * @param gradient      Sound speed gradient at each location (output).
+     * @param hints         Interval index of each location along each axis
+     *                      (input/output).
+     */
+    virtual void sound_speed(const wposition& location, matrix<double>* speed,
+            wvector* gradient, std::vector<size_t>* hints) {
+        this->_sound_speed->interpolate( location, speed, gradient, hints ) ;
+        this->adjust_speed(location, speed, gradient);
+    }
+
 private:
 
     /** Sound speed for all locations. */
@@ -52,6 +52,8 @@ class USML_DECLSPEC profile_linear : public profile_model {
 
   public:
 
+    using profile_model::sound_speed ;
+
     /**
      * Compute the speed of sound and it's first derivatives at
      * a series of locations.
@@ -19,6 +19,10 @@ using boost::numeric::ublas::vector;
 /**
  * A wrapper for a USML profile model that provides each instantiation with its own set
  * of mutex's for the sound_speed() and attenuation() methods.
+ *
+ * This wrapper is not needed for any of the USML profile models, because
+ * their sound_speed() and attenuation() methods do not modify any state
+ * inside the model.  It is only needed for client models that do.
  */
 class USML_DECLSPEC profile_lock : public profile_model {
 
@@ -62,6 +66,23 @@ class USML_DECLSPEC profile_lock : public profile_model {
 
         }
 
+        /**
+         * Compute the speed of sound and it's first derivatives at
+         * a series of locations, with search hints, and a mutex lock.
+         *
+         * @param location      Location at which to compute attenuation.
+         * @param speed         Speed of sound (m/s) at each location (output).
+         * @param gradient      Sound speed gradient at each location (output).
+         * @param hints         Search state for these locations (input/output).
+         */
+        virtual void sound_speed( const wposition& location,
+            matrix<double>* speed, wvector* gradient,
+            std::vector<size_t>* hints )
+        {
+            boost::lock_guard<boost::mutex> sound_speedLock(*_sound_speedMutex);
+            _other->sound_speed(location, speed, gradient, hints);
+        }
+
         /**
         * Computes the broadband absorption loss of sea water with a mutex lock.
         *
@@ -83,6 +104,26 @@ class USML_DECLSPEC profile_lock : public profile_model {
             _other->attenuation(location, frequencies, distance, attenuation ) ;
        }
 
+        /**
+        * Computes the broadband absorption loss of sea water into a
+        * contiguous spectral_matrix with a mutex lock.
+        *
+        * @param location      Location at which to compute attenuation.
+        * @param frequencies   Frequencies over which to compute loss. (Hz)
+        * @param distance      Distance traveled through the water (meters).
+        * @param attenuation   Absorption loss of sea water in dB (output).
+        */
+        virtual void attenuation(
+           const usml::types::wposition& location,
+           const seq_vector& frequencies,
+           const boost::numeric::ublas::matrix<double>& distance,
+           usml::types::spectral_matrix* attenuation)
+       {
+            boost::lock_guard<boost::mutex> attenuationLock(*_attenuationMutex);
+
+            _other->attenuation(location, frequencies, distance, attenuation ) ;
+       }
+
         /**
          * Destructor
          */
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <usml/ocean/attenuation_thorp.h>
+#include <vector>
 
 namespace usml {
 namespace ocean {
@@ -71,6 +72,25 @@ public:
     virtual void sound_speed( const wposition& location,
         matrix<double>* speed, wvector* gradient=NULL ) = 0 ;
 
+    /**
+     * Compute the speed of sound and it's first derivatives at a series
+     * of locations, using the results of the last call as a starting point.
+     * Used by wavefronts, whose rays only move a small distance between
+     * calls.  Models that don't benefit from these hints just ignore them.
+     *
+     * @param location      Location at which to compute attenuation.
+     * @param speed         Speed of sound (m/s) at each location (output).
+     * @param gradient      Sound speed gradient at each location (output).
+     * @param hints         Model specific search state for these locations
+     *                      (input/output).  Starts out empty.
+     */
+    virtual void sound_speed( const wposition& location,
+        matrix<double>* speed, wvector* gradient,
+        std::vector<size_t>* hints )
+    {
+        sound_speed( location, speed, gradient ) ;
+    }
+
    /**
     * Define a new in-water attenuation model.
     *
@@ -99,6 +119,25 @@ public:
            location, frequencies, distance, attenuation ) ;
    }
 
+   /**
+    * Computes the broadband absorption loss of sea water into a
+    * contiguous spectral_matrix.
+    *
+    * @param location      Location at which to compute attenuation.
+    * @param frequencies   Frequencies over which to compute loss. (Hz)
+    * @param distance      Distance travelled through the water (meters).
+    * @param attenuation   Absorption loss of sea water in dB (output).
+    */
+   virtual void attenuation(
+       const wposition& location,
+       const seq_vector& frequencies,
+       const matrix<double>& distance,
+       spectral_matrix* attenuation)
+   {
+       _attenuation->attenuation(
+           location, frequencies, distance, attenuation ) ;
+   }
+
 
   protected:
 
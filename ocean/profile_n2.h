@@ -48,6 +48,8 @@ class USML_DECLSPEC profile_n2 : public profile_model {
 
   public:
 
+    using profile_model::sound_speed ;
+
     /**
      * Compute the speed of sound and it's first derivatives at
      * a series of locations.
@@ -55,7 +55,8 @@ void reflect_loss_rayleigh_grid::reflect_loss(
     loc[0] = location.latitude();
     loc[1] = location.longitude();
 
-    size_t type = _bottom_grid->interpolate(loc);
+    data_grid_cursor<2> cursor ;
+    size_t type = (size_t) _bottom_grid->interpolate(loc, NULL, cursor) ;
     _rayleigh[type]->reflect_loss(location, frequencies, angle, amplitude, phase );
 }
 
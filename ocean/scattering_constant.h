@@ -81,6 +81,25 @@ public:
             // fast assignment of scalar to matrix of vectors
     }
 
+    /** Batch form of scattering(); see scattering_model. */
+    virtual void scattering( const std::vector<wposition1>& location,
+        const seq_vector& frequencies,
+        const std::vector<double>& de_incident,
+        const std::vector<double>& de_scattered,
+        const std::vector<double>& az_incident,
+        const std::vector<double>& az_scattered,
+        matrix<double>* amplitude )
+    {
+        const size_t num_freq = frequencies.size() ;
+        if ( amplitude->size1() != location.size()
+          || amplitude->size2() != num_freq )
+        {
+            amplitude->resize( location.size(), num_freq, false ) ;
+        }
+        std::fill( amplitude->data().begin(), amplitude->data().end(),
+                   _amplitude ) ;
+    }
+
 private:
 
     /** Holds the reverberation scattering strength ratio. */
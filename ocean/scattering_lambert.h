@@ -103,6 +103,30 @@ public:
         }
     }
 
+    /** Batch form of scattering(); see scattering_model. */
+    virtual void scattering( const std::vector<wposition1>& location,
+        const seq_vector& frequencies,
+        const std::vector<double>& de_incident,
+        const std::vector<double>& de_scattered,
+        const std::vector<double>& az_incident,
+        const std::vector<double>& az_scattered,
+        matrix<double>* amplitude )
+    {
+        const size_t num_freq = frequencies.size() ;
+        if ( amplitude->size1() != location.size()
+          || amplitude->size2() != num_freq )
+        {
+            amplitude->resize( location.size(), num_freq, false ) ;
+        }
+        double* data = amplitude->data().begin() ;
+        for ( size_t n=0 ; n < location.size() ; ++n ) {
+            const double value = abs( _coeff
+                * sin( de_incident[n] ) * sin( de_scattered[n] ) ) ;
+            std::fill( data, data + num_freq, value ) ;
+            data += num_freq ;
+        }
+    }
+
 private:
 
     /**
@@ -93,6 +93,51 @@ class USML_DECLSPEC scattering_model {
             const seq_vector& frequencies, double de_incident, matrix<double> de_scattered,
             double az_incident, matrix<double> az_scattered, matrix< vector<double> >* amplitude ) = 0 ;
 
+        /**
+         * Computes the broadband scattering strength for a batch of
+         * independent scattering geometries.  Each entry has its own
+         * location, incident angles, and scattered angles.  The results
+         * are returned as a single contiguous matrix, so that callers
+         * can evaluate many eigenverb pairs with one virtual call.
+         *
+         * @param location      Location of each scattering.
+         * @param frequencies   Frequencies over which to compute loss. (Hz)
+         * @param de_incident   Depression incident angle of each scattering (radians).
+         * @param de_scattered  Depression scattered angle of each scattering (radians).
+         * @param az_incident   Azimuthal incident angle of each scattering (radians).
+         * @param az_scattered  Azimuthal scattered angle of each scattering (radians).
+         * @param amplitude     Reverberation scattering strength ratio (output).
+         *                      Resized to one row per scattering
+         *                      and one column per frequency.
+         *
+         * The default implementation calls the single location version
+         * once for each scattering.  Sub-classes should override it with
+         * a vectorized implementation.
+         */
+        virtual void scattering( const std::vector<wposition1>& location,
+            const seq_vector& frequencies,
+            const std::vector<double>& de_incident,
+            const std::vector<double>& de_scattered,
+            const std::vector<double>& az_incident,
+            const std::vector<double>& az_scattered,
+            matrix<double>* amplitude )
+        {
+            const size_t num_freq = frequencies.size() ;
+            if ( amplitude->size1() != location.size()
+              || amplitude->size2() != num_freq )
+            {
+                amplitude->resize( location.size(), num_freq, false ) ;
+            }
+            vector<double> single( num_freq ) ;
+            for ( size_t n=0 ; n < location.size() ; ++n ) {
+                scattering( location[n], frequencies,
+                    de_incident[n], de_scattered[n],
+                    az_incident[n], az_scattered[n], &single ) ;
+                std::copy( single.begin(), single.end(),
+                           amplitude->data().begin() + n * num_freq ) ;
+            }
+        }
+
         /**
          * Virtual destructor
          */
@@ -125,6 +125,54 @@ BOOST_AUTO_TEST_CASE( thorp_test_b ) {
     }
 }
 
+/**
+ * Compare attenuation computed into a contiguous spectral_matrix to the
+ * results for the same points computed into a matrix of vectors.
+ * Tests a 3x2 grid of points at different depths and distances so
+ * that an error in the ray-major layout would be detected.
+ */
+BOOST_AUTO_TEST_CASE( spectral_matrix_test ) {
+    cout << "=== attenuation_test: spectral_matrix_test ===" << endl;
+
+    wposition points(3, 2);
+    matrix<double> distance(3, 2);
+    for (size_t n1 = 0; n1 < 3; ++n1) {
+        for (size_t n2 = 0; n2 < 2; ++n2) {
+            points.altitude(n1, n2, -100.0 * (n1 + 1) - 10.0 * n2);
+            distance(n1, n2) = 1000.0 * (n1 + 1) + 100.0 * n2;
+        }
+    }
+    seq_log freq(100.0, 2.0, 5);
+
+    matrix < vector<double> > atten(3, 2);
+    for (size_t n1 = 0; n1 < 3; ++n1) {
+        for (size_t n2 = 0; n2 < 2; ++n2) {
+            atten(n1, n2).resize(freq.size());
+        }
+    }
+    spectral_matrix contiguous(3, 2, freq.size());
+
+    attenuation_thorp model;
+    model.attenuation(points, freq, distance, &atten);
+    model.attenuation(points, freq, distance, &contiguous);
+
+    for (size_t n1 = 0; n1 < 3; ++n1) {
+        for (size_t n2 = 0; n2 < 2; ++n2) {
+            for (size_t f = 0; f < freq.size(); ++f) {
+                BOOST_CHECK_CLOSE(contiguous(n1, n2)(f), atten(n1, n2)(f), 1e-10);
+            }
+        }
+    }
+
+    // accumulate a second copy, as done by wave_queue::step()
+
+    spectral_matrix total(3, 2, freq.size());
+    total.clear();
+    total += contiguous;
+    total += contiguous;
+    BOOST_CHECK_CLOSE(total(2, 1)(4), 2.0 * atten(2, 1)(4), 1e-10);
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
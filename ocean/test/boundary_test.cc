@@ -310,6 +310,139 @@ BOOST_AUTO_TEST_CASE( scattering_strength_test ) {
     delete s ;
 }
 
+/**
+ * Checks that the batch version of the scattering strength calculation
+ * matches the single location version, for both the Lambert and constant
+ * models, when accessed through a boundary_model and a volume_model.
+ * Each row of the batch result must equal the single location result
+ * for the same geometry.
+ */
+BOOST_AUTO_TEST_CASE( scattering_batch_test ) {
+    cout << "=== boundary_test: scattering_batch_test ===" << endl;
+
+    boundary_flat bottom( 2000.0 ) ;
+    bottom.scattering( new scattering_lambert() ) ;
+    volume_flat layer( 1000.0, 10.0, -30.0 ) ;
+    const seq_linear freq( 100.0, 100.0, 4 ) ;
+    const size_t num = 25 ;
+
+    std::vector<wposition1> location( num ) ;
+    std::vector<double> de_incident( num ) ;
+    std::vector<double> de_scattered( num ) ;
+    std::vector<double> az_incident( num ) ;
+    std::vector<double> az_scattered( num ) ;
+    for ( size_t n=0 ; n < num ; ++n ) {
+        location[n] = wposition1( 0.01*n, -0.01*n ) ;
+        de_incident[n] = to_radians( 3.0 * n ) ;
+        de_scattered[n] = to_radians( 80.0 - 2.0 * n ) ;
+        az_incident[n] = to_radians( 10.0 * n ) ;
+        az_scattered[n] = to_radians( 5.0 * n ) ;
+    }
+
+    matrix<double> bottom_batch ;
+    matrix<double> layer_batch ;
+    bottom.scattering( location, freq, de_incident, de_scattered,
+            az_incident, az_scattered, &bottom_batch ) ;
+    layer.scattering( location, freq, de_incident, de_scattered,
+            az_incident, az_scattered, &layer_batch ) ;
+    BOOST_CHECK_EQUAL( bottom_batch.size1(), num ) ;
+    BOOST_CHECK_EQUAL( bottom_batch.size2(), freq.size() ) ;
+
+    vector<double> amplitude( freq.size() ) ;
+    for ( size_t n=0 ; n < num ; ++n ) {
+        bottom.scattering( location[n], freq, de_incident[n], de_scattered[n],
+                az_incident[n], az_scattered[n], &amplitude ) ;
+        for ( size_t f=0 ; f < freq.size() ; ++f ) {
+            BOOST_CHECK_EQUAL( bottom_batch(n,f), amplitude(f) ) ;
+        }
+        layer.scattering( location[n], freq, de_incident[n], de_scattered[n],
+                az_incident[n], az_scattered[n], &amplitude ) ;
+        for ( size_t f=0 ; f < freq.size() ; ++f ) {
+            BOOST_CHECK_EQUAL( layer_batch(n,f), amplitude(f) ) ;
+        }
+    }
+}
+
+/**
+ * Write a small bathymetry grid to a tiled file, and compare
+ * interpolations from bathy_tile_cache to those from data_grid_bathy.
+ * Uses a small tile size and memory budget, so that tiles are evicted
+ * from the cache and rebuilt while the test is running.  Also checks
+ * the boundary_tiled surface normal against boundary_grid_fast.
+ */
+BOOST_AUTO_TEST_CASE( tiled_boundary_test ) {
+    cout << "=== boundary_test: tiled_boundary_test ===" << endl;
+    const char* filename = USML_TEST_DIR "/ocean/test/tiled_boundary_test.bin" ;
+
+    // build a grid with a descending colatitude axis, like netcdf_bathy
+
+    const seq_vector* axis[2] ;
+    axis[0] = new seq_linear( to_colatitude(30.0), to_radians(-0.01), 19 ) ;
+    axis[1] = new seq_linear( to_radians(-45.0), to_radians(0.01), 23 ) ;
+    data_grid<double,2>* grid = new data_grid<double,2>( axis ) ;
+    size_t index[2] ;
+    for ( index[0]=0 ; index[0] < axis[0]->size() ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < axis[1]->size() ; ++index[1] ) {
+            const double depth = 1000.0
+                + 200.0 * sin( 0.7 * index[0] ) * cos( 0.3 * index[1] )
+                + 10.0 * index[1] ;
+            grid->data( index, wposition::earth_radius - depth ) ;
+        }
+    }
+    data_grid_bathy fast( grid ) ;         // takes ownership of grid
+    fast.edge_limit( 0, true ) ;
+    fast.edge_limit( 1, true ) ;
+    bathy_tile_cache::write( filename, fast, 4 ) ;
+
+    // compare to data_grid_bathy at random locations, including some
+    // that are outside of the grid
+
+    bathy_tile_cache cache( filename, 3 * 4 * 4 * 16 * sizeof(double) ) ;
+    BOOST_CHECK_EQUAL( cache.max_tiles(), 3u ) ;
+    data_grid_cursor<2> cursor ;
+    const enum GRID_INTERP_TYPE types[2] =
+        { GRID_INTERP_LINEAR, GRID_INTERP_PCHIP } ;
+    for ( size_t n=0 ; n < 1000 ; ++n ) {
+        double loc[2] ;
+        for ( size_t d=0 ; d < 2 ; ++d ) {
+            const double first = (*axis[d])(0) ;
+            const double last = (*axis[d])(axis[d]->size()-1) ;
+            loc[d] = first + ( last - first )
+                * ( 1.2 * randgen::uniform() - 0.1 ) ;
+        }
+        for ( size_t t=0 ; t < 2 ; ++t ) {
+            double grad[2], grad_fast[2] ;
+            const double value = cache.interpolate( types[t], loc, grad ) ;
+            const double value_fast = fast.interpolate(
+                types[t], loc, grad_fast, cursor ) ;
+            BOOST_CHECK_SMALL( value - value_fast, 1e-6 ) ;
+            BOOST_CHECK_SMALL( grad[0] - grad_fast[0],
+                1e-6 * abs( grad_fast[0] ) + 1e-3 ) ;
+            BOOST_CHECK_SMALL( grad[1] - grad_fast[1],
+                1e-6 * abs( grad_fast[1] ) + 1e-3 ) ;
+        }
+        BOOST_CHECK( cache.num_tiles() <= cache.max_tiles() ) ;
+    }
+
+    // compare the boundary models
+
+    boundary_tiled tiled( new bathy_tile_cache( filename ) ) ;
+    boundary_grid_fast reference( new data_grid_bathy(
+        new data_grid<double,2>( fast, true ) ) ) ;
+    wposition1 location( 29.95, -44.9 ) ;
+    double rho, rho_fast ;
+    wvector1 normal, normal_fast ;
+    tiled.height( location, &rho, &normal ) ;
+    reference.height( location, &rho_fast, &normal_fast ) ;
+    BOOST_CHECK_SMALL( rho - rho_fast, 1e-6 ) ;
+    BOOST_CHECK_SMALL( normal.theta() - normal_fast.theta(), 1e-9 ) ;
+    BOOST_CHECK_SMALL( normal.phi() - normal_fast.phi(), 1e-9 ) ;
+
+    delete axis[0] ;
+    delete axis[1] ;
+    std::remove( filename ) ;
+}
+
 /**
  * Test the basics of creating an ocean volume layer,
  */
@@ -33,9 +33,9 @@ public:
      * Create a new set of ocean data.
      */
     virtual void run() {
-        boundary_model* surface = new boundary_lock(new boundary_flat());
-        boundary_model* bottom = new boundary_lock(new boundary_flat(1000.0));
-        profile_model* profile = new profile_lock(new profile_linear());
+        boundary_model* surface = new boundary_flat();
+        boundary_model* bottom = new boundary_flat(1000.0);
+        profile_model* profile = new profile_linear();
         ocean_shared::reference ocean(new ocean_model(surface, bottom, profile));
         cout << id() << " producer: creating ocean_model=" << ocean << endl;
         ocean_shared::update(ocean);
@@ -217,6 +217,45 @@ BOOST_AUTO_TEST_CASE( random_producer ) {
     ocean_shared::reset();
 }
 
+/**
+ * Test that clients keep using their own snapshot of the ocean after
+ * a new one is published.  Takes a snapshot, publishes a new ocean, and
+ * checks that the snapshot still works and is not the current ocean.
+ * Then releases the snapshot and checks that the old ocean was deleted.
+ */
+BOOST_AUTO_TEST_CASE( snapshot_test ) {
+    cout << "=== ocean_shared_test: snapshot_test ===" << endl;
+
+    ocean_shared::reference first( new ocean_model(
+        new boundary_flat(), new boundary_flat(1000.0),
+        new profile_linear(1500.0) ) ) ;
+    ocean_shared::update( first ) ;
+    boost::weak_ptr<ocean_model> watch( first ) ;
+    first.reset() ;
+
+    ocean_shared::reference snapshot = ocean_shared::current() ;
+    BOOST_REQUIRE( snapshot.get() != NULL ) ;
+
+    ocean_shared::reference second( new ocean_model(
+        new boundary_flat(), new boundary_flat(2000.0),
+        new profile_linear(1490.0) ) ) ;
+    ocean_shared::update( second ) ;
+    BOOST_CHECK( ocean_shared::current() == second ) ;
+    BOOST_CHECK( ocean_shared::current() != snapshot ) ;
+
+    wposition1 location( 0.0, 0.0, -10.0 ) ;
+    double rho ;
+    snapshot->bottom().height( location, &rho ) ;
+    BOOST_CHECK_CLOSE( wposition::earth_radius - rho, 1000.0, 1e-6 ) ;
+    ocean_shared::current()->bottom().height( location, &rho ) ;
+    BOOST_CHECK_CLOSE( wposition::earth_radius - rho, 2000.0, 1e-6 ) ;
+
+    BOOST_CHECK( ! watch.expired() ) ;
+    snapshot.reset() ;
+    BOOST_CHECK( watch.expired() ) ;
+    ocean_shared::reset() ;
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
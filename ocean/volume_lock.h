@@ -21,6 +21,10 @@ using boost::lock_guard ;
  * A volume_model wrapper the allows access by multiple simultaneous threads.
  * The depth and scattering operations have separate mutexes that allow
  * one of these to be accessed without blocking the other.
+ *
+ * This wrapper is not needed for any of the USML volume models, because
+ * their depth() and scattering() methods do not modify any state
+ * inside the model.  It is only needed for client models that do.
  */
 class USML_DECLSPEC volume_lock : public volume_model {
 
@@ -133,6 +137,23 @@ public:
                 az_incident, az_scattered, amplitude ) ;
     }
 
+    /**
+     * Batch form of scattering(); see volume_model.
+     * Locks the mutex once for the whole batch.
+     */
+    virtual void scattering( const std::vector<wposition1>& location,
+        const seq_vector& frequencies,
+        const std::vector<double>& de_incident,
+        const std::vector<double>& de_scattered,
+        const std::vector<double>& az_incident,
+        const std::vector<double>& az_scattered,
+        matrix<double>* amplitude )
+    {
+        lock_guard<mutex> guard(_scattering_mutex);
+        _other->scattering( location, frequencies, de_incident, de_scattered,
+                az_incident, az_scattered, amplitude ) ;
+    }
+
 private:
 
      /** Mutex to guard access to depth operations. */
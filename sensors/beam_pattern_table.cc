@@ -0,0 +1,78 @@
+/**
+ * @file beam_pattern_table.cc
+ * Beam pattern levels tabulated for a fixed orientation and frequency list.
+ */
+#include <usml/sensors/beam_pattern_table.h>
+
+using namespace usml::sensors ;
+
+/**
+ * Default spacing of the DE and AZ axes (rad).
+ */
+double beam_pattern_table::default_spacing = M_PI / 180.0 ;
+
+/**
+ * Evaluates the beam pattern at every point in the DE/AZ grid.
+ */
+beam_pattern_table::beam_pattern_table(
+    beam_pattern_model& pattern, const orientation& orient,
+    const seq_vector& frequencies, double spacing )
+    : _num_freq( frequencies.size() ), _spacing( spacing )
+{
+    _num_de = (size_t) ceil( M_PI / _spacing ) + 1 ;
+    _de_spacing = M_PI / ( _num_de - 1 ) ;
+    _num_az = (size_t) ceil( 2.0 * M_PI / _spacing ) ;
+    _az_spacing = 2.0 * M_PI / _num_az ;
+    _levels.resize( _num_de * _num_az * _num_freq ) ;
+
+    const vector<double> freq = frequencies ;
+    vector<double> level( _num_freq ) ;
+    orientation rotation( orient ) ;
+    double* table = _levels.empty() ? NULL : &_levels[0] ;
+    for ( size_t d=0 ; d < _num_de ; ++d ) {
+        const double de = -M_PI_2 + d * _de_spacing ;
+        for ( size_t a=0 ; a < _num_az ; ++a ) {
+            const double az = a * _az_spacing ;
+            pattern.beam_level( de, az, rotation, freq, &level ) ;
+            std::copy( level.begin(), level.end(), table ) ;
+            table += _num_freq ;
+        }
+    }
+}
+
+/**
+ * Interpolates the beam level in a specific direction.
+ */
+void beam_pattern_table::beam_level(
+    double de, double az, double* level ) const
+{
+    // find the DE interval, clipped to the ends of the axis
+
+    double u = ( de + M_PI_2 ) / _de_spacing ;
+    u = std::max( 0.0, std::min( u, (double) ( _num_de - 1 ) ) ) ;
+    size_t d = std::min( (size_t) u, _num_de - 2 ) ;
+    u -= d ;
+
+    // find the AZ interval, wrapped around 360 degrees
+
+    double v = fmod( az, 2.0 * M_PI ) ;
+    if ( v < 0.0 ) v += 2.0 * M_PI ;
+    v /= _az_spacing ;
+    size_t a = std::min( (size_t) v, _num_az - 1 ) ;
+    v -= a ;
+    const size_t a2 = ( a + 1 == _num_az ) ? 0 : a + 1 ;
+
+    // bi-linear interpolation at each frequency
+
+    const double* p00 = &_levels[ ( d * _num_az + a ) * _num_freq ] ;
+    const double* p01 = &_levels[ ( d * _num_az + a2 ) * _num_freq ] ;
+    const double* p10 = p00 + _num_az * _num_freq ;
+    const double* p11 = p01 + _num_az * _num_freq ;
+    const double w00 = ( 1.0 - u ) * ( 1.0 - v ) ;
+    const double w01 = ( 1.0 - u ) * v ;
+    const double w10 = u * ( 1.0 - v ) ;
+    const double w11 = u * v ;
+    for ( size_t f=0 ; f < _num_freq ; ++f ) {
+        level[f] = w00 * p00[f] + w01 * p01[f] + w10 * p10[f] + w11 * p11[f] ;
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file beam_pattern_table.h
+ * Beam pattern levels tabulated for a fixed orientation and frequency list.
+ */
+#pragma once
+
+#include <usml/sensors/beam_pattern_model.h>
+#include <vector>
+
+namespace usml {
+namespace sensors {
+
+using boost::numeric::ublas::vector ;
+using namespace usml::types ;
+
+/// @ingroup beams
+/// @{
+
+/**
+ * Beam levels for one beam_pattern_model, at a fixed orientation and list of
+ * frequencies, tabulated on a regular grid of DE and AZ angles.  The
+ * beam_level() method bi-linearly interpolates this table, so that
+ * computing a beam level is a table lookup instead of the transcendental
+ * math in most beam patterns.  The DE axis runs from -90 to +90 degrees
+ * and the AZ axis wraps around at 360 degrees.
+ *
+ * Tables are immutable once they are constructed, so a single table can be
+ * shared by many threads.  Use a new table when the orientation changes.
+ * Interpolation smooths out features narrower than the grid spacing,
+ * like the nulls of long line arrays, so the spacing should be a small
+ * fraction of the beam width.
+ */
+class USML_DECLSPEC beam_pattern_table {
+
+    public:
+
+        /**
+         * Data type used for reference to a beam_pattern_table.
+         */
+        typedef shared_ptr<const beam_pattern_table> reference;
+
+        /**
+         * Default spacing of the DE and AZ axes (rad).
+         * Defaults to 1.0 degree.
+         */
+        static double default_spacing ;
+
+        /**
+         * Evaluates the beam pattern at every point in the DE/AZ grid.
+         *
+         * @param pattern       Beam pattern to tabulate.
+         * @param orient        Orientation of the array.
+         * @param frequencies   List of frequencies to tabulate (Hz).
+         * @param spacing       Spacing of the DE and AZ axes (rad).
+         */
+        beam_pattern_table( beam_pattern_model& pattern,
+                            const orientation& orient,
+                            const seq_vector& frequencies,
+                            double spacing = default_spacing ) ;
+
+        /**
+         * Interpolates the beam level in a specific direction.
+         *
+         * @param de        Depression/Elevation angle (rad)
+         * @param az        Azimuthal angle (rad)
+         * @param level     Beam level for each frequency (squared linear
+         *                  units).  Must have room for num_freq() values.
+         */
+        void beam_level( double de, double az, double* level ) const ;
+
+        /** Number of frequencies in the table. */
+        size_t num_freq() const {
+            return _num_freq ;
+        }
+
+        /** Spacing of the DE and AZ axes (rad). */
+        double spacing() const {
+            return _spacing ;
+        }
+
+    private:
+
+        /** Number of frequencies in the table. */
+        const size_t _num_freq ;
+
+        /** Requested spacing of the DE and AZ axes (rad). */
+        const double _spacing ;
+
+        /** Number of points on the DE axis, from -90 to +90 degrees. */
+        size_t _num_de ;
+
+        /** Spacing of the DE axis (rad), adjusted to divide 180 evenly. */
+        double _de_spacing ;
+
+        /** Number of points on the AZ axis, not including 360 degrees. */
+        size_t _num_az ;
+
+        /** Spacing of the AZ axis (rad), adjusted to divide 360 evenly. */
+        double _az_spacing ;
+
+        /**
+         * Beam levels in DE, AZ, and then frequency order.
+         */
+        std::vector<double> _levels ;
+};
+
+/// @}
+}   // end of namespace sensors
+}   // end of namespace usml
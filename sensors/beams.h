@@ -29,3 +29,5 @@
 #include <usml/sensors/beam_pattern_solid.h>
 #include <usml/sensors/beam_pattern_multi.h>
 #include <usml/sensors/beam_pattern_grid.h>
+
+#include <usml/sensors/beam_pattern_table.h>
@@ -6,9 +6,11 @@
 #include <usml/sensors/sensor_model.h>
 #include <usml/sensors/source_params_map.h>
 #include <usml/sensors/receiver_params_map.h>
+#include <usml/sensors/beam_pattern_map.h>
 #include <usml/eigenverb/wavefront_generator.h>
 #include <usml/ocean/ocean_shared.h>
 #include <boost/foreach.hpp>
+#include <sstream>
 
 using namespace usml::sensors;
 using namespace usml::waveq3d;
@@ -60,7 +62,7 @@ sensor_model::sensor_model(sensor_model::id_type sensorID, sensor_params::id_typ
  */
 sensor_model::~sensor_model() {
 	if ( _wavefront_task.get() != 0 ) {
-		_wavefront_task->abort();
+		thread_controller::instance()->cancel(_wavefront_task);
 	}
 }
 
@@ -118,6 +120,39 @@ eigenverb_collection::reference sensor_model::eigenverbs() const {
 	return _eigenverb_collection;
 }
 
+/**
+ * Beam patterns tabulated at the current orientation of this sensor.
+ */
+std::vector<beam_pattern_table::reference> sensor_model::beam_tables(
+		const sensor_params::beam_pattern_list& beam_list,
+		const seq_vector& frequencies ) const
+{
+	const orientation current = orient() ;
+	const std::vector<double> freq( frequencies.begin(), frequencies.end() ) ;
+	std::vector<beam_pattern_table::reference> tables ;
+
+	boost::mutex::scoped_lock guard( _beam_table_mutex ) ;
+	if ( current.heading() != _beam_table_orient.heading()
+		|| current.pitch() != _beam_table_orient.pitch()
+		|| current.roll() != _beam_table_orient.roll() )
+	{
+		_beam_tables.clear() ;
+		_beam_table_orient = current ;
+	}
+	BOOST_FOREACH( beam_pattern_model::id_type id, beam_list ) {
+		beam_pattern_table::reference& table =
+			_beam_tables[ beam_table_key( id, freq ) ] ;
+		if ( ! table ) {
+			beam_pattern_model::reference pattern =
+				beam_pattern_map::instance()->find( id ) ;
+			table.reset( new beam_pattern_table(
+				*pattern, current, frequencies ) ) ;
+		}
+		tables.push_back( table ) ;
+	}
+	return tables ;
+}
+
 /**
  * Asynchronous update of eigenrays and eigenverbs data from the wavefront task.
  * Passes this data onto all sensor listeners.
@@ -312,8 +347,11 @@ void sensor_model::frequencies() {
  */
 void sensor_model::run_wave_generator() {
 
+    // use the same ocean snapshot for the whole wavefront calculation
+    ocean_shared::reference ocean = ocean_shared::current() ;
+
     // Only run wavefront generator if ocean_model pointer is not NULL
-    if (ocean_shared::current().get() != NULL ) {
+    if (ocean.get() != NULL ) {
 
         #ifdef USML_DEBUG
             cout << "sensor_model: run_wave_generator(" << _sensorID << ")" << endl ;
@@ -334,7 +372,12 @@ void sensor_model::run_wave_generator() {
 
         // Create the wavefront_generator
         wavefront_generator* generator = new wavefront_generator (
-            ocean_shared::current(), _position, target_pos, _frequencies.get(), this);
+            ocean, _position, target_pos, _frequencies.get(), this);
+
+        // Replace any queued or running task for this sensor
+        std::ostringstream key ;
+        key << "wavefront " << _sensorID ;
+        generator->supersede_key( key.str() ) ;
 
         // Make wavefront_generator a wavefront_task, with use of shared_ptr
         _wavefront_task = thread_task::reference(generator);
@@ -344,7 +387,7 @@ void sensor_model::run_wave_generator() {
     }
 
     #ifdef USML_DEBUG
-        if (ocean_shared::current().get() == NULL ) {
+        if (ocean.get() == NULL ) {
              cout << "sensor_model: run_wave_generator no ocean provided !!! (" << _sensorID << ")" << endl ;
         }
     #endif
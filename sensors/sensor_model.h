@@ -6,6 +6,7 @@
 
 #include <usml/eigenverb/eigenverb_collection.h>
 #include <usml/eigenverb/wavefront_listener.h>
+#include <usml/sensors/beam_pattern_table.h>
 #include <usml/sensors/receiver_params.h>
 #include <usml/sensors/sensor_listener.h>
 #include <usml/sensors/orientation.h>
@@ -13,6 +14,7 @@
 #include <usml/sensors/xmitRcvModeType.h>
 #include <usml/threads/thread_task.h>
 #include <usml/waveq3d/eigenray_collection.h>
+#include <map>
 #include <set>
 
 namespace usml {
@@ -166,6 +168,21 @@ public:
      */
     eigenverb_collection::reference eigenverbs() const ;
 
+    /**
+     * Beam patterns tabulated at the current orientation of this sensor.
+     * Tables are built the first time that a beam pattern is requested
+     * for a specific list of frequencies, and then shared by all of
+     * the sensor pairs that use this sensor, until the orientation
+     * changes.
+     *
+     * @param beam_list     Beam pattern IDs, in beam number order.
+     * @param frequencies   Frequencies at which to tabulate the beams (Hz).
+     * @return              Tabulated beam pattern for each beam number.
+     */
+    std::vector<beam_pattern_table::reference> beam_tables(
+            const sensor_params::beam_pattern_list& beam_list,
+            const seq_vector& frequencies ) const ;
+
     /**
      * Asynchronous update of eigenrays and eigenverbs data from the wavefront task.
      * Passes this data onto all sensor listeners.
@@ -367,6 +384,29 @@ private:
      */
     mutable read_write_lock _eigenverbs_mutex ;
 
+    /**
+     * Key used to find a tabulated beam pattern: beam pattern ID
+     * and the list of frequencies in the table.
+     */
+    typedef std::pair< beam_pattern_model::id_type, std::vector<double> >
+        beam_table_key ;
+
+    /**
+     * Beam patterns tabulated at _beam_table_orient.
+     */
+    mutable std::map< beam_table_key, beam_pattern_table::reference >
+        _beam_tables ;
+
+    /**
+     * Orientation used to build the tabulated beam patterns.
+     */
+    mutable orientation _beam_table_orient ;
+
+    /**
+     * Mutex that locks the tabulated beam patterns.
+     */
+    mutable boost::mutex _beam_table_mutex ;
+
     /**
      * reference to the task that is computing eigenrays and eigenverbs.
      */
@@ -7,6 +7,7 @@
 #include <usml/eigenverb/wavefront_generator.h>
 #include <usml/waveq3d/eigenray_interpolator.h>
 #include <boost/foreach.hpp>
+#include <sstream>
 
 using namespace usml::sensors;
 using namespace usml::waveq3d;
@@ -20,15 +21,15 @@ void sensor_pair::run_envelope_generator(double initial_time) {
         cout << "sensor_pair: run_envelope_generator " << endl ;
     #endif
 
-    // Kill any currently running task
-    if ( _envelopes_task.get() != 0 ) {
-        _envelopes_task->abort();
-    }
-
     // Create the envelope_generator
     envelope_generator* generator = new envelope_generator (
 		this, initial_time, _src_freq_first, wavefront_generator::number_az );
 
+    // Replace any queued or running task for this pair
+    std::ostringstream key ;
+    key << "envelope " << _source->sensorID() << "/" << _receiver->sensorID() ;
+    generator->supersede_key( key.str() ) ;
+
     // Make envelope_generator a _envelopes_task, with use of shared_ptr
     _envelopes_task = thread_task::reference(generator);
 
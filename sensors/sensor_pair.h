@@ -13,6 +13,7 @@
 #include <usml/eigenverb/envelope_listener.h>
 #include <usml/eigenverb/envelope_collection.h>
 #include <usml/eigenverb/eigenverb_collection.h>
+#include <usml/threads/thread_controller.h>
 
 namespace usml {
 namespace sensors{
@@ -58,7 +59,7 @@ public:
     virtual ~sensor_pair() {
         delete _frequencies;
         if ( _envelopes_task.get() != 0 ) {
-            _envelopes_task->abort();
+            thread_controller::instance()->cancel(_envelopes_task);
         }
     }
 
@@ -5,9 +5,14 @@
 #include <usml/sensors/sensor_pair_manager.h>
 #include <usml/sensors/sensor_manager.h>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
 
 using namespace usml::sensors;
 
+const size_t sensor_pair_manager::num_stripes ;
+
 /**
  * Initialization of private static member _instance
  */
@@ -40,7 +45,7 @@ sensor_pair_manager* sensor_pair_manager::instance() {
 sensor_pair_manager::~sensor_pair_manager() {
 
     // Remove all sensor_pair pointers from the _map
-    sensor_map_template<std::string, sensor_pair*>::iterator iter;
+    std::map<pair_id_type, sensor_pair*>::iterator iter;
     for ( iter = _map.begin(); iter != _map.end(); ++iter )
     {
         sensor_pair* pair_data = iter->second;
@@ -52,124 +57,193 @@ sensor_pair_manager::~sensor_pair_manager() {
  * Reset the sensor_pair_manager instance to empty.
  */
 void sensor_pair_manager::reset() {
-    write_lock_guard(_instance_mutex);
+    write_lock_guard guard(_instance_mutex);
     _instance.reset();
 }
 
 /**
- * Finds all the keys in the _map that are in the sensor_data_list
+ * Acquires an exclusive lock on all of the stripes, in order.
  */
-std::set<std::string> sensor_pair_manager::find_pairs(const sensor_data_map &sensors)
-{   
-    std::set<std::string> hash_keys;
-    std::set<sensor_model::id_type> source_ids;
-    std::set<sensor_model::id_type> receiver_ids;
-    std::set<sensor_model::id_type>::iterator test_iter;
-
-    // Create a source_keys list and a receiver_key list 
-    // of the requested items
-    sensor_data sensor;
-    xmitRcvModeType mode;
-    sensor_model::id_type sensorID;
-    
-    std::pair<sensor_model::id_type,sensor_data> map_pair;
+class sensor_pair_manager::writer_guard {
+public:
+    writer_guard(lock_stripe* stripes) : _stripes(stripes) {
+        for ( size_t n=0 ; n < num_stripes ; ++n ) {
+            _stripes[n].mutex.lock();
+        }
+    }
+    ~writer_guard() {
+        for ( size_t n=num_stripes ; n > 0 ; --n ) {
+            _stripes[n-1].mutex.unlock();
+        }
+    }
+private:
+    lock_stripe* _stripes;
+};
+
+/**
+ * Lock stripe used by the current thread for queries.
+ */
+read_write_lock& sensor_pair_manager::reader_mutex() const {
+    const size_t hash =
+        boost::hash<boost::thread::id>()( boost::this_thread::get_id() );
+    return _stripes[ hash % num_stripes ].mutex;
+}
+
+namespace {
+
+/**
+ * Orders a list of pairs by receiver ID.
+ */
+struct by_receiver {
+    bool operator()(const sensor_pair* a, sensor_model::id_type id) const {
+        return a->receiver()->sensorID() < id;
+    }
+};
+
+/**
+ * Orders a list of pairs by source ID.
+ */
+struct by_source {
+    bool operator()(const sensor_pair* a, sensor_model::id_type id) const {
+        return a->source()->sensorID() < id;
+    }
+};
+
+/**
+ * Current position of the source and receiver for a pair.
+ * If source/receiver is in sensors list get current position
+ * else use initial value
+ */
+void current_positions(const sensor_data_map &sensors, const sensor_pair* pair,
+    wposition1* curr_src_pos, wposition1* curr_rcv_pos)
+{
+    sensor_data_map::const_iterator map_iter;
+    map_iter = sensors.find(pair->source()->sensorID());
+    if (map_iter != sensors.end()) {
+        *curr_src_pos = map_iter->second._position;
+    } else {
+        *curr_src_pos = pair->source()->position();
+    }
+    map_iter = sensors.find(pair->receiver()->sensorID());
+    if (map_iter != sensors.end()) {
+        *curr_rcv_pos = map_iter->second._position;
+    } else {
+        *curr_rcv_pos = pair->receiver()->position();
+    }
+}
+
+/**
+ * Adds the fathometer of each pair found to a fathometer_package.
+ */
+struct fathometer_visitor {
+    const sensor_data_map& sensors;
+    fathometer_collection::fathometer_package& fathometers;
 
-    BOOST_FOREACH(map_pair, sensors)
+    fathometer_visitor(const sensor_data_map& s,
+        fathometer_collection::fathometer_package& f) :
+        sensors(s), fathometers(f)
     {
-        sensorID = map_pair.second._sensorID;
-        mode = map_pair.second._mode;
-      
-        // Only add keys if the sensorID already exist in its respected list
-        switch ( mode )
+    }
+
+    void operator()(sensor_pair* pair_data) {
+        fathometer_collection::reference fathometer = pair_data->fathometer();
+        if ( fathometer.get() != NULL )
         {
-            case usml::sensors::SOURCE:
-                test_iter = _src_list.find(sensorID);
-                if ( test_iter != _src_list.end() ) {
-                    source_ids.insert(sensorID);
-                }
-                break;
-            case usml::sensors::RECEIVER:
-                test_iter = _rcv_list.find(sensorID);
-                if ( test_iter != _rcv_list.end() ) {
-                    receiver_ids.insert(sensorID);
-                }
-                break;
-            case usml::sensors::BOTH:
-                test_iter = _src_list.find(sensorID);
-                if ( test_iter != _src_list.end() )
-                {
-                    source_ids.insert(sensorID);
-               
-                    test_iter = _rcv_list.find(sensorID);
-                    if ( test_iter != _rcv_list.end() ) {
-                        receiver_ids.insert(sensorID);
-                    } else { // Did not exist, backout of source_ids
-                        source_ids.erase(sensorID);
-                    }
-                }
-                break;
-            default:
-                break;
+            if (pair_data->multistatic()) {
+                wposition1 curr_src_pos;
+                wposition1 curr_rcv_pos;
+                current_positions(sensors, pair_data, &curr_src_pos, &curr_rcv_pos);
+                pair_data->dead_reckon_fathometer(curr_src_pos, curr_rcv_pos);
+            }
+            fathometers.push_back(fathometer.get());
         }
     }
+};
 
-    // Build hash_keys from source_ids and receiver_ids 
-    BOOST_FOREACH(sensor_model::id_type srcID, source_ids)
+/**
+ * Adds the envelopes of each pair found to an envelope_package.
+ */
+struct envelope_visitor {
+    const sensor_data_map& sensors;
+    envelope_collection::envelope_package& envelopes;
+
+    envelope_visitor(const sensor_data_map& s,
+        envelope_collection::envelope_package& e) :
+        sensors(s), envelopes(e)
     {
-        BOOST_FOREACH(sensor_model::id_type rcvID, receiver_ids)
-        {
-            std::string key = generate_hash_key(srcID, rcvID);
-            hash_keys.insert(key);
+    }
+
+    void operator()(sensor_pair* pair_data) {
+        envelope_collection::reference collection = pair_data->envelopes();
+        if ( collection.get() != NULL ) {
+            if (pair_data->multistatic()) {
+                wposition1 curr_src_pos;
+                wposition1 curr_rcv_pos;
+                current_positions(sensors, pair_data, &curr_src_pos, &curr_rcv_pos);
+                pair_data->dead_reckon_envelopes(curr_src_pos, curr_rcv_pos);
+            }
+            envelopes.push_back(collection.get());
         }
     }
-    
-    return hash_keys;
-}
+};
+
+}   // end of anonymous namespace
 
 /**
- * Gets the fathometers for sensors in the sensor_data_list.
+ * Determines if a sensor is requested as a source or receiver.
  */
-fathometer_collection::fathometer_package sensor_pair_manager::get_fathometers(const sensor_data_map& sensors)
+bool sensor_pair_manager::requested(const sensor_data_map &sensors,
+    sensor_model::id_type id, bool source) const
 {
-    sensor_pair* pair;
-    read_lock_guard guard(_manager_mutex);
+    sensor_data_map::const_iterator iter = sensors.find(id);
+    if ( iter == sensors.end() ) return false;
 
-    std::set<std::string> keys = find_pairs(const_cast<sensor_data_map&>(sensors));
-    fathometer_collection::fathometer_package fathometers;
-    fathometers.reserve(keys.size());
-    BOOST_FOREACH(std::string s, keys)
+    // Only use sensorID if it exists in its respected list
+    switch ( iter->second._mode )
     {
-        pair = _map.find(s);
-        sensor_pair* pair_data = pair;
-        if ( pair_data != NULL ) {
-            fathometer_collection::reference fathometer = pair_data->fathometer();
-            if ( fathometer.get() != NULL )
-            {
-                if (pair_data->multistatic()) {
-                	// if source/receiver is in sensors list get current position
-                	// else use initial value
-                	wposition1 curr_src_pos;
-                	sensor_data_map::const_iterator map_iter;
-                	map_iter = sensors.find(pair_data->source()->sensorID());
-					if (map_iter != sensors.end()) {
-						curr_src_pos = map_iter->second._position;
-					} else {
-						curr_src_pos = pair_data->source()->position();
-					}
-					wposition1 curr_rcv_pos;
-					map_iter = sensors.find(pair_data->receiver()->sensorID());
-					if (map_iter != sensors.end()) {
-						curr_rcv_pos = map_iter->second._position;
-					} else {
-						curr_rcv_pos = pair_data->receiver()->position();
-					}
-
-					pair_data->dead_reckon_fathometer(curr_src_pos, curr_rcv_pos);
-                }
-                fathometers.push_back(fathometer.get());
+        case usml::sensors::SOURCE:
+            return source && _src_list.count(id) != 0;
+        case usml::sensors::RECEIVER:
+            return !source && _rcv_list.count(id) != 0;
+        case usml::sensors::BOTH:
+            return _src_list.count(id) != 0 && _rcv_list.count(id) != 0;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Finds all the pairs whose source and receiver are in the sensor_data_map
+ */
+template< class Visitor >
+void sensor_pair_manager::find_pairs(const sensor_data_map &sensors,
+    Visitor& visitor) const
+{
+    for ( sensor_data_map::const_iterator iter = sensors.begin();
+          iter != sensors.end(); ++iter )
+    {
+        const sensor_model::id_type srcID = iter->first;
+        if ( !requested(sensors, srcID, true) ) continue;
+        pair_index::const_iterator list = _src_pairs.find(srcID);
+        if ( list == _src_pairs.end() ) continue;
+        BOOST_FOREACH(sensor_pair* pair, list->second)
+        {
+            if ( requested(sensors, pair->receiver()->sensorID(), false) ) {
+                visitor(pair);
             }
         }
     }
+}
+
+/**
+ * Gets the fathometers for sensors in the sensor_data_list.
+ */
+fathometer_collection::fathometer_package sensor_pair_manager::get_fathometers(const sensor_data_map& sensors)
+{
+    read_lock_guard guard(reader_mutex());
+    fathometer_collection::fathometer_package fathometers;
+    fathometer_visitor visitor(sensors, fathometers);
+    find_pairs(sensors, visitor);
     return fathometers;
 }
 
@@ -178,53 +252,77 @@ fathometer_collection::fathometer_package sensor_pair_manager::get_fathometers(c
  */
 envelope_collection::envelope_package sensor_pair_manager::get_envelopes(const sensor_data_map &sensors)
 {
-    sensor_pair* pair;
-    read_lock_guard guard(_manager_mutex);
-
-    std::set<std::string> keys = find_pairs(sensors);
+    read_lock_guard guard(reader_mutex());
     envelope_collection::envelope_package envelopes;
-    envelopes.reserve(keys.size());
-    BOOST_FOREACH(std::string s, keys)
-    {
-        pair = _map.find(s);
-        sensor_pair* pair_data = pair;
-        if ( pair_data != NULL ) {
-            envelope_collection::reference collection = pair_data->envelopes();
-            if ( collection.get() != NULL ) {
-                if (pair_data->multistatic()) {
-                	// if source/receiver is in sensors list get current position
-                	// else use initial value
-                	wposition1 curr_src_pos;
-					sensor_data_map::const_iterator map_iter;
-					map_iter = sensors.find(pair_data->source()->sensorID());
-					if (map_iter != sensors.end()) {
-						curr_src_pos = map_iter->second._position;
-					} else {
-						curr_src_pos = pair_data->source()->position();
-					}
-					wposition1 curr_rcv_pos;
-					map_iter = sensors.find(pair_data->receiver()->sensorID());
-					if (map_iter != sensors.end()) {
-						curr_rcv_pos = map_iter->second._position;
-					} else {
-						curr_rcv_pos = pair_data->receiver()->position();
-					}
-
-					pair_data->dead_reckon_envelopes(curr_src_pos, curr_rcv_pos);
-                }
-                envelopes.push_back(collection.get());
-            }
-        }
-    }
+    envelope_visitor visitor(sensors, envelopes);
+    find_pairs(sensors, visitor);
     return envelopes;
 }
 
+/**
+ * Number of sensor pairs currently in the manager.
+ */
+size_t sensor_pair_manager::num_pairs() const {
+    read_lock_guard guard(reader_mutex());
+    return _map.size();
+}
+
+/**
+ * Determines if the manager has a pair for a source and receiver.
+ */
+bool sensor_pair_manager::has_pair(const sensor_model::id_type src_id,
+                                   const sensor_model::id_type rcv_id) const
+{
+    read_lock_guard guard(reader_mutex());
+    return _map.count(generate_pair_id(src_id, rcv_id)) != 0;
+}
+
+/**
+ * Adds a pair to the pair map and to the lists of pairs
+ * for its source and receiver.
+ */
+void sensor_pair_manager::insert_pair(sensor_pair* pair) {
+    const sensor_model::id_type sourceID = pair->source()->sensorID();
+    const sensor_model::id_type receiverID = pair->receiver()->sensorID();
+    _map[generate_pair_id(sourceID, receiverID)] = pair;
+
+    pair_list& src_list = _src_pairs[sourceID];
+    src_list.insert( std::lower_bound(src_list.begin(), src_list.end(),
+        receiverID, by_receiver()), pair );
+
+    pair_list& rcv_list = _rcv_pairs[receiverID];
+    rcv_list.insert( std::lower_bound(rcv_list.begin(), rcv_list.end(),
+        sourceID, by_source()), pair );
+}
+
+/**
+ * Removes a pair from the pair map and from the lists of pairs
+ * for its source and receiver, and then deletes it.
+ */
+void sensor_pair_manager::erase_pair(sensor_pair* pair) {
+    const sensor_model::id_type sourceID = pair->source()->sensorID();
+    const sensor_model::id_type receiverID = pair->receiver()->sensorID();
+    _map.erase(generate_pair_id(sourceID, receiverID));
+
+    pair_list& src_list = _src_pairs[sourceID];
+    src_list.erase( std::remove(src_list.begin(), src_list.end(), pair),
+                    src_list.end() );
+    if ( src_list.empty() ) _src_pairs.erase(sourceID);
+
+    pair_list& rcv_list = _rcv_pairs[receiverID];
+    rcv_list.erase( std::remove(rcv_list.begin(), rcv_list.end(), pair),
+                    rcv_list.end() );
+    if ( rcv_list.empty() ) _rcv_pairs.erase(receiverID);
+
+    delete pair;
+}
+
 /**
  * Builds new sensor_pair objects in reaction to notification
  * that a sensor is being added.
  */
 void sensor_pair_manager::add_sensor(sensor_model* sensor) {
-	write_lock_guard guard(_manager_mutex);
+	writer_guard guard(_stripes);
 	#ifdef USML_DEBUG
 		cout << "sensor_pair_manager: add sensor("
 		<< sensor->sensorID() << ")" << endl;
@@ -276,11 +374,12 @@ void sensor_pair_manager::add_sensor(sensor_model* sensor) {
     #ifdef USML_DEBUG
         // Print out all pairs
         cout << "sensor_pair_manager:  current pairs" << endl;
-        sensor_map_template<std::string, sensor_pair*>::iterator iter;
+        std::map<pair_id_type, sensor_pair*>::iterator iter;
         for ( iter = _map.begin(); iter != _map.end(); ++iter )
         {
-            std::string key  = iter->first;
-            cout << "     pair  src_rcv " << key << endl;      
+            sensor_pair* pair = iter->second;
+            cout << "     pair  src_rcv " << pair->source()->sensorID()
+                 << "_" << pair->receiver()->sensorID() << endl;
          } 
     #endif
 }
@@ -291,7 +390,7 @@ void sensor_pair_manager::add_sensor(sensor_model* sensor) {
  */
 bool sensor_pair_manager::remove_sensor(sensor_model* sensor) {
     size_t result = 0;
-	write_lock_guard guard(_manager_mutex);
+	writer_guard guard(_stripes);
 	#ifdef USML_DEBUG
 		cout << "sensor_pair_manager: remove sensor("
 		<< sensor->sensorID() << ")" << endl;
@@ -351,9 +450,9 @@ bool sensor_pair_manager::remove_sensor(sensor_model* sensor) {
  */
 void sensor_pair_manager::add_monostatic_pair(sensor_model* sensor) {
 	sensor_model::id_type sourceID = sensor->sensorID();
-    std::string hash_key = generate_hash_key(sourceID, sourceID);
-    sensor_pair* pair = new sensor_pair(sensor, sensor); 
-	_map.insert(hash_key, pair);
+	if ( _map.count(generate_pair_id(sourceID, sourceID)) != 0 ) return;
+    sensor_pair* pair = new sensor_pair(sensor, sensor);
+	insert_pair(pair);
 	sensor->add_sensor_listener(pair);
 	#ifdef USML_DEBUG
 		cout << "   add_monostatic_pair: sensor_pair("
@@ -373,11 +472,11 @@ void sensor_pair_manager::add_multistatic_source(sensor_model* source) {
                     receiver_sensor->receiver()->multistatic() &&
                     frequencies_overlap(source->source()->frequencies(), 
                     receiver_sensor->receiver()->min_active_freq(),
-                    receiver_sensor->receiver()->max_active_freq()) )
+                    receiver_sensor->receiver()->max_active_freq()) &&
+                    _map.count(generate_pair_id(sourceID, receiverID)) == 0 )
 			{
-                std::string hash_key = generate_hash_key(sourceID, receiverID);
                 sensor_pair* pair = new sensor_pair(source, receiver_sensor);
-                _map.insert(hash_key, pair);
+                insert_pair(pair);
 				source->add_sensor_listener(pair);
                 receiver_sensor->add_sensor_listener(pair);
 				#ifdef USML_DEBUG
@@ -401,11 +500,11 @@ void sensor_pair_manager::add_multistatic_receiver(sensor_model* receiver) {
                     source_sensor->source()->multistatic() &&
                     frequencies_overlap(source_sensor->source()->frequencies(), 
                                         receiver->receiver()->min_active_freq(),
-                                        receiver->receiver()->max_active_freq()) )
+                                        receiver->receiver()->max_active_freq()) &&
+                    _map.count(generate_pair_id(sourceID, receiverID)) == 0 )
 			{
-                std::string hash_key = generate_hash_key(sourceID, receiverID);
                 sensor_pair* pair = new sensor_pair(source_sensor, receiver);
-                _map.insert(hash_key, pair);
+                insert_pair(pair);
                 source_sensor->add_sensor_listener(pair);
 				receiver->add_sensor_listener(pair);
 				#ifdef USML_DEBUG
@@ -422,12 +521,11 @@ void sensor_pair_manager::add_multistatic_receiver(sensor_model* receiver) {
  */
 void sensor_pair_manager::remove_monostatic_pair(sensor_model* sensor) {
 	sensor_model::id_type sourceID = sensor->sensorID();
-    std::string hash_key = generate_hash_key(sourceID, sourceID);
-	sensor_pair* pair = _map.find(hash_key);
-	if (pair != NULL) {
-		sensor->remove_sensor_listener(pair);
-        delete pair;
-		_map.erase(hash_key);
+	std::map<pair_id_type, sensor_pair*>::iterator iter =
+	    _map.find(generate_pair_id(sourceID, sourceID));
+	if (iter != _map.end()) {
+		sensor->remove_sensor_listener(iter->second);
+		erase_pair(iter->second);
 		#ifdef USML_DEBUG
 			cout << "   remove_monostatic_pair: sensor_pair("
 				 << sourceID << "," << sourceID << ")" << endl;
@@ -437,62 +535,54 @@ void sensor_pair_manager::remove_monostatic_pair(sensor_model* sensor) {
 
 /**
  * Utility to remove a multistatic pair from the source.
+ * Uses the list of pairs for this source, instead of searching
+ * the list of active receivers.
  */
 void sensor_pair_manager::remove_multistatic_source(sensor_model* source) {
 	sensor_model::id_type sourceID = source->sensorID();
-	BOOST_FOREACH( sensor_model::id_type receiverID, _rcv_list ) {
+	pair_index::iterator list = _src_pairs.find(sourceID);
+	if ( list == _src_pairs.end() ) return;
+	const pair_list pairs( list->second );
+	BOOST_FOREACH( sensor_pair* pair, pairs ) {
+		sensor_model::id_type receiverID = pair->receiver()->sensorID();
 		if ( sourceID != receiverID ) {
             sensor_model* receiver_sensor = sensor_manager::instance()->find(receiverID);
-            if ( receiver_sensor != NULL &&
-                    receiver_sensor->receiver()->multistatic() &&
-                    frequencies_overlap(source->source()->frequencies(), 
-                                        receiver_sensor->receiver()->min_active_freq(),
-                                        receiver_sensor->receiver()->max_active_freq()) )
-			{
-                std::string hash_key = generate_hash_key(sourceID, receiverID);
-				sensor_pair* pair = _map.find(hash_key);
-				if ( pair != NULL ) {
-					source->remove_sensor_listener(pair);
-                    receiver_sensor->remove_sensor_listener(pair);
-                    delete pair;
-					_map.erase( hash_key );
-					#ifdef USML_DEBUG
-						cout << "   remove_multistatic_source: sensor_pair("
-							 << sourceID << "," << receiverID << ")" << endl;
-					#endif
-				}
-			}
+			source->remove_sensor_listener(pair);
+            if ( receiver_sensor != NULL ) {
+                receiver_sensor->remove_sensor_listener(pair);
+            }
+			erase_pair(pair);
+			#ifdef USML_DEBUG
+				cout << "   remove_multistatic_source: sensor_pair("
+					 << sourceID << "," << receiverID << ")" << endl;
+			#endif
 		}
 	}
 }
 
 /**
  * Utility to remove a multistatic pair from the receiver.
+ * Uses the list of pairs for this receiver, instead of searching
+ * the list of active sources.
  */
 void sensor_pair_manager::remove_multistatic_receiver(sensor_model* receiver) {
 	sensor_model::id_type receiverID = receiver->sensorID();
-	BOOST_FOREACH( sensor_model::id_type sourceID, _src_list ) {
+	pair_index::iterator list = _rcv_pairs.find(receiverID);
+	if ( list == _rcv_pairs.end() ) return;
+	const pair_list pairs( list->second );
+	BOOST_FOREACH( sensor_pair* pair, pairs ) {
+		sensor_model::id_type sourceID = pair->source()->sensorID();
 		if ( sourceID != receiverID ) { // exclude monostatic case
 			sensor_model* source_sensor = sensor_manager::instance()->find(sourceID);
-            if ( source_sensor != NULL && 
-                source_sensor->source()->multistatic() && 
-                frequencies_overlap(source_sensor->source()->frequencies(), 
-                                    receiver->receiver()->min_active_freq(),
-                                    receiver->receiver()->max_active_freq()) )
-			{
-                std::string hash_key = generate_hash_key(sourceID, receiverID);
-				sensor_pair* pair = _map.find(hash_key);
-				if ( pair != NULL ) {
-                    source_sensor->remove_sensor_listener(pair);
-					receiver->remove_sensor_listener(pair);
-                    delete pair;
-					_map.erase( hash_key );
-					#ifdef USML_DEBUG
-						cout << "   remove_multistatic_receiver: sensor_pair("
-							 << sourceID << "," << receiverID << ")" << endl;
-					#endif
-				}
-			}
+            if ( source_sensor != NULL ) {
+                source_sensor->remove_sensor_listener(pair);
+            }
+			receiver->remove_sensor_listener(pair);
+			erase_pair(pair);
+			#ifdef USML_DEBUG
+				cout << "   remove_multistatic_receiver: sensor_pair("
+					 << sourceID << "," << receiverID << ")" << endl;
+			#endif
 		}
 	}
 }
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <set>
+#include <vector>
+#include <boost/cstdint.hpp>
 
 #include <usml/sensors/sensor_model.h>
 #include <usml/sensors/sensor_pair.h>
@@ -25,9 +27,19 @@ namespace sensors {
  * Stores and manages the active sensor pairs in use by the simulation.
  * A sensor pair contains a source, receiver acoustic pair and it's
  * associated data. The each sensor_pair uses boost::shared_ptrs to the data
- * required. The sensor_pair_manager has a sensor_pair_map, that uses a 
- * std::string type hash key which created using the generate_hash_key call.
- * The payload of the sensor_pair_map is a shared pointer to the sensor_pair data.
+ * required. Pairs are stored in a map keyed by a 64 bit pair ID, which
+ * packs the source and receiver IDs together (see generate_pair_id).
+ * Each source and receiver also keeps a list of the pairs that it belongs
+ * to, so that get_fathometers() and get_envelopes() can find the pairs
+ * for a query without building any temporary containers.
+ *
+ * Queries are expected to be far more frequent than changes to the list
+ * of sensors, and to come from many threads at once.  Instead of a single
+ * manager wide read_write_lock, the manager keeps several lock stripes,
+ * each on its own cache line.  A query takes a shared lock on the stripe
+ * selected by its thread ID, so that concurrent queries do not contend
+ * for the same lock.  Adding or removing a sensor takes an exclusive
+ * lock on every stripe.
  */
 class USML_DECLSPEC sensor_pair_manager {
 
@@ -39,6 +51,31 @@ public:
     //typedef std::map<sensor_model::id_type, xmitRcvModeType> sensor_query_map ;
     //typedef std::pair<sensor_model::id_type, xmitRcvModeType> query_type ;
 
+    /**
+     * Data type used to identify a sensor_pair.
+     * Packs the source ID into the upper 32 bits
+     * and the receiver ID into the lower 32 bits.
+     */
+    typedef boost::uint64_t pair_id_type ;
+
+    /**
+     * Number of lock stripes used to protect the pairs.
+     */
+    static const size_t num_stripes = 16 ;
+
+    /**
+     * Generate the ID of a sensor_pair from its source and receiver IDs.
+     * @param    src_id   The source id used to generate the pair ID.
+     * @param    rcv_id   The receiver id used to generate the pair ID.
+     * @return   pair ID with the source in the upper 32 bits.
+     */
+    static pair_id_type generate_pair_id(const sensor_model::id_type src_id,
+                                         const sensor_model::id_type rcv_id)
+    {
+        return ( (pair_id_type) (boost::uint32_t) src_id << 32 )
+             | (pair_id_type) (boost::uint32_t) rcv_id ;
+    }
+
     /**
      * Singleton Constructor - Creates sensor_pair_manager instance just once.
      * Accessible everywhere.
@@ -210,6 +247,20 @@ public:
      */
     envelope_collection::envelope_package get_envelopes(const sensor_data_map &sensors);
 
+    /**
+     * Number of sensor pairs currently in the manager.
+     */
+    size_t num_pairs() const;
+
+    /**
+     * Determines if the manager has a pair for a source and receiver.
+     * @param    src_id   The source id of the pair.
+     * @param    rcv_id   The receiver id of the pair.
+     * @return   true if the pair exists.
+     */
+    bool has_pair(const sensor_model::id_type src_id,
+                  const sensor_model::id_type rcv_id) const;
+
 protected:
 
     /**
@@ -292,27 +343,67 @@ private:
      */
     void remove_multistatic_receiver(sensor_model* receiver);
 
-   /**
-    * Utility to generate a hash key for the sensor_pair_map
-    * @param    src_id   The source id used to generate the hash_key
-    * @param    rcv_id   The receiver id used to generate the hash_key
-    * @return   string   containing the generated hash_key.
-    */
-    std::string generate_hash_key(const sensor_model::id_type src_id,
-                                    const sensor_model::id_type rcv_id)
-    {
-        std::stringstream key;
-        key << src_id << '_' << rcv_id;
-        return key.str();
-    }
+    /**
+     * List of pairs that a single sensor belongs to.
+     */
+    typedef std::vector<sensor_pair*> pair_list ;
+
+    /**
+     * Lists of pairs indexed by sensor ID.
+     */
+    typedef std::map<sensor_model::id_type, pair_list> pair_index ;
 
     /**
-     * Utility to find the sensor_pair keys that are provided in the 
-     * sensor_query_map parameter.
-     * @param    sensors Contains a sensor_data_map of sensorID and modes that needs to be found
-     * @return   list of hash keys in the _map.
+     * Utility to add a pair to the pair map and to the lists of pairs
+     * for its source and receiver.
+     * @param    pair    Pair to be added.
      */
-    std::set<std::string> find_pairs(const sensor_data_map &sensors);
+    void insert_pair(sensor_pair* pair);
+
+    /**
+     * Utility to remove a pair from the pair map and from the lists of
+     * pairs for its source and receiver, and then delete it.
+     * @param    pair    Pair to be removed.
+     */
+    void erase_pair(sensor_pair* pair);
+
+    /**
+     * Utility to determine if a sensor is requested in the role of a
+     * source or receiver.  Sensors whose mode is BOTH are only used if
+     * they are active as both a source and a receiver.
+     * @param    sensors   Contains a sensor_data_map of sensorID and modes
+     *                     that needs to be found
+     * @param    id        ID of the sensor to test.
+     * @param    source    Test for the role of a source if true,
+     *                     and the role of a receiver if false.
+     * @return   true if the query uses this sensor in that role.
+     */
+    bool requested(const sensor_data_map &sensors,
+                   sensor_model::id_type id, bool source) const;
+
+    /**
+     * Utility to find the sensor_pairs that are provided in the
+     * sensor_data_map parameter.  Walks the list of pairs for each
+     * requested source, and applies the visitor to each pair whose
+     * receiver was also requested.  Does not allocate memory.  Caller
+     * must hold a shared lock on one of the lock stripes.
+     * @param    sensors Contains a sensor_data_map of sensorID and modes
+     *                   that needs to be found
+     * @param    visitor Operation applied to each pair found.
+     */
+    template< class Visitor >
+    void find_pairs(const sensor_data_map &sensors, Visitor& visitor) const;
+
+    /**
+     * Lock stripe used by the current thread for queries.
+     */
+    read_write_lock& reader_mutex() const;
+
+    /**
+     * Acquires an exclusive lock on all of the stripes.
+     */
+    class writer_guard ;
+    friend class writer_guard ;
 
     /**
      * Utility to determine if two frequency ranges overlap
@@ -351,9 +442,19 @@ private:
     static read_write_lock _instance_mutex;
 
     /**
-     * The mutex for adding and removing pairs in manager.
+     * A read_write_lock padded to fill its own cache line, so that
+     * readers on different stripes do not share memory.
+     */
+    struct lock_stripe {
+        read_write_lock mutex ;
+        char padding[64] ;
+    } ;
+
+    /**
+     * The mutexes for adding and removing pairs in manager.
+     * Queries lock one stripe, changes lock all of them.
      */
-    mutable read_write_lock _manager_mutex;
+    mutable lock_stripe _stripes[num_stripes];
 
     /**
      * List of all active source sensor IDs.  Used by add_sensor() to find
@@ -369,11 +470,21 @@ private:
 
     /**
      * Container for storing the sensor pair objects.
-     * Key is a string concatenation of "sourceID" + "_" + "receiverID"
-     * See generate_hash_key method.
+     * Key is the packed source and receiver ID.
+     * See generate_pair_id method.
      * Payload is a pointer to sensor_pair object.
      */
-    sensor_map_template<std::string,sensor_pair*> _map ;
+    std::map<pair_id_type,sensor_pair*> _map ;
+
+    /**
+     * Pairs for each source, sorted by receiver ID.
+     */
+    pair_index _src_pairs ;
+
+    /**
+     * Pairs for each receiver, sorted by source ID.
+     */
+    pair_index _rcv_pairs ;
 };
 
 /// @}
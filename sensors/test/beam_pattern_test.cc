@@ -631,4 +631,50 @@ BOOST_AUTO_TEST_CASE( grid_pattern_3d_test ) {
     delete[] data ;
 }
 
+/**
+ * Compares the levels interpolated from a beam_pattern_table to the
+ * direct calculation by a vertical line array, with a non-trivial
+ * orientation.  The table must be exact at its grid nodes, and must
+ * be within 0.01 of the direct beam level between them.
+ */
+BOOST_AUTO_TEST_CASE( table_pattern_test ) {
+    cout << "===== beam_pattern_test/table_pattern_test =====" << endl ;
+    beam_pattern_VLA array( 1500.0, 0.75, 5, M_PI/8.0 ) ;
+    orientation orient( -10.0, 37.0, 55.0, array.reference_axis() ) ;
+    seq_linear frequencies( 500.0, 200.0, 3 ) ;
+    const size_t num_freq = frequencies.size() ;
+    beam_pattern_table table( array, orient, frequencies ) ;
+    BOOST_CHECK_EQUAL( table.num_freq(), num_freq ) ;
+
+    vector<double> level( num_freq, 0.0 ) ;
+    std::vector<double> tabled( num_freq, 0.0 ) ;
+    const double dr = M_PI / 180.0 ;
+
+    // exact at the grid nodes, including the AZ wrap at 360 degrees
+    for ( int de=-90; de <= 90; de += 15 ) {
+        for ( int az=0; az <= 360; az += 20 ) {
+            array.beam_level( de*dr, az*dr, orient, frequencies, &level ) ;
+            table.beam_level( de*dr, az*dr, &tabled[0] ) ;
+            for ( size_t f=0; f < num_freq; ++f ) {
+                BOOST_CHECK_SMALL( tabled[f] - level(f), 1e-10 ) ;
+            }
+        }
+    }
+
+    // close to the direct calculation between grid nodes
+    srand(1) ;
+    double max_error = 0.0 ;
+    for ( int n=0; n < 1000; ++n ) {
+        double de = ( 180.0 * rand() / RAND_MAX - 90.0 ) * dr ;
+        double az = ( 360.0 * rand() / RAND_MAX ) * dr ;
+        array.beam_level( de, az, orient, frequencies, &level ) ;
+        table.beam_level( de, az, &tabled[0] ) ;
+        for ( size_t f=0; f < num_freq; ++f ) {
+            max_error = std::max( max_error, std::abs( tabled[f] - level(f) ) ) ;
+        }
+    }
+    cout << "maximum interpolation error: " << max_error << endl ;
+    BOOST_CHECK_SMALL( max_error, 0.01 ) ;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -126,6 +126,19 @@ BOOST_AUTO_TEST_CASE(pairs_test)
         manager->add_sensor(sensors[i], sensor_type[i]);
     }
 
+    // Expect monostatic pairs for 1 and 9, and multistatic pairs
+    // from sources 3, 6, 9 to receivers 4, 7, 9.  Sensor 1 is not multistatic.
+    sensor_pair_manager* pair_manager = sensor_pair_manager::instance();
+    BOOST_CHECK_EQUAL(pair_manager->num_pairs(), 10);
+    BOOST_CHECK(pair_manager->has_pair(1, 1));
+    BOOST_CHECK(pair_manager->has_pair(9, 9));
+    BOOST_CHECK(pair_manager->has_pair(3, 4));
+    BOOST_CHECK(pair_manager->has_pair(6, 9));
+    BOOST_CHECK(pair_manager->has_pair(9, 7));
+    BOOST_CHECK(!pair_manager->has_pair(4, 3));
+    BOOST_CHECK(!pair_manager->has_pair(1, 4));
+    BOOST_CHECK(!pair_manager->has_pair(3, 3));
+
     // Attempt to remove a non-existant sensor
     if ( manager->remove_sensor(2) != false ) {
          BOOST_FAIL("pairs_test:: Removed non-existent sensor_model");
@@ -149,6 +162,16 @@ BOOST_AUTO_TEST_CASE(pairs_test)
          BOOST_FAIL("pairs_test:: Failed to remove sensor_model");
     }
 
+    // Expect only the pairs between 6, 7, and 9 to remain
+    BOOST_CHECK_EQUAL(pair_manager->num_pairs(), 4);
+    BOOST_CHECK(pair_manager->has_pair(6, 7));
+    BOOST_CHECK(pair_manager->has_pair(6, 9));
+    BOOST_CHECK(pair_manager->has_pair(9, 7));
+    BOOST_CHECK(pair_manager->has_pair(9, 9));
+    BOOST_CHECK(!pair_manager->has_pair(1, 1));
+    BOOST_CHECK(!pair_manager->has_pair(3, 7));
+    BOOST_CHECK(!pair_manager->has_pair(9, 4));
+
     // Expected map contents
      sensor_model::id_type sensors_remaining[] = {6, 7, 9};
 
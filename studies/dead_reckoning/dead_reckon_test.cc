@@ -61,24 +61,21 @@ private:
 	 * </pre>
 	 *
 	 * Generates the ocean model and then updates the ocean_shared singleton.
-	 * Uses profile_lock and boundary_lock classes so that the new ocean
-	 * can be shared by multiple threads.
+	 * The USML models used here are reentrant, so the new ocean can be
+	 * shared by multiple threads without the _lock wrappers.
 	 */
 	void define_ocean_characteristics() {
 		cout << "== define ocean characteristics ==" << endl;
-		profile_model* water = new profile_linear(1500.0);
-		water->attenuation(new attenuation_constant(0.0));
-		profile_lock* profile = new profile_lock(water);
+		profile_model* profile = new profile_linear(1500.0);
+		profile->attenuation(new attenuation_constant(0.0));
 
-		boundary_model* surf = new boundary_flat();
-		boundary_lock* surface = new boundary_lock(surf);
+		boundary_model* surface = new boundary_flat();
 
 		/****************** BOTTOM DEPTH *****************************/
-		boundary_model* btm = new boundary_flat(505); // default 1657 ft.
-		btm->reflect_loss(
+		boundary_model* bottom = new boundary_flat(505); // default 1657 ft.
+		bottom->reflect_loss(
 				new reflect_loss_rayleigh(reflect_loss_rayleigh::SAND));
-		btm->scattering(new scattering_lambert());
-		boundary_lock* bottom = new boundary_lock(btm);
+		bottom->scattering(new scattering_lambert());
 
 		ocean_shared::reference ocean(
 				new ocean_model(surface, bottom, profile));
@@ -16,6 +16,8 @@
  *
  * The resulting wavefronts are stored in the "malta_movie.nc" netCDF
  * file for later plotting by Matlab, Octave, or other analysis routines.
+ * The wavefront_recorder writes this file on a background thread,
+ * so that the disk does not slow down the propagation.
  */
 #include <usml/waveq3d/waveq3d.h>
 #include <usml/netcdf/netcdf_files.h>
@@ -87,16 +89,16 @@ int main( int argc, char* argv[] ) {
     const char* ncname = USML_STUDIES_DIR "/malta_movie/malta_movie.nc" ;
     cout << "propagate rays & record to " << ncname << endl ;
     wave_queue wave( ocean, freq, pos, de, az, time_step ) ;
-    wave.init_netcdf( ncname ) ;
-    wave.save_netcdf() ;
+    wavefront_recorder recorder( wave, ncname ) ;
+    recorder.record() ;
 
     // propagate wavefront
 
     while ( wave.time() < time_max ) {
         // cout << "time=" << wave.time() << endl ;
         wave.step() ;
-        wave.save_netcdf() ;
+        recorder.record() ;
     }
-    wave.close_netcdf() ;
+    recorder.close() ;
     cout << "wave propagated for " << wave.time() << " secs" << endl ;
 }
@@ -0,0 +1,126 @@
+/**
+ * @file update_speed.cc
+ *
+ * Measure the per-step cost of the wavefront derivative calculations.
+ * Compares each of the instruction sets supported by the
+ * wave_front_kernel on this processor, for two sizes of ray fan:
+ *
+ *      - 181 D/E x 18 AZ, a typical transmission loss fan
+ *      - 1441 D/E x 72 AZ, a dense reverberation fan
+ *
+ * Reports the average time for the fused derivative kernel by itself,
+ * and for the complete wave_front::update(), which also includes the
+ * sound speed and attenuation lookups.  Uses a Munk profile, so the
+ * results do not depend on any external databases.
+ *
+ * Usage: update_speed [num_steps]
+ */
+#include <usml/waveq3d/waveq3d.h>
+#include <boost/chrono.hpp>
+#include <iomanip>
+#include <vector>
+
+using namespace usml::waveq3d ;
+using namespace usml::ocean ;
+
+typedef boost::chrono::steady_clock clock_type ;
+
+/**
+ * Average time, in microseconds, since a starting point.
+ */
+static double elapsed( clock_type::time_point start, int num_steps ) {
+    boost::chrono::duration<double,boost::micro> usec = clock_type::now() - start ;
+    return usec.count() / num_steps ;
+}
+
+/**
+ * Time the derivative calculations for one size of ray fan.
+ */
+static void time_fan( ocean_model& ocean, const seq_vector& freq,
+                      size_t num_de, size_t num_az, int num_steps )
+{
+    wposition1 source( 36.0, 16.0, -100.0 ) ;
+    seq_rayfan de( -90.0, 90.0, num_de ) ;
+    seq_linear az( 0.0, 360.0 / num_az, num_az ) ;
+    wave_front wave( ocean, &freq, num_de, num_az ) ;
+    wave.init_wave( source, de, az ) ;
+    wave.update() ;
+
+    // workspace for kernel timing, separate from the wavefront's own data
+
+    const size_t size = num_de * num_az ;
+    std::vector<double> output( 11 * size ) ;
+    wave_front_kernel::terms args ;
+    args.rho = wave.position.rho().data().begin() ;
+    args.theta = wave.position.theta().data().begin() ;
+    args.ndir_rho = wave.ndirection.rho().data().begin() ;
+    args.ndir_theta = wave.ndirection.theta().data().begin() ;
+    args.ndir_phi = wave.ndirection.phi().data().begin() ;
+    args.sound_speed = wave.sound_speed.data().begin() ;
+    args.grad_rho = wave.sound_gradient.rho().data().begin() ;
+    args.grad_theta = wave.sound_gradient.theta().data().begin() ;
+    args.grad_phi = wave.sound_gradient.phi().data().begin() ;
+    args.pos_grad_rho = &output[0] ;
+    args.pos_grad_theta = &output[size] ;
+    args.pos_grad_phi = &output[2*size] ;
+    args.ndir_grad_rho = &output[3*size] ;
+    args.ndir_grad_theta = &output[4*size] ;
+    args.ndir_grad_phi = &output[5*size] ;
+    args.dc_c_rho = &output[6*size] ;
+    args.dc_c_theta = &output[7*size] ;
+    args.dc_c_phi = &output[8*size] ;
+    args.sin_theta = &output[9*size] ;
+    args.cot_theta = &output[10*size] ;
+
+    for ( int n = wave_front_kernel::SCALAR ;
+          n <= wave_front_kernel::supported() ; ++n )
+    {
+        wave_front_kernel::instruction_set isa =
+            wave_front_kernel::active( (wave_front_kernel::instruction_set) n ) ;
+
+        clock_type::time_point start = clock_type::now() ;
+        for ( int s=0 ; s < num_steps ; ++s ) {
+            wave_front_kernel::compute( args, size ) ;
+        }
+        const double kernel = elapsed( start, num_steps ) ;
+
+        start = clock_type::now() ;
+        for ( int s=0 ; s < num_steps ; ++s ) {
+            wave.update() ;
+        }
+        const double update = elapsed( start, num_steps ) ;
+
+        cout << std::setw(5) << num_de << " x " << std::setw(3) << num_az
+             << std::setw(8) << wave_front_kernel::name( isa )
+             << std::setw(14) << kernel
+             << std::setw(14) << update << endl ;
+    }
+}
+
+/**
+ * Command line interface.
+ */
+int main( int argc, char* argv[] ) {
+    cout << "=== update_speed ===" << endl ;
+
+    int num_steps = 100 ;
+    if ( argc > 1 ) {
+        num_steps = atoi( argv[1] ) ;
+    }
+
+    wposition::compute_earth_radius( 36.0 ) ;
+    profile_model* profile = new profile_munk() ;
+    boundary_model* surface = new boundary_flat() ;
+    boundary_model* bottom = new boundary_flat( 5000.0 ) ;
+    ocean_model ocean( surface, bottom, profile ) ;
+    seq_log freq( 3000.0, 1.0, 1 ) ;
+
+    const wave_front_kernel::instruction_set original = wave_front_kernel::active() ;
+    cout << "average of " << num_steps << " steps (usec)" << endl
+         << "      fan      isa        kernel        update" << endl
+         << std::fixed << std::setprecision(1) ;
+    time_fan( ocean, freq, 181, 18, num_steps ) ;
+    time_fan( ocean, freq, 1441, 72, num_steps ) ;
+    wave_front_kernel::active( original ) ;
+    return 0 ;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file threads_bench.cc
+ * Benchmarks for task throughput in the thread_pool.
+ *
+ * Each task does a small, fixed amount of arithmetic, so that the
+ * results are dominated by the cost of scheduling the tasks.
+ */
+#include <usml/usml_bench.h>
+#include <usml/threads/threads.h>
+#include <cmath>
+#include <vector>
+
+using namespace usml::bench ;
+using namespace usml::threads ;
+
+namespace {
+
+/** Number of tasks scheduled by each iteration. */
+const size_t num_tasks = 1000 ;
+
+/** Number of square roots computed by each task. */
+const size_t task_work = 1000 ;
+
+/**
+ * Task that computes a fixed number of square roots.
+ */
+class work_task : public thread_task {
+
+public:
+
+    /** Result of the calculation. */
+    double result ;
+
+    /** Initialize result. */
+    work_task() : result(0.0) {}
+
+    /** Computes square roots. */
+    virtual void run() {
+        double sum = 0.0 ;
+        for ( size_t n=0 ; n < task_work ; ++n ) {
+            sum += std::sqrt( (double) n ) ;
+        }
+        result = sum ;
+    }
+} ;
+
+/**
+ * Task that forks num_tasks sub-tasks onto its own worker,
+ * and then joins them, so that idle workers have to steal them.
+ */
+class fork_task : public thread_task {
+
+public:
+
+    /** Pool that runs this task. */
+    thread_pool* pool ;
+
+    /** Initialize pool. */
+    fork_task( thread_pool* p ) : pool(p) {}
+
+    /** Fork and join the sub-tasks. */
+    virtual void run() {
+        std::vector<thread_task::reference> tasks( num_tasks ) ;
+        for ( size_t n=0 ; n < num_tasks ; ++n ) {
+            tasks[n].reset( new work_task() ) ;
+            pool->fork( tasks[n] ) ;
+        }
+        for ( size_t n=0 ; n < num_tasks ; ++n ) {
+            pool->join( tasks[n] ) ;
+        }
+    }
+} ;
+
+/** Number of worker threads in the pool. */
+const size_t thread_counts[] = { 1, 2, 4, 8 } ;
+
+}   // end of anonymous namespace
+
+/**
+ * Throughput of independent tasks added to the shared queue
+ * with thread_pool::run(), as a function of the number of workers.
+ */
+USML_BENCH_ARGS( thread_pool_run, "num_threads", thread_counts ) {
+    thread_pool pool( state.arg() ) ;
+    std::vector<thread_task::reference> tasks( num_tasks ) ;
+    while ( state.keep_running() ) {
+        for ( size_t n=0 ; n < num_tasks ; ++n ) {
+            tasks[n].reset( new work_task() ) ;
+            pool.run( tasks[n] ) ;
+        }
+        for ( size_t n=0 ; n < num_tasks ; ++n ) {
+            pool.join( tasks[n] ) ;
+        }
+    }
+    const thread_pool::statistics_type stats = pool.statistics() ;
+    state.items_processed( num_tasks ) ;
+    state.counter( "mean_latency", stats.mean_latency ) ;
+    state.counter( "max_latency", stats.max_latency ) ;
+}
+
+/**
+ * Throughput of sub-tasks forked by a worker, and stolen by its
+ * neighbors, as a function of the number of workers.
+ */
+USML_BENCH_ARGS( thread_pool_fork, "num_threads", thread_counts ) {
+    thread_pool pool( state.arg() ) ;
+    while ( state.keep_running() ) {
+        thread_task::reference parent( new fork_task( &pool ) ) ;
+        pool.run( parent ) ;
+        pool.join( parent ) ;
+    }
+    const thread_pool::statistics_type stats = pool.statistics() ;
+    state.items_processed( num_tasks ) ;
+    state.counter( "num_stolen", stats.num_stolen ) ;
+}
@@ -291,6 +291,241 @@ BOOST_AUTO_TEST_CASE( thread_controller_test ) {
 	#endif
 }
 
+/**
+ * Task that blocks a worker thread until it is released by the test.
+ * Used to hold the other tasks in the queue while they are added.
+ */
+class gate_task : public thread_task {
+public:
+    gate_task() : _open(false) {}
+
+    /** Wait until the gate is opened. */
+    virtual void run() {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        while ( ! _open ) _opened.wait( guard ) ;
+    }
+
+    /** Block the test until a worker thread is stuck in this task. */
+    void wait_running() {
+        while ( status() != RUNNING ) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+
+    /** Release the worker thread. */
+    void open() {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        _open = true ;
+        _opened.notify_all() ;
+    }
+
+private:
+    bool _open ;
+    boost::mutex _mutex ;
+    boost::condition_variable _opened ;
+} ;
+
+/**
+ * Task that keeps running until it is aborted.
+ */
+class spin_task : public thread_task {
+public:
+
+    /** Wait until the task is aborted. */
+    virtual void run() {
+        while ( ! _abort ) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+
+    /** Block the test until a worker thread is running this task. */
+    void wait_running() {
+        while ( status() != RUNNING ) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+} ;
+
+/**
+ * Task that records the order in which tasks are executed.
+ */
+class order_task : public thread_task {
+public:
+    order_task( int label, std::vector<int>* order, boost::mutex* mutex ) :
+        _label(label), _order(order), _mutex(mutex) {}
+
+    /** Add this task's label to the list. */
+    virtual void run() {
+        boost::mutex::scoped_lock guard( *_mutex ) ;
+        _order->push_back( _label ) ;
+    }
+
+private:
+    int _label ;
+    std::vector<int>* _order ;
+    boost::mutex* _mutex ;
+} ;
+
+/**
+ * Task that sums a range of integers by forking sub-tasks for each
+ * half of the range, until the range is small, and joining their results.
+ */
+class sum_task : public thread_task {
+public:
+    sum_task( thread_pool* pool, size_t first, size_t last ) :
+        result(0), _pool(pool), _first(first), _last(last) {}
+
+    /** Recursively split the range into sub-tasks. */
+    virtual void run() {
+        if ( _last - _first <= 100 ) {
+            for ( size_t n=_first ; n < _last ; ++n ) result += n ;
+            return ;
+        }
+        const size_t middle = ( _first + _last ) / 2 ;
+        shared_ptr<sum_task> left( new sum_task( _pool, _first, middle ) ) ;
+        shared_ptr<sum_task> right( new sum_task( _pool, middle, _last ) ) ;
+        _pool->fork( left ) ;
+        _pool->fork( right ) ;
+        _pool->join( right ) ;
+        _pool->join( left ) ;
+        result = left->result + right->result ;
+    }
+
+    /** Sum of the integers in the range [first,last). */
+    size_t result ;
+
+private:
+    thread_pool* _pool ;
+    size_t _first ;
+    size_t _last ;
+} ;
+
+/**
+ * Test that tasks with a higher priority are started first, and that
+ * tasks with the same priority are started in the order they were added.
+ * Uses a single worker thread, blocked by a gate_task, so that all of
+ * the tasks are in the queue before any of them start.
+ */
+BOOST_AUTO_TEST_CASE( thread_priority_test ) {
+    cout << "=== threads_test: thread_priority_test ===" << endl;
+    std::vector<int> order ;
+    boost::mutex mutex ;
+    thread_pool pool(1) ;
+    shared_ptr<gate_task> gate( new gate_task() ) ;
+    pool.run( gate ) ;
+    gate->wait_running() ;
+
+    const int priority[] = { 0, 5, 0, 10, 5 } ;
+    std::vector<thread_task::reference> tasks ;
+    for ( int n=0 ; n < 5 ; ++n ) {
+        tasks.push_back( thread_task::reference(
+            new order_task( n, &order, &mutex ) ) ) ;
+        tasks.back()->priority( priority[n] ) ;
+        pool.run( tasks.back() ) ;
+    }
+    gate->open() ;
+    for ( size_t n=0 ; n < tasks.size() ; ++n ) {
+        pool.join( tasks[n] ) ;
+    }
+
+    const int expected[] = { 3, 1, 4, 0, 2 } ;
+    BOOST_CHECK_EQUAL_COLLECTIONS( order.begin(), order.end(),
+        expected, expected+5 ) ;
+}
+
+/**
+ * Test that a new task supersedes a queued task with the same key,
+ * and that it leaves tasks with other keys alone.
+ */
+BOOST_AUTO_TEST_CASE( thread_supersede_test ) {
+    cout << "=== threads_test: thread_supersede_test ===" << endl;
+    std::vector<int> order ;
+    boost::mutex mutex ;
+    thread_pool pool(1) ;
+    shared_ptr<gate_task> gate( new gate_task() ) ;
+    pool.run( gate ) ;
+    gate->wait_running() ;
+
+    thread_task::reference old_task( new order_task( 0, &order, &mutex ) ) ;
+    thread_task::reference other( new order_task( 1, &order, &mutex ) ) ;
+    thread_task::reference new_task( new order_task( 2, &order, &mutex ) ) ;
+    old_task->supersede_key( "sensor 1" ) ;
+    other->supersede_key( "sensor 2" ) ;
+    new_task->supersede_key( "sensor 1" ) ;
+    pool.run( old_task ) ;
+    pool.run( other ) ;
+    pool.run( new_task ) ;
+    BOOST_CHECK_EQUAL( old_task->status(), thread_task::SUPERSEDED ) ;
+    BOOST_CHECK_EQUAL( pool.statistics().queue_depth, 2u ) ;
+
+    gate->open() ;
+    pool.join( new_task ) ;
+    pool.join( other ) ;
+    BOOST_CHECK_EQUAL( new_task->status(), thread_task::COMPLETE ) ;
+    BOOST_CHECK_EQUAL( other->status(), thread_task::COMPLETE ) ;
+    const int expected[] = { 1, 2 } ;
+    BOOST_CHECK_EQUAL_COLLECTIONS( order.begin(), order.end(),
+        expected, expected+2 ) ;
+
+    thread_pool::statistics_type stats = pool.statistics() ;
+    BOOST_CHECK_EQUAL( stats.num_cancelled, 0u ) ;
+    BOOST_CHECK_EQUAL( stats.num_superseded, 1u ) ;
+    BOOST_CHECK_EQUAL( stats.num_completed, 3u ) ;
+    BOOST_CHECK_EQUAL( stats.queue_depth, 0u ) ;
+}
+
+/**
+ * Test that a new task aborts a running task with the same supersede key,
+ * and that the old task finishes with a superseded status.
+ */
+BOOST_AUTO_TEST_CASE( thread_supersede_running_test ) {
+    cout << "=== threads_test: thread_supersede_running_test ===" << endl;
+    std::vector<int> order ;
+    boost::mutex mutex ;
+    thread_pool pool(1) ;
+    shared_ptr<spin_task> old_task( new spin_task() ) ;
+    old_task->supersede_key( "sensor 1" ) ;
+    pool.run( old_task ) ;
+    old_task->wait_running() ;
+
+    thread_task::reference new_task( new order_task( 1, &order, &mutex ) ) ;
+    new_task->supersede_key( "sensor 1" ) ;
+    pool.run( new_task ) ;
+    pool.join( new_task ) ;
+    pool.join( old_task ) ;
+    BOOST_CHECK_EQUAL( old_task->status(), thread_task::SUPERSEDED ) ;
+    BOOST_CHECK_EQUAL( new_task->status(), thread_task::COMPLETE ) ;
+    BOOST_CHECK_EQUAL( order.size(), 1u ) ;
+
+    thread_pool::statistics_type stats = pool.statistics() ;
+    BOOST_CHECK_EQUAL( stats.num_superseded, 1u ) ;
+    BOOST_CHECK_EQUAL( stats.num_completed, 2u ) ;
+}
+
+/**
+ * Test recursive fork/join of sub-tasks.  Sums the integers in a range
+ * by splitting it into many small sub-tasks.  Uses more sub-tasks than
+ * threads, so workers must run other sub-tasks while they wait in join().
+ */
+BOOST_AUTO_TEST_CASE( thread_fork_join_test ) {
+    cout << "=== threads_test: thread_fork_join_test ===" << endl;
+    const size_t N = 100000 ;
+    for ( size_t num_threads=1 ; num_threads <= 4 ; num_threads *= 2 ) {
+        thread_pool pool( num_threads ) ;
+        shared_ptr<sum_task> task( new sum_task( &pool, 0, N ) ) ;
+        pool.run( task ) ;
+        pool.join( task ) ;
+        BOOST_CHECK_EQUAL( task->result, N * (N-1) / 2 ) ;
+
+        thread_pool::statistics_type stats = pool.statistics() ;
+        cout << "threads=" << num_threads
+             << " completed=" << stats.num_completed
+             << " stolen=" << stats.num_stolen
+             << " mean latency=" << stats.mean_latency << " sec" << endl ;
+        BOOST_CHECK_EQUAL( stats.queue_depth + stats.fork_depth, 0u ) ;
+    }
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
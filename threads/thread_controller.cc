@@ -1,6 +1,6 @@
 /**
- * @file thread_pool.cc
- * A thread pool for executing tasks in a separate thread.
+ * @file thread_controller.cc
+ * Singleton version of a thread_pool.
  */
 #include <usml/threads/thread_controller.h>
 
@@ -43,6 +43,6 @@ thread_pool* thread_controller::instance() {
  * Reset the thread_controller to empty.
  */
 void thread_controller::reset() {
-    write_lock_guard(_instance_mutex);
+    write_lock_guard guard(_instance_mutex);
     _instance.reset();
 }
@@ -7,7 +7,6 @@
 #include <usml/threads/thread_pool.h>
 #include <usml/threads/read_write_lock.h>
 #include <boost/thread/thread.hpp>
-#include <boost/asio.hpp>
 
 namespace usml {
 namespace threads {
@@ -40,6 +39,14 @@ public:
      */
     static void reset();
 
+    /**
+     * Queue depth and latency statistics for the thread_pool owned by
+     * this singleton.  Constructs the singleton if it does not yet exist.
+     */
+    static thread_pool::statistics_type statistics() {
+        return instance()->statistics() ;
+    }
+
 private:
 
     /**
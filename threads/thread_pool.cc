@@ -4,19 +4,28 @@
  */
 #include <usml/threads/thread_pool.h>
 #include <boost/bind.hpp>
+#include <algorithm>
 
 using namespace usml::threads ;
+using boost::posix_time::microsec_clock ;
+using boost::posix_time::ptime ;
 
 /**
  * Creates a new thread pool with a specific number of threads.
  */
 thread_pool::thread_pool( size_t num_threads ) :
-    _scheduler(),
-    _scheduler_work(_scheduler)
+    _sequence(0), _pending(0), _stop(false),
+    _num_running(0), _num_completed(0), _num_cancelled(0), _num_superseded(0),
+    _num_stolen(0),
+    _total_latency(0.0), _max_latency(0.0), _total_run_time(0.0)
 {
+    if ( num_threads < 1 ) num_threads = 1 ;
+    for (size_t n = 0; n < num_threads; ++n) {
+        _workers.push_back( new worker() ) ;
+    }
     for (size_t n = 0; n < num_threads; ++n) {
         _thread_group.create_thread(
-                boost::bind(&boost::asio::io_service::run, &_scheduler));
+                boost::bind(&thread_pool::work, this, n));
     }
 }
 
@@ -24,19 +33,322 @@ thread_pool::thread_pool( size_t num_threads ) :
  * Stop the scheduler and terminate the threads used to execute tasks.
  */
 thread_pool::~thread_pool() {
-    _scheduler.stop();
+    {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        _stop = true ;
+        _ready.notify_all() ;
+    }
     try {
         _thread_group.join_all();
     } catch( ... ) {
         // suppress all exceptions
     }
+
+    // cancel tasks that never started
+
+    for ( queue_type::iterator iter = _queue.begin() ;
+          iter != _queue.end() ; ++iter )
+    {
+        iter->second->cancel() ;
+    }
+    for ( size_t n=0 ; n < _workers.size() ; ++n ) {
+        std::deque<thread_task::reference>& tasks = _workers[n]->tasks ;
+        for ( size_t t=0 ; t < tasks.size() ; ++t ) {
+            tasks[t]->cancel() ;
+        }
+        delete _workers[n] ;
+    }
 }
 
 /**
- * Adds a task to the scheduler.
+ * Adds a task to the shared queue.
  */
 void thread_pool::run( thread_task::reference task ) {
-    _scheduler.post( boost::bind(&thread_task::start, task) ) ;
+    thread_task::reference queued ;
+    std::vector<thread_task::reference> running ;
+    {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        const std::string& key = task->supersede_key() ;
+        if ( ! key.empty() ) {
+            std::map<std::string,queue_type::iterator>::iterator
+                found = _keyed.find( key ) ;
+            if ( found != _keyed.end() ) {
+                queued = found->second->second ;
+                erase( found->second ) ;
+                ++_num_superseded ;
+            }
+            std::pair<running_type::iterator,running_type::iterator>
+                range = _running.equal_range( key ) ;
+            for ( running_type::iterator iter = range.first ;
+                  iter != range.second ; ++iter )
+            {
+                running.push_back( iter->second ) ;
+                ++_num_superseded ;
+            }
+            _running.erase( range.first, range.second ) ;
+        }
+        task->_queue_time = microsec_clock::universal_time() ;
+        queue_type::iterator iter = _queue.insert( std::make_pair(
+            queue_key( -task->priority(), _sequence++ ), task ) ).first ;
+        if ( ! key.empty() ) {
+            _keyed[key] = iter ;
+        }
+        ++_pending ;
+        _ready.notify_one() ;
+    }
+    if ( queued ) {
+        queued->cancel( thread_task::SUPERSEDED ) ;
+    }
+    for ( size_t n=0 ; n < running.size() ; ++n ) {
+        running[n]->supersede() ;
+    }
 }
 
+/**
+ * Adds a sub-task to the queue of the calling worker thread.
+ */
+void thread_pool::fork( thread_task::reference task ) {
+    size_t* index = worker_index() ;
+    if ( index == NULL ) {
+        run( task ) ;
+        return ;
+    }
+    worker* w = _workers[*index] ;
+    boost::mutex::scoped_lock local( w->mutex ) ;
+    task->_queue_time = microsec_clock::universal_time() ;
+    w->tasks.push_back( task ) ;
+    boost::mutex::scoped_lock guard( _mutex ) ;
+    ++_pending ;
+    _ready.notify_one() ;
+}
+
+/**
+ * Blocks until a task has finished.
+ */
+void thread_pool::join( thread_task::reference task ) {
+    size_t* index = worker_index() ;
+    if ( index != NULL ) {
+
+        // run the task here if it is still in the shared queue,
+        // so that a worker never waits on a task that has not started
+
+        bool queued = false ;
+        {
+            boost::mutex::scoped_lock guard( _mutex ) ;
+            for ( queue_type::iterator iter = _queue.begin() ;
+                  iter != _queue.end() ; ++iter )
+            {
+                if ( iter->second == task ) {
+                    erase( iter ) ;
+                    starting( task ) ;
+                    queued = true ;
+                    break ;
+                }
+            }
+        }
+        if ( queued ) {
+            execute( task ) ;
+            return ;
+        }
+
+        // run forked sub-tasks until the task is finished
 
+        while ( ! task->finished() ) {
+            thread_task::reference other = next_task( *index, false ) ;
+            if ( ! other ) break ;
+            execute( other ) ;
+        }
+    }
+
+    // nothing left to help with, so the task must be running elsewhere
+
+    task->wait() ;
+}
+
+/**
+ * Cancels a task if it is still waiting in the shared queue.
+ */
+bool thread_pool::cancel( thread_task::reference task ) {
+    bool removed = false ;
+    {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        for ( queue_type::iterator iter = _queue.begin() ;
+              iter != _queue.end() ; ++iter )
+        {
+            if ( iter->second == task ) {
+                erase( iter ) ;
+                ++_num_cancelled ;
+                removed = true ;
+                break ;
+            }
+        }
+    }
+    if ( removed ) {
+        task->cancel() ;
+    } else {
+        task->abort() ;
+    }
+    return removed ;
+}
+
+/**
+ * Snapshot of the queue depth and latency statistics.
+ */
+thread_pool::statistics_type thread_pool::statistics() const {
+    statistics_type stats ;
+    boost::mutex::scoped_lock guard( _mutex ) ;
+    stats.num_threads = _workers.size() ;
+    stats.queue_depth = _queue.size() ;
+    stats.fork_depth = _pending - _queue.size() ;
+    stats.num_running = _num_running ;
+    stats.num_completed = _num_completed ;
+    stats.num_cancelled = _num_cancelled ;
+    stats.num_superseded = _num_superseded ;
+    stats.num_stolen = _num_stolen ;
+    stats.mean_latency = ( _num_completed > 0 ) ?
+        _total_latency / _num_completed : 0.0 ;
+    stats.max_latency = _max_latency ;
+    stats.mean_run_time = ( _num_completed > 0 ) ?
+        _total_run_time / _num_completed : 0.0 ;
+    return stats ;
+}
+
+/**
+ * Main loop for each worker thread.
+ */
+void thread_pool::work( size_t index ) {
+    _worker_index.reset( new size_t(index) ) ;
+    while ( true ) {
+        {
+            boost::mutex::scoped_lock guard( _mutex ) ;
+            while ( _pending == 0 && ! _stop ) {
+                _ready.wait( guard ) ;
+            }
+            if ( _stop ) return ;
+        }
+        thread_task::reference task = next_task( index, true ) ;
+        if ( task ) execute( task ) ;
+    }
+}
+
+/**
+ * Removes the next task for a worker.
+ */
+thread_task::reference thread_pool::next_task( size_t index, bool shared ) {
+
+    // newest sub-task forked by this worker
+
+    thread_task::reference task = pop_worker( index, false ) ;
+    if ( task ) return task ;
+
+    // oldest sub-task forked by another worker
+
+    const size_t N = _workers.size() ;
+    for ( size_t n=1 ; n < N ; ++n ) {
+        task = pop_worker( (index + n) % N, true ) ;
+        if ( task ) {
+            boost::mutex::scoped_lock guard( _mutex ) ;
+            ++_num_stolen ;
+            return task ;
+        }
+    }
+
+    // highest priority task in the shared queue
+
+    if ( shared ) {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        if ( ! _queue.empty() ) {
+            task = _queue.begin()->second ;
+            erase( _queue.begin() ) ;
+            starting( task ) ;
+        }
+    }
+    return task ;
+}
+
+/**
+ * Removes a task from one of the worker queues.
+ */
+thread_task::reference thread_pool::pop_worker( size_t index, bool steal ) {
+    thread_task::reference task ;
+    worker* w = _workers[index] ;
+    boost::mutex::scoped_lock local( w->mutex ) ;
+    if ( ! w->tasks.empty() ) {
+        if ( steal ) {
+            task = w->tasks.front() ;
+            w->tasks.pop_front() ;
+        } else {
+            task = w->tasks.back() ;
+            w->tasks.pop_back() ;
+        }
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        --_pending ;
+    }
+    return task ;
+}
+
+/**
+ * Runs a task in the current thread and updates the statistics.
+ */
+void thread_pool::execute( thread_task::reference task ) {
+    const ptime start = microsec_clock::universal_time() ;
+    {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        ++_num_running ;
+    }
+    task->start() ;
+    const ptime finish = microsec_clock::universal_time() ;
+    const double latency = 1e-6 * ( start - task->_queue_time )
+        .total_microseconds() ;
+    const double run_time = 1e-6 * ( finish - start ).total_microseconds() ;
+    {
+        boost::mutex::scoped_lock guard( _mutex ) ;
+        --_num_running ;
+        ++_num_completed ;
+        finishing( task ) ;
+        _total_latency += latency ;
+        _max_latency = std::max( _max_latency, latency ) ;
+        _total_run_time += run_time ;
+    }
+    task->status( thread_task::COMPLETE ) ;
+}
+
+/**
+ * Removes a task from the shared queue.
+ */
+void thread_pool::erase( queue_type::iterator iter ) {
+    const std::string& key = iter->second->supersede_key() ;
+    if ( ! key.empty() ) {
+        _keyed.erase( key ) ;
+    }
+    _queue.erase( iter ) ;
+    --_pending ;
+}
+
+/**
+ * Records a task, taken from the shared queue, that is about to run.
+ */
+void thread_pool::starting( thread_task::reference task ) {
+    const std::string& key = task->supersede_key() ;
+    if ( ! key.empty() ) {
+        _running.insert( std::make_pair( key, task ) ) ;
+    }
+}
+
+/**
+ * Forgets about a task that has finished running.
+ */
+void thread_pool::finishing( thread_task::reference task ) {
+    const std::string& key = task->supersede_key() ;
+    if ( key.empty() ) return ;
+    std::pair<running_type::iterator,running_type::iterator>
+        range = _running.equal_range( key ) ;
+    for ( running_type::iterator iter = range.first ;
+          iter != range.second ; ++iter )
+    {
+        if ( iter->second == task ) {
+            _running.erase( iter ) ;
+            return ;
+        }
+    }
+}
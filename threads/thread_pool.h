@@ -6,7 +6,10 @@
 
 #include <usml/threads/thread_task.h>
 #include <boost/thread/thread.hpp>
-#include <boost/asio.hpp>
+#include <boost/thread/tss.hpp>
+#include <deque>
+#include <map>
+#include <vector>
 
 namespace usml {
 namespace threads {
@@ -17,26 +20,72 @@ namespace threads {
 /**
  * A thread pool for executing tasks in a separate thread.  This scheme
  * allows the developer to limit the number of tasks running
- * simultaneously on a specific computer. Uses Boost's Asynchronous I/O
- * library (ASIO) to schedule the tasks.
+ * simultaneously on a specific computer.
  *
- * @xref ASIO Recipe for a thread pool for executing arbitrary tasks,
- *       http://think-async.com/Asio/Recipes
+ * Tasks added with run() wait in a shared queue that is sorted by
+ * thread_task::priority(), and then by the order in which they were added.
+ * When a new task has the same thread_task::supersede_key() as a task
+ * that is still waiting in this queue, the older task is removed from
+ * the queue.  If the older task is already running, it is asked to abort.
+ * Either way, the older task finishes with a thread_task::SUPERSEDED
+ * status, so that a burst of updates does not leave stale work
+ * ahead of fresh work.
+ *
+ * Tasks running in the pool can split their work into sub-tasks using
+ * fork() and join().  Each worker thread keeps its own queue of forked
+ * sub-tasks, and takes the newest sub-task from its own queue first.
+ * Idle workers steal the oldest sub-task from the queues of other workers
+ * before they take a new task from the shared queue.  A worker that is
+ * blocked in join() runs forked sub-tasks while it waits.
+ *
+ * @xref R. D. Blumofe, C. E. Leiserson, "Scheduling Multithreaded
+ *       Computations by Work Stealing", Journal of the ACM, 46(5),
+ *       pp. 720-748, 1999.
  */
 class USML_DECLSPEC thread_pool {
 
-private:
+public:
 
-    /** ASIO service that queues tasks for execution. */
-    boost::asio::io_service _scheduler;
+    /**
+     * Queue depth and latency statistics for a thread_pool.
+     * Latency is the time from when a task was queued until
+     * it started to run.
+     */
+    struct statistics_type {
 
-    /** ASIO service that runs the scheduler. */
-    boost::asio::io_service::work _scheduler_work;
+        /** Number of worker threads. */
+        size_t num_threads ;
 
-    /** Group of threads used by the scheduler to execute tasks. */
-    boost::thread_group _thread_group;
+        /** Number of tasks waiting in the shared queue. */
+        size_t queue_depth ;
 
-public:
+        /** Number of forked sub-tasks waiting in worker queues. */
+        size_t fork_depth ;
+
+        /** Number of tasks being executed. */
+        size_t num_running ;
+
+        /** Number of tasks that have completed. */
+        size_t num_completed ;
+
+        /** Number of tasks cancelled before they started. */
+        size_t num_cancelled ;
+
+        /** Number of tasks replaced by a newer task with the same key. */
+        size_t num_superseded ;
+
+        /** Number of sub-tasks taken from the queue of another worker. */
+        size_t num_stolen ;
+
+        /** Average time that completed tasks spent in a queue (sec). */
+        double mean_latency ;
+
+        /** Longest time that a completed task spent in a queue (sec). */
+        double max_latency ;
+
+        /** Average time spent running completed tasks (sec). */
+        double mean_run_time ;
+    } ;
 
     /**
      * Creates a new thread pool with a specific number of threads.
@@ -47,6 +96,7 @@ public:
 
     /**
      * Stop the scheduler and terminate the threads used to execute tasks.
+     * Tasks that have not yet started are cancelled.
      */
     ~thread_pool() ;
 
@@ -56,13 +106,207 @@ public:
      * on the shared reference, without fear that the scheduler has already
      * disposed of the task object.  The task object is deleted when both the
      * calling program and the scheduler have de-referenced the shared object.
+     * Supersedes any task, with the same supersede key, that is still
+     * waiting to start, or that is running.
      *
      * @param task      Shared pointer to the task to be executed
      */
     void run( thread_task::reference task ) ;
+
+    /**
+     * Adds a sub-task to the queue of the calling worker thread.  Forked
+     * tasks ignore priority and supersede keys.  Behaves like run() when
+     * it is not called from one of the threads in this pool.
+     *
+     * @param task      Shared pointer to the sub-task to be executed
+     */
+    void fork( thread_task::reference task ) ;
+
+    /**
+     * Blocks until a task has finished.  When it is called from one of
+     * the threads in this pool, that thread runs other forked sub-tasks
+     * while it waits.
+     *
+     * @param task      Shared pointer to the task to wait for.
+     */
+    void join( thread_task::reference task ) ;
+
+    /**
+     * Cancels a task if it is still waiting in the shared queue.
+     * Otherwise, asks the task to abort itself.
+     *
+     * @param task      Shared pointer to the task to cancel.
+     * @return          True if the task was removed from the queue.
+     */
+    bool cancel( thread_task::reference task ) ;
+
+    /**
+     * Number of threads used to execute tasks.
+     */
+    size_t num_threads() const {
+        return _workers.size() ;
+    }
+
+    /**
+     * Snapshot of the queue depth and latency statistics.
+     */
+    statistics_type statistics() const ;
+
+private:
+
+    /**
+     * Sort order for the shared queue: highest priority first,
+     * and then by the order in which the tasks were added.
+     */
+    typedef std::pair<int,size_t> queue_key ;
+
+    /** Shared queue of tasks, sorted by priority. */
+    typedef std::map<queue_key,thread_task::reference> queue_type ;
+
+    /**
+     * Queue of forked sub-tasks owned by one worker thread.
+     */
+    struct worker {
+
+        /** Sub-tasks waiting to run, newest at the back. */
+        std::deque<thread_task::reference> tasks ;
+
+        /** Locks the sub-task queue. */
+        boost::mutex mutex ;
+    } ;
+
+    /** Queue of forked sub-tasks for each worker thread. */
+    std::vector<worker*> _workers ;
+
+    /** Group of threads used by the scheduler to execute tasks. */
+    boost::thread_group _thread_group ;
+
+    /** Index of the worker that owns each thread in this pool. */
+    boost::thread_specific_ptr<size_t> _worker_index ;
+
+    /** Tasks added with run() that have not yet started. */
+    queue_type _queue ;
+
+    /** Location of each waiting task that has a supersede key. */
+    std::map<std::string,queue_type::iterator> _keyed ;
+
+    /** Tasks, with a supersede key, that have left the shared queue. */
+    typedef std::multimap<std::string,thread_task::reference> running_type ;
+
+    /** Running tasks that can be superseded, sorted by key. */
+    running_type _running ;
+
+    /** Sequence number of the next task added to the shared queue. */
+    size_t _sequence ;
+
+    /** Number of tasks waiting in all queues. */
+    size_t _pending ;
+
+    /** Set to true when the pool is being destroyed. */
+    bool _stop ;
+
+    /**
+     * Locks the shared queue, the pending task count, and the statistics.
+     * When both are needed, a worker mutex must be locked before this one.
+     */
+    mutable boost::mutex _mutex ;
+
+    /** Wakes up idle workers when new tasks are added. */
+    boost::condition_variable _ready ;
+
+    /** Number of tasks being executed. */
+    size_t _num_running ;
+
+    /** Number of tasks that have completed. */
+    size_t _num_completed ;
+
+    /** Number of tasks cancelled before they started. */
+    size_t _num_cancelled ;
+
+    /** Number of tasks replaced by a newer task with the same key. */
+    size_t _num_superseded ;
+
+    /** Number of sub-tasks taken from the queue of another worker. */
+    size_t _num_stolen ;
+
+    /** Total time that completed tasks spent in a queue (sec). */
+    double _total_latency ;
+
+    /** Longest time that a completed task spent in a queue (sec). */
+    double _max_latency ;
+
+    /** Total time spent running completed tasks (sec). */
+    double _total_run_time ;
+
+    /**
+     * Main loop for each worker thread.  Runs tasks until the pool stops.
+     *
+     * @param index     Index of the worker that owns this thread.
+     */
+    void work( size_t index ) ;
+
+    /**
+     * Removes the next task for a worker from its own queue,
+     * the queue of another worker, or the shared queue, in that order.
+     *
+     * @param index     Index of the worker looking for a task.
+     * @param shared    Include the shared queue in this search.
+     * @return          Next task, or a null reference if none found.
+     */
+    thread_task::reference next_task( size_t index, bool shared ) ;
+
+    /**
+     * Removes a task from the back of one of the worker queues.
+     *
+     * @param index     Index of the worker queue to search.
+     * @param steal     Take the oldest task, from the front of the
+     *                  queue, instead of the newest.
+     * @return          Task, or a null reference if the queue was empty.
+     */
+    thread_task::reference pop_worker( size_t index, bool steal ) ;
+
+    /**
+     * Runs a task in the current thread and updates the statistics.
+     *
+     * @param task      Task to execute.
+     */
+    void execute( thread_task::reference task ) ;
+
+    /**
+     * Removes a task from the shared queue.  The caller must hold #_mutex.
+     *
+     * @param iter      Location of the task in the shared queue.
+     */
+    void erase( queue_type::iterator iter ) ;
+
+    /**
+     * Records a task, taken from the shared queue, that is about to run,
+     * so that newer tasks can supersede it.  The caller must hold #_mutex.
+     *
+     * @param task      Task that is about to run.
+     */
+    void starting( thread_task::reference task ) ;
+
+    /**
+     * Forgets about a task that has finished running.
+     * The caller must hold #_mutex.
+     *
+     * @param task      Task that has finished.
+     */
+    void finishing( thread_task::reference task ) ;
+
+    /** Index of the worker for the calling thread, or NULL if none. */
+    size_t* worker_index() const {
+        return _worker_index.get() ;
+    }
+
+    /** Hide copy constructor. */
+    thread_pool( const thread_pool& ) ;
+
+    /** Hide assignment operator. */
+    thread_pool& operator=( const thread_pool& ) ;
 };
 
 /// @}
 } // end of namespace threads
 } // end of namespace usml
-
@@ -1,6 +1,6 @@
 /**
- * @file thread_pool.cc
- * World location in geodetic earth coordinates
+ * @file thread_task.cc
+ * Task that executes in the thread_pool.
  */
 #include <usml/threads/thread_task.h>
 //#include <exception>
@@ -16,11 +16,17 @@ size_t thread_task::_id_next = 0 ;
 /** Number of active tasks in the thread pool */
 size_t thread_task::_num_active = 0;
 
+/** Locks the task ID and active task counters. */
+boost::mutex thread_task::_count_mutex ;
+
 /**
  * Initiates a task in the thread pool.
  */
-thread_task::thread_task() {
+thread_task::thread_task() :
+    _priority(0), _status(PENDING), _superseded(false)
+{
     _abort = false ;
+    boost::mutex::scoped_lock guard( _count_mutex ) ;
     _id = _id_next ;
     ++_num_active;
     if ( _id_next == std::numeric_limits<std::size_t>::max() ) {
@@ -34,6 +40,7 @@ thread_task::thread_task() {
  * Initiates a task in the thread pool.
  */
 void thread_task::start() {
+    status( RUNNING ) ;
     try {
         run() ;   // invoke the user's version of this task
     } catch( std::exception& ex ) {
@@ -42,5 +49,49 @@ void thread_task::start() {
         // suppress all exceptions
     }
     // After run is completed decrement number of active tasks counter.
+    boost::mutex::scoped_lock guard( _count_mutex ) ;
     --_num_active;
 }
+
+/**
+ * Removes a task from the queue without running it.
+ */
+void thread_task::cancel( status_type status ) {
+    _abort = true ;
+    {
+        boost::mutex::scoped_lock guard( _count_mutex ) ;
+        --_num_active;
+    }
+    this->status( status ) ;
+}
+
+/**
+ * Asks a running task to stop, because a newer one replaces it.
+ */
+void thread_task::supersede() {
+    _abort = true ;
+    boost::mutex::scoped_lock guard( _status_mutex ) ;
+    _superseded = true ;
+}
+
+/**
+ * Change the status of this task.
+ */
+void thread_task::status( status_type status ) {
+    boost::mutex::scoped_lock guard( _status_mutex ) ;
+    if ( status == COMPLETE && _superseded ) {
+        status = SUPERSEDED ;
+    }
+    _status = status ;
+    _status_changed.notify_all() ;
+}
+
+/**
+ * Block the calling thread until this task has finished.
+ */
+void thread_task::wait() const {
+    boost::mutex::scoped_lock guard( _status_mutex ) ;
+    while ( _status < COMPLETE ) {
+        _status_changed.wait( guard ) ;
+    }
+}
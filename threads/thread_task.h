@@ -6,7 +6,12 @@
 
 #include <usml/usml_config.h>
 #include <usml/threads/smart_ptr.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <cstddef>
+#include <string>
 
 namespace usml {
 namespace threads {
@@ -34,6 +39,13 @@ class thread_pool ;
  *   to pre-maturely abort this task.  The developers code monitors the
  *   _abort flag to detect when abort() has been invoked.
  *
+ * Tasks with a higher priority() are started before those with a lower
+ * priority.  Tasks that share the same supersede_key() replace each
+ * other: when a new task is added to the thread_pool, a task with the
+ * same key that has not yet started is removed from the queue, and a task
+ * with the same key that is already running is asked to abort.  Use the
+ * status() method to find out what happened to a task.
+ *
  * Automatically assigns an identification number for each task when it is
  * created. Sub-classes are responsible for catching their own exceptions.
  * Exceptions that are not caught by the sub-class are ignored.
@@ -48,6 +60,17 @@ public:
     // Boost self type shared_ptr
     typedef shared_ptr<thread_task> reference;
 
+    /**
+     * Stages in the life of a task.
+     */
+    enum status_type {
+        PENDING,        ///< created, or waiting in the thread_pool queue
+        RUNNING,        ///< run() method is being executed
+        COMPLETE,       ///< run() method has returned
+        CANCELLED,      ///< removed from the queue before it started
+        SUPERSEDED      ///< replaced by a newer task with the same key
+    } ;
+
     /**
      * Default constructor, assigns a new id to this task.
      * Creates a sequential task ID number for each new task as it is created.
@@ -81,6 +104,7 @@ public:
     * @return number of active tasks
     */
     static size_t num_active() {
+        boost::mutex::scoped_lock guard( _count_mutex ) ;
         return _num_active;
     }
    
@@ -93,27 +117,140 @@ public:
         _abort  = true ;
     }
 
+    /**
+     * Scheduling priority for this task.  Tasks with higher priority
+     * are started first.  Tasks with the same priority are started
+     * in the order that they were added to the thread_pool.
+     */
+    int priority() const {
+        return _priority ;
+    }
+
+    /**
+     * Defines the scheduling priority for this task.  Has no effect
+     * once the task has been added to the thread_pool.
+     *
+     * @param priority  Tasks with higher priority are started first.
+     *                  Defaults to zero.
+     */
+    void priority( int priority ) {
+        _priority = priority ;
+    }
+
+    /**
+     * Key used to find older tasks that this one replaces.
+     * An empty key means that this task does not supersede anything.
+     */
+    const std::string& supersede_key() const {
+        return _supersede_key ;
+    }
+
+    /**
+     * Defines the key used to find older tasks that this one replaces,
+     * like the ID of the sensor that this task is working for.  Has no
+     * effect once the task has been added to the thread_pool.
+     *
+     * @param key       Tasks that share this key supersede each other.
+     */
+    void supersede_key( const std::string& key ) {
+        _supersede_key = key ;
+    }
+
+    /**
+     * Current stage in the life of this task.
+     */
+    status_type status() const {
+        boost::mutex::scoped_lock guard( _status_mutex ) ;
+        return _status ;
+    }
+
+    /**
+     * True if the task has completed, was cancelled before it started,
+     * or was superseded by a newer task.
+     */
+    bool finished() const {
+        boost::mutex::scoped_lock guard( _status_mutex ) ;
+        return _status >= COMPLETE ;
+    }
+
  protected:
 
-    /** Indication that task needs to abort. */
-    bool _abort ;
+    /**
+     * Indication that task needs to abort.  Atomic because it is set by
+     * other threads while run() is polling it.
+     */
+    boost::atomic<bool> _abort ;
 
  private:
 
     /**
      * Safely initiates a task in the thread pool.
      * Traps uncaught exceptions to prevent thread_pool from crashing.
+     * The thread_pool marks the task as complete after it has
+     * updated its statistics.
      */
     void start() ;
 
+    /**
+     * Called by the thread_pool when it removes this task from its
+     * queue without running it.  Aborts the task and marks it as finished.
+     *
+     * @param status    CANCELLED, or SUPERSEDED if a newer task with the
+     *                  same supersede key replaced this one.
+     */
+    void cancel( status_type status = CANCELLED ) ;
+
+    /**
+     * Called by the thread_pool when a newer task, with the same
+     * supersede key, replaces this one while it is running.  Aborts the
+     * task, and marks it as superseded, instead of complete, when
+     * run() returns.
+     */
+    void supersede() ;
+
+    /**
+     * Change the status of this task and wake up any threads
+     * that are waiting for it to finish.
+     */
+    void status( status_type status ) ;
+
+    /**
+     * Block the calling thread until this task has finished.
+     */
+    void wait() const ;
+
     /** Next identification number to be assigned to a task. */
     static size_t _id_next ;
 
     /** Keep track of the total number of active task */
     static size_t _num_active;
 
+    /** Locks the task ID and active task counters. */
+    static boost::mutex _count_mutex ;
+
      /** Automatically assigned identification number for this task. */
     size_t _id ;
+
+    /** Scheduling priority, higher values are started first. */
+    int _priority ;
+
+    /** Tasks that share this key supersede each other. */
+    std::string _supersede_key ;
+
+    /** Current stage in the life of this task. */
+    status_type _status ;
+
+    /** Set when a newer task, with the same key, replaces this one. */
+    bool _superseded ;
+
+    /** Locks the status of this task. */
+    mutable boost::mutex _status_mutex ;
+
+    /** Signals changes in the status of this task. */
+    mutable boost::condition_variable _status_changed ;
+
+    /** Time that this task was added to the thread_pool queue. */
+    boost::posix_time::ptime _queue_time ;
 };
 
 /// @}
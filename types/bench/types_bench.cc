@@ -0,0 +1,224 @@
+/**
+ * @file types_bench.cc
+ * Benchmarks for interpolation in data_grid, data_grid_svp,
+ * and data_grid_bathy.
+ *
+ * All of the grids are synthetic, with an ocean-like sound speed profile
+ * on a 101 x 41 x 41 grid, and a smooth bathymetry surface on a 41 x 41
+ * grid.  Each iteration interpolates the same set of random locations,
+ * in the same order, so the interval searches are mostly hits on the
+ * cursor left by the previous location.
+ */
+#include <usml/usml_bench.h>
+#include <usml/types/types.h>
+#include <usml/ublas/randgen.h>
+#include <cmath>
+
+using namespace usml::bench ;
+using namespace usml::types ;
+using usml::ublas::randgen ;
+
+namespace {
+
+/** Number of locations interpolated by each iteration. */
+const size_t num_points = 10000 ;
+
+/** Number of depths in the synthetic grids. */
+const size_t num_depths = 101 ;
+
+/** Number of latitudes and longitudes in the synthetic grids. */
+const size_t num_horz = 41 ;
+
+/** Depth increment in the synthetic grids (meters). */
+const double depth_inc = 50.0 ;
+
+/** Horizontal increment in the synthetic grids (radians). */
+const double horz_inc = 0.001 ;
+
+/**
+ * Sound speed that increases with depth, with a sound channel
+ * at 1000 meters and a gentle horizontal gradient.
+ */
+double synthetic_speed( double z, double x, double y ) {
+    const double eta = 2.0 * ( z - 1000.0 ) / 1300.0 ;
+    return 1500.0 * ( 1.0 + 0.00737 * ( eta - 1.0 + std::exp( -eta ) ) )
+        + 100.0 * x + 50.0 * y ;
+}
+
+/**
+ * Builds a synthetic 3-D sound speed grid.  The caller owns the result.
+ */
+data_grid<double,3>* build_profile() {
+    seq_linear depth( 0.0, depth_inc, num_depths ) ;
+    seq_linear horz( 0.0, horz_inc, num_horz ) ;
+    const seq_vector* axis[3] = { &depth, &horz, &horz } ;
+    data_grid<double,3>* grid = new data_grid<double,3>( axis ) ;
+    size_t index[3] ;
+    for ( index[0]=0 ; index[0] < num_depths ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < num_horz ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < num_horz ; ++index[2] ) {
+                grid->data( index, synthetic_speed( depth[index[0]],
+                    horz[index[1]], horz[index[2]] ) ) ;
+            }
+        }
+    }
+    return grid ;
+}
+
+/**
+ * Builds a synthetic 2-D bathymetry grid.  The caller owns the result.
+ */
+data_grid<double,2>* build_bathy() {
+    seq_linear horz( 0.0, horz_inc, num_horz ) ;
+    const seq_vector* axis[2] = { &horz, &horz } ;
+    data_grid<double,2>* grid = new data_grid<double,2>( axis ) ;
+    size_t index[2] ;
+    for ( index[0]=0 ; index[0] < num_horz ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < num_horz ; ++index[1] ) {
+            const double x = horz[index[0]] / horz_inc ;
+            const double y = horz[index[1]] / horz_inc ;
+            grid->data( index, -2000.0 + 10.0 * x + 5.0 * std::sin( 0.3 * y ) ) ;
+        }
+    }
+    return grid ;
+}
+
+/**
+ * Random locations inside the synthetic grids, with axes in
+ * (depth, latitude, longitude) order.
+ */
+matrix<double> random_points() {
+    const double depth_max = depth_inc * ( num_depths - 1 ) ;
+    const double horz_max = horz_inc * ( num_horz - 1 ) ;
+    matrix<double> points( num_points, 3 ) ;
+    for ( size_t n=0 ; n < num_points ; ++n ) {
+        points(n,0) = depth_max * randgen::uniform() ;
+        points(n,1) = horz_max * randgen::uniform() ;
+        points(n,2) = horz_max * randgen::uniform() ;
+    }
+    return points ;
+}
+
+/**
+ * Interpolates a generic 3-D data_grid at each random location,
+ * with the same interpolation type in every dimension.
+ */
+void interp_grid( bench_state& state, GRID_INTERP_TYPE type ) {
+    data_grid<double,3>* grid = build_profile() ;
+    const matrix<double> points = random_points() ;
+    const GRID_INTERP_TYPE types[3] = { type, type, type } ;
+    data_grid_cursor<3> cursor ;
+    double location[3] ;
+    double derivative[3] ;
+    double sum = 0.0 ;
+    while ( state.keep_running() ) {
+        for ( size_t n=0 ; n < num_points ; ++n ) {
+            location[0] = points(n,0) ;
+            location[1] = points(n,1) ;
+            location[2] = points(n,2) ;
+            sum += grid->interpolate( location, derivative, cursor, types ) ;
+        }
+    }
+    state.items_processed( num_points ) ;
+    state.counter( "checksum", sum / state.samples().size() ) ;
+    delete grid ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Generic 3-D data_grid, linear interpolation in every dimension.
+ */
+USML_BENCH( data_grid_linear ) {
+    interp_grid( state, GRID_INTERP_LINEAR ) ;
+}
+
+/**
+ * Generic 3-D data_grid, PCHIP interpolation in every dimension.
+ */
+USML_BENCH( data_grid_pchip ) {
+    interp_grid( state, GRID_INTERP_PCHIP ) ;
+}
+
+/**
+ * data_grid_svp, one location at a time, with derivatives.
+ */
+USML_BENCH( data_grid_svp_point ) {
+    data_grid<double,3>* grid = build_profile() ;
+    data_grid_svp svp( grid ) ;
+    delete grid ;
+    const matrix<double> points = random_points() ;
+    data_grid_cursor<3> cursor ;
+    double location[3] ;
+    double derivative[3] ;
+    double sum = 0.0 ;
+    while ( state.keep_running() ) {
+        for ( size_t n=0 ; n < num_points ; ++n ) {
+            location[0] = points(n,0) ;
+            location[1] = points(n,1) ;
+            location[2] = points(n,2) ;
+            sum += svp.interpolate( location, derivative, cursor ) ;
+        }
+    }
+    state.items_processed( num_points ) ;
+    state.counter( "checksum", sum / state.samples().size() ) ;
+}
+
+/**
+ * data_grid_svp batch interpolation of a wavefront sized set of
+ * locations, with hints.  The argument selects the scalar (0) or
+ * AVX2 (1) form.  The AVX2 case falls back to the scalar form on
+ * processors that do not support it, and reports simd=0.
+ */
+static const size_t simd_modes[] = { 0, 1 } ;
+USML_BENCH_ARGS( data_grid_svp_batch, "simd", simd_modes ) {
+    data_grid<double,3>* grid = build_profile() ;
+    data_grid_svp svp( grid ) ;
+    delete grid ;
+    svp.simd( state.arg() != 0 ) ;
+
+    const size_t rows = 100 ;
+    const size_t cols = num_points / rows ;
+    const matrix<double> points = random_points() ;
+    wposition location( rows, cols ) ;
+    for ( size_t n=0 ; n < num_points ; ++n ) {
+        location.rho( n / cols, n % cols, points(n,0) ) ;
+        location.theta( n / cols, n % cols, points(n,1) ) ;
+        location.phi( n / cols, n % cols, points(n,2) ) ;
+    }
+    matrix<double> speed( rows, cols ) ;
+    wvector gradient( rows, cols ) ;
+    std::vector<size_t> hints ;
+    while ( state.keep_running() ) {
+        svp.interpolate( location, &speed, &gradient, &hints ) ;
+    }
+    state.items_processed( num_points ) ;
+    state.counter( "simd", svp.simd() ? 1.0 : 0.0 ) ;
+}
+
+/**
+ * data_grid_bathy, one location at a time, with derivatives.
+ * The argument selects linear (0) or PCHIP (1) interpolation.
+ */
+static const size_t bathy_modes[] = { 0, 1 } ;
+USML_BENCH_ARGS( data_grid_bathy_point, "pchip", bathy_modes ) {
+    data_grid<double,2>* grid = build_bathy() ;
+    data_grid_bathy bathy( grid ) ;
+    delete grid ;
+    const GRID_INTERP_TYPE type =
+        state.arg() ? GRID_INTERP_PCHIP : GRID_INTERP_LINEAR ;
+    const matrix<double> points = random_points() ;
+    data_grid_cursor<2> cursor ;
+    double location[2] ;
+    double derivative[2] ;
+    double sum = 0.0 ;
+    while ( state.keep_running() ) {
+        for ( size_t n=0 ; n < num_points ; ++n ) {
+            location[0] = points(n,1) ;
+            location[1] = points(n,2) ;
+            sum += bathy.interpolate( type, location, derivative, cursor ) ;
+        }
+    }
+    state.items_processed( num_points ) ;
+    state.counter( "checksum", sum / state.samples().size() ) ;
+}
@@ -55,6 +55,28 @@ namespace types {
         return index[0];
     }
 
+/**
+ * Caller-owned scratch state for the reentrant form of data_grid
+ * interpolation.  Holds the interval index found along each axis by the
+ * most recent interpolation, which is also the starting point for the
+ * next search along that axis.  Each thread keeps its own cursor, which
+ * allows a single data_grid to be queried from many threads at the
+ * same time without a mutex.
+ *
+ * @param  NUM_DIMS     Number of dimensions in the associated grid.
+ */
+template<size_t NUM_DIMS>
+struct data_grid_cursor {
+
+    /** Interval index along each axis. */
+    size_t offset[NUM_DIMS] ;
+
+    /** Start all axes at their first interval. */
+    data_grid_cursor() {
+        memset(offset, 0, NUM_DIMS * sizeof(size_t)) ;
+    }
+};
+
 /**
  * N-dimensional data set and its associated axes.
  * Supports interpolation in any number of dimensions.
@@ -324,74 +346,86 @@ class USML_DLLEXPORT data_grid {
          */
         DATA_TYPE interpolate(double* location, DATA_TYPE* derivative = NULL)
         {
-            // find the "interval index" in each dimension
-
-            for (size_t dim = 0; dim < NUM_DIMS; ++dim) {
-
-                // limit interpolation to axis domain if _edge_limit turned on
-
-                if ( _edge_limit[dim] ) {
-                    double a = *(_axis[dim]->begin()) ;
-                    double b = *(_axis[dim]->rbegin()) ;
-                    double inc = _axis[dim]->increment(0);
-                    if ( inc < 0) {                                                     // a > b
-                        if ( location[dim] >= a ) {                                     //left of the axis
-                            location[dim] = a ;
-                            _offset[dim] = 0 ;
-                        } else if ( location[dim] <= b ) {                              //right of the axis
-                            location[dim] = b ;
-                            _offset[dim] = _axis[dim]->size()-2 ;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]);       //somewhere in-between the endpoints of the axis
-                        }
-                    }
-                    if (inc > 0 ) {                                                     // a < b
-                        if ( location[dim] <= a ) {                                     //left of the axis
-                            location[dim] = a ;
-                            _offset[dim] = 0 ;
-                        } else if ( location[dim] >= b ) {                              //right of the axis
-                            location[dim] = b ;
-                            _offset[dim] = _axis[dim]->size()-2 ;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]);       //somewhere in-between the endpoints of the axis
-                        }
-                    }
-
-                // allow extrapolation if _edge_limit turned off
-
-                } else {
-                    _offset[dim] = _axis[dim]->find_index(location[dim]);
-                }
-            }
+            return interpolate(location, derivative, _cursor);
+        }
 
-            // compute interpolation results for value and derivative
+        /**
+         * Reentrant form of multi-dimensional interpolation. All of the
+         * scratch state for this calculation is stored in a caller-owned
+         * cursor, which allows a single data_grid to be shared by
+         * multiple threads without locking, as long as each thread uses
+         * its own cursor.
+         *
+         * @param   location    Location at which field value is desired. Must
+         *                      have the same rank as the data grid or higher.
+         *                      WARNING: The contents of the location vector
+         *                      may be modified if edge_limit() is true for
+         *                      any dimension.
+         * @param   derivative  If this is not null, the first derivative
+         *                      of the field at this point will also be computed.
+         * @param   cursor      Interval indices for this calculation.
+         *                      Search hints on input (input/output).
+         * @return              Value of the field at this point.
+         */
+        DATA_TYPE interpolate(double* location, DATA_TYPE* derivative,
+                data_grid_cursor<NUM_DIMS>& cursor) const
+        {
+            return interpolate(location, derivative, cursor, _interp_type);
+        }
 
+        /**
+         * Reentrant form of multi-dimensional interpolation that uses
+         * a caller supplied interpolation type for each dimension, instead
+         * of the interp_type() settings stored in the grid.  Allows
+         * different clients to interpolate a shared grid in different
+         * ways, without modifying it.
+         *
+         * @param   location    Location at which field value is desired. Must
+         *                      have the same rank as the data grid or higher.
+         *                      WARNING: The contents of the location vector
+         *                      may be modified if edge_limit() is true for
+         *                      any dimension.
+         * @param   derivative  If this is not null, the first derivative
+         *                      of the field at this point will also be computed.
+         * @param   cursor      Interval indices for this calculation.
+         *                      Search hints on input (input/output).
+         * @param   type        Type of interpolation for each dimension.
+         * @return              Value of the field at this point.
+         */
+        DATA_TYPE interpolate(double* location, DATA_TYPE* derivative,
+                data_grid_cursor<NUM_DIMS>& cursor,
+                const enum GRID_INTERP_TYPE* type) const
+        {
+            find_offsets(location, cursor);
             DATA_TYPE dresult;
-            return interp(NUM_DIMS - 1, _offset, location, dresult, derivative);
+            return interp(NUM_DIMS - 1, cursor.offset, location, dresult,
+                    derivative, type);
         }
 
         /**
          * Interpolation 1-D specialization where the arguments, and results,
          * are matrix<double>.  This is used frequently in the WaveQ3D model
-         * to interpolate environmental parameters.
+         * to interpolate environmental parameters. Safe to call from
+         * multiple threads at the same time.
          *
          * @param   x           First dimension of location.
          * @param   result      Interpolated values at each location (output).
          * @param   dx          First dimension of derivative (output).
          */
         void interpolate(const matrix<double>& x, matrix<double>* result, matrix<
-                double>* dx = NULL)
+                double>* dx = NULL) const
         {
             double location[1];
             DATA_TYPE derivative[1];
+            data_grid_cursor<NUM_DIMS> cursor;
             for (size_t n = 0; n < x.size1(); ++n) {
                 for (size_t m = 0; m < x.size2(); ++m) {
                     location[0] = x(n, m);
                     if (dx == NULL) {
-                        (*result)(n, m) = (double) interpolate(location);
+                        (*result)(n, m) = (double) interpolate(location, NULL, cursor);
                     } else {
                         (*result)(n, m)
-                                = (double) interpolate(location, derivative);
+                                = (double) interpolate(location, derivative, cursor);
                         (*dx)(n, m) = (double) derivative[0];
                     }
                 }
@@ -401,7 +435,8 @@ class USML_DLLEXPORT data_grid {
         /**
          * Interpolation 2-D specialization where the arguments, and results,
          * are matrix<double>.  This is used frequently in the WaveQ3D model
-         * to interpolate environmental parameters.
+         * to interpolate environmental parameters. Safe to call from
+         * multiple threads at the same time.
          *
          * @param   x           First dimension of location.
          * @param   y           Second dimension of location.
@@ -411,19 +446,20 @@ class USML_DLLEXPORT data_grid {
          */
         void interpolate(const matrix<double>& x, const matrix<double>& y, matrix<
                 double>* result, matrix<double>* dx = NULL, matrix<double>* dy =
-                NULL)
+                NULL) const
         {
             double location[2];
             DATA_TYPE derivative[2];
+            data_grid_cursor<NUM_DIMS> cursor;
             for (size_t n = 0; n < x.size1(); ++n) {
                 for (size_t m = 0; m < x.size2(); ++m) {
                     location[0] = x(n, m);
                     location[1] = y(n, m);
                     if (dx == NULL || dy == NULL) {
-                        (*result)(n, m) = (double) interpolate(location);
+                        (*result)(n, m) = (double) interpolate(location, NULL, cursor);
                     } else {
                         (*result)(n, m)
-                                = (double) interpolate(location, derivative);
+                                = (double) interpolate(location, derivative, cursor);
                         (*dx)(n, m) = (double) derivative[0];
                         (*dy)(n, m) = (double) derivative[1];
                     }
@@ -434,7 +470,8 @@ class USML_DLLEXPORT data_grid {
         /**
          * Interpolation 3-D specialization where the arguments, and results,
          * are matrix<double>.  This is used frequently in the WaveQ3D model
-         * to interpolate environmental parameters.
+         * to interpolate environmental parameters. Safe to call from
+         * multiple threads at the same time.
          *
          * @param   x           First dimension of location.
          * @param   y           Second dimension of location.
@@ -447,20 +484,21 @@ class USML_DLLEXPORT data_grid {
         void interpolate(const matrix<double>& x, const matrix<double>& y,
                 const matrix<double>& z, matrix<double>* result,
                 matrix<double>* dx = NULL, matrix<double>* dy = NULL,
-                matrix<double>* dz = NULL)
+                matrix<double>* dz = NULL) const
         {
             double location[3];
             DATA_TYPE derivative[3];
+            data_grid_cursor<NUM_DIMS> cursor;
             for (size_t n = 0; n < x.size1(); ++n) {
                 for (size_t m = 0; m < x.size2(); ++m) {
                     location[0] = x(n, m);
                     location[1] = y(n, m);
                     location[2] = z(n, m);
                     if (dx == NULL || dy == NULL || dz == NULL) {
-                        (*result)(n, m) = (double) interpolate(location);
+                        (*result)(n, m) = (double) interpolate(location, NULL, cursor);
                     } else {
                         (*result)(n, m)
-                                = (double) interpolate(location, derivative);
+                                = (double) interpolate(location, derivative, cursor);
                         (*dx)(n, m) = (double) derivative[0];
                         (*dy)(n, m) = (double) derivative[1];
                         (*dz)(n, m) = (double) derivative[2];
@@ -480,8 +518,12 @@ class USML_DLLEXPORT data_grid {
         /** Limits locations to values inside axis when true. */
         bool _edge_limit[NUM_DIMS];
 
-        /** Used during interpolation to hold the axis offsets. */
-        size_t _offset[NUM_DIMS] ;
+        /**
+         * Cursor used by the non-reentrant form of interpolate().
+         * Callers that share this grid across threads should supply their
+         * own data_grid_cursor instead.
+         */
+        data_grid_cursor<NUM_DIMS> _cursor ;
 
         /**
          * Multi-dimensional data stored as a linear array in column major order.
@@ -505,6 +547,64 @@ class USML_DLLEXPORT data_grid {
             memset(_edge_limit, true, NUM_DIMS * sizeof(bool)) ;
         }
 
+        /**
+         * Find the interval index along each axis of the data grid.
+         * Limits the location to the axis domain if _edge_limit is turned on
+         * for that dimension.  Allows extrapolation if _edge_limit turned off.
+         * Uses the thread-safe, hinted seq_vector::find_index() so that it
+         * does not modify any state in this grid.  The intervals from the
+         * previous search are the hints for this one, which makes the
+         * search very fast when consecutive locations are close together.
+         *
+         * @param   location    Location at which field value is desired.
+         *                      Modified if it falls outside of an edge
+         *                      limited axis.
+         * @param   cursor      Interval index in each dimension.  Starting
+         *                      point for the search on input, and the
+         *                      interval found on output.
+         */
+        void find_offsets(double* location, data_grid_cursor<NUM_DIMS>& cursor) const
+        {
+            for (size_t dim = 0; dim < NUM_DIMS; ++dim) {
+                const seq_vector* ax = _axis[dim];
+
+                // limit interpolation to axis domain if _edge_limit turned on
+
+                if ( _edge_limit[dim] ) {
+                    double a = *(ax->begin()) ;
+                    double b = *(ax->rbegin()) ;
+                    double inc = ax->increment(0);
+                    if ( inc < 0) {                                                     // a > b
+                        if ( location[dim] >= a ) {                                     //left of the axis
+                            location[dim] = a ;
+                            cursor.offset[dim] = 0 ;
+                        } else if ( location[dim] <= b ) {                              //right of the axis
+                            location[dim] = b ;
+                            cursor.offset[dim] = ax->size()-2 ;
+                        } else {
+                            cursor.offset[dim] = ax->find_index(location[dim],cursor.offset[dim]);             //somewhere in-between the endpoints of the axis
+                        }
+                    }
+                    if (inc > 0 ) {                                                     // a < b
+                        if ( location[dim] <= a ) {                                     //left of the axis
+                            location[dim] = a ;
+                            cursor.offset[dim] = 0 ;
+                        } else if ( location[dim] >= b ) {                              //right of the axis
+                            location[dim] = b ;
+                            cursor.offset[dim] = ax->size()-2 ;
+                        } else {
+                            cursor.offset[dim] = ax->find_index(location[dim],cursor.offset[dim]);             //somewhere in-between the endpoints of the axis
+                        }
+                    }
+
+                // allow extrapolation if _edge_limit turned off
+
+                } else {
+                    cursor.offset[dim] = ax->find_index(location[dim],cursor.offset[dim]);
+                }
+            }
+        }
+
     private:
 
         //*************************************************************************
@@ -513,7 +613,7 @@ class USML_DLLEXPORT data_grid {
         /**
          * Private recursion engine for multi-dimensional interpolation.
          * The type of interpolation for each dimension is determined using
-         * the _interp_type[] field. Interpolation coefficients are computed on
+         * the type[] argument. Interpolation coefficients are computed on
          * the fly to make arbitrary combinations of interpolation types viable.
          *
          * @param   dim         Index of the dimension currently being processed.
@@ -526,10 +626,12 @@ class USML_DLLEXPORT data_grid {
          * @param   deriv        Derivative for this iteration.
          * @param    deriv_vec   Results vector for derivative.
          *                        Derivative not computed if NULL.
+         * @param   type        Type of interpolation for each dimension.
          * @return              Estimate of the field after interpolation.
          */
         DATA_TYPE interp(int dim, const size_t* index, const double* location,
-                DATA_TYPE& deriv, DATA_TYPE* deriv_vec) const;
+                DATA_TYPE& deriv, DATA_TYPE* deriv_vec,
+                const enum GRID_INTERP_TYPE* type) const;
         // forward reference needed for recursion
 
         /**
@@ -544,10 +646,12 @@ class USML_DLLEXPORT data_grid {
          *                      nearest neighbor interpolation.
          * @param    deriv_vec   Results vector for derivative.
          *                        Derivative not computed if NULL.
+         * @param   type        Type of interpolation for each dimension.
          * @return              Estimate of the field after interpolation.
          */
         DATA_TYPE nearest(int dim, const size_t* index, const double* location,
-                DATA_TYPE& deriv, DATA_TYPE* deriv_vec) const
+                DATA_TYPE& deriv, DATA_TYPE* deriv_vec,
+                const enum GRID_INTERP_TYPE* type) const
         {
             DATA_TYPE result, da;
 
@@ -557,12 +661,12 @@ class USML_DLLEXPORT data_grid {
             seq_vector* ax = _axis[dim];
             const double u = (location[dim] - (*ax)(k)) / ax->increment(k);
             if (u < 0.5) {
-                result = interp(dim - 1, index, location, da, deriv_vec);
+                result = interp(dim - 1, index, location, da, deriv_vec, type);
             } else {
                 size_t next[NUM_DIMS];
                 memcpy(next, index, NUM_DIMS * sizeof(size_t));
                 ++next[dim];
-                result = interp(dim - 1, next, location, da, deriv_vec);
+                result = interp(dim - 1, next, location, da, deriv_vec, type);
             }
 
             // compute derivative in this dimension
@@ -590,20 +694,22 @@ class USML_DLLEXPORT data_grid {
          *                      interval for linear interpolation.
          * @param    deriv_vec   Results vector for derivative.
          *                        Derivative not computed if NULL.
+         * @param   type        Type of interpolation for each dimension.
          * @return              Estimate of the field after interpolation.
          */
         DATA_TYPE linear(int dim, const size_t* index, const double* location,
-                DATA_TYPE& deriv, DATA_TYPE* deriv_vec) const
+                DATA_TYPE& deriv, DATA_TYPE* deriv_vec,
+                const enum GRID_INTERP_TYPE* type) const
         {
             DATA_TYPE result, da, db;
 
             // build interpolation coefficients
 
-            const DATA_TYPE a = interp(dim - 1, index, location, da, deriv_vec);
+            const DATA_TYPE a = interp(dim - 1, index, location, da, deriv_vec, type);
             size_t next[NUM_DIMS];
             memcpy(next, index, NUM_DIMS * sizeof(size_t));
             ++next[dim];
-            const DATA_TYPE b = interp(dim - 1, next, location, db, deriv_vec);
+            const DATA_TYPE b = interp(dim - 1, next, location, db, deriv_vec, type);
             const size_t k = index[dim];
             seq_vector* ax = _axis[dim];
 
@@ -689,10 +795,12 @@ class USML_DLLEXPORT data_grid {
          *                      interval for linear interpolation.
          * @param    deriv_vec   Results vector for derivative.
          *                        Derivative not computed if NULL.
+         * @param   type        Type of interpolation for each dimension.
          * @return              Estimate of the field after interpolation.
          */
         DATA_TYPE pchip(int dim, const size_t* index, const double* location,
-                DATA_TYPE& deriv, DATA_TYPE* deriv_vec) const
+                DATA_TYPE& deriv, DATA_TYPE* deriv_vec,
+                const enum GRID_INTERP_TYPE* type) const
         {
             DATA_TYPE result ;
             DATA_TYPE y0, y1, y2, y3 ;             // dim-1 values at k-1, k, k+1, k+2
@@ -704,13 +812,13 @@ class USML_DLLEXPORT data_grid {
 
             const size_t k = index[dim];
             seq_vector* ax = _axis[dim];
-            y1 = interp( dim-1, index, location, dy1, deriv_vec );
+            y1 = interp( dim-1, index, location, dy1, deriv_vec, type );
 
             if ( k >= kmin ) {
                 size_t prev[NUM_DIMS];
                 memcpy(prev, index, NUM_DIMS * sizeof(size_t));
                 --prev[dim];
-                y0 = interp( dim-1, prev, location, dy0, deriv_vec );
+                y0 = interp( dim-1, prev, location, dy0, deriv_vec, type );
             } else {    // use harmless values at left end-point
                 y0 = y1 ;
                 dy0 = dy1 ;
@@ -721,13 +829,13 @@ class USML_DLLEXPORT data_grid {
             size_t next[NUM_DIMS];
             memcpy(next, index, NUM_DIMS * sizeof(size_t));
             ++next[dim];
-            y2 = interp( dim-1, next, location, dy2, deriv_vec );
+            y2 = interp( dim-1, next, location, dy2, deriv_vec, type );
 
             if ( k <= kmax ) {
                 size_t last[NUM_DIMS];
                 memcpy(last, next, NUM_DIMS * sizeof(size_t));
                 ++last[dim];
-                y3 = interp(dim - 1, last, location, dy3, deriv_vec);
+                y3 = interp(dim - 1, last, location, dy3, deriv_vec, type);
             } else {    // use harmless values at right end-point
                 y3 = y2 ;
                 dy3 = dy2 ;
@@ -880,7 +988,7 @@ class USML_DLLEXPORT data_grid {
 template<class DATA_TYPE, size_t NUM_DIMS>
 DATA_TYPE data_grid<DATA_TYPE, NUM_DIMS>::interp(int dim,
         const size_t* index, const double* location, DATA_TYPE& deriv,
-        DATA_TYPE* deriv_vec) const
+        DATA_TYPE* deriv_vec, const enum GRID_INTERP_TYPE* type) const
 {
     DATA_TYPE result;
 
@@ -889,12 +997,12 @@ DATA_TYPE data_grid<DATA_TYPE, NUM_DIMS>::interp(int dim,
         // terminates recursion
 
     } else {
-        if (_interp_type[dim] == GRID_INTERP_LINEAR) {
-            result = linear(dim, index, location, deriv, deriv_vec);
-        } else if (_interp_type[dim] == GRID_INTERP_PCHIP) {
-            result = pchip(dim, index, location, deriv, deriv_vec);
+        if (type[dim] == GRID_INTERP_LINEAR) {
+            result = linear(dim, index, location, deriv, deriv_vec, type);
+        } else if (type[dim] == GRID_INTERP_PCHIP) {
+            result = pchip(dim, index, location, deriv, deriv_vec, type);
         } else {
-            result = nearest(dim, index, location, deriv, deriv_vec);
+            result = nearest(dim, index, location, deriv, deriv_vec, type);
         }
     }
     return result;
@@ -42,8 +42,7 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
          * @param grid      The data_grid that is to be wrapped.
          */
         data_grid_bathy(const data_grid<double, 2>* grid) :
-                data_grid<double, 2>(*grid, true), _bicubic_coeff(16, 1),
-                _field(16, 1), _xyloc(1, 16), _result_pchip(1, 1), _value(4, 4),
+                data_grid<double, 2>(*grid, true),
                 _kmin(0u), _k0max(_axis[0]->size() - 1u), _k1max(_axis[1]->size() - 1u)
         {
             // Construct the inverse bicubic interpolation coefficient matrix
@@ -118,9 +117,6 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
             _inv_bicubic_coeff(15, 12) = _inv_bicubic_coeff(15, 13) =
                     _inv_bicubic_coeff(15, 14) = _inv_bicubic_coeff(15, 15) = 1;
 
-            _fast_index[0] = 0;
-            _fast_index[1] = 0;
-
             //Pre-construct increments for all intervals once to save time
             matrix<double> inc_x(_k0max + 1u, 1);
             for (size_t i = 0; i < _k0max + 1u; ++i) {
@@ -245,65 +241,68 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
          */
 
         double interpolate(double* location, double* derivative = NULL) {
+            return interpolate(interp_type(0), location, derivative, _cursor);
+        }
 
-            double result = 0;
-            // find the interval index in each dimension
-
-            for (size_t dim = 0; dim < 2; ++dim) {
+        /**
+         * Reentrant form of the non-recursive interpolation at a single
+         * location. All scratch state is kept on the stack or in the
+         * caller-owned cursor, so a single data_grid_bathy can be shared
+         * by multiple threads without locking.
+         *
+         * @param location   Location to do the interpolation at
+         * @param derivative Derivative at the location (output)
+         * @param cursor     Interval indices for this calculation.
+         *                  Search hints on input (input/output).
+         * @return           Returns the value at the field location
+         */
+        double interpolate(double* location, double* derivative,
+                data_grid_cursor<2>& cursor) const {
+            return interpolate(interp_type(0), location, derivative, cursor);
+        }
 
-                // limit interpolation to axis domain if _edge_limit turned on
+        /**
+         * Reentrant interpolation at a single location that uses the
+         * interpolation type supplied by the caller instead of the one
+         * stored with the 0th dimensional axis.  Allows callers to switch
+         * between fast and accurate interpolation without modifying
+         * the shared grid.
+         *
+         * @param type       Type of interpolation to use in both dimensions.
+         * @param location   Location to do the interpolation at
+         * @param derivative Derivative at the location (output)
+         * @param cursor     Interval indices for this calculation.
+         *                  Search hints on input (input/output).
+         * @return           Returns the value at the field location
+         */
+        double interpolate(enum GRID_INTERP_TYPE type, double* location,
+                double* derivative, data_grid_cursor<2>& cursor) const {
 
-                if (edge_limit(dim)) {
-                    double a = *(_axis[dim]->begin()) ;
-                    double b = *(_axis[dim]->rbegin());
-                    double inc = _axis[dim]->increment(0);
-                    if (inc < 0) {                                          // a > b
-                        if (location[dim] >= a) {                //left of the axis
-                            location[dim] = a;
-                            _offset[dim] = 0;
-                        } else if (location[dim] <= b) {         //right of the axis
-                            location[dim] = b;
-                            _offset[dim] = _axis[dim]->size() - 2;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]); //somewhere in-between the endpoints of the axis
-                        }
-                    }
-                    if (inc > 0) {                                          // a < b
-                        if (location[dim] <= a) {                 //left of the axis
-                            location[dim] = a;
-                            _offset[dim] = 0;
-                        } else if (location[dim] >= b) {         //right of the axis
-                            location[dim] = b;
-                            _offset[dim] = _axis[dim]->size() - 2;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]); //somewhere in-between the endpoints of the axis
-                        }
-                    }
+            double result = 0;
+            const size_t* offset = cursor.offset;
+            size_t fast_index[2];
 
-                    // allow extrapolation if _edge_limit turned off
+            // find the interval index in each dimension
 
-                } else {
-                    _offset[dim] = _axis[dim]->find_index(location[dim]);
-                }
-            }
+            find_offsets(location, cursor);
 
-            switch (interp_type(0)) {
+            switch (type) {
 
             //****nearest****
             case -1:
                 for (int dim = 0; dim < 2; ++dim) {
                     double inc = _axis[dim]->increment(0);
-                    double u = abs(location[dim] - (*_axis[dim])(_offset[dim]))
+                    double u = abs(location[dim] - (*_axis[dim])(offset[dim]))
                             / inc;
                     if (u < 0.5) {
-                        _fast_index[dim] = _offset[dim];
+                        fast_index[dim] = offset[dim];
                     } else {
-                        _fast_index[dim] = _offset[dim] + 1;
+                        fast_index[dim] = offset[dim] + 1;
                     }
                 }
                 if (derivative)
                     derivative[0] = derivative[1] = 0;
-                return data(_fast_index);
+                return data(fast_index);
                 break;
 
                 //****linear****
@@ -312,21 +311,21 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
                 double x, x1, x2, y, y1, y2;
 
                 x = location[0];
-                x1 = (*_axis[0])(_offset[0]);
-                x2 = (*_axis[0])(_offset[0] + 1);
+                x1 = (*_axis[0])(offset[0]);
+                x2 = (*_axis[0])(offset[0] + 1);
                 y = location[1];
-                y1 = (*_axis[1])(_offset[1]);
-                y2 = (*_axis[1])(_offset[1] + 1);
-                f11 = data(_offset);
-                _fast_index[0] = _offset[0] + 1;
-                _fast_index[1] = _offset[1];
-                f21 = data(_fast_index);
-                _fast_index[0] = _offset[0];
-                _fast_index[1] = _offset[1] + 1;
-                f12 = data(_fast_index);
-                _fast_index[0] = _offset[0] + 1;
-                _fast_index[1] = _offset[1] + 1;
-                f22 = data(_fast_index);
+                y1 = (*_axis[1])(offset[1]);
+                y2 = (*_axis[1])(offset[1] + 1);
+                f11 = data(offset);
+                fast_index[0] = offset[0] + 1;
+                fast_index[1] = offset[1];
+                f21 = data(fast_index);
+                fast_index[0] = offset[0];
+                fast_index[1] = offset[1] + 1;
+                f12 = data(fast_index);
+                fast_index[0] = offset[0] + 1;
+                fast_index[1] = offset[1] + 1;
+                f22 = data(fast_index);
                 x_diff = x2 - x1;
                 y_diff = y2 - y1;
                 result = (f11 * (x2 - x) * (y2 - y) + f21 * (x - x1) * (y2 - y)
@@ -343,7 +342,7 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
 
                 //****pchip****
             case 1:
-                result = fast_pchip(_offset, location, derivative);
+                result = fast_pchip(offset, location, derivative);
                 return result;
                 break;
 
@@ -358,7 +357,8 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
          * Overrides the interpolate function within data_grid using the
          * non-recursive formula.
          *
-         * Interpolate at a series of locations.
+         * Interpolate at a series of locations. Safe to call from
+         * multiple threads at the same time.
          *
          * @param   x           First dimension of location.
          * @param   y           Second dimension of location.
@@ -369,18 +369,39 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
 
         void interpolate(const matrix<double>& x, const matrix<double>& y,
                 matrix<double>* result, matrix<double>* dx = NULL,
-                matrix<double>* dy = NULL) {
+                matrix<double>* dy = NULL) const {
+            interpolate(interp_type(0), x, y, result, dx, dy);
+        }
+
+        /**
+         * Interpolate at a series of locations using the interpolation
+         * type supplied by the caller. Safe to call from multiple threads
+         * at the same time.
+         *
+         * @param   type        Type of interpolation in both dimensions.
+         * @param   x           First dimension of location.
+         * @param   y           Second dimension of location.
+         * @param   result      Interpolated values at each location (output).
+         * @param   dx          First dimension of derivative (output).
+         * @param   dy          Second dimension of derivative (output).
+         */
+        void interpolate(enum GRID_INTERP_TYPE type,
+                const matrix<double>& x, const matrix<double>& y,
+                matrix<double>* result, matrix<double>* dx = NULL,
+                matrix<double>* dy = NULL) const {
             double location[2];
             double derivative[2];
+            data_grid_cursor<2> cursor;
             for (size_t n = 0; n < x.size1(); ++n) {
                 for (size_t m = 0; m < x.size2(); ++m) {
                     location[0] = x(n, m);
                     location[1] = y(n, m);
                     if (dx == NULL || dy == NULL) {
-                        (*result)(n, m) = (double) interpolate(location);
+                        (*result)(n, m) = (double) interpolate(type,
+                                location, NULL, cursor);
                     } else {
-                        (*result)(n, m) = (double) interpolate(location,
-                                derivative);
+                        (*result)(n, m) = (double) interpolate(type,
+                                location, derivative, cursor);
                         (*dx)(n, m) = (double) derivative[0];
                         (*dy)(n, m) = (double) derivative[1];
                     }
@@ -391,7 +412,7 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
     private:
 
         /** Utility accessor function for data grid values */
-        inline double data_2d(size_t row, size_t col) {
+        inline double data_2d(size_t row, size_t col) const {
             size_t grid_index[2];
             grid_index[0] = row;
             grid_index[1] = col;
@@ -450,11 +471,17 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
          * @param derivative    Generate the derivative at the location (output)
          * @return              Returns the value at the field location
          */
-        double fast_pchip(const size_t* interp_index, double* location,
-                double* derivative = NULL) {
+        double fast_pchip(const size_t* interp_index, const double* location,
+                double* derivative = NULL) const {
             size_t k0 = interp_index[0];
             size_t k1 = interp_index[1];
             double norm0, norm1;
+            size_t fast_index[2];
+            c_matrix<double, 16, 1> bicubic_coeff;
+            c_matrix<double, 16, 1> field;
+            c_matrix<double, 1, 16> xyloc;
+            c_matrix<double, 1, 1> result_pchip;
+            c_matrix<double, 4, 4> value;
 
             // Checks for boundaries of the axes
             norm0 = _axis[0]->increment(k0) ;
@@ -463,86 +490,86 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
                 for (int j = -1; j < 3; ++j) {
                     //get appropriate data when at boundaries
                     if ((k0 + i) >= _k0max) {
-                        _fast_index[0] = _k0max ;
+                        fast_index[0] = _k0max ;
                     } else if ((k0 + i) <= _kmin) {
-                        _fast_index[0] = _kmin ;
+                        fast_index[0] = _kmin ;
                     } else {
-                        _fast_index[0] = k0 + i ;
+                        fast_index[0] = k0 + i ;
                     }
                     //get appropriate data when at boundaries
                     if ((k1 + j) >= _k1max) {
-                        _fast_index[1] = _k1max ;
+                        fast_index[1] = _k1max ;
                     } else if ((k1 + j) <= _kmin) {
-                        _fast_index[1] = _kmin ;
+                        fast_index[1] = _kmin ;
                     } else {
-                        _fast_index[1] = k1 + j ;
+                        fast_index[1] = k1 + j ;
                     }
-                    _value(i + 1, j + 1) = data(_fast_index) ;
+                    value(i + 1, j + 1) = data(fast_index) ;
                 }   //end for-loop in j
             }   //end for-loop in i
 
-            // Construct the _field matrix
-            _field(0, 0) = _value(1, 1);                  //f(0,0)
-            _field(1, 0) = _value(1, 2);                  //f(0,1)
-            _field(2, 0) = _value(2, 1);                  //f(1,0)
-            _field(3, 0) = _value(2, 2);                  //f(1,1)
-            _field(4, 0) = _derv_x(k0, k1);               //f_x(0,0)
-            _field(5, 0) = _derv_x(k0, k1 + 1);           //f_x(0,1)
-            _field(6, 0) = _derv_x(k0 + 1, k1);           //f_x(1,0)
-            _field(7, 0) = _derv_x(k0 + 1, k1 + 1);       //f_x(1,1)
-            _field(8, 0) = _derv_y(k0, k1);               //f_y(0,0)
-            _field(9, 0) = _derv_y(k0, k1 + 1);           //f_y(0,1)
-            _field(10, 0) = _derv_y(k0 + 1, k1);          //f_y(1,0)
-            _field(11, 0) = _derv_y(k0 + 1, k1 + 1);      //f_y(1,1)
-            _field(12, 0) = _derv_x_y(k0, k1);            //f_x_y(0,0)
-            _field(13, 0) = _derv_x_y(k0, k1 + 1);        //f_x_y(0,1)
-            _field(14, 0) = _derv_x_y(k0 + 1, k1);        //f_x_y(1,0)
-            _field(15, 0) = _derv_x_y(k0 + 1, k1 + 1);    //f_x_y(1,1)
+            // Construct the field matrix
+            field(0, 0) = value(1, 1);                  //f(0,0)
+            field(1, 0) = value(1, 2);                  //f(0,1)
+            field(2, 0) = value(2, 1);                  //f(1,0)
+            field(3, 0) = value(2, 2);                  //f(1,1)
+            field(4, 0) = _derv_x(k0, k1);               //f_x(0,0)
+            field(5, 0) = _derv_x(k0, k1 + 1);           //f_x(0,1)
+            field(6, 0) = _derv_x(k0 + 1, k1);           //f_x(1,0)
+            field(7, 0) = _derv_x(k0 + 1, k1 + 1);       //f_x(1,1)
+            field(8, 0) = _derv_y(k0, k1);               //f_y(0,0)
+            field(9, 0) = _derv_y(k0, k1 + 1);           //f_y(0,1)
+            field(10, 0) = _derv_y(k0 + 1, k1);          //f_y(1,0)
+            field(11, 0) = _derv_y(k0 + 1, k1 + 1);      //f_y(1,1)
+            field(12, 0) = _derv_x_y(k0, k1);            //f_x_y(0,0)
+            field(13, 0) = _derv_x_y(k0, k1 + 1);        //f_x_y(0,1)
+            field(14, 0) = _derv_x_y(k0 + 1, k1);        //f_x_y(1,0)
+            field(15, 0) = _derv_x_y(k0 + 1, k1 + 1);    //f_x_y(1,1)
 
             // Construct the coefficients of the bicubic interpolation
-            _bicubic_coeff = prod(_inv_bicubic_coeff, _field);
+            bicubic_coeff = prod(_inv_bicubic_coeff, field);
 
             // Create the power series of the interpolation formula before hand for speed
             double x_inv = location[0] - (*_axis[0])(k0);
             double y_inv = location[1] - (*_axis[1])(k1);
 
-            _xyloc(0, 0) = 1;
-            _xyloc(0, 1) = y_inv / norm1;
-            _xyloc(0, 2) = _xyloc(0, 1) * _xyloc(0, 1);
-            _xyloc(0, 3) = _xyloc(0, 2) * _xyloc(0, 1);
-            _xyloc(0, 4) = x_inv / norm0;
-            _xyloc(0, 5) = _xyloc(0, 4) * _xyloc(0, 1);
-            _xyloc(0, 6) = _xyloc(0, 4) * _xyloc(0, 2);
-            _xyloc(0, 7) = _xyloc(0, 4) * _xyloc(0, 3);
-            _xyloc(0, 8) = _xyloc(0, 4) * _xyloc(0, 4);
-            _xyloc(0, 9) = _xyloc(0, 8) * _xyloc(0, 1);
-            _xyloc(0, 10) = _xyloc(0, 8) * _xyloc(0, 2);
-            _xyloc(0, 11) = _xyloc(0, 8) * _xyloc(0, 3);
-            _xyloc(0, 12) = _xyloc(0, 8) * _xyloc(0, 4);
-            _xyloc(0, 13) = _xyloc(0, 12) * _xyloc(0, 1);
-            _xyloc(0, 14) = _xyloc(0, 12) * _xyloc(0, 2);
-            _xyloc(0, 15) = _xyloc(0, 12) * _xyloc(0, 3);
-
-            _result_pchip = prod(_xyloc, _bicubic_coeff);
+            xyloc(0, 0) = 1;
+            xyloc(0, 1) = y_inv / norm1;
+            xyloc(0, 2) = xyloc(0, 1) * xyloc(0, 1);
+            xyloc(0, 3) = xyloc(0, 2) * xyloc(0, 1);
+            xyloc(0, 4) = x_inv / norm0;
+            xyloc(0, 5) = xyloc(0, 4) * xyloc(0, 1);
+            xyloc(0, 6) = xyloc(0, 4) * xyloc(0, 2);
+            xyloc(0, 7) = xyloc(0, 4) * xyloc(0, 3);
+            xyloc(0, 8) = xyloc(0, 4) * xyloc(0, 4);
+            xyloc(0, 9) = xyloc(0, 8) * xyloc(0, 1);
+            xyloc(0, 10) = xyloc(0, 8) * xyloc(0, 2);
+            xyloc(0, 11) = xyloc(0, 8) * xyloc(0, 3);
+            xyloc(0, 12) = xyloc(0, 8) * xyloc(0, 4);
+            xyloc(0, 13) = xyloc(0, 12) * xyloc(0, 1);
+            xyloc(0, 14) = xyloc(0, 12) * xyloc(0, 2);
+            xyloc(0, 15) = xyloc(0, 12) * xyloc(0, 3);
+
+            result_pchip = prod(xyloc, bicubic_coeff);
             if (derivative) {
                 derivative[0] = 0;
                 derivative[1] = 0;
                 for (int i = 1; i < 4; ++i) {
                     for (int j = 0; j < 4; ++j) {
-                        derivative[0] += i * _bicubic_coeff(i * 4 + j, 0)
-                                * _xyloc(0, 4 * (i - 1)) * _xyloc(0, j);
+                        derivative[0] += i * bicubic_coeff(i * 4 + j, 0)
+                                * xyloc(0, 4 * (i - 1)) * xyloc(0, j);
                     }
                 }
                 derivative[0] /= _axis[0]->increment(k0) ;
                 for (int i = 0; i < 4; ++i) {
                     for (int j = 1; j < 4; ++j) {
-                        derivative[1] += j * _bicubic_coeff(i * 4 + j, 0)
-                                * _xyloc(0, 4 * i) * _xyloc(0, j - 1);
+                        derivative[1] += j * bicubic_coeff(i * 4 + j, 0)
+                                * xyloc(0, 4 * i) * xyloc(0, j - 1);
                     }
                 }
                 derivative[1] /= _axis[1]->increment(k1) ;
             }
-            return _result_pchip(0, 0);
+            return result_pchip(0, 0);
         }
 
         //***********************************************************/
@@ -556,21 +583,12 @@ class USML_DECLSPEC data_grid_bathy: public data_grid<double, 2> {
         c_matrix<double, 16, 16> _inv_bicubic_coeff;
 
         /**
-         * Create variables that are used multiple times through out
-         * the course of multiple calls per instance. Thus allowing
-         * these variables to be created once and used as many times
-         * as needed and save memory and time.
+         * Partial and mixed derivatives at each grid point, computed
+         * once in the constructor.
          */
-
-        c_matrix<double, 16, 1> _bicubic_coeff;
-        c_matrix<double, 16, 1> _field;
-        c_matrix<double, 1, 16> _xyloc;
-        c_matrix<double, 1, 1> _result_pchip;
-        c_matrix<double, 4, 4> _value;
         matrix<double> _derv_x;
         matrix<double> _derv_y;
         matrix<double> _derv_x_y;
-        size_t  _fast_index[2];
         const size_t _kmin;
         const size_t _k0max;
         const size_t _k1max;
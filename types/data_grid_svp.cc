@@ -0,0 +1,197 @@
+/**
+ * @file data_grid_svp.cc
+ * Wrapper for a data_grid in 3d that uses the fast non-recursive
+ * interpolation algorithm.
+ */
+#include <usml/types/data_grid_svp.h>
+
+#if ( defined(__GNUC__) || defined(__clang__) ) \
+    && ( defined(__x86_64__) || defined(__i386__) )
+    #define USML_DATA_GRID_SVP_X86
+    #include <immintrin.h>
+#endif
+
+using namespace usml::types ;
+
+#ifdef USML_DATA_GRID_SVP_X86
+
+namespace {
+
+/**
+ * Sum the elements of four vectors.
+ *
+ * @return  Vector of [sum(a),sum(b),sum(c),sum(d)].
+ */
+__attribute__((target("avx2")))
+inline __m256d hsum4( __m256d a, __m256d b, __m256d c, __m256d d ) {
+    const __m256d ab = _mm256_hadd_pd( a, b ) ;
+    const __m256d cd = _mm256_hadd_pd( c, d ) ;
+    return _mm256_add_pd(
+        _mm256_permute2f128_pd( ab, cd, 0x20 ),
+        _mm256_permute2f128_pd( ab, cd, 0x31 ) ) ;
+}
+
+/**
+ * AVX2 version of the PCHIP/bi-linear interpolation for a single cell.
+ * Each lane of a vector holds one of the four corners of the cell in the
+ * (theta,phi) plane. The (value,derivative) pairs for the two depths
+ * on either side of the location are adjacent in the coefficient table,
+ * so each corner is a single 256 bit load.  The depth interpolation at
+ * each corner is then a dot product with the Hermite basis functions,
+ * and the final result, and all three derivatives, are dot products of
+ * the interpolated plane with the bi-linear weights.
+ *
+ * @param   coef        Coefficients for the first corner of the cell.
+ * @param   stride1     Distance to the next corner along theta.
+ * @param   stride2     Distance to the next corner along phi.
+ * @param   t           Fractional position in the depth interval.
+ * @param   inc         Size of the depth interval.
+ * @param   x           Location along theta.
+ * @param   x1          Start of the theta interval.
+ * @param   x2          End of the theta interval.
+ * @param   y           Location along phi.
+ * @param   y1          Start of the phi interval.
+ * @param   y2          End of the phi interval.
+ * @param   derivative  Derivative in each dimension (output).
+ *                      Not computed if NULL.
+ * @return              Interpolated value.
+ */
+__attribute__((target("avx2")))
+double evaluate_avx2( const double* coef, size_t stride1, size_t stride2,
+        double t, double inc, double x, double x1, double x2,
+        double y, double y1, double y2, double* derivative )
+{
+    const double t_2 = t * t ;
+    const double t_3 = t_2 * t ;
+    const __m256d hermite = _mm256_setr_pd(
+        2 * t_3 - 3 * t_2 + 1, t_3 - 2 * t_2 + t,
+        3 * t_2 - 2 * t_3, t_3 - t_2 ) ;
+
+    const __m256d c00 = _mm256_loadu_pd( coef ) ;
+    const __m256d c10 = _mm256_loadu_pd( coef + stride1 ) ;
+    const __m256d c01 = _mm256_loadu_pd( coef + stride2 ) ;
+    const __m256d c11 = _mm256_loadu_pd( coef + stride1 + stride2 ) ;
+    const __m256d plane = hsum4(
+        _mm256_mul_pd( c00, hermite ), _mm256_mul_pd( c10, hermite ),
+        _mm256_mul_pd( c01, hermite ), _mm256_mul_pd( c11, hermite ) ) ;
+
+    const double area = ( x2 - x1 ) * ( y2 - y1 ) ;
+    const __m256d weight = _mm256_div_pd( _mm256_setr_pd(
+        ( x2 - x ) * ( y2 - y ), ( x - x1 ) * ( y2 - y ),
+        ( x2 - x ) * ( y - y1 ), ( x - x1 ) * ( y - y1 ) ),
+        _mm256_set1_pd( area ) ) ;
+    const __m256d value = _mm256_mul_pd( plane, weight ) ;
+
+    double sums[4] ;
+    if ( derivative ) {
+        const __m256d dhermite = _mm256_div_pd( _mm256_setr_pd(
+            6 * t_2 - 6 * t, 3 * t_2 - 4 * t + 1,
+            6 * t - 6 * t_2, 3 * t_2 - 2 * t ),
+            _mm256_set1_pd( inc ) ) ;
+        const __m256d dplane = hsum4(
+            _mm256_mul_pd( c00, dhermite ), _mm256_mul_pd( c10, dhermite ),
+            _mm256_mul_pd( c01, dhermite ), _mm256_mul_pd( c11, dhermite ) ) ;
+        const __m256d dx = _mm256_div_pd( _mm256_setr_pd(
+            -( y2 - y ), y2 - y, -( y - y1 ), y - y1 ),
+            _mm256_set1_pd( area ) ) ;
+        const __m256d dy = _mm256_div_pd( _mm256_setr_pd(
+            -( x2 - x ), -( x - x1 ), x2 - x, x - x1 ),
+            _mm256_set1_pd( area ) ) ;
+        _mm256_storeu_pd( sums, hsum4( value,
+            _mm256_mul_pd( dplane, weight ),
+            _mm256_mul_pd( plane, dx ),
+            _mm256_mul_pd( plane, dy ) ) ) ;
+        derivative[0] = sums[1] ;
+        derivative[1] = sums[2] ;
+        derivative[2] = sums[3] ;
+    } else {
+        _mm256_storeu_pd( sums, hsum4( value, value, value, value ) ) ;
+    }
+    return sums[0] ;
+}
+
+}  // end of anonymous namespace
+
+#endif
+
+/**
+ * Batch interpolation of sound speed at every point of a wavefront.
+ */
+void data_grid_svp::interpolate(const wposition& location,
+        matrix<double>* result, wvector* gradient,
+        std::vector<size_t>* hints) const
+{
+    const size_t size = location.size1() * location.size2() ;
+    const double* rho = location.rho().data().begin() ;
+    const double* theta = location.theta().data().begin() ;
+    const double* phi = location.phi().data().begin() ;
+    double* value = result->data().begin() ;
+    double* drho = NULL ;
+    double* dtheta = NULL ;
+    double* dphi = NULL ;
+    if ( gradient ) {
+        drho = gradient->rho_data() ;
+        dtheta = gradient->theta_data() ;
+        dphi = gradient->phi_data() ;
+    }
+
+    // start from the first interval if hints don't match this wavefront
+
+    if ( hints->size() != 3 * size ) {
+        hints->assign( 3 * size, 0 ) ;
+    }
+    size_t* hint = size ? &(*hints)[0] : NULL ;
+
+    double loc[3] ;
+    double derivative[3] ;
+    data_grid_cursor<3> cursor ;
+    const size_t* offset = cursor.offset ;
+    for ( size_t n=0 ; n < size ; ++n, hint += 3 ) {
+        loc[0] = rho[n] ;
+        loc[1] = theta[n] ;
+        loc[2] = phi[n] ;
+        std::copy( hint, hint+3, cursor.offset ) ;
+        find_offsets( loc, cursor ) ;
+        std::copy( offset, offset+3, hint ) ;
+        double* deriv = gradient ? derivative : NULL ;
+
+        #ifdef USML_DATA_GRID_SVP_X86
+            if ( _simd ) {
+                const seq_vector& z = *_axis[0] ;
+                const seq_vector& x = *_axis[1] ;
+                const seq_vector& y = *_axis[2] ;
+                const double inc = z.increment( offset[0] ) ;
+                const size_t stride1 = 2 * ( _kzmax + 1 ) ;
+                value[n] = evaluate_avx2(
+                    &_coef[coef_index( offset[0], offset[1], offset[2] )],
+                    stride1, stride1 * ( _kxmax + 1 ),
+                    ( loc[0] - z[offset[0]] ) / inc, inc,
+                    loc[1], x[offset[1]], x[offset[1]+1],
+                    loc[2], y[offset[2]], y[offset[2]+1], deriv ) ;
+            } else {
+                value[n] = evaluate( loc, deriv, offset ) ;
+            }
+        #else
+            value[n] = evaluate( loc, deriv, offset ) ;
+        #endif
+
+        if ( gradient ) {
+            drho[n] = derivative[0] ;
+            dtheta[n] = derivative[1] ;
+            dphi[n] = derivative[2] ;
+        }
+    }
+}
+
+/**
+ * True if the processor supports the AVX2 form of batch interpolation.
+ */
+bool data_grid_svp::simd_supported() {
+    #ifdef USML_DATA_GRID_SVP_X86
+        __builtin_cpu_init() ;
+        static const bool avx2 = __builtin_cpu_supports( "avx2" ) ;
+        return avx2 ;
+    #else
+        return false ;
+    #endif
+}
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <usml/types/data_grid.h>
+#include <usml/types/wposition.h>
+#include <vector>
 
 namespace usml {
 namespace types {
@@ -28,6 +30,13 @@ namespace types {
  * Since the data is passed in and referenced by this wrapper,
  * the data is taken control of and destroyed at the end of its
  * use cycle.
+ *
+ * The data values and their PCHIP depth derivatives are also copied into
+ * a single interleaved table, so that the four numbers needed to
+ * interpolate one corner of a cell along the depth axis are adjacent
+ * in memory.  The batch form of interpolate() uses this table to evaluate
+ * all four corners of a cell with AVX2 instructions, on processors that
+ * support them.
  */
 
 class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
@@ -44,7 +53,9 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
             :   data_grid<double, 3>(*grid, true),
                 _kzmax(_axis[0]->size() - 1u),
                 _kxmax(_axis[1]->size() - 1u),
-                _kymax(_axis[2]->size() - 1u)
+                _kymax(_axis[2]->size() - 1u),
+                _coef(2 * _axis[0]->size() * _axis[1]->size() * _axis[2]->size()),
+                _simd(simd_supported())
         {
             double result = 0.0;
 
@@ -57,13 +68,6 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
 			interp_type(0, GRID_INTERP_PCHIP);
 			interp_type(1, GRID_INTERP_LINEAR);
 			interp_type(2, GRID_INTERP_LINEAR);
-            derv_z = new double**[_kzmax + 1u];
-            for (int i = 0; i < _kzmax + 1u; ++i) {
-                derv_z[i] = new double*[_kxmax + 1u];
-                for (int j = 0; j < _kxmax + 1u; ++j) {
-                    derv_z[i][j] = new double[_kymax + 1u];
-                }
-            }
             for (int i = 0; i < _kzmax + 1u; ++i) {
                 for (int j = 0; j < _kxmax + 1u; ++j) {
                     for (int k = 0; k < _kymax + 1u; ++k) {
@@ -113,7 +117,8 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
                                         / ((w1 / slope_1) + (w2 / slope_2));
                             }
                         }
-                        derv_z[i][j][k] = result ;
+                        _coef[coef_index(i, j, k)] = data_3d(i, j, k) ;
+                        _coef[coef_index(i, j, k) + 1] = result ;
                     } //end for-loop in k
                 } //end for-loop in j
             } //end for-loop in i
@@ -124,13 +129,6 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
          * Destructor
          */
         virtual ~data_grid_svp() {
-            for(size_t i=0; i<=_kzmax; ++i) {
-                for(size_t j=0; j<=_kxmax; ++j) {
-                    delete[] derv_z[i][j] ;
-                }
-                delete[] derv_z[i] ;
-            }
-            delete[] derv_z ;
         }
 
         /**
@@ -146,6 +144,146 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
          */
 
         double interpolate(double* location, double* derivative = NULL)
+        {
+            return interpolate(location, derivative, _cursor);
+        }
+
+        /**
+         * Reentrant form of the non-recursive interpolation at a single
+         * location. All scratch state is kept on the stack or in the
+         * caller-owned cursor, so a single data_grid_svp can be shared
+         * by multiple threads without locking.
+         *
+         * @param location   Location to do the interpolation at
+         * @param derivative Calculates first derivative if not NULL
+         * @param cursor     Interval indices for this calculation.
+         *                  Search hints on input (input/output).
+         */
+        double interpolate(double* location, double* derivative,
+                data_grid_cursor<3>& cursor) const
+        {
+            // find the interval index in each dimension
+
+            find_offsets(location, cursor);
+            return evaluate(location, derivative, cursor.offset);
+        } // end interpolate at a single location.
+
+        /**
+         * Interpolation 3-D specialization where the arguments, and results,
+         * are matrix<double>.  This is used frequently in the WaveQ3D model
+         * to interpolate environmental parameters. Safe to call from
+         * multiple threads at the same time.
+         *
+         * @param   x           First dimension of location.
+         * @param   y           Second dimension of location.
+         * @param   z           Third dimension of location.
+         * @param   result      Interpolated values at each location (output).
+         * @param   dx          First dimension of derivative (output).
+         * @param   dy          Second dimension of derivative (output).
+         * @param   dz          Third dimension of derivative (output).
+         */
+        void interpolate(const matrix<double>& x, const matrix<double>& y,
+                const matrix<double>& z, matrix<double>* result,
+                matrix<double>* dx = NULL, matrix<double>* dy = NULL,
+                matrix<double>* dz = NULL) const
+        {
+            double location[3];
+            double derivative[3];
+            data_grid_cursor<3> cursor;
+            for (size_t n = 0; n < x.size1(); ++n) {
+                for (size_t m = 0; m < x.size2(); ++m) {
+                    location[0] = x(n, m);
+                    location[1] = y(n, m);
+                    location[2] = z(n, m);
+                    if (dx == NULL || dy == NULL || dz == NULL) {
+                        (*result)(n, m) = (double) interpolate(location,
+                                NULL, cursor);
+                    } else {
+                        (*result)(n, m) = (double) interpolate(location,
+                                derivative, cursor);
+                        (*dx)(n, m) = (double) derivative[0];
+                        (*dy)(n, m) = (double) derivative[1];
+                        (*dz)(n, m) = (double) derivative[2];
+                    }
+                }
+            }
+
+        } // end interpolate
+
+        /**
+         * Batch interpolation of sound speed, and its gradient, at every
+         * point of a wavefront.  Rays in a wavefront move a small distance
+         * on each time step, so the interval index of each point along each
+         * axis is usually the same as, or next to, its index on the last
+         * call.  The caller-owned hints store these indices between calls,
+         * so that each search starts from the last answer.  With simd()
+         * turned off, it produces the same results as the matrix form of
+         * interpolate().  Safe to call
+         * from multiple threads at the same time, as long as each thread
+         * uses its own hints.
+         *
+         * @param   location    Locations at which to interpolate, with
+         *                      axes in (rho, theta, phi) order.
+         * @param   result      Interpolated values at each location (output).
+         * @param   gradient    Derivative of the field at each location
+         *                      (output). Not computed if NULL.
+         * @param   hints       Interval index of each location along each
+         *                      axis (input/output).  Resized, and reset
+         *                      to the first interval, if it does not have
+         *                      three entries for each location.
+         */
+        void interpolate(const wposition& location, matrix<double>* result,
+                wvector* gradient, std::vector<size_t>* hints) const ;
+
+        /**
+         * True if the processor supports the AVX2 form of batch
+         * interpolation.
+         */
+        static bool simd_supported() ;
+
+        /**
+         * Enables the AVX2 form of batch interpolation.  Defaults to
+         * simd_supported().  Requests to enable it on processors that do
+         * not support it are ignored.  Because the vector form adds up
+         * the terms of each polynomial in a different order, its results
+         * may differ from the scalar form in the last few bits.
+         *
+         * @param   enable      Use AVX2 instructions if true.
+         */
+        void simd(bool enable) {
+            _simd = enable && simd_supported() ;
+        }
+
+        /**
+         * True if batch interpolation uses AVX2 instructions.
+         */
+        bool simd() const {
+            return _simd ;
+        }
+
+    private:
+
+        /** Utility accessor function for data grid values */
+        inline double data_3d(size_t dim0, size_t dim1, size_t dim2) const
+        {
+            size_t grid_index[3];
+            grid_index[0] = dim0;
+            grid_index[1] = dim1;
+            grid_index[2] = dim2;
+            return data(grid_index);
+
+        } // end data_3d
+
+        /**
+         * Non-recursive interpolation at a single location, once the
+         * interval index along each axis is known.
+         *
+         * @param location   Location to do the interpolation at
+         * @param derivative Calculates first derivative if not NULL
+         * @param offset     Interval index along each axis.
+         */
+        double evaluate(const double* location, double* derivative,
+                const size_t* offset) const
         {
             double result = 0.0;
             size_t k0, k1, k2;           //indices of he offset data
@@ -153,6 +291,8 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
             //bi-linear variables
             double f11, f21, f12, f22, x_diff, y_diff;
             double x, x1, x2, y, y1, y2;
+            c_matrix<double, 2, 2> interp_plane;
+            c_matrix<double, 2, 2> dz;
 
             //pchip variables
             double v1, v2;
@@ -160,61 +300,22 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
             double t, t_2, t_3;
             double h00, h10, h01, h11;
 
-            // find the interval index in each dimension
-
-            for (size_t dim = 0; dim < 3; ++dim) {
-
-                // limit interpolation to axis domain if _edge_limit turned on
-
-                if (edge_limit(dim)) {
-                    double a = *(_axis[dim]->begin());
-                    double b = *(_axis[dim]->rbegin());
-                    double inc = _axis[dim]->increment(0);
-                    if (inc < 0) {                                // a > b
-                        if (location[dim] >= a) {                 //left of the axis
-                            location[dim] = a;
-                            _offset[dim] = 0;
-                        } else if (location[dim] <= b) {         //right of the axis
-                            location[dim] = b;
-                            _offset[dim] = _axis[dim]->size() - 2;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]); //somewhere in-between the endpoints of the axis
-                        }
-                    }
-                    if (inc > 0) {                                // a < b
-                        if (location[dim] <= a) {                 //left of the axis
-                            location[dim] = a;
-                            _offset[dim] = 0;
-                        } else if (location[dim] >= b) {         //right of the axis
-                            location[dim] = b;
-                            _offset[dim] = _axis[dim]->size() - 2;
-                        } else {
-                            _offset[dim] = _axis[dim]->find_index(location[dim]); //somewhere in-between the endpoints of the axis
-                        }
-                    }
-
-                    // allow extrapolation if _edge_limit turned off
-
-                } else {
-                    _offset[dim] = _axis[dim]->find_index(location[dim]);
-                }
-            }
-
             //** PCHIP contribution in zeroth dimension */
             if (derivative) {
                 derivative[0] = 0;
             }
-            k0 = _offset[0];
-            k1 = _offset[1];
-            k2 = _offset[2];
+            k0 = offset[0];
+            k1 = offset[1];
+            k2 = offset[2];
 
             // construct the interpolated plane to which the final bi-linear
             // interpolation will happen
             for (int i = 0; i < 2; ++i) {
                 for (int j = 0; j < 2; ++j) {
                     //extract data and take precautions when at boundaries of the axis
-                    v1 = data_3d(k0, k1 + i, k2 + j);
-                    v2 = data_3d(k0 + 1, k1 + i, k2 + j);
+                    const double* coef = &_coef[coef_index(k0, k1 + i, k2 + j)];
+                    v1 = coef[0];
+                    v2 = coef[2];
                     inc1 = _axis[0]->increment(k0);
 
                     t = (location[0] - (*_axis[0])(k0)) / inc1;
@@ -227,14 +328,14 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
                     h01 = (3 * t_2 - 2 * t_3);
                     h11 = (t_3 - t_2);
 
-                    _interp_plane(i, j) = h00 * v1 + h10 * derv_z[k0][k1 + i][k2 + j]
-                            + h01 * v2 + h11 * derv_z[k0 + 1][k1 + i][k2 + j];
+                    interp_plane(i, j) = h00 * v1 + h10 * coef[1]
+                            + h01 * v2 + h11 * coef[3];
 
                     if (derivative) {
-                        _dz(i, j) = (6 * t_2 - 6 * t) * v1 / inc1
-                                + (3 * t_2 - 4 * t + 1) * derv_z[k0][k1 + i][k2 + j] / inc1
+                        dz(i, j) = (6 * t_2 - 6 * t) * v1 / inc1
+                                + (3 * t_2 - 4 * t + 1) * coef[1] / inc1
                                 + (6 * t - 6 * t_2) * v2 / inc1
-                                + (3 * t_2 - 2 * t) * derv_z[k0 + 1][k1 + i][k2 + j] / inc1 ;
+                                + (3 * t_2 - 2 * t) * coef[3] / inc1 ;
                     }
                 }
             }
@@ -247,10 +348,10 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
             y = location[2];
             y1 = (*_axis[2])(k2);
             y2 = (*_axis[2])(k2 + 1);
-            f11 = _interp_plane(0, 0);
-            f21 = _interp_plane(1, 0);
-            f12 = _interp_plane(0, 1);
-            f22 = _interp_plane(1, 1);
+            f11 = interp_plane(0, 0);
+            f21 = interp_plane(1, 0);
+            f12 = interp_plane(0, 1);
+            f22 = interp_plane(1, 1);
             x_diff = x2 - x1;
             y_diff = y2 - y1;
 
@@ -259,10 +360,10 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
                     / (x_diff * y_diff);
 
             if (derivative) {
-                derivative[0] = (_dz(0, 0) * (x2 - x) * (y2 - y)
-                        + _dz(1, 0) * (x - x1) * (y2 - y)
-                        + _dz(0, 1) * (x2 - x) * (y - y1)
-                        + _dz(1, 1) * (x - x1) * (y - y1)) / (x_diff * y_diff);
+                derivative[0] = (dz(0, 0) * (x2 - x) * (y2 - y)
+                        + dz(1, 0) * (x - x1) * (y2 - y)
+                        + dz(0, 1) * (x2 - x) * (y - y1)
+                        + dz(1, 1) * (x - x1) * (y - y1)) / (x_diff * y_diff);
                 derivative[1] = (-f11 * (y2 - y) + f21 * (y2 - y) - f12 * (y - y1)
                         + f22 * (y - y1)) / (x_diff * y_diff);
                 derivative[2] = (-f11 * (x2 - x) - f21 * (x - x1) + f12 * (x2 - x)
@@ -271,72 +372,28 @@ class USML_DECLSPEC data_grid_svp: public data_grid<double, 3> {
 
             return result;
 
-        } // end interpolate at a single location.
+        } // end evaluate
 
         /**
-         * Interpolation 3-D specialization where the arguments, and results,
-         * are matrix<double>.  This is used frequently in the WaveQ3D model
-         * to interpolate environmental parameters.
-         *
-         * @param   x           First dimension of location.
-         * @param   y           Second dimension of location.
-         * @param   z           Third dimension of location.
-         * @param   result      Interpolated values at each location (output).
-         * @param   dx          First dimension of derivative (output).
-         * @param   dy          Second dimension of derivative (output).
-         * @param   dz          Third dimension of derivative (output).
+         * Index of the first coefficient for a grid node in _coef.
+         * Nodes are stored with depth varying fastest.
          */
-        void interpolate(const matrix<double>& x, const matrix<double>& y,
-                const matrix<double>& z, matrix<double>* result,
-                matrix<double>* dx = NULL, matrix<double>* dy = NULL,
-                matrix<double>* dz = NULL)
+        inline size_t coef_index(size_t dim0, size_t dim1, size_t dim2) const
         {
-            double location[3];
-            double derivative[3];
-            for (size_t n = 0; n < x.size1(); ++n) {
-                for (size_t m = 0; m < x.size2(); ++m) {
-                    location[0] = x(n, m);
-                    location[1] = y(n, m);
-                    location[2] = z(n, m);
-                    if (dx == NULL || dy == NULL || dz == NULL) {
-                        (*result)(n, m) = (double) interpolate(location);
-                    } else {
-                        (*result)(n, m) = (double) interpolate(location,
-                                derivative);
-                        (*dx)(n, m) = (double) derivative[0];
-                        (*dy)(n, m) = (double) derivative[1];
-                        (*dz)(n, m) = (double) derivative[2];
-                    }
-                }
-            }
-
-        } // end interpolate
-
-    private:
-
-        /** Utility accessor function for data grid values */
-        inline double data_3d(size_t dim0, size_t dim1, size_t dim2)
-        {
-            size_t grid_index[3];
-            grid_index[0] = dim0;
-            grid_index[1] = dim1;
-            grid_index[2] = dim2;
-            return data(grid_index);
+            return 2 * (dim0 + (_kzmax + 1) * (dim1 + (_kxmax + 1) * dim2));
+        }
 
-        } // end data_3d
+        /** Largest index on each axis. */
+        size_t _kzmax, _kxmax, _kymax;  //max index on z-axis (depth)
 
         /**
-         * Create all variables needed for each calculation once
-         * to same time and memory.
+         * Data value and PCHIP depth derivative at each grid node,
+         * interleaved as (value,derivative) pairs.
          */
-        size_t _kzmax, _kxmax, _kymax;  //max index on z-axis (depth)
-
-        //bi-linear variable
-        c_matrix<double, 2, 2> _interp_plane;
+        std::vector<double> _coef;
 
-        //pchip variables
-        c_matrix<double, 2, 2> _dz;
-        double*** derv_z;
+        /** Use AVX2 instructions for batch interpolation. */
+        bool _simd;
 
 }; // end data_grid_svp class
 
@@ -90,6 +90,9 @@ class USML_DECLSPEC seq_data : public seq_vector
         /** Virtual destructor. */
         virtual ~seq_data() {}
 
+        /** Hinted search from the base class. */
+        using seq_vector::find_index ;
+
         //**************************************************
         // virtual functions
 
@@ -86,6 +86,9 @@ class USML_DECLSPEC seq_linear : public seq_vector
             return new seq_linear( *this ) ;
         }
 
+        /** Hinted search from the base class. */
+        using seq_vector::find_index ;
+
         /**
          * Search for a value in this sequence. If the value is outside of the
          * legal range, the index for the nearest endpoint will
@@ -96,6 +99,18 @@ class USML_DECLSPEC seq_linear : public seq_vector
          *                      than the argument.
          */
         virtual size_type find_index( value_type value ) {
+            return search( value ) ;
+        }
+
+        /**
+         * Thread-safe search for a value in this sequence.  The index is
+         * computed directly from the first element and the increment.
+         *
+         * @param   value       Value of the element to find.
+         * @return              Index of the largest value that is not greater
+         *                      than the argument.
+         */
+        virtual size_type search( value_type value ) const {
             return (size_type) max(
                 (difference_type) 0, min( (difference_type) this->size()-2,
                 (difference_type) floor( (value - _data[0]) / _increment[0]) ));
@@ -82,6 +82,9 @@ public:
     /** Virtual destructor. */
     virtual ~seq_log() {}
 
+    /** Hinted search from the base class. */
+    using seq_vector::find_index ;
+
     //***************************************************************
     // vritual functions
 
@@ -62,6 +62,73 @@ class USML_DECLSPEC seq_vector: public vector_container<seq_vector>
          */
         virtual size_type find_index( value_type value ) = 0 ;
 
+        /**
+         * Thread-safe version of find_index().  Does not use, or update,
+         * any search state cached inside the sequence, so it can be used
+         * by many threads at once on a shared axis. The default
+         * implementation is a bisection search over the axis values.
+         * Sub-classes override it when a faster, closed-form search exists.
+         *
+         * @param   value       Value of the element to find.
+         * @return              Index of the largest value that is not greater
+         *                      than the argument, limited to [0,size-2].
+         */
+        virtual size_type search( value_type value ) const {
+            if ( _max_index == 0 ) {
+                return 0 ;
+            }
+            const value_type sign = ( _increment[0] < 0.0 ) ? -1.0 : 1.0 ;
+            value *= sign ;
+            size_type lower = 0 ;
+            size_type upper = _max_index ;
+            while ( upper - lower > 1 ) {
+                const size_type middle = ( lower + upper ) / 2 ;
+                if ( _data[middle] * sign <= value ) {
+                    lower = middle ;
+                } else {
+                    upper = middle ;
+                }
+            }
+            return lower ;
+        }
+
+        /**
+         * Thread-safe search that starts from the interval found by an
+         * earlier search.  Consecutive lookups along a ray almost always
+         * land in the same, or a neighboring, interval, so a short walk
+         * from the hint avoids both the virtual call and the full search.
+         * Falls back to search() if the value is more than a few
+         * intervals away from the hint.  The same walk serves all of the
+         * sub-classes, because it only compares against the axis values.
+         *
+         * @param   value       Value of the element to find.
+         * @param   hint        Index returned by a previous search.
+         *                      Need not be in the range of this axis.
+         * @return              Index of the largest value that is not greater
+         *                      than the argument, limited to [0,size-2].
+         */
+        size_type find_index( value_type value, size_type hint ) const {
+            if ( _max_index == 0 ) {
+                return 0 ;
+            }
+            const value_type sign = ( _increment[0] < 0.0 ) ? -1.0 : 1.0 ;
+            const value_type target = value * sign ;
+            size_type n = std::min( hint, _max_index - 1 ) ;
+            for ( int step = 0 ; step < 4 ; ++step ) {
+                if ( _data[n] * sign > target ) {
+                    if ( n == 0 ) {
+                        return 0 ;
+                    }
+                    --n ;
+                } else if ( n + 1 < _max_index && _data[n+1] * sign <= target ) {
+                    ++n ;
+                } else {
+                    return n ;
+                }
+            }
+            return search( value ) ;
+        }
+
         /**
          * Retrieves the value at a specified index in the sequence in the fastest
          * way possible. Problems will occur if the index is outside of the
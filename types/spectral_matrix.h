@@ -0,0 +1,166 @@
+/**
+ * @file spectral_matrix.h
+ * Matrix of frequency dependent values stored in one contiguous buffer.
+ */
+#pragma once
+
+#include <usml/ublas/ublas.h>
+#include <boost/numeric/ublas/vector_proxy.hpp>
+
+namespace usml {
+namespace types {
+
+using namespace usml::ublas;
+
+using boost::numeric::ublas::vector;
+
+/// @ingroup wposition
+/// @{
+
+/**
+ * Matrix of frequency dependent values stored in one contiguous buffer.
+ * Replaces matrix< vector<double> > for wavefront properties, like
+ * attenuation and phase, that have a spectrum at each D/E and AZ index.
+ * All of the spectra are packed into a single ray-major array,
+ * so that element (n1,n2,f) is stored at index (n1*size2+n2)*size3+f.
+ *
+ * The spectrum at each (n1,n2) is returned as a uBLAS vector_range,
+ * so existing code can use expressions like attenuation(de,az)(f)
+ * or attenuation(de,az)*dt without change.  Operations over the
+ * whole matrix, like clear() and operator+=(), become a single
+ * streaming loop over contiguous memory instead of one heap
+ * allocation per ray.
+ */
+class USML_DECLSPEC spectral_matrix
+{
+
+public:
+
+    typedef vector<double> array_type ;
+    typedef vector_range<array_type> reference ;
+    typedef const vector_range<const array_type> const_reference ;
+
+    /**
+     * Allocates storage for all spectra.  Values are not initialized.
+     *
+     * @param  size1    Number of rows (D/E angles in a ray fan).
+     * @param  size2    Number of columns (AZ angles in a ray fan).
+     * @param  size3    Number of values in each spectrum (frequencies).
+     */
+    spectral_matrix( size_t size1 = 0, size_t size2 = 0, size_t size3 = 0 ) :
+        _size1( size1 ), _size2( size2 ), _size3( size3 ),
+        _data( size1 * size2 * size3 )
+    {
+    }
+
+    /**
+     * Changes the dimensions of this matrix.  Existing values are
+     * not preserved.
+     *
+     * @param  size1    Number of rows (D/E angles in a ray fan).
+     * @param  size2    Number of columns (AZ angles in a ray fan).
+     * @param  size3    Number of values in each spectrum (frequencies).
+     */
+    void resize( size_t size1, size_t size2, size_t size3 ) {
+        _size1 = size1 ;
+        _size2 = size2 ;
+        _size3 = size3 ;
+        _data.resize( size1 * size2 * size3, false ) ;
+    }
+
+    /** Number of rows. */
+    inline size_t size1() const {
+        return _size1 ;
+    }
+
+    /** Number of columns. */
+    inline size_t size2() const {
+        return _size2 ;
+    }
+
+    /** Number of values in each spectrum. */
+    inline size_t size3() const {
+        return _size3 ;
+    }
+
+    /**
+     * Writable view of the spectrum at a single row and column.
+     *
+     * @param  n1       Row number (zero indexed).
+     * @param  n2       Column number (zero indexed).
+     * @return          Vector view into the contiguous buffer.
+     */
+    inline reference operator()( size_t n1, size_t n2 ) {
+        const size_t first = ( n1 * _size2 + n2 ) * _size3 ;
+        return reference( _data, boost::numeric::ublas::range( first, first + _size3 ) ) ;
+    }
+
+    /**
+     * Read-only view of the spectrum at a single row and column.
+     *
+     * @param  n1       Row number (zero indexed).
+     * @param  n2       Column number (zero indexed).
+     * @return          Vector view into the contiguous buffer.
+     */
+    inline const_reference operator()( size_t n1, size_t n2 ) const {
+        const size_t first = ( n1 * _size2 + n2 ) * _size3 ;
+        return const_reference( _data, boost::numeric::ublas::range( first, first + _size3 ) ) ;
+    }
+
+    /**
+     * Contiguous storage for all spectra in ray-major order.
+     */
+    inline array_type& data() {
+        return _data ;
+    }
+
+    /**
+     * Contiguous storage for all spectra in ray-major order.
+     */
+    inline const array_type& data() const {
+        return _data ;
+    }
+
+    /**
+     * Sets all values to zero.
+     */
+    inline void clear() {
+        _data.clear() ;
+    }
+
+    /**
+     * Adds the values from another matrix of the same dimensions.
+     * Implemented as a single loop over the contiguous buffers.
+     *
+     * @param  other    Matrix to add to this one.
+     * @return          Reference to this matrix.
+     */
+    spectral_matrix& operator+=( const spectral_matrix& other ) {
+        const size_t N = _data.size() ;
+        double* out = _data.data().begin() ;
+        const double* in = other._data.data().begin() ;
+        for ( size_t n=0 ; n < N ; ++n ) {
+            out[n] += in[n] ;
+        }
+        return *this ;
+    }
+
+private:
+
+    /** Number of rows. */
+    size_t _size1 ;
+
+    /** Number of columns. */
+    size_t _size2 ;
+
+    /** Number of values in each spectrum. */
+    size_t _size3 ;
+
+    /** Contiguous storage for all spectra in ray-major order. */
+    array_type _data ;
+
+};
+
+/// @}
+} // end of namespace types
+} // end of namespace usml
@@ -2,6 +2,7 @@
  * @example types/test/datagrid_test.cc
  */
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
 #include <usml/types/types.h>
 #include <iostream>
 #include <sstream>
@@ -550,4 +551,225 @@ BOOST_AUTO_TEST_CASE(grid_2d_test) {
         delete[] location;
 }
 
+/**
+ * @ingroup types_test
+ * Worker used by reentrant_interp_test to interpolate a shared
+ * data_grid_svp and data_grid_bathy from its own thread, using its
+ * own data_grid_cursor.  Results are stored for later comparison
+ * because Boost.Test assertions are not thread-safe.
+ */
+class reentrant_interp_worker {
+public:
+    reentrant_interp_worker( const data_grid_svp* svp,
+        const data_grid_bathy* bathy, const matrix<double>* points,
+        vector<double>* svp_value, vector<double>* bathy_value )
+        : _svp(svp), _bathy(bathy), _points(points),
+          _svp_value(svp_value), _bathy_value(bathy_value)
+    {}
+
+    void operator()() {
+        data_grid_cursor<3> svp_cursor ;
+        data_grid_cursor<2> bathy_cursor ;
+        double location[3] ;
+        double derivative[3] ;
+        for ( size_t repeat = 0 ; repeat < 10 ; ++repeat ) {
+            for ( size_t n = 0 ; n < _points->size1() ; ++n ) {
+                location[0] = (*_points)(n,0) ;
+                location[1] = (*_points)(n,1) ;
+                location[2] = (*_points)(n,2) ;
+                (*_svp_value)(n) = _svp->interpolate(
+                        location, derivative, svp_cursor ) ;
+                location[0] = (*_points)(n,1) ;
+                location[1] = (*_points)(n,2) ;
+                (*_bathy_value)(n) = _bathy->interpolate(
+                        location, derivative, bathy_cursor ) ;
+            }
+        }
+    }
+
+private:
+    const data_grid_svp* _svp ;
+    const data_grid_bathy* _bathy ;
+    const matrix<double>* _points ;
+    vector<double>* _svp_value ;
+    vector<double>* _bathy_value ;
+};
+
+/**
+ * @ingroup types_test
+ * Interpolate a shared data_grid_svp and data_grid_bathy from several
+ * threads at once, using the const, cursor based interpolation methods.
+ * Uses an unevenly spaced depth axis so that the seq_data search
+ * is exercised. Generate errors if any thread produces results that
+ * differ from a serial calculation using the non-reentrant methods.
+ */
+BOOST_AUTO_TEST_CASE( reentrant_interp_test ) {
+    cout << "=== datagrid_test: reentrant_interp_test ===" << endl;
+
+    // build 3-D grid with an uneven depth axis
+
+    const double depth[] = { 0.0, 10.0, 25.0, 50.0, 100.0, 200.0, 500.0 } ;
+    const seq_vector* axis[3] ;
+    axis[0] = new seq_data( depth, 7 ) ;
+    axis[1] = new seq_linear( 0.0, 0.1, 6 ) ;
+    axis[2] = new seq_linear( 0.0, 0.1, 6 ) ;
+    data_grid<double,3>* grid3 = new data_grid<double,3>(axis) ;
+    data_grid<double,2>* grid2 = new data_grid<double,2>(axis+1) ;
+    size_t index[3] ;
+    for ( index[0]=0 ; index[0] < axis[0]->size() ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < axis[1]->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < axis[2]->size() ; ++index[2] ) {
+                const double z = (*axis[0])[index[0]] ;
+                const double x = (*axis[1])[index[1]] ;
+                const double y = (*axis[2])[index[2]] ;
+                grid3->data( index, 1500.0 + 0.1 * z + cubic2d(x,y) ) ;
+                if ( index[0] == 0 ) {
+                    grid2->data( index+1, cubic2d(x,y) ) ;
+                }
+            }
+        }
+    }
+    data_grid_svp svp( grid3 ) ;
+    data_grid_bathy bathy( grid2 ) ;
+    bathy.interp_type( 0, GRID_INTERP_PCHIP ) ;
+    bathy.interp_type( 1, GRID_INTERP_PCHIP ) ;
+
+    // compute serial answers with the non-reentrant interpolation
+
+    const size_t N = 500 ;
+    matrix<double> points( N, 3 ) ;
+    vector<double> svp_truth( N ) ;
+    vector<double> bathy_truth( N ) ;
+    double location[3] ;
+    for ( size_t n = 0 ; n < N ; ++n ) {
+        points(n,0) = 500.0 * randgen::uniform() ;
+        points(n,1) = 0.5 * randgen::uniform() ;
+        points(n,2) = 0.5 * randgen::uniform() ;
+        location[0] = points(n,0) ;
+        location[1] = points(n,1) ;
+        location[2] = points(n,2) ;
+        svp_truth(n) = svp.interpolate( location ) ;
+        location[0] = points(n,1) ;
+        location[1] = points(n,2) ;
+        bathy_truth(n) = bathy.interpolate( location ) ;
+    }
+
+    // repeat the calculation on multiple threads at the same time
+
+    const size_t num_threads = 4 ;
+    std::vector< vector<double> > svp_value( num_threads, vector<double>(N) ) ;
+    std::vector< vector<double> > bathy_value( num_threads, vector<double>(N) ) ;
+    boost::thread_group threads ;
+    for ( size_t t = 0 ; t < num_threads ; ++t ) {
+        threads.create_thread( reentrant_interp_worker( &svp, &bathy,
+                &points, &svp_value[t], &bathy_value[t] ) ) ;
+    }
+    threads.join_all() ;
+
+    for ( size_t t = 0 ; t < num_threads ; ++t ) {
+        for ( size_t n = 0 ; n < N ; ++n ) {
+            BOOST_CHECK_EQUAL( svp_value[t](n), svp_truth(n) ) ;
+            BOOST_CHECK_EQUAL( bathy_value[t](n), bathy_truth(n) ) ;
+        }
+    }
+    delete axis[0] ;
+    delete axis[1] ;
+    delete axis[2] ;
+}
+
+/**
+ * @ingroup types_test
+ * Compare the batch form of data_grid_svp::interpolate() to the single
+ * point form.  Uses the same grid as reentrant_interp_test, with some
+ * points outside of the grid so that the edge limits are exercised.
+ * The batch form is called twice: once with empty hints, which forces
+ * a full search, and once after every point has moved by a small amount,
+ * so that each search starts from the hint saved by the first call.
+ * The scalar form must reproduce the single point results exactly.  The
+ * AVX2 form, if this processor supports it, must match to 1e-10 percent.
+ * The horizontal derivatives are differences between nearly equal sound
+ * speeds, so they are compared with an absolute tolerance of 1e-9 instead.
+ */
+BOOST_AUTO_TEST_CASE( batch_interp_test ) {
+    cout << "=== datagrid_test: batch_interp_test ===" << endl;
+
+    const double depth[] = { 0.0, 10.0, 25.0, 50.0, 100.0, 200.0, 500.0 } ;
+    const seq_vector* axis[3] ;
+    axis[0] = new seq_data( depth, 7 ) ;
+    axis[1] = new seq_linear( 0.0, 0.1, 6 ) ;
+    axis[2] = new seq_linear( 0.0, 0.1, 6 ) ;
+    data_grid<double,3>* grid3 = new data_grid<double,3>(axis) ;
+    size_t index[3] ;
+    for ( index[0]=0 ; index[0] < axis[0]->size() ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < axis[1]->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < axis[2]->size() ; ++index[2] ) {
+                const double z = (*axis[0])[index[0]] ;
+                const double x = (*axis[1])[index[1]] ;
+                const double y = (*axis[2])[index[2]] ;
+                grid3->data( index, 1500.0 + 0.1 * z + cubic2d(x,y)
+                        + 0.001 * z * x ) ;
+            }
+        }
+    }
+    data_grid_svp svp( grid3 ) ;
+
+    const size_t rows = 20 ;
+    const size_t cols = 25 ;
+    wposition points( rows, cols ) ;
+    for ( size_t r = 0 ; r < rows ; ++r ) {
+        for ( size_t c = 0 ; c < cols ; ++c ) {
+            points.rho( r, c, 600.0 * randgen::uniform() - 50.0 ) ;
+            points.theta( r, c, 0.6 * randgen::uniform() - 0.05 ) ;
+            points.phi( r, c, 0.6 * randgen::uniform() - 0.05 ) ;
+        }
+    }
+
+    matrix<double> speed( rows, cols ) ;
+    wvector gradient( rows, cols ) ;
+    std::vector<size_t> hints ;
+    for ( int pass = 0 ; pass < 2 ; ++pass ) {
+        for ( int vector_form = 0 ; vector_form < 2 ; ++vector_form ) {
+            svp.simd( vector_form == 1 ) ;
+            if ( vector_form && !svp.simd() ) continue ;
+            svp.interpolate( points, &speed, &gradient, &hints ) ;
+            BOOST_CHECK_EQUAL( hints.size(), 3 * rows * cols ) ;
+
+            double location[3] ;
+            double derivative[3] ;
+            for ( size_t r = 0 ; r < rows ; ++r ) {
+                for ( size_t c = 0 ; c < cols ; ++c ) {
+                    location[0] = points.rho(r,c) ;
+                    location[1] = points.theta(r,c) ;
+                    location[2] = points.phi(r,c) ;
+                    const double value = svp.interpolate( location, derivative ) ;
+                    if ( vector_form ) {
+                        BOOST_CHECK_CLOSE( speed(r,c), value, 1e-10 ) ;
+                        BOOST_CHECK_CLOSE( gradient.rho(r,c), derivative[0], 1e-10 ) ;
+                        BOOST_CHECK_SMALL( gradient.theta(r,c) - derivative[1], 1e-9 ) ;
+                        BOOST_CHECK_SMALL( gradient.phi(r,c) - derivative[2], 1e-9 ) ;
+                    } else {
+                        BOOST_CHECK_EQUAL( speed(r,c), value ) ;
+                        BOOST_CHECK_EQUAL( gradient.rho(r,c), derivative[0] ) ;
+                        BOOST_CHECK_EQUAL( gradient.theta(r,c), derivative[1] ) ;
+                        BOOST_CHECK_EQUAL( gradient.phi(r,c), derivative[2] ) ;
+                    }
+                }
+            }
+        }
+
+        // move each point a small amount before the hinted pass
+
+        for ( size_t r = 0 ; r < rows ; ++r ) {
+            for ( size_t c = 0 ; c < cols ; ++c ) {
+                points.rho( r, c, points.rho(r,c) + 20.0 * randgen::uniform() - 10.0 ) ;
+                points.theta( r, c, points.theta(r,c) + 0.02 * randgen::uniform() - 0.01 ) ;
+                points.phi( r, c, points.phi(r,c) + 0.02 * randgen::uniform() - 0.01 ) ;
+            }
+        }
+    }
+    delete axis[0] ;
+    delete axis[1] ;
+    delete axis[2] ;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -637,4 +637,48 @@ BOOST_AUTO_TEST_CASE( seq_vector_equal_test ) {
     }
 }
 
+/**
+ * Tests the hinted form of find_index() against the full search()
+ * for each kind of sequence, including a decreasing seq_data.
+ * Uses both random hints, and the result of the last search as the
+ * hint for the next one, like a ray moving through a data_grid.
+ * Test fails if the hinted search ever returns a different index.
+ */
+BOOST_AUTO_TEST_CASE( seq_hinted_find_index_test ) {
+    cout << "=== sequence_test/seq_hinted_find_index_test ===" << endl ;
+
+    double depths[] = { 0.0, 10.0, 20.0, 30.0, 50.0, 75.0, 100.0, 125.0,
+                        150.0, 200.0, 250.0, 300.0, 400.0, 500.0, 600.0 } ;
+    const size_t num_depths = sizeof(depths) / sizeof(double) ;
+    vector<double> down( num_depths ) ;
+    for ( size_t n=0 ; n < num_depths ; ++n ) {
+        down[n] = -depths[n] ;
+    }
+
+    seq_linear linear( -5.0, 0.5, 41 ) ;
+    seq_log log( 10.0, 1.1, 30 ) ;
+    seq_data data( down ) ;
+    seq_rayfan rayfan( -90.0, 90.0, 45 ) ;
+    seq_vector* axes[] = { &linear, &log, &data, &rayfan } ;
+
+    std::srand( 1 ) ;
+    for ( size_t a=0 ; a < 4 ; ++a ) {
+        const seq_vector& ax = *axes[a] ;
+        const double first = ax(0) ;
+        const double last = ax(ax.size()-1) ;
+        const double span = last - first ;
+        size_t hint = 0 ;
+        for ( size_t n=0 ; n < 1000 ; ++n ) {
+            const double value = first - 0.1 * span
+                + 1.2 * span * std::rand() / RAND_MAX ;
+            const size_t index = ax.search( value ) ;
+
+            const size_t random = std::rand() % ( ax.size() + 2 ) ;
+            BOOST_CHECK_EQUAL( ax.find_index( value, random ), index ) ;
+            hint = ax.find_index( value, hint ) ;
+            BOOST_CHECK_EQUAL( hint, index ) ;
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -44,6 +44,7 @@
 #include <usml/types/wvector1.h>
 #include <usml/types/wposition.h>
 #include <usml/types/wposition1.h>
+#include <usml/types/spectral_matrix.h>
 
 #include <usml/types/seq_linear.h>
 #include <usml/types/seq_log.h>
@@ -275,6 +275,31 @@ public:
         _phi.clear();
     }
 
+    /**
+     * Row-major storage for the radial component.  Used by computational
+     * kernels that fill all three components in a single pass.
+     */
+    inline double* rho_data()
+    {
+        return _rho.data().begin();
+    }
+
+    /**
+     * Row-major storage for the colatitude component.
+     */
+    inline double* theta_data()
+    {
+        return _theta.data().begin();
+    }
+
+    /**
+     * Row-major storage for the longitude component.
+     */
+    inline double* phi_data()
+    {
+        return _phi.data().begin();
+    }
+
     /**
      * Compute the dot product between this vector and some other 
      * spherical earth vector.  The transformation from cartesian
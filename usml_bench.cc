@@ -0,0 +1,302 @@
+/**
+ * @file usml_bench.cc
+ * Runs all of the benchmarks in USML, and writes the results as JSON.
+ *
+ * Usage: usml_bench [--filter text] [--min_time sec] [--max_iterations N]
+ *                   [--output file.json] [--list]
+ *
+ *      - filter:           only run cases whose name contains this text
+ *      - min_time:         minimum time to spend on each case (default 0.5)
+ *      - max_iterations:   maximum iterations for each case (default 100000)
+ *      - output:           write JSON to this file instead of stdout
+ *      - list:             print the name of each case and exit
+ *
+ * Progress messages are written to stderr, so that the JSON document
+ * can be piped to other tools.  The JSON document has the form:
+ * <pre>
+ *  {
+ *    "context": { "date": "2015-06-01T12:00:00", "num_cpus": 8,
+ *                 "usml_version": "1.0", "build_type": "Release",
+ *                 "min_time": 0.5 },
+ *    "benchmarks": [
+ *      { "name": "wave_queue_step/num_de:91", "family": "wave_queue_step",
+ *        "arg_name": "num_de", "arg": 91, "iterations": 1234,
+ *        "mean_usec": ..., "median_usec": ..., "min_usec": ...,
+ *        "max_usec": ..., "stddev_usec": ..., "items_per_second": ...,
+ *        "counters": { "num_az": 18 } },
+ *      ...
+ *    ]
+ *  }
+ * </pre>
+ */
+#include <usml/usml_bench.h>
+#include <usml/ublas/randgen.h>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef USML_VERSION
+#define USML_VERSION ""
+#endif
+
+#ifndef USML_BUILD_TYPE
+#define USML_BUILD_TYPE ""
+#endif
+
+using namespace usml::bench ;
+using usml::ublas::randgen ;
+
+const size_t bench_state::min_iterations ;
+
+/**
+ * Initialize the timing loop.
+ */
+bench_state::bench_state( size_t arg, double min_time, size_t max_iterations )
+    : _arg( arg ), _min_time( min_time ),
+      _max_iterations( std::max( max_iterations, min_iterations ) ),
+      _running( false ), _paused( false ), _excluded( 0.0 ), _elapsed( 0.0 ),
+      _items( 0.0 )
+{
+}
+
+/**
+ * Records the time for the last iteration, and decides whether
+ * to start another one.
+ */
+bool bench_state::keep_running() {
+    const time_point now = clock_type::universal_time() ;
+    if ( _running ) {
+        if ( _paused ) resume_timing() ;
+        const double sec = 1e-6 * ( now - _start ).total_microseconds() ;
+        const double sample = std::max( 0.0, sec - _excluded ) ;
+        _samples.push_back( sample ) ;
+        _elapsed += sample ;
+        if ( _samples.size() >= _max_iterations
+            || ( _samples.size() >= min_iterations && _elapsed >= _min_time ) )
+        {
+            _running = false ;
+            return false ;
+        }
+    }
+    _running = true ;
+    _excluded = 0.0 ;
+    _start = clock_type::universal_time() ;
+    return true ;
+}
+
+/**
+ * Stops the clock.
+ */
+void bench_state::pause_timing() {
+    if ( _paused ) return ;
+    _paused = true ;
+    _pause_start = clock_type::universal_time() ;
+}
+
+/**
+ * Restarts the clock.
+ */
+void bench_state::resume_timing() {
+    if ( ! _paused ) return ;
+    _paused = false ;
+    const time_point now = clock_type::universal_time() ;
+    _excluded += 1e-6 * ( now - _pause_start ).total_microseconds() ;
+}
+
+/**
+ * Singleton instance of the registry.
+ */
+bench_registry* bench_registry::instance() {
+    static bench_registry registry ;
+    return &registry ;
+}
+
+/**
+ * Adds a benchmark to the registry.
+ */
+int bench_registry::add( const char* name, bench_function function,
+    const char* arg_name, const size_t* args, size_t num_args )
+{
+    bench_case item ;
+    item.name = name ;
+    item.function = function ;
+    if ( arg_name ) item.arg_name = arg_name ;
+    if ( args ) item.args.assign( args, args + num_args ) ;
+    _cases.push_back( item ) ;
+    return (int) _cases.size() ;
+}
+
+namespace {
+
+/**
+ * Name of a case in the JSON output.
+ */
+std::string case_name( const bench_case& item, size_t arg ) {
+    std::ostringstream name ;
+    name << item.name ;
+    if ( ! item.arg_name.empty() ) {
+        name << '/' << item.arg_name << ':' << arg ;
+    }
+    return name.str() ;
+}
+
+/**
+ * Writes a number in a form that JSON can parse.
+ */
+void write_number( std::ostream& os, double value ) {
+    if ( value != value || std::abs(value) > 1e300 ) {
+        os << "null" ;
+    } else {
+        os << value ;
+    }
+}
+
+/**
+ * Runs a single case and writes its statistics as a JSON object.
+ */
+void run_case( std::ostream& os, const bench_case& item, size_t arg,
+    double min_time, size_t max_iterations )
+{
+    const std::string name = case_name( item, arg ) ;
+    std::cerr << name << " ... " << std::flush ;
+    randgen::seed( 0 ) ;
+    bench_state state( arg, min_time, max_iterations ) ;
+    item.function( state ) ;
+
+    // compute statistics in microseconds
+
+    std::vector<double> usec( state.samples() ) ;
+    const size_t N = usec.size() ;
+    double mean = 0.0, median = 0.0, low = 0.0, high = 0.0, stddev = 0.0 ;
+    double total = 0.0 ;
+    if ( N > 0 ) {
+        for ( size_t n=0 ; n < N ; ++n ) {
+            total += usec[n] ;
+            usec[n] *= 1e6 ;
+        }
+        std::sort( usec.begin(), usec.end() ) ;
+        mean = total * 1e6 / N ;
+        median = ( N % 2 ) ? usec[N/2] : 0.5 * ( usec[N/2-1] + usec[N/2] ) ;
+        low = usec.front() ;
+        high = usec.back() ;
+        for ( size_t n=0 ; n < N ; ++n ) {
+            stddev += ( usec[n] - mean ) * ( usec[n] - mean ) ;
+        }
+        stddev = ( N > 1 ) ? std::sqrt( stddev / ( N - 1 ) ) : 0.0 ;
+    }
+    std::cerr << N << " iterations, median " << median << " usec" << std::endl ;
+
+    os << "    { \"name\": \"" << name << "\", \"family\": \"" << item.name
+       << "\", " ;
+    if ( ! item.arg_name.empty() ) {
+        os << "\"arg_name\": \"" << item.arg_name << "\", \"arg\": " << arg
+           << ", " ;
+    }
+    os << "\"iterations\": " << N ;
+    os << ",\n      \"mean_usec\": " ; write_number( os, mean ) ;
+    os << ", \"median_usec\": " ; write_number( os, median ) ;
+    os << ", \"min_usec\": " ; write_number( os, low ) ;
+    os << ", \"max_usec\": " ; write_number( os, high ) ;
+    os << ", \"stddev_usec\": " ; write_number( os, stddev ) ;
+    if ( state.items_processed() > 0.0 && total > 0.0 ) {
+        os << ",\n      \"items_per_second\": " ;
+        write_number( os, state.items_processed() * N / total ) ;
+    }
+    os << ",\n      \"counters\": {" ;
+    const char* separator = " " ;
+    for ( std::map<std::string,double>::const_iterator iter
+          = state.counters().begin() ; iter != state.counters().end() ; ++iter )
+    {
+        os << separator << '"' << iter->first << "\": " ;
+        write_number( os, iter->second ) ;
+        separator = ", " ;
+    }
+    os << " } }" ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Command line interface.
+ */
+int main( int argc, char* argv[] ) {
+    std::string filter ;
+    std::string output ;
+    double min_time = 0.5 ;
+    size_t max_iterations = 100000 ;
+    bool list = false ;
+    for ( int n=1 ; n < argc ; ++n ) {
+        if ( std::strcmp( argv[n], "--filter" ) == 0 && n+1 < argc ) {
+            filter = argv[++n] ;
+        } else if ( std::strcmp( argv[n], "--min_time" ) == 0 && n+1 < argc ) {
+            min_time = std::atof( argv[++n] ) ;
+        } else if ( std::strcmp( argv[n], "--max_iterations" ) == 0 && n+1 < argc ) {
+            max_iterations = (size_t) std::atol( argv[++n] ) ;
+        } else if ( std::strcmp( argv[n], "--output" ) == 0 && n+1 < argc ) {
+            output = argv[++n] ;
+        } else if ( std::strcmp( argv[n], "--list" ) == 0 ) {
+            list = true ;
+        } else {
+            std::cerr << "usage: usml_bench [--filter text] [--min_time sec]"
+                      << " [--max_iterations N] [--output file.json] [--list]"
+                      << std::endl ;
+            return 1 ;
+        }
+    }
+
+    // build the list of cases to run
+
+    typedef std::pair<const bench_case*,size_t> selection ;
+    std::vector<selection> selected ;
+    const std::vector<bench_case>& cases = bench_registry::instance()->cases() ;
+    for ( size_t c=0 ; c < cases.size() ; ++c ) {
+        std::vector<size_t> args( cases[c].args ) ;
+        if ( args.empty() ) args.push_back( 0 ) ;
+        for ( size_t a=0 ; a < args.size() ; ++a ) {
+            const std::string name = case_name( cases[c], args[a] ) ;
+            if ( name.find( filter ) == std::string::npos ) continue ;
+            if ( list ) {
+                std::cout << name << std::endl ;
+            } else {
+                selected.push_back( selection( &cases[c], args[a] ) ) ;
+            }
+        }
+    }
+    if ( list ) return 0 ;
+
+    // run each case and write results
+
+    std::ofstream file ;
+    if ( ! output.empty() ) {
+        file.open( output.c_str() ) ;
+        if ( ! file ) {
+            std::cerr << "can not open " << output << std::endl ;
+            return 1 ;
+        }
+    }
+    std::ostream& os = output.empty() ? std::cout : file ;
+    os.precision( 10 ) ;
+
+    char date[32] ;
+    const std::time_t now = std::time( NULL ) ;
+    std::strftime( date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime( &now ) ) ;
+    os << "{\n  \"context\": { \"date\": \"" << date
+       << "\", \"num_cpus\": " << boost::thread::hardware_concurrency()
+       << ", \"usml_version\": \"" << USML_VERSION
+       << "\", \"build_type\": \"" << USML_BUILD_TYPE
+       << "\", \"min_time\": " << min_time << " },\n"
+       << "  \"benchmarks\": [\n" ;
+    for ( size_t n=0 ; n < selected.size() ; ++n ) {
+        run_case( os, *selected[n].first, selected[n].second,
+                  min_time, max_iterations ) ;
+        os << ( ( n+1 < selected.size() ) ? ",\n" : "\n" ) ;
+    }
+    os << "  ]\n}" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file usml_bench.h
+ * Framework for the micro- and macro-benchmarks in the usml_bench target.
+ */
+#pragma once
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace usml {
+namespace bench {
+
+using std::size_t ;
+
+/**
+ * @defgroup bench Benchmarks
+ * @{
+ *
+ * Each benchmark is a function that builds a synthetic environment, and
+ * then repeats the operation being measured until keep_running() returns
+ * false.  The time between calls to keep_running() is recorded as one
+ * sample, minus any time spent between pause_timing() and resume_timing().
+ * Benchmarks are registered with the USML_BENCH() or USML_BENCH_ARGS()
+ * macros, and run by the usml_bench program, which writes the timing
+ * statistics of every case as a JSON document.
+ *
+ * <pre>
+ *      static const size_t fan_sizes[] = { 15, 45, 91 } ;
+ *      USML_BENCH_ARGS( wave_queue_step, "num_de", fan_sizes ) {
+ *          wave_queue wave( ... state.arg() ... ) ;
+ *          while ( state.keep_running() ) {
+ *              wave.step() ;
+ *          }
+ *          state.items_processed( state.arg() * num_az ) ;
+ *      }
+ * </pre>
+ *
+ * Synthetic environments should only use the randgen generator, which is
+ * re-seeded before each case, so that results are repeatable.
+ */
+
+/**
+ * Controls the timing loop of a single benchmark case,
+ * and stores the samples that it measures.
+ */
+class bench_state {
+
+public:
+
+    /** Clock used to measure elapsed time. */
+    typedef boost::posix_time::microsec_clock clock_type ;
+
+    /** Point in time measured by the clock. */
+    typedef boost::posix_time::ptime time_point ;
+
+    /**
+     * Initialize the timing loop.
+     *
+     * @param   arg             Argument for this case, zero if none.
+     * @param   min_time        Minimum time to spend in the timing loop (sec).
+     * @param   max_iterations  Maximum number of times through the loop.
+     */
+    bench_state( size_t arg, double min_time, size_t max_iterations ) ;
+
+    /**
+     * Argument for this case, from the list given to USML_BENCH_ARGS().
+     */
+    size_t arg() const {
+        return _arg ;
+    }
+
+    /**
+     * Records the time for the last iteration, and decides whether
+     * to start another one.  Stops after at least min_time seconds,
+     * and min_iterations iterations, or after max_iterations.
+     *
+     * @return  True if the benchmark should run another iteration.
+     */
+    bool keep_running() ;
+
+    /**
+     * Stops the clock, so that work which should not be measured,
+     * like rebuilding the input for the next iteration, can be excluded.
+     */
+    void pause_timing() ;
+
+    /**
+     * Restarts the clock after pause_timing().
+     */
+    void resume_timing() ;
+
+    /**
+     * Number of items, like rays or interpolations, processed
+     * in each iteration.  Used to compute items per second.
+     */
+    void items_processed( double items ) {
+        _items = items ;
+    }
+
+    /**
+     * Items processed in each iteration.
+     */
+    double items_processed() const {
+        return _items ;
+    }
+
+    /**
+     * Reports an extra value, like a problem size, along with the timing.
+     *
+     * @param   name    Name of the value in the JSON output.
+     * @param   value   Value to report.
+     */
+    void counter( const std::string& name, double value ) {
+        _counters[name] = value ;
+    }
+
+    /**
+     * Extra values reported by the benchmark.
+     */
+    const std::map<std::string,double>& counters() const {
+        return _counters ;
+    }
+
+    /**
+     * Time for each iteration (sec).
+     */
+    const std::vector<double>& samples() const {
+        return _samples ;
+    }
+
+    /** Minimum number of iterations for each case. */
+    static const size_t min_iterations = 3 ;
+
+private:
+
+    /** Argument for this case. */
+    const size_t _arg ;
+
+    /** Minimum time to spend in the timing loop (sec). */
+    const double _min_time ;
+
+    /** Maximum number of times through the loop. */
+    const size_t _max_iterations ;
+
+    /** True after the first call to keep_running(). */
+    bool _running ;
+
+    /** True between pause_timing() and resume_timing(). */
+    bool _paused ;
+
+    /** Start of the current iteration. */
+    time_point _start ;
+
+    /** Start of the current pause. */
+    time_point _pause_start ;
+
+    /** Time excluded from the current iteration (sec). */
+    double _excluded ;
+
+    /** Total time in all iterations so far (sec). */
+    double _elapsed ;
+
+    /** Items processed in each iteration. */
+    double _items ;
+
+    /** Time for each iteration (sec). */
+    std::vector<double> _samples ;
+
+    /** Extra values reported by the benchmark. */
+    std::map<std::string,double> _counters ;
+} ;
+
+/** Function that implements a benchmark. */
+typedef void (*bench_function)( bench_state& state ) ;
+
+/**
+ * Benchmark function, and the arguments to run it with.
+ */
+struct bench_case {
+
+    /** Name of the benchmark. */
+    std::string name ;
+
+    /** Function that implements the benchmark. */
+    bench_function function ;
+
+    /** Name of the argument, empty if the benchmark has none. */
+    std::string arg_name ;
+
+    /** Arguments to run the benchmark with, empty if none. */
+    std::vector<size_t> args ;
+} ;
+
+/**
+ * Singleton list of all benchmarks, in the order they were registered.
+ */
+class bench_registry {
+
+public:
+
+    /**
+     * Singleton instance of the registry.
+     */
+    static bench_registry* instance() ;
+
+    /**
+     * Adds a benchmark to the registry.
+     *
+     * @param   name        Name of the benchmark.
+     * @param   function    Function that implements the benchmark.
+     * @param   arg_name    Name of the argument, NULL if none.
+     * @param   args        Arguments to run the benchmark with.
+     * @param   num_args    Number of arguments.
+     * @return              Number of benchmarks registered so far.
+     */
+    int add( const char* name, bench_function function,
+             const char* arg_name = NULL, const size_t* args = NULL,
+             size_t num_args = 0 ) ;
+
+    /**
+     * List of benchmarks, in the order they were registered.
+     */
+    const std::vector<bench_case>& cases() const {
+        return _cases ;
+    }
+
+private:
+
+    /** List of benchmarks. */
+    std::vector<bench_case> _cases ;
+} ;
+
+/// @}
+}   // end of namespace bench
+}   // end of namespace usml
+
+/**
+ * Defines and registers a benchmark that has no arguments.
+ */
+#define USML_BENCH( name ) \
+    static void name( usml::bench::bench_state& state ) ; \
+    static const int name##_registered = \
+        usml::bench::bench_registry::instance()->add( #name, name ) ; \
+    static void name( usml::bench::bench_state& state )
+
+/**
+ * Defines and registers a benchmark that is run once for each entry
+ * in a static array of arguments.
+ */
+#define USML_BENCH_ARGS( name, arg_name, args ) \
+    static void name( usml::bench::bench_state& state ) ; \
+    static const int name##_registered = \
+        usml::bench::bench_registry::instance()->add( #name, name, \
+            arg_name, args, sizeof(args) / sizeof(args[0]) ) ; \
+    static void name( usml::bench::bench_state& state )
@@ -0,0 +1,197 @@
+/**
+ * @file waveq3d_bench.cc
+ * Benchmarks for wavefront propagation in the WaveQ3D model.
+ *
+ * Uses a Munk profile over a flat 5000 meter bottom, with the source at
+ * 1000 meters, so the results do not depend on any external databases.
+ * Targets are scattered randomly within 0.5 degrees of the source.
+ */
+#include <usml/usml_bench.h>
+#include <usml/waveq3d/waveq3d.h>
+#include <usml/ublas/randgen.h>
+
+using namespace usml::bench ;
+using namespace usml::waveq3d ;
+using namespace usml::ocean ;
+using usml::ublas::randgen ;
+
+namespace {
+
+/** Time step used to propagate the wavefronts (sec). */
+const double time_step = 0.1 ;
+
+/** Number of steps before the wavefront is restarted at the source. */
+const size_t max_steps = 600 ;
+
+/** Number of AZ angles in each ray fan. */
+const size_t num_az = 18 ;
+
+/** Number of D/E angles in the ray fans that have targets. */
+const size_t target_de = 91 ;
+
+/**
+ * Synthetic ocean and ray fan shared by the WaveQ3D benchmarks.
+ */
+struct scenario {
+
+    /** Environmental parameters. */
+    ocean_model ocean ;
+
+    /** Frequencies over which to compute loss. */
+    seq_log freq ;
+
+    /** Location of the source. */
+    wposition1 source ;
+
+    /** AZ launch angles. */
+    seq_linear az ;
+
+    /** Build the ocean and the AZ launch angles. */
+    scenario() :
+        ocean( new boundary_flat(), new boundary_flat(5000.0),
+               new profile_munk() ),
+        freq( 3000.0, 1.0, 1 ),
+        source( 36.0, 16.0, -1000.0 ),
+        az( 0.0, 360.0 / num_az, num_az )
+    {
+        wposition::compute_earth_radius( 36.0 ) ;
+    }
+
+    /**
+     * Random targets within 0.5 degrees of the source.
+     * The caller owns the result.
+     */
+    wposition* targets( size_t num_targets ) const {
+        wposition* result = new wposition( num_targets, 1,
+            source.latitude(), source.longitude(), source.altitude() ) ;
+        for ( size_t n=0 ; n < num_targets ; ++n ) {
+            result->latitude( n, 0, source.latitude() + randgen::uniform() - 0.5 ) ;
+            result->longitude( n, 0, source.longitude() + randgen::uniform() - 0.5 ) ;
+            result->altitude( n, 0, -5000.0 * randgen::uniform() ) ;
+        }
+        return result ;
+    }
+} ;
+
+/**
+ * Steps a wave_queue until the timing loop is done, restarting it at the
+ * source every max_steps steps, so that all rays stay in the water column.
+ * The restarts are not included in the timing.
+ */
+void step_queue( bench_state& state, scenario& env, size_t num_de,
+    const wposition* targets )
+{
+    seq_rayfan de( -90.0, 90.0, num_de ) ;
+    wave_queue* wave = NULL ;
+    size_t steps = max_steps ;
+    while ( state.keep_running() ) {
+        if ( steps == max_steps ) {
+            state.pause_timing() ;
+            delete wave ;
+            wave = new wave_queue( env.ocean, env.freq, env.source, de, env.az,
+                time_step, targets ) ;
+            steps = 0 ;
+            state.resume_timing() ;
+        }
+        wave->step() ;
+        ++steps ;
+    }
+    delete wave ;
+    state.items_processed( num_de * num_az ) ;
+    state.counter( "num_az", num_az ) ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Time for a single wave_queue::step() as a function of the number of
+ * D/E angles in the fan, without targets.
+ */
+static const size_t fan_sizes[] = { 15, 45, 91, 181, 361 } ;
+USML_BENCH_ARGS( wave_queue_step, "num_de", fan_sizes ) {
+    scenario env ;
+    step_queue( state, env, state.arg(), NULL ) ;
+}
+
+/**
+ * Time for a single wave_queue::step() as a function of the number of
+ * targets, which includes the eigenray search.
+ */
+static const size_t target_counts[] = { 1, 10, 100, 1000 } ;
+USML_BENCH_ARGS( wave_queue_step_targets, "num_targets", target_counts ) {
+    scenario env ;
+    wposition* targets = env.targets( state.arg() ) ;
+    step_queue( state, env, target_de, targets ) ;
+    state.counter( "num_de", target_de ) ;
+    delete targets ;
+}
+
+/**
+ * Time for wave_front::update() as a function of the number of targets.
+ * The difference from the single target case is dominated by
+ * compute_target_distance().
+ */
+USML_BENCH_ARGS( wave_front_target_distance, "num_targets", target_counts ) {
+    scenario env ;
+    wposition* targets = env.targets( state.arg() ) ;
+    matrix<double> sin_theta( targets->size1(), targets->size2() ) ;
+    for ( size_t n=0 ; n < targets->size1() ; ++n ) {
+        sin_theta(n,0) = sin( targets->theta(n,0) ) ;
+    }
+    seq_rayfan de( -90.0, 90.0, target_de ) ;
+    wave_front wave( env.ocean, &env.freq, target_de, num_az,
+        targets, &sin_theta ) ;
+    wave.init_wave( env.source, de, env.az ) ;
+    while ( state.keep_running() ) {
+        wave.update() ;
+    }
+    state.items_processed( (double) state.arg() * target_de * num_az ) ;
+    state.counter( "num_de", target_de ) ;
+    state.counter( "num_az", num_az ) ;
+    delete targets ;
+}
+
+/**
+ * Time for eigenray_collection::sum_eigenrays() as a function of the
+ * number of frequencies, for 100 targets with 20 eigenrays each.
+ * The eigenrays have random travel times, losses, and phases.
+ * Includes the time to pack the eigenrays into the flat store.
+ */
+static const size_t freq_counts[] = { 1, 10, 100 } ;
+USML_BENCH_ARGS( eigenray_sum, "num_freq", freq_counts ) {
+    const size_t num_targets = 100 ;
+    const size_t num_rays = 20 ;
+    scenario env ;
+    wposition* targets = env.targets( num_targets ) ;
+    seq_linear freq( 1000.0, 100.0, state.arg() ) ;
+    seq_rayfan de( -90.0, 90.0, target_de ) ;
+    eigenray_collection collection( freq, env.source, de, env.az,
+        time_step, targets ) ;
+    for ( size_t n=0 ; n < num_targets ; ++n ) {
+        for ( size_t r=0 ; r < num_rays ; ++r ) {
+            eigenray ray ;
+            ray.time = 10.0 * randgen::uniform() ;
+            ray.frequencies = &freq ;
+            ray.intensity.resize( freq.size() ) ;
+            ray.phase.resize( freq.size() ) ;
+            for ( size_t f=0 ; f < freq.size() ; ++f ) {
+                ray.intensity(f) = 60.0 + 40.0 * randgen::uniform() ;
+                ray.phase(f) = -M_PI * ( r % 3 ) ;
+            }
+            ray.source_de = 180.0 * randgen::uniform() - 90.0 ;
+            ray.source_az = 360.0 * randgen::uniform() ;
+            ray.target_de = 180.0 * randgen::uniform() - 90.0 ;
+            ray.target_az = 360.0 * randgen::uniform() ;
+            ray.surface = ray.bottom = ray.caustic = 0 ;
+            ray.upper = ray.lower = 0 ;
+            collection.add_eigenray( n, 0, ray, 0 ) ;
+        }
+    }
+    while ( state.keep_running() ) {
+        collection.sum_eigenrays() ;
+    }
+    state.items_processed( (double) num_targets * num_rays * state.arg() ) ;
+    state.counter( "num_targets", num_targets ) ;
+    state.counter( "num_rays", num_rays ) ;
+    delete targets ;
+}
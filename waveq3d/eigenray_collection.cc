@@ -28,7 +28,8 @@ eigenray_collection::eigenray_collection(
 	_time_step(time_step),
 	_eigenrays( size1(), size2() ),
 	_num_eigenrays(0),
-	_loss( size1(), size2() )
+	_loss( size1(), size2() ),
+	_partition( NULL )
 {
 	initialize();
 }
@@ -50,169 +51,227 @@ void eigenray_collection::initialize()
     }
 }
 
+namespace {
+
+/**
+ * Sine and cosine of a phase, without calls to the math library, so that
+ * the loops in sum_targets() can be vectorized by the compiler.  The phase
+ * is reduced to r = p - j*PI/2, in [-PI/4,PI/4], using a three part
+ * (Cody-Waite) split of PI/2.  The sine and cosine of r are computed from
+ * the same minimax polynomials as the Cephes library, and the quadrant
+ * j mod 4 rotates the result with multipliers that are exactly 0, 1, or -1.
+ * Valid for |p| < 2^29 * PI/2.  With -ffast-math, the compiler may fold
+ * the split back into a single constant, and the error grows to about
+ * 1e-16 |p|.  This is the same error as the fmod( p, TWO_PI ) that it
+ * replaces, and smaller than the rounding error in p itself.
+ *
+ * @param   p       Phase (radians).
+ * @param   s       Sine of the phase (output).
+ * @param   c       Cosine of the phase (output).
+ */
+inline void phasor( double p, double& s, double& c ) {
+    const double PIO2_1 = 1.57079625129699707031E0 ;
+    const double PIO2_2 = 7.54978941586159635336E-8 ;
+    const double PIO2_3 = 5.39030285815811905290E-15 ;
+    const double BIAS = 1073741824.0 ;  // 2^30 keeps truncation positive
+
+    // round to the nearest multiple of PI/2
+
+    const int j = (int) ( p * ( 2.0 / M_PI ) + ( BIAS + 0.5 ) )
+        - (int) BIAS ;
+    const double n = (double) j ;
+    const double r = ( ( p - n * PIO2_1 ) - n * PIO2_2 ) - n * PIO2_3 ;
+
+    // polynomials for sine and cosine in [-PI/4,PI/4]
+
+    const double z = r * r ;
+    const double sr = r + r * z * ( ( ( ( ( 1.58962301576546568060E-10
+        * z - 2.50507477628578072866E-8 )
+        * z + 2.75573136213857245213E-6 )
+        * z - 1.98412698295895385996E-4 )
+        * z + 8.33333333332211858878E-3 )
+        * z - 1.66666666666666307295E-1 ) ;
+    const double cr = 1.0 - 0.5 * z + z * z * ( ( ( ( ( -1.13585365213876817300E-11
+        * z + 2.08757008419747316778E-9 )
+        * z - 2.75573141792967388112E-7 )
+        * z + 2.48015872888517045348E-5 )
+        * z - 1.38888888888730564116E-3 )
+        * z + 4.16666666666665929218E-2 ) ;
+
+    // rotate by the quadrant
+
+    const double odd = (double) ( j & 1 ) ;
+    const double sign = 1.0 - (double) ( j & 2 ) ;
+    s = sign * ( ( 1.0 - odd ) * sr + odd * cr ) ;
+    c = sign * ( ( 1.0 - odd ) * cr - odd * sr ) ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Applies sum_targets() to one block of the partition.
+ */
+class eigenray_collection::sum_task : public wave_partition::block_task {
+  public:
+    sum_task( eigenray_collection& collection, const double* omega,
+        bool coherent ) :
+        _collection( collection ), _omega( omega ), _coherent( coherent )
+    {
+    }
+
+    virtual void run_block( size_t block, size_t first, size_t last ) {
+        _collection.sum_targets( first, last, _omega, _coherent ) ;
+    }
+
+  private:
+    eigenray_collection& _collection ;
+    const double* _omega ;
+    const bool _coherent ;
+};
+
+/**
+ * Number of threads used by sum_eigenrays().
+ */
+void eigenray_collection::num_threads( size_t num ) {
+    if ( _partition ) {
+        delete _partition ;
+        _partition = NULL ;
+    }
+    const size_t num_targets = size1() * size2() ;
+    if ( num <= 1 || num_targets <= 1 ) return ;
+    _partition = new wave_partition( num_targets, num ) ;
+}
+
 /**
  * Compute propagation loss summed over all eigenrays.
  */
 void eigenray_collection::sum_eigenrays( bool coherent ) {
+    const size_t num_freq = _frequencies->size() ;
+    _store.pack( _eigenrays, num_freq ) ;
 
-	/// coherent signal summation
-
-    if( coherent ) {
-        for ( size_t t1=0 ; t1 < _targets->size1() ; ++t1 ) {
-            for ( size_t t2=0 ; t2 < _targets->size2() ; ++t2 ) {
-
-                double time = 0.0 ;
-                double source_de = 0.0 ;
-                double source_az_x = 0.0 ; // East/West component
-                double source_az_y = 0.0 ; // North/South component
-                double target_de = 0.0 ;
-                double target_az_x = 0.0 ; // East/West component
-                double target_az_y = 0.0 ; // North/South component
-                int surface = -1 ;
-                int bottom = -1 ;
-                int caustic = -1 ;
-                double wgt = 0.0 ;
-                double max_a = 0.0 ;
-
-                // compute at each frequency
-
-                const eigenray_list* entry = eigenrays(t1,t2) ;
-                eigenray* loss = &( _loss(t1,t2) ) ;
-
-                    for ( size_t f=0 ; f < _frequencies->size() ; ++f ) {
-
-                        // sum complex amplitudes over eigenrays
-
-                        std::complex<double> phasor( 0.0, 0.0 ) ;
-
-                        for ( eigenray_list::const_iterator iter = entry->begin() ;
-                              iter != entry->end() ; ++iter )
-                        {
-                            const eigenray& ray = *iter ;
-
-                            // complex pressure
-
-                            double a = pow( 10.0, ray.intensity(f) / -20.0 ) ;                // pressure
-                            double p = TWO_PI * (*_frequencies)(f) * ray.time + ray.phase(f) ;
-                            p = fmod( p, TWO_PI ) ; // large phases bad for cos,sin
-                            std::complex<double> value( a * cos(p), a * sin(p) ) ;
-                            phasor += value ;
-
-                            // other eigenray terms
-
-                            a *= a ;          // scale by the pressure squared
-                            wgt += a ;
-                            time += a * ray.time ;
-                            source_de += a * ray.source_de ;
-                            source_az_x += a * sin(to_radians(ray.source_az)) ;
-                            source_az_y += a * cos(to_radians(ray.source_az)) ;
-                            target_de += a * ray.target_de ;
-                            target_az_x += a * sin(to_radians(ray.target_az)) ;
-                            target_az_y += a * cos(to_radians(ray.target_az)) ;
-                            if ( a > max_a ) {
-                                max_a = a ;
-                                surface = ray.surface ;
-                                bottom = ray.bottom ;
-                                caustic = ray.caustic ;
-                            }
-                        } // end eigenray_list
-
-                        // convert back into intensity (dB) and phase (radians) values
-
-                        loss->intensity(f) = -20.0*log10( max(1e-15,abs(phasor)) ) ;
-                        loss->phase(f) = arg(phasor) ;
-                    } // end frequency
-
-                // weighted average of other eigenray terms
-
-                loss->time = time / wgt ;
-                loss->source_de = source_de / wgt ;
-                loss->source_az = 90.0 - to_degrees(atan2(source_az_y, source_az_x)) ;
-                loss->target_de = target_de / wgt ;
-                loss->target_az = 90.0 - to_degrees(atan2(target_az_y, target_az_x)) ;
-                loss->surface = surface ;
-                loss->bottom = bottom ;
-                loss->caustic = caustic ;
-            } // end target size2
-        } // end target size1
-
-    /// incoherent signal summation
+    std::vector<double> omega( num_freq + 1 ) ;
+    for ( size_t f=0 ; f < num_freq ; ++f ) {
+        omega[f] = TWO_PI * (*_frequencies)(f) ;
+    }
 
+    if ( _partition ) {
+        sum_task task( *this, &omega[0], coherent ) ;
+        _partition->run( task ) ;
     } else {
-        for ( size_t t1=0 ; t1 < _targets->size1() ; ++t1 ) {
-            for ( size_t t2=0 ; t2 < _targets->size2() ; ++t2 ) {
-
-                double time = 0.0 ;
-                double source_de = 0.0 ;
-                double source_az_x = 0.0 ; // East/West component
-                double source_az_y = 0.0 ; // North/South component
-                double target_de = 0.0 ;
-                double target_az_x = 0.0 ; // East/West component
-                double target_az_y = 0.0 ; // North/South component
-                int surface = -1 ;
-                int bottom = -1 ;
-                int caustic = -1 ;
-                double wgt = 0.0 ;
-                double max_a = 0.0 ;
-
-                // compute at each frequency
-
-                const eigenray_list* entry = eigenrays(t1,t2) ;
-                eigenray* loss = &( _loss(t1,t2) ) ;
-
-                    for ( size_t f=0 ; f < _frequencies->size() ; ++f ) {
-
-                        // sum complex amplitudes over eigenrays
-
-                        double phasor = 0.0 ;
-
-                        for ( eigenray_list::const_iterator iter = entry->begin() ;
-                              iter != entry->end() ; ++iter )
-                        {
-                            const eigenray& ray = *iter ;
-
-                            // complex pressure
-
-                            const double a = pow( 10.0, ray.intensity(f) / -10.0 ) ; // pressure squared
-                            phasor += a ;
-
-                            // other eigenray terms
-
-                            wgt += a ;
-                            time += a * ray.time ;
-                            source_de += a * ray.source_de ;
-                            source_az_x += a * sin(to_radians(ray.source_az)) ;
-                            source_az_y += a * cos(to_radians(ray.source_az)) ;
-                            target_de += a * ray.target_de ;
-                            target_az_x += a * sin(to_radians(ray.target_az)) ;
-                            target_az_y += a * cos(to_radians(ray.target_az)) ;
-                            if ( a > max_a ) {
-                                max_a = a ;
-                                surface = ray.surface ;
-                                bottom = ray.bottom ;
-                                caustic = ray.caustic ;
-                            }
-                        } // end eigenray_list
-
-                        // convert back into intensity (dB) and phase (radians) values
-
-                        loss->intensity(f) = -20.0*log10( max(1e-15,sqrt(phasor)) ) ;
-                        loss->phase(f) = 0.0 ;
-                    } // end frequency
-
-                // weighted average of other eigenray terms
-
-                loss->time = time / wgt ;
-                loss->source_de = source_de / wgt ;
-                loss->source_az = 90.0 - to_degrees(atan2(source_az_y, source_az_x)) ;
-                loss->target_de = target_de / wgt ;
-                loss->target_az = 90.0 - to_degrees(atan2(target_az_y, target_az_x)) ;
-                loss->surface = surface ;
-                loss->bottom = bottom ;
-                loss->caustic = caustic ;
-            } // end targets size2
-        } // end targets size1
-    } // end coherent/incoherent
+        sum_targets( 0, _store.num_targets(), &omega[0], coherent ) ;
+    }
+}
+
+/**
+ * Sums the eigenrays for a range of targets in the flat store.
+ * The real and imaginary parts of the phasor sum (or the sum of the
+ * intensities in the incoherent case) are accumulated directly in the
+ * intensity and phase vectors of the result, and then converted into
+ * dB and radians.  The weighted averages of time and angle use the sum
+ * of the squared pressures over all frequencies as the weight of each ray.
+ */
+void eigenray_collection::sum_targets( size_t first, size_t last,
+    const double* omega, bool coherent )
+{
+    const size_t num_freq = _store.num_freq ;
+    const size_t cols = size2() ;
+
+    for ( size_t t = first ; t < last ; ++t ) {
+        eigenray& loss = _loss( t / cols, t % cols ) ;
+        double* real = &loss.intensity.data()[0] ;
+        double* imag = &loss.phase.data()[0] ;
+        for ( size_t f=0 ; f < num_freq ; ++f ) {
+            real[f] = 0.0 ;
+            imag[f] = 0.0 ;
+        }
+
+        double time = 0.0 ;
+        double source_de = 0.0 ;
+        double source_az_x = 0.0 ; // East/West component
+        double source_az_y = 0.0 ; // North/South component
+        double target_de = 0.0 ;
+        double target_az_x = 0.0 ; // East/West component
+        double target_az_y = 0.0 ; // North/South component
+        int surface = -1 ;
+        int bottom = -1 ;
+        int caustic = -1 ;
+        double wgt = 0.0 ;
+        double max_a = 0.0 ;
+
+        // sum over the contiguous range of rays for this target
+
+        for ( size_t r = _store.begin(t) ; r < _store.end(t) ; ++r ) {
+            const double* pressure = &_store.pressure[r*num_freq] ;
+            double weight = 0.0 ;
+            double peak = 0.0 ;
+
+            if ( coherent ) {
+                const double* phase = &_store.phase[r*num_freq] ;
+                const double ray_time = _store.time[r] ;
+                for ( size_t f=0 ; f < num_freq ; ++f ) {
+                    const double a = pressure[f] ;
+                    double s, c ;
+                    phasor( omega[f] * ray_time + phase[f], s, c ) ;
+                    real[f] += a * c ;
+                    imag[f] += a * s ;
+                }
+            } else {
+                for ( size_t f=0 ; f < num_freq ; ++f ) {
+                    real[f] += pressure[f] * pressure[f] ;
+                }
+            }
+
+            // scale by the pressure squared
+
+            for ( size_t f=0 ; f < num_freq ; ++f ) {
+                const double a2 = pressure[f] * pressure[f] ;
+                weight += a2 ;
+                peak = max( peak, a2 ) ;
+            }
+
+            // other eigenray terms
+
+            wgt += weight ;
+            time += weight * _store.time[r] ;
+            source_de += weight * _store.source_de[r] ;
+            source_az_x += weight * _store.source_az_x[r] ;
+            source_az_y += weight * _store.source_az_y[r] ;
+            target_de += weight * _store.target_de[r] ;
+            target_az_x += weight * _store.target_az_x[r] ;
+            target_az_y += weight * _store.target_az_y[r] ;
+            if ( peak > max_a ) {
+                max_a = peak ;
+                surface = _store.surface[r] ;
+                bottom = _store.bottom[r] ;
+                caustic = _store.caustic[r] ;
+            }
+        }
+
+        // convert back into intensity (dB) and phase (radians) values
+
+        if ( coherent ) {
+            for ( size_t f=0 ; f < num_freq ; ++f ) {
+                const std::complex<double> phasor( real[f], imag[f] ) ;
+                real[f] = -20.0*log10( max(1e-15,abs(phasor)) ) ;
+                imag[f] = arg(phasor) ;
+            }
+        } else {
+            for ( size_t f=0 ; f < num_freq ; ++f ) {
+                real[f] = -20.0*log10( max(1e-15,sqrt(real[f])) ) ;
+            }
+        }
+
+        // weighted average of other eigenray terms
+
+        loss.time = time / wgt ;
+        loss.source_de = source_de / wgt ;
+        loss.source_az = 90.0 - to_degrees(atan2(source_az_y, source_az_x)) ;
+        loss.target_de = target_de / wgt ;
+        loss.target_az = 90.0 - to_degrees(atan2(target_az_y, target_az_x)) ;
+        loss.surface = surface ;
+        loss.bottom = bottom ;
+        loss.caustic = caustic ;
+    }
 }
 
 /**
@@ -6,6 +6,8 @@
 
 #include <usml/ocean/ocean.h>
 #include <usml/waveq3d/eigenray_listener.h>
+#include <usml/waveq3d/eigenray_store.h>
+#include <usml/waveq3d/wave_partition.h>
 #include <usml/waveq3d/wave_queue.h>
 
 namespace usml {
@@ -90,6 +92,19 @@ private:
      */
     matrix< eigenray > _loss;
 
+    /**
+     * Flat copy of the eigenray lists used by sum_eigenrays().
+     * Repacked on each call, so that changes to the lists
+     * are always included in the summation.
+     */
+    eigenray_store _store ;
+
+    /**
+     * Splits the targets into blocks that are summed in parallel.
+     * Null if the summation is done in the calling thread.
+     */
+    wave_partition* _partition ;
+
 public:
 
     /**
@@ -120,6 +135,7 @@ public:
       */
     virtual ~eigenray_collection(){
 
+        delete _partition;
         delete _frequencies;
         delete _source_de;
         delete _source_az;
@@ -133,6 +149,21 @@ private:
      */
     void initialize();
 
+    /**
+     * Sums the eigenrays for a range of targets in the flat store.
+     *
+     * @param   first       First target, in row-major order.
+     * @param   last        One past the last target.
+     * @param   omega       Angular frequency of each frequency (rad/sec).
+     * @param   coherent    Coherent summation if true, incoherent if false.
+     */
+    void sum_targets( size_t first, size_t last, const double* omega,
+                      bool coherent ) ;
+
+    /** Applies sum_targets() to one block of the partition. */
+    class sum_task ;
+    friend class sum_task ;
+
 public:
 
     /**
@@ -206,13 +237,34 @@ public:
     void add_eigenray(size_t target_row, size_t target_col, eigenray ray, size_t runID) ;
 
     /**
-     * Compute propagation loss summed over all eigenrays.
+     * Compute propagation loss summed over all eigenrays.  The eigenray
+     * lists are first packed into a flat eigenray_store, so that the
+     * summation for each target reads a contiguous range of memory,
+     * and then the targets are summed in blocks, in parallel if
+     * num_threads() is greater than one.  The results do not depend
+     * on the number of threads.
      *
      * @param   coherent    Compute coherent propagation loss if true,
      *                      and incoherent if false.
      */
     void sum_eigenrays(bool coherent = true);
 
+    /**
+     * Number of threads used by sum_eigenrays().  Defaults to one,
+     * which sums all targets in the calling thread.  Larger values
+     * split the targets into that many blocks.
+     *
+     * @param   num     Number of threads (limited to the number of targets).
+     */
+    void num_threads( size_t num ) ;
+
+    /**
+     * Number of threads used by sum_eigenrays().
+     */
+    inline size_t num_threads() const {
+        return ( _partition ) ? _partition->num_blocks() : 1 ;
+    }
+
     /**
      * Write eigenray_collection scenario data to a netCDF file using a ragged
      * array structure. This ragged array concept (see reference) stores
@@ -0,0 +1,75 @@
+/**
+ * @file eigenray_store.cc
+ * Flat, structure-of-arrays copy of the eigenrays for a grid of targets.
+ */
+#include <usml/waveq3d/eigenray_store.h>
+#include <algorithm>
+
+using namespace usml::waveq3d ;
+
+/**
+ * Copies the eigenray lists for a grid of targets into this store.
+ */
+void eigenray_store::pack(
+    const matrix< eigenray_list >& eigenrays, size_t num_freq )
+{
+    this->num_freq = num_freq ;
+
+    // find the range of rays for each target
+
+    const size_t num_targets = eigenrays.size1() * eigenrays.size2() ;
+    offset.resize( num_targets + 1 ) ;
+    offset[0] = 0 ;
+    size_t t = 0 ;
+    for ( size_t t1=0 ; t1 < eigenrays.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < eigenrays.size2() ; ++t2, ++t ) {
+            offset[t+1] = offset[t] + eigenrays(t1,t2).size() ;
+        }
+    }
+    const size_t num_rays = offset.back() ;
+
+    pressure.resize( num_rays * num_freq ) ;
+    phase.resize( num_rays * num_freq ) ;
+    time.resize( num_rays ) ;
+    source_de.resize( num_rays ) ;
+    source_az_x.resize( num_rays ) ;
+    source_az_y.resize( num_rays ) ;
+    target_de.resize( num_rays ) ;
+    target_az_x.resize( num_rays ) ;
+    target_az_y.resize( num_rays ) ;
+    surface.resize( num_rays ) ;
+    bottom.resize( num_rays ) ;
+    caustic.resize( num_rays ) ;
+
+    // copy each ray into the flat arrays
+    // convert loss in dB into pressure using exp() instead of pow()
+
+    const double scale = -log( 10.0 ) / 20.0 ;
+    size_t r = 0 ;
+    for ( size_t t1=0 ; t1 < eigenrays.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < eigenrays.size2() ; ++t2 ) {
+            const eigenray_list& list = eigenrays(t1,t2) ;
+            for ( eigenray_list::const_iterator iter = list.begin() ;
+                  iter != list.end() ; ++iter, ++r )
+            {
+                const eigenray& ray = *iter ;
+                double* amplitude = &pressure[r * num_freq] ;
+                for ( size_t f=0 ; f < num_freq ; ++f ) {
+                    amplitude[f] = exp( scale * ray.intensity(f) ) ;
+                }
+                std::copy( ray.phase.begin(), ray.phase.begin()+num_freq,
+                           phase.begin() + r * num_freq ) ;
+                time[r] = ray.time ;
+                source_de[r] = ray.source_de ;
+                source_az_x[r] = sin( to_radians(ray.source_az) ) ;
+                source_az_y[r] = cos( to_radians(ray.source_az) ) ;
+                target_de[r] = ray.target_de ;
+                target_az_x[r] = sin( to_radians(ray.target_az) ) ;
+                target_az_y[r] = cos( to_radians(ray.target_az) ) ;
+                surface[r] = ray.surface ;
+                bottom[r] = ray.bottom ;
+                caustic[r] = ray.caustic ;
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file eigenray_store.h
+ * Flat, structure-of-arrays copy of the eigenrays for a grid of targets.
+ */
+#pragma once
+
+#include <usml/waveq3d/eigenray.h>
+#include <vector>
+
+namespace usml {
+namespace waveq3d {
+
+using boost::numeric::ublas::matrix;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Flat, structure-of-arrays copy of the eigenrays for a grid of targets.
+ * The eigenrays for each target occupy a contiguous range of rays
+ * [begin(t),end(t)), where targets are numbered in row-major order
+ * as t = t1 * size2 + t2.  Each field of the eigenray is stored in its
+ * own array, so that the summation over eigenrays and frequencies
+ * reads memory sequentially.  The pressure and phase arrays are
+ * ray-major, with all of the frequencies of a ray stored next to each
+ * other.
+ *
+ * The propagation loss of each ray is converted from dB into a linear
+ * pressure when the store is packed, so that the summation does not
+ * need to call pow() for every ray and frequency.
+ *
+ * The azimuths are converted into their East/West (sin) and North/South
+ * (cos) components when the store is packed, because the weighted
+ * averages in eigenray_collection::sum_eigenrays() only need these
+ * components.
+ */
+struct USML_DECLSPEC eigenray_store {
+
+    /** Number of frequencies for each ray. */
+    size_t num_freq ;
+
+    /** Index of the first ray for each target, plus one past the end. */
+    std::vector<size_t> offset ;
+
+    /** Pressure amplitude (linear), ray-major by frequency. */
+    std::vector<double> pressure ;
+
+    /** Phase change (radians), ray-major by frequency. */
+    std::vector<double> phase ;
+
+    /** Time of arrival for each ray (sec). */
+    std::vector<double> time ;
+
+    /** Initial D/E angle at the source (degrees). */
+    std::vector<double> source_de ;
+
+    /** East/West component of the initial AZ angle at the source. */
+    std::vector<double> source_az_x ;
+
+    /** North/South component of the initial AZ angle at the source. */
+    std::vector<double> source_az_y ;
+
+    /** Final D/E angle at the target (degrees). */
+    std::vector<double> target_de ;
+
+    /** East/West component of the final AZ angle at the target. */
+    std::vector<double> target_az_x ;
+
+    /** North/South component of the final AZ angle at the target. */
+    std::vector<double> target_az_y ;
+
+    /** Number of surface reflections along each path. */
+    std::vector<int> surface ;
+
+    /** Number of bottom reflections along each path. */
+    std::vector<int> bottom ;
+
+    /** Number of caustics along each path. */
+    std::vector<int> caustic ;
+
+    /** Creates an empty store. */
+    eigenray_store() : num_freq(0), offset(1,0) {}
+
+    /**
+     * Copies the eigenray lists for a grid of targets into this store.
+     * Reuses the memory from previous calls when possible.
+     *
+     * @param   eigenrays   List of eigenrays for each target.
+     * @param   num_freq    Number of frequencies in each eigenray.
+     */
+    void pack( const matrix< eigenray_list >& eigenrays, size_t num_freq ) ;
+
+    /** Number of targets in the store. */
+    inline size_t num_targets() const {
+        return offset.size() - 1 ;
+    }
+
+    /** Total number of eigenrays in the store. */
+    inline size_t size() const {
+        return offset.back() ;
+    }
+
+    /** Index of the first eigenray for a target. */
+    inline size_t begin( size_t target ) const {
+        return offset[target] ;
+    }
+
+    /** One past the index of the last eigenray for a target. */
+    inline size_t end( size_t target ) const {
+        return offset[target+1] ;
+    }
+};
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
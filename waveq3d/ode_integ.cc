@@ -197,3 +197,205 @@ void ode_integ::ab3_ndir( double dt, wave_front *y0, wave_front *y1,
         - A1 * y1->ndir_gradient.phi()
         + A0 * y0->ndir_gradient.phi() ), no_alias ) ;
 }
+
+/**
+ * Adams-Bashforth (3rd order) estimate of position for a list of rays.
+ */
+void ode_integ::ab3_pos( double dt, wave_front *y0, wave_front *y1,
+    wave_front *y2, wave_front *y3, const std::vector<size_t>& active )
+{
+    static const double A2 = 23.0 / 12.0 ;
+    static const double A1 = 16.0 / 12.0 ;
+    static const double A0 =  5.0 / 12.0 ;
+
+    const double* g0[3] = { y0->pos_gradient.rho_data(),
+        y0->pos_gradient.theta_data(), y0->pos_gradient.phi_data() } ;
+    const double* g1[3] = { y1->pos_gradient.rho_data(),
+        y1->pos_gradient.theta_data(), y1->pos_gradient.phi_data() } ;
+    const double* g2[3] = { y2->pos_gradient.rho_data(),
+        y2->pos_gradient.theta_data(), y2->pos_gradient.phi_data() } ;
+    const double* p2[3] = { y2->position.rho_data(),
+        y2->position.theta_data(), y2->position.phi_data() } ;
+    double* p3[3] = { y3->position.rho_data(),
+        y3->position.theta_data(), y3->position.phi_data() } ;
+    double* distance = &y3->distance.data()[0] ;
+
+    for ( size_t n=0 ; n < active.size() ; ++n ) {
+        const size_t i = active[n] ;
+        double delta[3] ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            delta[k] = dt * ( A2 * g2[k][i] - A1 * g1[k][i] + A0 * g0[k][i] ) ;
+        }
+        const double rho = p2[0][i] ;
+        const double r_theta = rho * delta[1] ;
+        const double r_phi = rho * ( sin( p2[1][i] ) * delta[2] ) ;
+        distance[i] = sqrt( delta[0] * delta[0] + r_theta * r_theta
+                          + r_phi * r_phi ) ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            p3[k][i] = p2[k][i] + delta[k] ;
+        }
+    }
+}
+
+/**
+ * Adams-Bashforth (3rd order) estimate of ndirection for a list of rays.
+ */
+void ode_integ::ab3_ndir( double dt, wave_front *y0, wave_front *y1,
+    wave_front *y2, wave_front *y3, const std::vector<size_t>& active )
+{
+    static const double A2 = 23.0 / 12.0 ;
+    static const double A1 = 16.0 / 12.0 ;
+    static const double A0 =  5.0 / 12.0 ;
+
+    const double* g0[3] = { y0->ndir_gradient.rho_data(),
+        y0->ndir_gradient.theta_data(), y0->ndir_gradient.phi_data() } ;
+    const double* g1[3] = { y1->ndir_gradient.rho_data(),
+        y1->ndir_gradient.theta_data(), y1->ndir_gradient.phi_data() } ;
+    const double* g2[3] = { y2->ndir_gradient.rho_data(),
+        y2->ndir_gradient.theta_data(), y2->ndir_gradient.phi_data() } ;
+    const double* d2[3] = { y2->ndirection.rho_data(),
+        y2->ndirection.theta_data(), y2->ndirection.phi_data() } ;
+    double* d3[3] = { y3->ndirection.rho_data(),
+        y3->ndirection.theta_data(), y3->ndirection.phi_data() } ;
+
+    for ( size_t n=0 ; n < active.size() ; ++n ) {
+        const size_t i = active[n] ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            d3[k][i] = d2[k][i]
+                + dt * ( A2 * g2[k][i] - A1 * g1[k][i] + A0 * g0[k][i] ) ;
+        }
+    }
+}
+
+/**
+ * Weights of the variable step Adams-Bashforth (3rd order) method.
+ */
+void ode_integ::ab3_weights( double dt, double prev_step, double past_step,
+    double weight[3] )
+{
+    const double a = prev_step ;
+    const double b = past_step ;
+    const double h2 = dt * dt / 2.0 ;
+    const double h3 = dt * dt * dt / 3.0 ;
+    weight[2] = ( h3 + ( 2.0 * a + b ) * h2 + a * ( a + b ) * dt ) / ( a * ( a + b ) ) ;
+    weight[1] = - ( h3 + ( a + b ) * h2 ) / ( a * b ) ;
+    weight[0] = ( h3 + a * h2 ) / ( b * ( a + b ) ) ;
+}
+
+/**
+ * Variable step Adams-Bashforth (3rd order) estimate of position.
+ */
+void ode_integ::ab3_pos( const double weight[3], wave_front *y0,
+    wave_front *y1, wave_front *y2, wave_front *y3, bool no_alias )
+{
+    y3->position.rho(
+          weight[2] * y2->pos_gradient.rho()
+        + weight[1] * y1->pos_gradient.rho()
+        + weight[0] * y0->pos_gradient.rho(), no_alias ) ;
+    y3->position.theta(
+          weight[2] * y2->pos_gradient.theta()
+        + weight[1] * y1->pos_gradient.theta()
+        + weight[0] * y0->pos_gradient.theta(), no_alias ) ;
+    y3->position.phi(
+          weight[2] * y2->pos_gradient.phi()
+        + weight[1] * y1->pos_gradient.phi()
+        + weight[0] * y0->pos_gradient.phi(), no_alias ) ;
+
+    y3->distance = sqrt(
+        abs2( y3->position.rho() ) +
+        abs2( element_prod( y2->position.rho(), y3->position.theta() ) ) +
+        abs2( element_prod( y2->position.rho(),
+            element_prod( sin(y2->position.theta()), y3->position.phi() )
+        ) )
+    ) ;
+
+    y3->position.rho(   y2->position.rho()   + y3->position.rho(),   false ) ;
+    y3->position.theta( y2->position.theta() + y3->position.theta(), false ) ;
+    y3->position.phi(   y2->position.phi()   + y3->position.phi(),   false ) ;
+}
+
+/**
+ * Variable step Adams-Bashforth (3rd order) estimate of ndirection.
+ */
+void ode_integ::ab3_ndir( const double weight[3], wave_front *y0,
+    wave_front *y1, wave_front *y2, wave_front *y3, bool no_alias )
+{
+    y3->ndirection.rho( y2->ndirection.rho()
+        + weight[2] * y2->ndir_gradient.rho()
+        + weight[1] * y1->ndir_gradient.rho()
+        + weight[0] * y0->ndir_gradient.rho(), no_alias ) ;
+    y3->ndirection.theta( y2->ndirection.theta()
+        + weight[2] * y2->ndir_gradient.theta()
+        + weight[1] * y1->ndir_gradient.theta()
+        + weight[0] * y0->ndir_gradient.theta(), no_alias ) ;
+    y3->ndirection.phi( y2->ndirection.phi()
+        + weight[2] * y2->ndir_gradient.phi()
+        + weight[1] * y1->ndir_gradient.phi()
+        + weight[0] * y0->ndir_gradient.phi(), no_alias ) ;
+}
+
+/**
+ * Variable step Adams-Bashforth (3rd order) estimate of position
+ * for a list of rays.
+ */
+void ode_integ::ab3_pos( const double weight[3], wave_front *y0,
+    wave_front *y1, wave_front *y2, wave_front *y3,
+    const std::vector<size_t>& active )
+{
+    const double* g0[3] = { y0->pos_gradient.rho_data(),
+        y0->pos_gradient.theta_data(), y0->pos_gradient.phi_data() } ;
+    const double* g1[3] = { y1->pos_gradient.rho_data(),
+        y1->pos_gradient.theta_data(), y1->pos_gradient.phi_data() } ;
+    const double* g2[3] = { y2->pos_gradient.rho_data(),
+        y2->pos_gradient.theta_data(), y2->pos_gradient.phi_data() } ;
+    const double* p2[3] = { y2->position.rho_data(),
+        y2->position.theta_data(), y2->position.phi_data() } ;
+    double* p3[3] = { y3->position.rho_data(),
+        y3->position.theta_data(), y3->position.phi_data() } ;
+    double* distance = &y3->distance.data()[0] ;
+
+    for ( size_t n=0 ; n < active.size() ; ++n ) {
+        const size_t i = active[n] ;
+        double delta[3] ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            delta[k] = weight[2] * g2[k][i] + weight[1] * g1[k][i]
+                     + weight[0] * g0[k][i] ;
+        }
+        const double rho = p2[0][i] ;
+        const double r_theta = rho * delta[1] ;
+        const double r_phi = rho * ( sin( p2[1][i] ) * delta[2] ) ;
+        distance[i] = sqrt( delta[0] * delta[0] + r_theta * r_theta
+                          + r_phi * r_phi ) ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            p3[k][i] = p2[k][i] + delta[k] ;
+        }
+    }
+}
+
+/**
+ * Variable step Adams-Bashforth (3rd order) estimate of ndirection
+ * for a list of rays.
+ */
+void ode_integ::ab3_ndir( const double weight[3], wave_front *y0,
+    wave_front *y1, wave_front *y2, wave_front *y3,
+    const std::vector<size_t>& active )
+{
+    const double* g0[3] = { y0->ndir_gradient.rho_data(),
+        y0->ndir_gradient.theta_data(), y0->ndir_gradient.phi_data() } ;
+    const double* g1[3] = { y1->ndir_gradient.rho_data(),
+        y1->ndir_gradient.theta_data(), y1->ndir_gradient.phi_data() } ;
+    const double* g2[3] = { y2->ndir_gradient.rho_data(),
+        y2->ndir_gradient.theta_data(), y2->ndir_gradient.phi_data() } ;
+    const double* d2[3] = { y2->ndirection.rho_data(),
+        y2->ndirection.theta_data(), y2->ndirection.phi_data() } ;
+    double* d3[3] = { y3->ndirection.rho_data(),
+        y3->ndirection.theta_data(), y3->ndirection.phi_data() } ;
+
+    for ( size_t n=0 ; n < active.size() ; ++n ) {
+        const size_t i = active[n] ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            d3[k][i] = d2[k][i] + weight[2] * g2[k][i]
+                     + weight[1] * g1[k][i] + weight[0] * g0[k][i] ;
+        }
+    }
+}
@@ -122,6 +122,111 @@ class USML_DECLSPEC ode_integ {
      */        
     static void ab3_ndir( double dt, wave_front *y0, wave_front *y1, 
         wave_front *y2, wave_front *y3, bool no_alias=true ) ;
+
+    /**
+     * Adams-Bashforth (3rd order) estimate of position for a list
+     * of rays.  Produces the same results as the whole wavefront version
+     * for those rays, and leaves all other rays unchanged.
+     *
+     * @param  dt       Time step
+     * @param  y0       Position of wavefront 2 iterations ago (input).
+     * @param  y1       Position of wavefront 1 iteration ago (input).
+     * @param  y2       Current position estimate (input).
+     * @param  y3       New position estimate (result).
+     * @param  active   Row major index of the rays to integrate.
+     */
+    static void ab3_pos( double dt, wave_front *y0, wave_front *y1,
+        wave_front *y2, wave_front *y3, const std::vector<size_t>& active ) ;
+
+    /**
+     * Adams-Bashforth (3rd order) estimate of ndirection for a list
+     * of rays.  Produces the same results as the whole wavefront version
+     * for those rays, and leaves all other rays unchanged.
+     *
+     * @param  dt       Time step
+     * @param  y0       Direction of wavefront 2 iterations ago (input).
+     * @param  y1       Direction of wavefront 1 iteration ago (input).
+     * @param  y2       Current ndirection estimate (input).
+     * @param  y3       New ndirection estimate (result).
+     * @param  active   Row major index of the rays to integrate.
+     */
+    static void ab3_ndir( double dt, wave_front *y0, wave_front *y1,
+        wave_front *y2, wave_front *y3, const std::vector<size_t>& active ) ;
+
+    /**
+     * Weights of the variable step Adams-Bashforth (3rd order) method.
+     * Integrates the quadratic through the derivatives at the last three
+     * wavefronts across the new time step. Reduces to dt * (5,-16,23) / 12
+     * when all three steps are equal.
+     *
+     * @param  dt        New time step, from y2 to y3.
+     * @param  prev_step Time step from y1 to y2.
+     * @param  past_step Time step from y0 to y1.
+     * @param  weight    Weights for the y0, y1, and y2 derivatives (result).
+     */
+    static void ab3_weights( double dt, double prev_step, double past_step,
+        double weight[3] ) ;
+
+    /**
+     * Variable step Adams-Bashforth (3rd order) estimate of position.
+     * Includes calculation of distance between current and new positions.
+     *
+     * @param  weight   Weights for the y0, y1, and y2 derivatives,
+     *                  from ab3_weights().
+     * @param  y0       Position of wavefront 2 iterations ago (input).
+     * @param  y1       Position of wavefront 1 iteration ago (input).
+     * @param  y2       Current position estimate (input).
+     * @param  y3       New position estimate (result).
+     * @param  no_alias Use uBLAS noalias() assignment speed-up if true.
+     */
+    static void ab3_pos( const double weight[3], wave_front *y0,
+        wave_front *y1, wave_front *y2, wave_front *y3, bool no_alias=true ) ;
+
+    /**
+     * Variable step Adams-Bashforth (3rd order) estimate of ndirection.
+     *
+     * @param  weight   Weights for the y0, y1, and y2 derivatives,
+     *                  from ab3_weights().
+     * @param  y0       Direction of wavefront 2 iterations ago (input).
+     * @param  y1       Direction of wavefront 1 iteration ago (input).
+     * @param  y2       Current ndirection estimate (input).
+     * @param  y3       New ndirection estimate (result).
+     * @param  no_alias Use uBLAS noalias() assignment speed-up if true.
+     */
+    static void ab3_ndir( const double weight[3], wave_front *y0,
+        wave_front *y1, wave_front *y2, wave_front *y3, bool no_alias=true ) ;
+
+    /**
+     * Variable step Adams-Bashforth (3rd order) estimate of position
+     * for a list of rays.
+     *
+     * @param  weight   Weights for the y0, y1, and y2 derivatives,
+     *                  from ab3_weights().
+     * @param  y0       Position of wavefront 2 iterations ago (input).
+     * @param  y1       Position of wavefront 1 iteration ago (input).
+     * @param  y2       Current position estimate (input).
+     * @param  y3       New position estimate (result).
+     * @param  active   Row major index of the rays to integrate.
+     */
+    static void ab3_pos( const double weight[3], wave_front *y0,
+        wave_front *y1, wave_front *y2, wave_front *y3,
+        const std::vector<size_t>& active ) ;
+
+    /**
+     * Variable step Adams-Bashforth (3rd order) estimate of ndirection
+     * for a list of rays.
+     *
+     * @param  weight   Weights for the y0, y1, and y2 derivatives,
+     *                  from ab3_weights().
+     * @param  y0       Direction of wavefront 2 iterations ago (input).
+     * @param  y1       Direction of wavefront 1 iteration ago (input).
+     * @param  y2       Current ndirection estimate (input).
+     * @param  y3       New ndirection estimate (result).
+     * @param  active   Row major index of the rays to integrate.
+     */
+    static void ab3_ndir( const double weight[3], wave_front *y0,
+        wave_front *y1, wave_front *y2, wave_front *y3,
+        const std::vector<size_t>& active ) ;
 } ;
 
 }  // end of namespace waveq3d
@@ -111,10 +111,8 @@ bool reflection_model::bottom_reflection( size_t de, size_t az, double depth ) {
     vector<double> phase( _wave._frequencies->size() ) ;
     boundary.reflect_loss(
         position, *(_wave._frequencies), grazing, &amplitude, &phase ) ;
-    for ( size_t f=0 ; f < _wave._frequencies->size() ; ++f ) {
-        _wave._next->attenuation(de,az)(f) += amplitude(f) ;
-        _wave._next->phase(de,az)(f) += phase(f) ;
-    }
+    _wave._next->attenuation(de,az) += amplitude ;
+    _wave._next->phase(de,az) += phase ;
 
     // change direction of the ray ( R = I - 2 dot(n,I) n )
     // and reinit past, prev, curr, next entries
@@ -175,9 +173,10 @@ bool reflection_model::surface_reflection( size_t de, size_t az ) {
     vector<double> amplitude( _wave._frequencies->size() ) ;
     boundary.reflect_loss(
         position, *(_wave._frequencies), grazing, &amplitude ) ;
+    _wave._next->attenuation(de,az) += amplitude ;
+    spectral_matrix::reference next_phase = _wave._next->phase(de,az) ;
     for ( size_t f=0 ; f < _wave._frequencies->size() ; ++f ) {
-        _wave._next->attenuation(de,az)(f) += amplitude(f) ;
-        _wave._next->phase(de,az)(f) -= M_PI ;
+        next_phase(f) -= M_PI ;
     }
 
     // change direction of the ray ( Rz = -Iz )
@@ -234,8 +233,9 @@ void reflection_model::reflection_reinit(
 
     // Runge-Kutta to estimate prev wavefront from curr entry
     // adapted from wave_queue::init_wavefronts()
+    // uses the actual time steps between the wavefronts in the queue
 
-    double time_step = _wave._time_step ;
+    double time_step = _wave._prev_step ;
     ode_integ::rk1_pos(  - time_step, &curr, &next ) ;
     ode_integ::rk1_ndir( - time_step, &curr, &next ) ;
     next.update() ;
@@ -252,6 +252,8 @@ void reflection_model::reflection_reinit(
     // Runge-Kutta to estimate past wavefront from prev entry
     // adapted from wave_queue::init_wavefronts()
 
+    time_step = _wave._past_step ;
+
     ode_integ::rk1_pos(  - time_step, &prev, &next ) ;
     ode_integ::rk1_ndir( - time_step, &prev, &next ) ;
     next.update() ;
@@ -269,8 +271,18 @@ void reflection_model::reflection_reinit(
     // from past, prev, and curr entries
     // adapted from wave_queue::init_wavefronts()
 
-    ode_integ::ab3_pos(  time_step, &past, &prev, &curr, &next ) ;
-    ode_integ::ab3_ndir( time_step, &past, &prev, &curr, &next ) ;
+    if ( _wave._past_step == _wave._prev_step
+      && _wave._prev_step == _wave._time_step )
+    {
+        ode_integ::ab3_pos(  _wave._time_step, &past, &prev, &curr, &next ) ;
+        ode_integ::ab3_ndir( _wave._time_step, &past, &prev, &curr, &next ) ;
+    } else {
+        double weight[3] ;
+        ode_integ::ab3_weights( _wave._time_step, _wave._prev_step,
+            _wave._past_step, weight ) ;
+        ode_integ::ab3_pos(  weight, &past, &prev, &curr, &next ) ;
+        ode_integ::ab3_ndir( weight, &past, &prev, &curr, &next ) ;
+    }
     next.update() ;
     reflection_copy( _wave._next, de, az, next ) ;
 }
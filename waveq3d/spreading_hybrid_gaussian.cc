@@ -387,7 +387,7 @@ double spreading_hybrid_gaussian::width_de(
 
     // compute relative offsets in time (u) and azimuth (v)
 
-    const double u = fabs(offset(0)) / _wave._time_step;
+    const double u = fabs(offset(0)) / _wave.stencil_step(offset(0));
     const double v = fabs(offset(2)) / (*_wave._source_az).increment(az);
 
     // compute the DE width for the current time step
@@ -448,7 +448,7 @@ double spreading_hybrid_gaussian::width_az(
     double L1, L2, length1, length2 ;
     // compute relative offsets in time (u) and D/E (v)
 
-    const double u = fabs(offset(0)) / _wave._time_step ;
+    const double u = fabs(offset(0)) / _wave.stencil_step(offset(0)) ;
     const double v = fabs(offset(1)) / (*_wave._source_de).increment(de) ;
 
     // compute the AZ width for the current time step
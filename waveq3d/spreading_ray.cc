@@ -25,7 +25,7 @@ spreading_ray::spreading_ray(wave_queue& wave) :
     for (size_t a = 0; a < wave._source_az->size() - 1; ++a) {
         _init_area(wave.num_de() - 1, a) = _init_area(wave.num_de() - 2, a);
     }
-    _init_sound_speed = _wave._curr->sound_speed(0, 0);
+    _init_sound_speed = _wave._source_speed;
 }
 
 /**
@@ -90,7 +90,7 @@ const vector<double>& spreading_ray::intensity(
         area2 = t2p1.area(t2p2, t2p3, t2p4);
     }
 
-    double u = fabs(offset(0)) / _wave._time_step;
+    double u = fabs(offset(0)) / _wave.stencil_step(offset(0));
     const double area = (1.0 - u) * area1 + u * area2;
 //    cout << " area1=" << area1 << " area2=" << area2
 //         << " u=" << u << " area=" << area << endl ;
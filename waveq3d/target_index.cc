@@ -0,0 +1,54 @@
+/**
+ * @file target_index.cc
+ * Spatial index of eigenray target locations.
+ */
+#include <usml/waveq3d/target_index.h>
+#include <iterator>
+
+using namespace usml::waveq3d ;
+
+/**
+ * Builds an index for all of the targets in a wposition.
+ */
+target_index::target_index( const wposition& targets ) :
+    _tree( make_values( targets ) )
+{
+}
+
+/**
+ * Creates the list of target locations used to pack the tree.
+ */
+std::vector<target_index::value_type> target_index::make_values(
+    const wposition& targets )
+{
+    std::vector<value_type> values ;
+    values.reserve( targets.size1() * targets.size2() ) ;
+    double xyz[3] ;
+    for ( size_t t1=0 ; t1 < targets.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < targets.size2() ; ++t2 ) {
+            cartesian( targets.rho(t1,t2), targets.theta(t1,t2),
+                       targets.phi(t1,t2), xyz ) ;
+            values.push_back( value_type(
+                point_type( xyz[0], xyz[1], xyz[2] ),
+                t1 * targets.size2() + t2 ) ) ;
+        }
+    }
+    return values ;
+}
+
+/**
+ * Finds all of the targets inside of a box centered on a point.
+ */
+void target_index::query( const double center[3], double radius,
+                          std::vector<size_t>* found ) const
+{
+    const box_type box(
+        point_type( center[0]-radius, center[1]-radius, center[2]-radius ),
+        point_type( center[0]+radius, center[1]+radius, center[2]+radius ) ) ;
+    std::vector<value_type> hits ;
+    _tree.query( boost::geometry::index::intersects(box),
+                 std::back_inserter(hits) ) ;
+    for ( size_t n=0 ; n < hits.size() ; ++n ) {
+        found->push_back( hits[n].second ) ;
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file target_index.h
+ * Spatial index of eigenray target locations.
+ */
+#pragma once
+
+#include <usml/types/types.h>
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <vector>
+
+namespace usml {
+namespace waveq3d {
+
+using namespace usml::types ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Spatial index of eigenray target locations.  Stores the earth centered
+ * cartesian coordinates of each target in an R-tree, so that the eigenray
+ * search can find the targets near a wavefront cell without computing
+ * the distance from every target to every ray.  Targets are identified
+ * by their row major index t1*size2+t2 in the wposition used to build
+ * the index.
+ *
+ * Targets do not move during a propagation run, so the tree is built once
+ * with the packing algorithm and then only queried.  Queries are read-only,
+ * and can be made from multiple threads at the same time.
+ */
+class USML_DECLSPEC target_index {
+
+  public:
+
+    /**
+     * Builds an index for all of the targets in a wposition.
+     *
+     * @param  targets  Location of each eigenray target.
+     */
+    target_index( const wposition& targets ) ;
+
+    /**
+     * Finds all of the targets inside of a box that is centered on
+     * a specific point.  Results are appended to the output list
+     * in no particular order.
+     *
+     * @param  center   Earth centered cartesian coordinates of the
+     *                  center of the box (meters).
+     * @param  radius   Half width of the box in each direction (meters).
+     * @param  found    Row major index of each target in the box (output).
+     */
+    void query( const double center[3], double radius,
+                std::vector<size_t>* found ) const ;
+
+    /**
+     * Converts spherical earth coordinates into earth centered
+     * cartesian coordinates.
+     *
+     * @param  rho      Distance from the center of the earth (meters).
+     * @param  theta    Colatitude (radians).
+     * @param  phi      Longitude (radians).
+     * @param  xyz      Earth centered cartesian coordinates (output).
+     */
+    static inline void cartesian( double rho, double theta, double phi,
+                                  double xyz[3] )
+    {
+        const double r = rho * sin( theta ) ;
+        xyz[0] = r * cos( phi ) ;
+        xyz[1] = r * sin( phi ) ;
+        xyz[2] = rho * cos( theta ) ;
+    }
+
+  private:
+
+    typedef boost::geometry::model::point<double, 3,
+        boost::geometry::cs::cartesian> point_type ;
+    typedef boost::geometry::model::box<point_type> box_type ;
+    typedef std::pair<point_type, size_t> value_type ;
+    typedef boost::geometry::index::rtree<value_type,
+        boost::geometry::index::rstar<16,4> > tree_type ;
+
+    /** R-tree of target locations. */
+    tree_type _tree ;
+
+    /**
+     * Creates the list of target locations used to pack the tree.
+     */
+    static std::vector<value_type> make_values( const wposition& targets ) ;
+};
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
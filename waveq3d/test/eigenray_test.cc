@@ -872,6 +872,714 @@ BOOST_AUTO_TEST_CASE( eigenray_interpolate ) {
     }
 }
 
+/**
+ * Compare the eigenrays computed by a single threaded wave_queue to the
+ * eigenrays computed when the ray fan is split across multiple threads.
+ * Uses the eigenray_basic scenario, with a 2x3 grid of targets at
+ * different ranges and depths, so that eigenrays are found in several
+ * different blocks of D/E rows.  Splitting the fan must not change
+ * the number, the order, or the values of the eigenrays.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_threads ) {
+    cout << "=== eigenray_test: eigenray_threads ===" << endl;
+    const double src_alt = -1000.0;
+    const double time_max = 3.5;
+
+    wposition::compute_earth_radius( src_lat );
+    attenuation_model* attn = new attenuation_constant(0.0);
+    profile_model* profile = new profile_linear(c0,attn);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(3000.0);
+    ocean_model ocean( surface, bottom, profile );
+
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, src_alt );
+    seq_linear de( -60.0, 5.0, 60.0 );
+    seq_linear az( -4.0, 1.0, 4.0 );
+
+    wposition target( 2, 3, 0.0, src_lng, 0.0 );
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            target.latitude( t1, t2, src_lat + 0.01 * (t2+1) ) ;
+            target.altitude( t1, t2, -500.0 * (t1+1) ) ;
+        }
+    }
+
+    eigenray_collection serial(freq, pos, de, az, time_step, &target);
+    eigenray_collection parallel(freq, pos, de, az, time_step, &target);
+    wave_queue wave1( ocean, freq, pos, de, az, time_step, &target) ;
+    wave_queue wave4( ocean, freq, pos, de, az, time_step, &target) ;
+    wave1.add_eigenray_listener(&serial);
+    wave4.add_eigenray_listener(&parallel);
+    wave4.num_threads(4) ;
+    BOOST_CHECK_EQUAL( wave1.num_threads(), 1 ) ;
+    BOOST_CHECK_EQUAL( wave4.num_threads(), 4 ) ;
+
+    while ( wave1.time() < time_max ) {
+        wave1.step();
+        wave4.step();
+    }
+
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const eigenray_list* list1 = serial.eigenrays(t1,t2) ;
+            const eigenray_list* list4 = parallel.eigenrays(t1,t2) ;
+            BOOST_CHECK( list1->size() >= 2 ) ;
+            BOOST_CHECK_EQUAL( list1->size(), list4->size() ) ;
+            eigenray_list::const_iterator iter1 = list1->begin() ;
+            eigenray_list::const_iterator iter4 = list4->begin() ;
+            for ( ; iter1 != list1->end() && iter4 != list4->end() ;
+                  ++iter1, ++iter4 )
+            {
+                BOOST_CHECK_EQUAL( iter1->time, iter4->time ) ;
+                BOOST_CHECK_EQUAL( iter1->source_de, iter4->source_de ) ;
+                BOOST_CHECK_EQUAL( iter1->source_az, iter4->source_az ) ;
+                BOOST_CHECK_EQUAL( iter1->intensity(0), iter4->intensity(0) ) ;
+                BOOST_CHECK_EQUAL( iter1->phase(0), iter4->phase(0) ) ;
+            }
+        }
+    }
+}
+
+/**
+ * Compare the eigenrays computed by an exhaustive search of every target
+ * and ray to the eigenrays computed when the search uses a spatial index
+ * of the targets. Uses a full 360 degree azimuthal fan, with a 4x6 grid
+ * of targets in different directions, ranges, and depths. Target (0,0)
+ * is directly below the source to exercise the D/E branch point logic.
+ * The index must not change the number, the order, or the values
+ * of the eigenrays, with or without multiple threads.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_target_index ) {
+    cout << "=== eigenray_test: eigenray_target_index ===" << endl;
+    const double src_alt = -1000.0;
+    const double time_max = 3.5;
+
+    wposition::compute_earth_radius( src_lat );
+    attenuation_model* attn = new attenuation_constant(0.0);
+    profile_model* profile = new profile_linear(c0,attn);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(3000.0);
+    ocean_model ocean( surface, bottom, profile );
+
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, src_alt );
+    seq_linear de( -80.0, 5.0, 80.0 );
+    seq_linear az( 0.0, 15.0, 360.0 );
+
+    wposition target( 4, 6, src_lat, src_lng, 0.0 );
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const double range = 0.004 * ( t1 + t2 ) ;
+            const double bearing = to_radians( 55.0 * t2 + 10.0 * t1 ) ;
+            target.latitude( t1, t2, src_lat + range * cos(bearing) ) ;
+            target.longitude( t1, t2, src_lng + range * sin(bearing) ) ;
+            target.altitude( t1, t2, -400.0 * (t1+1) - 100.0 * t2 ) ;
+        }
+    }
+
+    eigenray_collection exhaustive(freq, pos, de, az, time_step, &target);
+    eigenray_collection indexed(freq, pos, de, az, time_step, &target);
+    eigenray_collection parallel(freq, pos, de, az, time_step, &target);
+    wave_queue wave1( ocean, freq, pos, de, az, time_step, &target) ;
+    wave_queue wave2( ocean, freq, pos, de, az, time_step, &target) ;
+    wave_queue wave3( ocean, freq, pos, de, az, time_step, &target) ;
+    wave1.add_eigenray_listener(&exhaustive);
+    wave2.add_eigenray_listener(&indexed);
+    wave3.add_eigenray_listener(&parallel);
+    wave2.use_target_index(true) ;
+    wave3.use_target_index(true) ;
+    wave3.num_threads(3) ;
+    BOOST_CHECK( ! wave1.use_target_index() ) ;
+    BOOST_CHECK( wave2.use_target_index() ) ;
+
+    while ( wave1.time() < time_max ) {
+        wave1.step();
+        wave2.step();
+        wave3.step();
+    }
+
+    size_t total = 0 ;
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const eigenray_list* list1 = exhaustive.eigenrays(t1,t2) ;
+            const eigenray_list* list2 = indexed.eigenrays(t1,t2) ;
+            const eigenray_list* list3 = parallel.eigenrays(t1,t2) ;
+            total += list1->size() ;
+            BOOST_CHECK_EQUAL( list1->size(), list2->size() ) ;
+            BOOST_CHECK_EQUAL( list1->size(), list3->size() ) ;
+            eigenray_list::const_iterator iter1 = list1->begin() ;
+            eigenray_list::const_iterator iter2 = list2->begin() ;
+            eigenray_list::const_iterator iter3 = list3->begin() ;
+            for ( ; iter1 != list1->end() && iter2 != list2->end()
+                    && iter3 != list3->end() ; ++iter1, ++iter2, ++iter3 )
+            {
+                BOOST_CHECK_EQUAL( iter1->time, iter2->time ) ;
+                BOOST_CHECK_EQUAL( iter1->source_de, iter2->source_de ) ;
+                BOOST_CHECK_EQUAL( iter1->source_az, iter2->source_az ) ;
+                BOOST_CHECK_EQUAL( iter1->intensity(0), iter2->intensity(0) ) ;
+                BOOST_CHECK_EQUAL( iter1->time, iter3->time ) ;
+                BOOST_CHECK_EQUAL( iter1->source_de, iter3->source_de ) ;
+                BOOST_CHECK_EQUAL( iter1->source_az, iter3->source_az ) ;
+                BOOST_CHECK_EQUAL( iter1->intensity(0), iter3->intensity(0) ) ;
+            }
+        }
+    }
+    BOOST_CHECK( total > 2 * target.size1() * target.size2() ) ;
+}
+
+/**
+ * Count the calls to each phase of the propagation step, and the number
+ * of eigenrays and reflections, using the wave_profiler. Uses the same
+ * scenario as the eigenray_threads test. The call counts must match the
+ * number of steps and the number of eigenrays in the collection, and the
+ * counters must not change while the profiler is disabled.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_profiler ) {
+    cout << "=== eigenray_test: eigenray_profiler ===" << endl;
+    const char* jsonname = USML_TEST_DIR "/waveq3d/test/eigenray_profiler.json";
+    const double src_alt = -1000.0;
+    const double time_max = 3.5;
+
+    wposition::compute_earth_radius( src_lat );
+    attenuation_model* attn = new attenuation_constant(0.0);
+    profile_model* profile = new profile_linear(c0,attn);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(3000.0);
+    ocean_model ocean( surface, bottom, profile );
+
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, src_alt );
+    seq_linear de( -60.0, 5.0, 60.0 );
+    seq_linear az( -4.0, 1.0, 4.0 );
+
+    wposition target( 2, 3, 0.0, src_lng, 0.0 );
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            target.latitude( t1, t2, src_lat + 0.01 * (t2+1) ) ;
+            target.altitude( t1, t2, -500.0 * (t1+1) ) ;
+        }
+    }
+
+    eigenray_collection loss(freq, pos, de, az, time_step, &target);
+    wave_queue wave( ocean, freq, pos, de, az, time_step, &target) ;
+    wave.add_eigenray_listener(&loss);
+
+    BOOST_CHECK( ! wave_profiler::enabled() ) ;
+    wave_profiler::reset() ;
+    wave_profiler::enable( true ) ;
+    size_t num_steps = 0 ;
+    while ( wave.time() < time_max ) {
+        wave.step();
+        ++num_steps ;
+    }
+    wave_profiler::enable( false ) ;
+    const wave_profiler::statistics_type stats = wave_profiler::statistics() ;
+    wave.step() ;
+    std::ofstream json( jsonname ) ;
+    wave_profiler::write_json( json ) ;
+
+    // compare counters to the number of steps and eigenrays
+
+    size_t num_rays = 0 ;
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            num_rays += loss.eigenrays(t1,t2)->size() ;
+        }
+    }
+    BOOST_CHECK( num_rays > 0 ) ;
+    BOOST_CHECK_EQUAL( stats.events[wave_profiler::WAVE_STEPS], num_steps ) ;
+    BOOST_CHECK_EQUAL( stats.events[wave_profiler::EIGENRAYS], num_rays ) ;
+    BOOST_CHECK( stats.events[wave_profiler::SURFACE_REFLECTIONS] > 0 ) ;
+    BOOST_CHECK( stats.events[wave_profiler::BOTTOM_REFLECTIONS] > 0 ) ;
+    BOOST_CHECK_EQUAL( stats.phases[wave_profiler::WAVE_UPDATE].calls, num_steps ) ;
+    BOOST_CHECK_EQUAL( stats.phases[wave_profiler::DETECT_REFLECTIONS].calls, num_steps ) ;
+    BOOST_CHECK_EQUAL( stats.phases[wave_profiler::DETECT_EIGENRAYS].calls, num_steps ) ;
+    BOOST_CHECK( stats.phases[wave_profiler::BUILD_EIGENRAY].calls >= num_rays ) ;
+    BOOST_CHECK_EQUAL( stats.phases[wave_profiler::SPREADING].calls,
+                       stats.phases[wave_profiler::BUILD_EIGENRAY].calls ) ;
+    BOOST_CHECK( stats.phases[wave_profiler::WAVE_UPDATE].seconds > 0.0 ) ;
+    BOOST_CHECK( stats.phases[wave_profiler::DETECT_EIGENRAYS].seconds
+              >= stats.phases[wave_profiler::BUILD_EIGENRAY].seconds ) ;
+
+    // counters must not change while disabled
+
+    const wave_profiler::statistics_type after = wave_profiler::statistics() ;
+    BOOST_CHECK( ! after.enabled ) ;
+    BOOST_CHECK_EQUAL( after.events[wave_profiler::WAVE_STEPS], num_steps ) ;
+    BOOST_CHECK_EQUAL( after.phases[wave_profiler::WAVE_UPDATE].calls, num_steps ) ;
+    wave_profiler::reset() ;
+}
+
+/**
+ * Compare the propagation loss summed over the eigenrays in parallel,
+ * with 4 threads, to the serial sum, and to a direct implementation of
+ * the coherent and incoherent sums.  Uses synthetic eigenrays on a 3x4
+ * grid of targets, with a different number of eigenrays at each target,
+ * at three frequencies.  The number of threads must not change the
+ * result.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_sum_threads ) {
+    cout << "=== eigenray_test: eigenray_sum_threads ===" << endl;
+    seq_linear freq( 1000.0, 500.0, 3 );
+    wposition1 pos( src_lat, src_lng, -100.0 );
+    seq_linear de( -10.0, 10.0, 10.0 );
+    seq_linear az( 0.0, 10.0, 10.0 );
+    wposition target( 3, 4, src_lat, src_lng, -100.0 );
+
+    eigenray_collection serial(freq, pos, de, az, time_step, &target);
+    eigenray_collection parallel(freq, pos, de, az, time_step, &target);
+    parallel.num_threads(4) ;
+    BOOST_CHECK_EQUAL( serial.num_threads(), 1 ) ;
+    BOOST_CHECK_EQUAL( parallel.num_threads(), 4 ) ;
+
+    eigenray ray ;
+    ray.frequencies = &freq ;
+    ray.intensity.resize( freq.size() ) ;
+    ray.phase.resize( freq.size() ) ;
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const size_t num_rays = 1 + ( 3 * t1 + t2 ) % 5 ;
+            for ( size_t n=0 ; n < num_rays ; ++n ) {
+                const double k = n + 10.0 * t1 + 3.0 * t2 ;
+                ray.time = 1.0 + 0.137 * k ;
+                for ( size_t f=0 ; f < freq.size() ; ++f ) {
+                    ray.intensity(f) = 60.0 + 3.0 * n + f + 0.1 * k ;
+                    ray.phase(f) = ( n % 2 ) ? -M_PI_2 : 0.0 ;
+                }
+                ray.source_de = -20.0 + 7.0 * n ;
+                ray.source_az = 350.0 + 13.0 * n ;
+                ray.target_de = 20.0 - 7.0 * n ;
+                ray.target_az = 170.0 + 13.0 * n ;
+                ray.surface = (int) n ;
+                ray.bottom = (int) ( n / 2 ) ;
+                ray.caustic = 0 ;
+                serial.add_eigenray( t1, t2, ray, 0 ) ;
+                parallel.add_eigenray( t1, t2, ray, 0 ) ;
+            }
+        }
+    }
+
+    for ( int coherent=1 ; coherent >= 0 ; --coherent ) {
+        serial.sum_eigenrays( coherent != 0 ) ;
+        parallel.sum_eigenrays( coherent != 0 ) ;
+        for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+            for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+                const eigenray* loss1 = serial.total(t1,t2) ;
+                const eigenray* loss4 = parallel.total(t1,t2) ;
+
+                // direct sum over the eigenray list
+
+                double wgt = 0.0, time = 0.0, max_a = 0.0 ;
+                int surface = -1 ;
+                for ( size_t f=0 ; f < freq.size() ; ++f ) {
+                    std::complex<double> phasor( 0.0, 0.0 ) ;
+                    double power = 0.0 ;
+                    const eigenray_list* list = serial.eigenrays(t1,t2) ;
+                    for ( eigenray_list::const_iterator iter = list->begin() ;
+                          iter != list->end() ; ++iter )
+                    {
+                        const double a = pow( 10.0, iter->intensity(f) / -20.0 ) ;
+                        const double p = TWO_PI * freq(f) * iter->time
+                                       + iter->phase(f) ;
+                        phasor += std::complex<double>( a * cos(p), a * sin(p) ) ;
+                        power += a * a ;
+                        wgt += a * a ;
+                        time += a * a * iter->time ;
+                        if ( a * a > max_a ) {
+                            max_a = a * a ;
+                            surface = iter->surface ;
+                        }
+                    }
+                    const double level = coherent ?
+                        -20.0 * log10( abs(phasor) ) : -10.0 * log10( power ) ;
+                    BOOST_CHECK_CLOSE( loss1->intensity(f), level, 1e-8 ) ;
+                    if ( coherent ) {
+                        BOOST_CHECK_SMALL( sin( loss1->phase(f) - arg(phasor) ), 1e-8 ) ;
+                    } else {
+                        BOOST_CHECK_EQUAL( loss1->phase(f), 0.0 ) ;
+                    }
+                    BOOST_CHECK_EQUAL( loss1->intensity(f), loss4->intensity(f) ) ;
+                    BOOST_CHECK_EQUAL( loss1->phase(f), loss4->phase(f) ) ;
+                }
+                BOOST_CHECK_CLOSE( loss1->time, time / wgt, 1e-8 ) ;
+                BOOST_CHECK_EQUAL( loss1->surface, surface ) ;
+                BOOST_CHECK_EQUAL( loss1->time, loss4->time ) ;
+                BOOST_CHECK_EQUAL( loss1->source_de, loss4->source_de ) ;
+                BOOST_CHECK_EQUAL( loss1->source_az, loss4->source_az ) ;
+                BOOST_CHECK_EQUAL( loss1->target_de, loss4->target_de ) ;
+                BOOST_CHECK_EQUAL( loss1->target_az, loss4->target_az ) ;
+                BOOST_CHECK_EQUAL( loss1->surface, loss4->surface ) ;
+                BOOST_CHECK_EQUAL( loss1->bottom, loss4->bottom ) ;
+            }
+        }
+    }
+}
+
+/**
+ * Compare the eigenrays computed by integrating every ray in the fan to
+ * the eigenrays computed when only the first AZ column is integrated and
+ * the other columns are rotated copies of it. Uses the eigenray_target_index
+ * scenario, a flat bottom linear profile ocean with a full 360 degree
+ * azimuthal fan and targets in many different directions. The symmetric
+ * fast path must find the same eigenrays, with travel times and angles
+ * that agree to within round off, and intensities within 1e-6 dB.
+ * Also checks that a sloping bottom is not considered range independent.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_symmetry ) {
+    cout << "=== eigenray_test: eigenray_symmetry ===" << endl;
+    const double src_alt = -1000.0;
+    const double time_max = 3.5;
+
+    wposition::compute_earth_radius( src_lat );
+    attenuation_model* attn = new attenuation_constant(0.0);
+    profile_model* profile = new profile_linear(c0,attn);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(3000.0);
+    ocean_model ocean( surface, bottom, profile );
+
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, src_alt );
+    seq_linear de( -80.0, 5.0, 80.0 );
+    seq_linear az( 0.0, 15.0, 360.0 );
+
+    wposition target( 4, 6, src_lat, src_lng, 0.0 );
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const double range = 0.004 * ( t1 + t2 ) ;
+            const double bearing = to_radians( 55.0 * t2 + 10.0 * t1 ) ;
+            target.latitude( t1, t2, src_lat + range * cos(bearing) ) ;
+            target.longitude( t1, t2, src_lng + range * sin(bearing) ) ;
+            target.altitude( t1, t2, -400.0 * (t1+1) - 100.0 * t2 ) ;
+        }
+    }
+
+    eigenray_collection full(freq, pos, de, az, time_step, &target);
+    eigenray_collection symmetric(freq, pos, de, az, time_step, &target);
+    wave_queue wave1( ocean, freq, pos, de, az, time_step, &target) ;
+    wave_queue wave2( ocean, freq, pos, de, az, time_step, &target) ;
+    wave1.add_eigenray_listener(&full);
+    wave2.add_eigenray_listener(&symmetric);
+    BOOST_CHECK( wave_queue::is_range_independent( ocean ) ) ;
+    wave2.use_azimuthal_symmetry(true) ;
+    BOOST_CHECK( ! wave1.use_azimuthal_symmetry() ) ;
+    BOOST_CHECK( wave2.use_azimuthal_symmetry() ) ;
+
+    while ( wave1.time() < time_max ) {
+        wave1.step();
+        wave2.step();
+    }
+
+    size_t total = 0 ;
+    for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+        for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+            const eigenray_list* list1 = full.eigenrays(t1,t2) ;
+            const eigenray_list* list2 = symmetric.eigenrays(t1,t2) ;
+            total += list1->size() ;
+            BOOST_CHECK_EQUAL( list1->size(), list2->size() ) ;
+            eigenray_list::const_iterator iter1 = list1->begin() ;
+            eigenray_list::const_iterator iter2 = list2->begin() ;
+            for ( ; iter1 != list1->end() && iter2 != list2->end() ;
+                  ++iter1, ++iter2 )
+            {
+                BOOST_CHECK_CLOSE( iter1->time, iter2->time, 1e-8 ) ;
+                BOOST_CHECK_SMALL( iter1->source_de - iter2->source_de, 1e-6 ) ;
+                BOOST_CHECK_SMALL( iter1->source_az - iter2->source_az, 1e-6 ) ;
+                BOOST_CHECK_SMALL( iter1->target_de - iter2->target_de, 1e-6 ) ;
+                BOOST_CHECK_SMALL( iter1->intensity(0) - iter2->intensity(0), 1e-6 ) ;
+                BOOST_CHECK_EQUAL( iter1->surface, iter2->surface ) ;
+                BOOST_CHECK_EQUAL( iter1->bottom, iter2->bottom ) ;
+            }
+        }
+    }
+    BOOST_CHECK( total > 2 * target.size1() * target.size2() ) ;
+
+    // sloping bottom depends on range
+
+    boundary_model* slope = new boundary_slope( pos, 3000.0, to_radians(1.0) ) ;
+    ocean_model sloped( new boundary_flat(), slope, new profile_linear(c0) ) ;
+    BOOST_CHECK( ! wave_queue::is_range_independent( sloped ) ) ;
+}
+
+/**
+ * Deep water scenario shared by the tests that compare the eigenrays
+ * from two different wave_queue configurations.  Uses a Munk profile,
+ * a flat 5000 meter bottom, and a source at 1000 meters depth, with
+ * a 3x3 grid of targets at different ranges and depths, so that the
+ * eigenrays include refracted and bottom reflected paths.
+ */
+struct munk_scenario {
+
+    wposition1 pos ;
+    ocean_model ocean ;
+    seq_log freq ;
+    seq_linear az ;
+    wposition target ;
+
+    /**
+     * Sets the earth radius for the source latitude, before the
+     * boundaries are built, and returns the source location.
+     */
+    static wposition1 source() {
+        wposition::compute_earth_radius( src_lat );
+        return wposition1( src_lat, src_lng, -1000.0 ) ;
+    }
+
+    /**
+     * Builds the ocean and the target grid.  The target latitudes
+     * increase with the column index, and the target depths increase
+     * with the row index, in 500 meter steps.
+     *
+     * @param   first       Latitude of the first column of targets,
+     *                      relative to the source (deg).
+     * @param   spacing     Latitude between columns of targets (deg).
+     */
+    munk_scenario( double first, double spacing ) :
+        pos( source() ),
+        ocean( new boundary_flat(), new boundary_flat(5000.0),
+               new profile_munk(1300.0,1300.0,1500.0,7.37e-3,
+                                new attenuation_constant(0.0)) ),
+        freq( 1000.0, 1.0, 1 ),
+        az( -4.0, 1.0, 4.0 ),
+        target( 3, 3 )
+    {
+        for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+            for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+                target.latitude( t1, t2, src_lat + first + spacing * t2 ) ;
+                target.longitude( t1, t2, src_lng ) ;
+                target.altitude( t1, t2, -500.0 * (t1+1) ) ;
+            }
+        }
+    }
+
+    /**
+     * Searches for each expected eigenray in another collection.  The
+     * match is the eigenray with the same number of surface reflections,
+     * bottom reflections, and caustics, whose launch angle is closest.
+     * Eigenrays launched near the edges of the ray fan are skipped.
+     * The travel time, launch angle, and intensity of each match are
+     * only checked if their tolerances are not zero.
+     *
+     * @param   expected    Eigenrays used as the reference.
+     * @param   actual      Eigenrays to search.
+     * @param   max_de      Largest launch angle compared (deg).
+     * @param   match_de    Largest launch angle error for a match (deg).
+     * @param   total       Number of expected eigenrays compared (output).
+     * @param   time_tol    Largest travel time error (sec).
+     * @param   de_tol      Largest launch angle error (deg).
+     * @param   db_tol      Largest intensity error (dB).
+     * @return              Number of expected eigenrays with no match.
+     */
+    size_t compare( eigenray_collection& expected,
+        eigenray_collection& actual, double max_de, double match_de,
+        size_t* total, double time_tol = 0.0, double de_tol = 0.0,
+        double db_tol = 0.0 ) const
+    {
+        size_t missing = 0 ;
+        *total = 0 ;
+        for ( size_t t1=0 ; t1 < target.size1() ; ++t1 ) {
+            for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+                const eigenray_list* list = actual.eigenrays(t1,t2) ;
+                BOOST_FOREACH( const eigenray& ray1, *expected.eigenrays(t1,t2) ) {
+                    if ( abs(ray1.source_de) > max_de ) continue ;
+                    ++( *total ) ;
+                    const eigenray* match = NULL ;
+                    BOOST_FOREACH( const eigenray& ray2, *list ) {
+                        if ( ray2.surface != ray1.surface
+                          || ray2.bottom != ray1.bottom
+                          || ray2.caustic != ray1.caustic ) continue ;
+                        if ( match == NULL || abs(ray2.source_de-ray1.source_de)
+                                            < abs(match->source_de-ray1.source_de) )
+                        {
+                            match = &ray2 ;
+                        }
+                    }
+                    if ( match == NULL
+                      || abs(match->source_de-ray1.source_de) > match_de )
+                    {
+                        ++missing ;
+                        continue ;
+                    }
+                    if ( time_tol > 0.0 ) {
+                        BOOST_CHECK_SMALL( ray1.time - match->time, time_tol ) ;
+                    }
+                    if ( de_tol > 0.0 ) {
+                        BOOST_CHECK_SMALL( ray1.source_de - match->source_de, de_tol ) ;
+                    }
+                    if ( db_tol > 0.0 ) {
+                        BOOST_CHECK_SMALL( ray1.intensity(0) - match->intensity(0), db_tol ) ;
+                    }
+                }
+            }
+        }
+        return missing ;
+    }
+} ;
+
+/**
+ * Compare the eigenrays computed with a small fixed time step to those
+ * computed with the adaptive time step, in the munk_scenario with
+ * targets at 6 to 17 km. The adaptive time step starts at the same
+ * small value, and must use fewer than a quarter of the steps. Each
+ * eigenray that is not on the edge of the ray fan must be found by both
+ * runs, with the same number of surface reflections, bottom reflections,
+ * and caustics, and with travel times within 1 msec, launch angles within
+ * 0.01 degrees, and intensities within 0.1 dB.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_adaptive_step ) {
+    cout << "=== eigenray_test: eigenray_adaptive_step ===" << endl;
+    const double time_max = 25.0;
+    const double small_step = 0.01;
+    munk_scenario scenario( 0.05, 0.05 ) ;
+    ocean_model& ocean = scenario.ocean ;
+    const seq_vector& freq = scenario.freq ;
+    const wposition1& pos = scenario.pos ;
+    const seq_vector& az = scenario.az ;
+    seq_linear de( -40.0, 1.0, 40.0 );
+
+    eigenray_collection fixed(freq, pos, de, az, small_step, &scenario.target);
+    eigenray_collection adaptive(freq, pos, de, az, small_step, &scenario.target);
+    wave_queue wave1( ocean, freq, pos, de, az, small_step, &scenario.target) ;
+    wave_queue wave2( ocean, freq, pos, de, az, small_step, &scenario.target) ;
+    wave1.add_eigenray_listener(&fixed);
+    wave2.add_eigenray_listener(&adaptive);
+    wave2.use_adaptive_step( 0.001, 0.0, 0.2 ) ;
+    BOOST_CHECK_EQUAL( wave1.step_tolerance(), 0.0 ) ;
+    BOOST_CHECK_EQUAL( wave2.step_tolerance(), 0.001 ) ;
+
+    size_t steps1 = 0 ;
+    while ( wave1.time() < time_max ) {
+        wave1.step();
+        ++steps1 ;
+    }
+    size_t steps2 = 0 ;
+    while ( wave2.time() < time_max ) {
+        wave2.step();
+        ++steps2 ;
+    }
+    cout << "fixed steps " << steps1 << " adaptive steps " << steps2
+         << " rejected " << wave2.num_rejected()
+         << " final step " << wave2.time_step() << endl ;
+    BOOST_CHECK_EQUAL( wave1.time_step(), small_step ) ;
+    BOOST_CHECK( wave2.time_step() > small_step ) ;
+    BOOST_CHECK( 4 * steps2 < steps1 ) ;
+
+    size_t total = 0 ;
+    const size_t missing = scenario.compare( fixed, adaptive, 35.0, 180.0,
+        &total, 1e-3, 0.01, 0.1 ) ;
+    BOOST_CHECK_EQUAL( missing, (size_t) 0 ) ;
+    BOOST_CHECK( total >= 2 * scenario.target.size1() * scenario.target.size2() ) ;
+}
+
+/**
+ * Compares the eigenrays from a coarse ray fan with adaptive refinement to
+ * those from a uniformly dense ray fan, in the munk_scenario with targets
+ * at 22 to 44 km.  The coarse fan, without refinement, is too coarse
+ * to find many of the bottom bounce paths at these ranges.  With
+ * refinement, the coarse fan should find more of the eigenrays in the
+ * dense fan, with similar travel times, launch angles, and intensities,
+ * while integrating fewer rays.  Rays near the edges of the fan are
+ * not compared.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_fan_refinement ) {
+    cout << "=== eigenray_test: eigenray_fan_refinement ===" << endl;
+    const double time_max = 40.0;
+    const double time_step = 0.05;
+    munk_scenario scenario( 0.2, 0.1 ) ;
+    ocean_model& ocean = scenario.ocean ;
+    const seq_vector& freq = scenario.freq ;
+    const wposition1& pos = scenario.pos ;
+    const seq_vector& az = scenario.az ;
+    seq_linear dense_de( -20.0, 0.25, 20.0 );
+    seq_linear coarse_de( -20.0, 1.0, 20.0 );
+
+    eigenray_collection dense(freq, pos, dense_de, az, time_step, &scenario.target);
+    eigenray_collection coarse(freq, pos, coarse_de, az, time_step, &scenario.target);
+    eigenray_collection refined(freq, pos, coarse_de, az, time_step, &scenario.target);
+    wave_queue wave1( ocean, freq, pos, dense_de, az, time_step, &scenario.target) ;
+    wave_queue wave2( ocean, freq, pos, coarse_de, az, time_step, &scenario.target) ;
+    wave_queue wave3( ocean, freq, pos, coarse_de, az, time_step, &scenario.target) ;
+    wave1.add_eigenray_listener(&dense);
+    wave2.add_eigenray_listener(&coarse);
+    wave3.add_eigenray_listener(&refined);
+    wave3.use_fan_refinement( 300.0 ) ;
+    BOOST_CHECK_EQUAL( wave2.fan_tolerance(), 0.0 ) ;
+    BOOST_CHECK_EQUAL( wave3.fan_tolerance(), 300.0 ) ;
+
+    size_t rays1 = 0 ;
+    while ( wave1.time() < time_max ) {
+        wave1.step();
+        rays1 += wave1.num_de() ;
+    }
+    while ( wave2.time() < time_max ) {
+        wave2.step();
+    }
+    size_t rays3 = 0 ;
+    while ( wave3.time() < time_max ) {
+        wave3.step();
+        rays3 += wave3.num_de() ;
+    }
+    cout << "dense rows " << wave1.num_de() << " ray steps " << rays1 << endl
+         << "refined rows " << wave3.num_de() << " ray steps " << rays3
+         << " splits " << wave3.num_splits()
+         << " merges " << wave3.num_merges() << endl ;
+    BOOST_CHECK_EQUAL( wave2.num_de(), coarse_de.size() ) ;
+    BOOST_CHECK_EQUAL( wave2.num_splits(), 0u ) ;
+    BOOST_CHECK( wave3.num_splits() > 0 ) ;
+    BOOST_CHECK_EQUAL( wave3.num_de(), coarse_de.size()
+        + wave3.num_splits() - wave3.num_merges() ) ;
+    BOOST_CHECK( 4 * rays3 < 3 * rays1 ) ;
+
+    // search for each dense eigenray in the coarse and refined results
+
+    size_t total = 0 ;
+    const size_t missing_coarse = scenario.compare( dense, coarse,
+        17.0, 0.5, &total ) ;
+    const size_t missing_refined = scenario.compare( dense, refined,
+        17.0, 0.5, &total, 0.01, 0.25, 1.5 ) ;
+    cout << "dense eigenrays " << total << " missing from coarse "
+         << missing_coarse << " missing from refined " << missing_refined << endl ;
+    BOOST_CHECK( total >= 2 * scenario.target.size1() * scenario.target.size2() ) ;
+    BOOST_CHECK( missing_refined <= 1 ) ;
+    BOOST_CHECK( missing_refined < missing_coarse ) ;
+}
+
+/**
+ * Refines the non-uniform seq_rayfan used by the wavefront_generator,
+ * in the munk_scenario.  Rows added by the refinement may be merged again,
+ * but each launch angle of the original fan must remain in the fan for
+ * the whole propagation, even where the original rays are closer together
+ * than the widest spacing in the fan.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_fan_rayfan ) {
+    cout << "=== eigenray_test: eigenray_fan_rayfan ===" << endl;
+    const double time_max = 40.0;
+    const double time_step = 0.05;
+    munk_scenario scenario( 0.2, 0.1 ) ;
+    seq_rayfan de( -30.0, 30.0, 31 ) ;
+    wave_queue wave( scenario.ocean, scenario.freq, scenario.pos, de,
+        scenario.az, time_step, &scenario.target ) ;
+    wave.use_fan_refinement( 300.0 ) ;
+
+    size_t missing = 0 ;
+    while ( wave.time() < time_max ) {
+        wave.step();
+        size_t n = 0 ;
+        for ( size_t d=0 ; d < de.size() ; ++d ) {
+            while ( n < wave.num_de() && wave.source_de(n) < de(d) - 1e-10 ) {
+                ++n ;
+            }
+            if ( n == wave.num_de() || abs( wave.source_de(n) - de(d) ) > 1e-10 ) {
+                ++missing ;
+            }
+        }
+    }
+    cout << "rows " << wave.num_de() << " splits " << wave.num_splits()
+         << " merges " << wave.num_merges() << endl ;
+    BOOST_CHECK( wave.num_merges() > 0 ) ;
+    BOOST_CHECK_EQUAL( missing, (size_t) 0 ) ;
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
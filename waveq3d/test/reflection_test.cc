@@ -634,6 +634,107 @@ BOOST_AUTO_TEST_CASE( bounce_threshold_test ) {
     }
 
 }
+
+/**
+ * Compares the eigenrays and eigenverbs computed with and without the
+ * retirement of dead rays, in 200 meters of water where most of the steep
+ * rays exceed the bounce thresholds in the first second. Uses the
+ * CLASSIC_RAY spreading model, whose stencil is covered by the halo of
+ * dead rays around each live ray, so the results must be identical.
+ * The number of active rays must also shrink to less than half of the fan.
+ */
+BOOST_AUTO_TEST_CASE( bounce_active_set_test ) {
+    cout << "=== reflection_test: bounce_active_set_test ===" << endl ;
+
+    double depth = 200.0 ;
+    double c0 = 1500.0 ;
+    double dt = 0.1 ;
+    double max_time = 3.0 ;
+
+    seq_linear freq( 900.0, 1.0, 1) ;
+    seq_linear de(-90.0, 2.0, 90.0) ;
+    seq_linear az(0.0, 30.0, 360.0) ;
+    wposition1 src( 0.0, 0.0, -100.0 ) ;
+
+    boundary_model* surface = new boundary_flat() ;
+    boundary_model* bottom = new boundary_flat( depth, new reflect_loss_constant(0.0) ) ;
+    profile_model* profile = new profile_linear( c0 ) ;
+    ocean_model ocean( surface, bottom, profile ) ;
+
+    wposition target( 1, 3, 0.0, 0.0, -100.0 ) ;
+    for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+        target.latitude( 0, t2, 0.01 * (t2+1) ) ;
+    }
+    eigenray_collection full_loss( freq, src, de, az, dt, &target ) ;
+    eigenray_collection active_loss( freq, src, de, az, dt, &target ) ;
+    eigenverb_collection full_reverb( 0 ) ;
+    eigenverb_collection active_reverb( 0 ) ;
+    wave_queue full( ocean, freq, src, de, az, dt, &target, 1,
+        wave_queue::CLASSIC_RAY ) ;
+    wave_queue active( ocean, freq, src, de, az, dt, &target, 1,
+        wave_queue::CLASSIC_RAY ) ;
+    full.add_eigenray_listener(&full_loss) ;
+    full.add_eigenverb_listener(&full_reverb) ;
+    active.add_eigenray_listener(&active_loss) ;
+    active.add_eigenverb_listener(&active_reverb) ;
+    full.max_surface(2) ;
+    full.max_bottom(2) ;
+    active.max_surface(2) ;
+    active.max_bottom(2) ;
+    active.use_active_set(true) ;
+    BOOST_CHECK( active.use_active_set() ) ;
+    BOOST_CHECK_EQUAL( active.num_active(), de.size() * az.size() ) ;
+
+    while ( full.time() < max_time ) {
+        full.step() ;
+        active.step() ;
+    }
+    cout << "active rays " << active.num_active()
+         << " live rays " << active.num_live()
+         << " of " << de.size() * az.size() << endl ;
+    BOOST_CHECK( 2 * active.num_active() < de.size() * az.size() ) ;
+    BOOST_CHECK( active.num_live() < active.num_active() ) ;
+
+    // eigenrays must be identical
+
+    size_t total = 0 ;
+    for ( size_t t2=0 ; t2 < target.size2() ; ++t2 ) {
+        const eigenray_list* list1 = full_loss.eigenrays(0,t2) ;
+        const eigenray_list* list2 = active_loss.eigenrays(0,t2) ;
+        total += list1->size() ;
+        BOOST_CHECK_EQUAL( list1->size(), list2->size() ) ;
+        eigenray_list::const_iterator iter1 = list1->begin() ;
+        eigenray_list::const_iterator iter2 = list2->begin() ;
+        for ( ; iter1 != list1->end() && iter2 != list2->end() ;
+              ++iter1, ++iter2 )
+        {
+            BOOST_CHECK_EQUAL( iter1->time, iter2->time ) ;
+            BOOST_CHECK_EQUAL( iter1->source_de, iter2->source_de ) ;
+            BOOST_CHECK_EQUAL( iter1->intensity(0), iter2->intensity(0) ) ;
+            BOOST_CHECK_EQUAL( iter1->bottom, iter2->bottom ) ;
+        }
+    }
+    BOOST_CHECK( total > 0 ) ;
+
+    // eigenverbs must be identical
+
+    for ( size_t n=0 ; n < 2 ; ++n ) {
+        const eigenverb_list& list1 = full_reverb.eigenverbs( n ) ;
+        const eigenverb_list& list2 = active_reverb.eigenverbs( n ) ;
+        BOOST_CHECK( list1.size() > 0 ) ;
+        BOOST_CHECK_EQUAL( list1.size(), list2.size() ) ;
+        eigenverb_list::const_iterator iter1 = list1.begin() ;
+        eigenverb_list::const_iterator iter2 = list2.begin() ;
+        for ( ; iter1 != list1.end() && iter2 != list2.end() ;
+              ++iter1, ++iter2 )
+        {
+            BOOST_CHECK_EQUAL( iter1->time, iter2->time ) ;
+            BOOST_CHECK_EQUAL( iter1->de_index, iter2->de_index ) ;
+            BOOST_CHECK_EQUAL( iter1->az_index, iter2->az_index ) ;
+            BOOST_CHECK_EQUAL( iter1->power(0), iter2->power(0) ) ;
+        }
+    }
+}
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
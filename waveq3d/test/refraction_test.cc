@@ -1157,6 +1157,189 @@ BOOST_AUTO_TEST_CASE( surface_duct_test ) {
     delete axis[0] ;
 }
 
+/**
+ * Compare the propagation derivatives computed by each of the instruction
+ * sets supported by the wave_front_kernel.  Uses a Munk profile so that the
+ * sound speed gradient contributes to the result, and a 21x7 ray fan so
+ * that the vector versions must also process a partial block of rays at
+ * the end of the wavefront.  The scalar version is the reference.
+ * The vector versions use fused multiply-add operations, so they are
+ * only expected to match the scalar version to about 1e-8 percent.
+ */
+BOOST_AUTO_TEST_CASE( refraction_kernel ) {
+    cout << "=== refraction_test: refraction_kernel ===" << endl;
+    profile_model* profile = new profile_munk() ;
+    boundary_model* surface = new boundary_flat() ;
+    boundary_model* bottom = new boundary_flat(5000.0) ;
+    ocean_model ocean( surface, bottom, profile ) ;
+
+    wposition1 source( 45.0, -45.0, -1000.0 ) ;
+    seq_linear de( -50.0, 5.0, 50.0 ) ;
+    seq_linear az( 0.0, 30.0, 180.0 ) ;
+    wave_front reference( ocean, &freq, de.size(), az.size() ) ;
+    reference.init_wave( source, de, az ) ;
+
+    const wave_front_kernel::instruction_set original = wave_front_kernel::active() ;
+    wave_front_kernel::active( wave_front_kernel::SCALAR ) ;
+    reference.update() ;
+
+    for ( int n = wave_front_kernel::AVX2 ;
+          n <= wave_front_kernel::supported() ; ++n )
+    {
+        const wave_front_kernel::instruction_set isa =
+            wave_front_kernel::active( (wave_front_kernel::instruction_set) n ) ;
+        cout << "instruction set: " << wave_front_kernel::name(isa) << endl ;
+        wave_front wave( ocean, &freq, de.size(), az.size() ) ;
+        wave.init_wave( source, de, az ) ;
+        wave.update() ;
+        for ( size_t d=0 ; d < de.size() ; ++d ) {
+            for ( size_t a=0 ; a < az.size() ; ++a ) {
+                BOOST_CHECK_CLOSE( wave.pos_gradient.rho(d,a),
+                                   reference.pos_gradient.rho(d,a), 1e-8 ) ;
+                BOOST_CHECK_CLOSE( wave.pos_gradient.theta(d,a),
+                                   reference.pos_gradient.theta(d,a), 1e-8 ) ;
+                BOOST_CHECK_CLOSE( wave.pos_gradient.phi(d,a),
+                                   reference.pos_gradient.phi(d,a), 1e-8 ) ;
+                BOOST_CHECK_CLOSE( wave.ndir_gradient.rho(d,a),
+                                   reference.ndir_gradient.rho(d,a), 1e-8 ) ;
+                BOOST_CHECK_CLOSE( wave.ndir_gradient.theta(d,a),
+                                   reference.ndir_gradient.theta(d,a), 1e-8 ) ;
+                BOOST_CHECK_CLOSE( wave.ndir_gradient.phi(d,a),
+                                   reference.ndir_gradient.phi(d,a), 1e-8 ) ;
+            }
+        }
+    }
+    wave_front_kernel::active( original ) ;
+}
+
+/**
+ * Record the wavefront of an isovelocity ocean with the wavefront_recorder,
+ * using decimation in time and a subset of the launch angles.  Reads the
+ * file back in and checks that the number of records, and the
+ * positions of the recorded rays, match the propagated wavefront.
+ */
+BOOST_AUTO_TEST_CASE( refraction_recorder ) {
+    cout << "=== refraction_test: refraction_recorder ===" << endl;
+    const char* ncname = USML_TEST_DIR "/waveq3d/test/refraction_recorder.nc";
+    profile_model* profile = new profile_linear() ;
+    boundary_model* surface = new boundary_flat() ;
+    boundary_model* bottom = new boundary_flat(3000.0) ;
+    ocean_model ocean( surface, bottom, profile ) ;
+
+    wposition1 pos( 45.0, -45.0, -1000.0 ) ;
+    seq_linear de( -20.0, 5.0, 20.0 ) ;
+    seq_linear az( 0.0, 30.0, 180.0 ) ;
+    wave_queue wave( ocean, freq, pos, de, az, time_step ) ;
+
+    std::vector<size_t> de_index ;
+    de_index.push_back(1) ;
+    de_index.push_back(4) ;
+    de_index.push_back(7) ;
+    std::vector<size_t> az_index ;
+    az_index.push_back(2) ;
+    az_index.push_back(5) ;
+
+    // record every third time step, with compression
+
+    const size_t decimation = 3 ;
+    const size_t num_steps = 20 ;
+    double lat = 0.0 ;
+    {
+        wavefront_recorder recorder( wave, ncname, "refraction_recorder",
+            decimation, &de_index, &az_index, 5 ) ;
+        recorder.record() ;
+        for ( size_t n=0 ; n < num_steps ; ++n ) {
+            wave.step() ;
+            recorder.record() ;
+            if ( n + 1 == 18 ) {
+                lat = to_latitude( wave.curr()->position.theta(4,5) ) ;
+            }
+        }
+        recorder.close() ;
+        BOOST_CHECK_EQUAL( recorder.num_records(),
+            ( num_steps + decimation ) / decimation ) ;
+    }
+
+    // read the file back in
+
+    NcFile file( ncname ) ;
+    BOOST_REQUIRE( file.is_valid() ) ;
+    BOOST_CHECK_EQUAL( file.get_dim("source_de")->size(), 3 ) ;
+    BOOST_CHECK_EQUAL( file.get_dim("source_az")->size(), 2 ) ;
+    BOOST_CHECK_EQUAL( file.rec_dim()->size(),
+        (long) ( ( num_steps + decimation ) / decimation ) ) ;
+    double de_value[3] ;
+    file.get_var("source_de")->get( de_value, 3 ) ;
+    BOOST_CHECK_CLOSE( de_value[1], de(4), 1e-10 ) ;
+
+    // record 6 was written after time step 18
+
+    double time ;
+    NcVar* time_var = file.get_var("travel_time") ;
+    time_var->set_cur( 6L ) ;
+    time_var->get( &time, 1 ) ;
+    BOOST_CHECK_CLOSE( time, 18 * time_step, 1e-10 ) ;
+
+    double latitude[3][2] ;
+    NcVar* lat_var = file.get_var("latitude") ;
+    lat_var->set_cur( 6L, 0L, 0L ) ;
+    lat_var->get( &latitude[0][0], 1, 3, 2 ) ;
+    BOOST_CHECK_CLOSE( latitude[1][1], lat, 1e-10 ) ;
+}
+
+/**
+ * Record the wavefront of a Munk profile with the wavefront_recorder,
+ * while the ray fan refinement is enabled.  The fan must keep the
+ * D/E angles that were written to the file until the recorder is
+ * closed, and then resume its refinement.
+ */
+BOOST_AUTO_TEST_CASE( refraction_recorder_refinement ) {
+    cout << "=== refraction_test: refraction_recorder_refinement ===" << endl;
+    const char* ncname = USML_TEST_DIR
+        "/waveq3d/test/refraction_recorder_refinement.nc";
+    profile_model* profile = new profile_munk() ;
+    boundary_model* surface = new boundary_flat() ;
+    boundary_model* bottom = new boundary_flat(5000.0) ;
+    ocean_model ocean( surface, bottom, profile ) ;
+
+    wposition1 pos( 45.0, -45.0, -1000.0 ) ;
+    seq_linear de( -20.0, 1.0, 20.0 ) ;
+    seq_linear az( -4.0, 1.0, 4.0 ) ;
+    wave_queue wave( ocean, freq, pos, de, az, time_step ) ;
+    wave.use_fan_refinement( 300.0 ) ;
+
+    // the fan is not refined while it is being recorded
+
+    const size_t num_steps = 200 ;
+    {
+        wavefront_recorder recorder( wave, ncname,
+            "refraction_recorder_refinement" ) ;
+        recorder.record() ;
+        for ( size_t n=0 ; n < num_steps ; ++n ) {
+            wave.step() ;
+            recorder.record() ;
+        }
+        recorder.close() ;
+        BOOST_CHECK_EQUAL( recorder.num_records(), num_steps + 1 ) ;
+    }
+    BOOST_CHECK_EQUAL( wave.num_de(), de.size() ) ;
+    BOOST_CHECK_EQUAL( wave.num_splits(), (size_t) 0 ) ;
+
+    NcFile file( ncname ) ;
+    BOOST_REQUIRE( file.is_valid() ) ;
+    BOOST_CHECK_EQUAL( file.get_dim("source_de")->size(), (long) de.size() ) ;
+    BOOST_CHECK_EQUAL( file.rec_dim()->size(), (long) ( num_steps + 1 ) ) ;
+
+    // the fan is refined again once the recorder is closed
+
+    for ( size_t n=0 ; n < num_steps ; ++n ) {
+        wave.step() ;
+    }
+    BOOST_CHECK( wave.num_splits() > 0 ) ;
+    BOOST_CHECK_EQUAL( wave.num_de(),
+        de.size() + wave.num_splits() - wave.num_merges() ) ;
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
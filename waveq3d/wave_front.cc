@@ -3,6 +3,7 @@
  * Wavefront characteristics at a specific point in time.
  */
 #include <usml/waveq3d/wave_front.h>
+#include <algorithm>
 
 using namespace usml::waveq3d ;
 
@@ -23,8 +24,8 @@ wave_front::wave_front(
     ndir_gradient( num_de, num_az ),
     sound_speed( num_de, num_az ),
     sound_gradient( num_de, num_az ),
-    attenuation( num_de, num_az ),
-    phase( num_de, num_az ),
+    attenuation( num_de, num_az, freq->size() ),
+    phase( num_de, num_az, freq->size() ),
     distance( num_de, num_az ),
     path_length( num_de, num_az ),
     surface( num_de, num_az ),
@@ -37,10 +38,10 @@ wave_front::wave_front(
     _ocean( ocean ),
     _frequencies( freq ),
     _dc_c( num_de, num_az ),
-    _c2_r( num_de, num_az ),
     _sin_theta( num_de, num_az ),
     _cot_theta( num_de, num_az ),
-    _target_sin_theta( sin_theta )
+    _target_sin_theta( sin_theta ),
+    _cache_distance( targets != NULL )
 {
     sound_speed.clear() ;
     distance.clear() ;
@@ -51,15 +52,8 @@ wave_front::wave_front(
     upper.clear() ;
     lower.clear() ;
     on_edge.clear() ;
-
-    for ( size_t n1=0 ; n1 < num_de ; ++n1 ) {
-        for ( size_t n2=0 ; n2 < num_az ; ++n2 ) {
-            attenuation(n1,n2).resize( freq->size() ) ;
-            attenuation(n1,n2).clear() ;
-            phase(n1,n2).resize( freq->size() ) ;
-            phase(n1,n2).clear() ;
-        }
-    }
+    attenuation.clear() ;
+    phase.clear() ;
 
     if ( this->targets ) {
         distance2.resize( this->targets->size1(), this->targets->size2() ) ;
@@ -124,50 +118,327 @@ void wave_front::update() {
 
     compute_profile();
 
-    // compute commonly used terms in the wave propagation derivatives
-
-    _dc_c.rho(element_div(sound_gradient.rho(), sound_speed));
-    _dc_c.theta(element_div(sound_gradient.theta(), sound_speed));
-    _dc_c.phi(element_div(sound_gradient.phi(), sound_speed));
-    noalias(_sin_theta) = sin(position.theta());
-    noalias(_cot_theta) = element_div(cos(position.theta()), _sin_theta);
-
-    // update wave propagation position derivatives
-    // Reilly eqns. 36-38
-
-    _c2_r = abs2(sound_speed);
-    pos_gradient.rho(element_prod(_c2_r, ndirection.rho()));
-    _c2_r = element_div(_c2_r, position.rho());
-    pos_gradient.theta(element_prod(_c2_r, ndirection.theta()));
-    pos_gradient.phi(element_prod(
-        element_div(_c2_r, _sin_theta),
-        ndirection.phi()));
-
-    // update wave propagation direction derivatives
-    // Reilly eqns. 39-41
-
-    ndir_gradient.rho(
-        element_prod(_c2_r, abs2(ndirection.theta()) + abs2(ndirection.phi()))
-            - _dc_c.rho()
-        );
-    ndir_gradient.theta(
-        element_prod(-_c2_r,
-            element_prod(ndirection.rho(), ndirection.theta())
-            - element_prod(abs2(ndirection.phi()), _cot_theta))
-            - element_div(_dc_c.theta(), position.rho())
-        );
-    ndir_gradient.phi(
-        element_prod(-_c2_r,
-            element_prod(ndirection.phi(),
-                ndirection.rho() + element_prod(ndirection.theta(), _cot_theta)
-            )
-        )
-        - element_div(_dc_c.phi(), element_prod(position.rho(), _sin_theta))
-        );
+    // compute the wave propagation derivatives, Reilly eqns. 36-41,
+    // and the commonly used terms in a single pass over the wavefront
+
+    compute_derivatives() ;
 
     // update data that relies on new wavefront locations
 
-    if (targets) compute_target_distance();
+    if ( targets && _cache_distance ) compute_target_distance();
+}
+
+/**
+ * Update properties for a block of D/E rows.
+ */
+void wave_front::update( size_t first, wave_front& workspace ) {
+    const size_t rows = workspace.num_de() ;
+    const size_t cols = num_az() ;
+
+    // copy inputs into the workspace
+
+    for ( size_t r=0 ; r < rows ; ++r ) {
+        for ( size_t c=0 ; c < cols ; ++c ) {
+            workspace.position.rho(   r, c, position.rho(   first+r, c ) ) ;
+            workspace.position.theta( r, c, position.theta( first+r, c ) ) ;
+            workspace.position.phi(   r, c, position.phi(   first+r, c ) ) ;
+            workspace.ndirection.rho(   r, c, ndirection.rho(   first+r, c ) ) ;
+            workspace.ndirection.theta( r, c, ndirection.theta( first+r, c ) ) ;
+            workspace.ndirection.phi(   r, c, ndirection.phi(   first+r, c ) ) ;
+            workspace.distance( r, c ) = distance( first+r, c ) ;
+        }
+    }
+
+    workspace.update() ;
+
+    // copy results back into this wavefront
+
+    for ( size_t r=0 ; r < rows ; ++r ) {
+        for ( size_t c=0 ; c < cols ; ++c ) {
+            sound_speed( first+r, c ) = workspace.sound_speed( r, c ) ;
+            sound_gradient.rho(   first+r, c, workspace.sound_gradient.rho(   r, c ) ) ;
+            sound_gradient.theta( first+r, c, workspace.sound_gradient.theta( r, c ) ) ;
+            sound_gradient.phi(   first+r, c, workspace.sound_gradient.phi(   r, c ) ) ;
+            pos_gradient.rho(   first+r, c, workspace.pos_gradient.rho(   r, c ) ) ;
+            pos_gradient.theta( first+r, c, workspace.pos_gradient.theta( r, c ) ) ;
+            pos_gradient.phi(   first+r, c, workspace.pos_gradient.phi(   r, c ) ) ;
+            ndir_gradient.rho(   first+r, c, workspace.ndir_gradient.rho(   r, c ) ) ;
+            ndir_gradient.theta( first+r, c, workspace.ndir_gradient.theta( r, c ) ) ;
+            ndir_gradient.phi(   first+r, c, workspace.ndir_gradient.phi(   r, c ) ) ;
+            _sin_theta( first+r, c ) = workspace._sin_theta( r, c ) ;
+        }
+    }
+
+    // spectra for consecutive rows are contiguous in memory
+
+    const size_t offset = first * cols * _frequencies->size() ;
+    std::copy( workspace.attenuation.data().begin(),
+               workspace.attenuation.data().end(),
+               attenuation.data().begin() + offset ) ;
+    std::copy( workspace.phase.data().begin(),
+               workspace.phase.data().end(),
+               phase.data().begin() + offset ) ;
+
+    if ( targets && _cache_distance ) {
+        for ( size_t n1=0 ; n1 < targets->size1() ; ++n1 ) {
+            for ( size_t n2=0 ; n2 < targets->size2() ; ++n2 ) {
+                const matrix<double>& from = workspace.distance2(n1,n2) ;
+                matrix<double>& to = distance2(n1,n2) ;
+                for ( size_t r=0 ; r < rows ; ++r ) {
+                    for ( size_t c=0 ; c < cols ; ++c ) {
+                        to( first+r, c ) = from( r, c ) ;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Update properties for a list of rays.
+ */
+void wave_front::update( const size_t* index, wave_front& workspace ) {
+    const size_t count = workspace.num_de() ;
+    const size_t num_freq = _frequencies->size() ;
+
+    // gather inputs into the workspace
+
+    double* rho = workspace.position.rho_data() ;
+    double* theta = workspace.position.theta_data() ;
+    double* phi = workspace.position.phi_data() ;
+    double* ndir_rho = workspace.ndirection.rho_data() ;
+    double* ndir_theta = workspace.ndirection.theta_data() ;
+    double* ndir_phi = workspace.ndirection.phi_data() ;
+    for ( size_t n=0 ; n < count ; ++n ) {
+        const size_t i = index[n] ;
+        rho[n] = position.rho().data()[i] ;
+        theta[n] = position.theta().data()[i] ;
+        phi[n] = position.phi().data()[i] ;
+        ndir_rho[n] = ndirection.rho().data()[i] ;
+        ndir_theta[n] = ndirection.theta().data()[i] ;
+        ndir_phi[n] = ndirection.phi().data()[i] ;
+        workspace.distance.data()[n] = distance.data()[i] ;
+    }
+
+    workspace.update() ;
+
+    // scatter results back into this wavefront
+
+    for ( size_t n=0 ; n < count ; ++n ) {
+        const size_t i = index[n] ;
+        sound_speed.data()[i] = workspace.sound_speed.data()[n] ;
+        sound_gradient.rho_data()[i] = workspace.sound_gradient.rho().data()[n] ;
+        sound_gradient.theta_data()[i] = workspace.sound_gradient.theta().data()[n] ;
+        sound_gradient.phi_data()[i] = workspace.sound_gradient.phi().data()[n] ;
+        pos_gradient.rho_data()[i] = workspace.pos_gradient.rho().data()[n] ;
+        pos_gradient.theta_data()[i] = workspace.pos_gradient.theta().data()[n] ;
+        pos_gradient.phi_data()[i] = workspace.pos_gradient.phi().data()[n] ;
+        ndir_gradient.rho_data()[i] = workspace.ndir_gradient.rho().data()[n] ;
+        ndir_gradient.theta_data()[i] = workspace.ndir_gradient.theta().data()[n] ;
+        ndir_gradient.phi_data()[i] = workspace.ndir_gradient.phi().data()[n] ;
+        _sin_theta.data()[i] = workspace._sin_theta.data()[n] ;
+        std::copy( workspace.attenuation.data().begin() + n * num_freq,
+                   workspace.attenuation.data().begin() + ( n + 1 ) * num_freq,
+                   attenuation.data().begin() + i * num_freq ) ;
+        std::copy( workspace.phase.data().begin() + n * num_freq,
+                   workspace.phase.data().begin() + ( n + 1 ) * num_freq,
+                   phase.data().begin() + i * num_freq ) ;
+    }
+
+    if ( targets && _cache_distance ) {
+        for ( size_t n1=0 ; n1 < targets->size1() ; ++n1 ) {
+            for ( size_t n2=0 ; n2 < targets->size2() ; ++n2 ) {
+                const matrix<double>& from = workspace.distance2(n1,n2) ;
+                matrix<double>& to = distance2(n1,n2) ;
+                for ( size_t n=0 ; n < count ; ++n ) {
+                    to.data()[ index[n] ] = from.data()[n] ;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Update properties for an azimuthally symmetric ocean.
+ */
+void wave_front::update_symmetric( wave_front& workspace, const double* rotation ) {
+    const size_t rows = num_de() ;
+    const size_t cols = num_az() ;
+    const size_t num_freq = _frequencies->size() ;
+
+    // update the first column in the workspace
+
+    for ( size_t r=0 ; r < rows ; ++r ) {
+        workspace.position.rho(   r, 0, position.rho(   r, 0 ) ) ;
+        workspace.position.theta( r, 0, position.theta( r, 0 ) ) ;
+        workspace.position.phi(   r, 0, position.phi(   r, 0 ) ) ;
+        workspace.ndirection.rho(   r, 0, ndirection.rho(   r, 0 ) ) ;
+        workspace.ndirection.theta( r, 0, ndirection.theta( r, 0 ) ) ;
+        workspace.ndirection.phi(   r, 0, ndirection.phi(   r, 0 ) ) ;
+        workspace.distance( r, 0 ) = distance( r, 0 ) ;
+    }
+    workspace.compute_profile() ;
+
+    for ( size_t r=0 ; r < rows ; ++r ) {
+
+        // convert the first column into earth centered Cartesian coordinates
+
+        const double rho = position.rho( r, 0 ) ;
+        const double phi0 = position.phi( r, 0 ) ;
+        const double st = sin( position.theta( r, 0 ) ) ;
+        const double ct = cos( position.theta( r, 0 ) ) ;
+        const double sp = sin( phi0 ) ;
+        const double cp = cos( phi0 ) ;
+        const double nr = ndirection.rho( r, 0 ) ;
+        const double nt = ndirection.theta( r, 0 ) ;
+        const double np = ndirection.phi( r, 0 ) ;
+        const double pos[3] = { st * cp, st * sp, ct } ;
+        const double dir[3] = {
+            nr * st * cp + nt * ct * cp - np * sp,
+            nr * st * sp + nt * ct * sp + np * cp,
+            nr * ct - nt * st } ;
+
+        for ( size_t c=0 ; c < cols ; ++c ) {
+
+            // rotate position and direction into the other columns
+
+            if ( c > 0 ) {
+                const double* R = rotation + 9 * c ;
+                double p[3], d[3] ;
+                for ( size_t i=0 ; i < 3 ; ++i ) {
+                    p[i] = R[3*i] * pos[0] + R[3*i+1] * pos[1] + R[3*i+2] * pos[2] ;
+                    d[i] = R[3*i] * dir[0] + R[3*i+1] * dir[1] + R[3*i+2] * dir[2] ;
+                }
+                const double st2 = sqrt( p[0] * p[0] + p[1] * p[1] ) ;
+                const double ct2 = p[2] ;
+                double phi = atan2( p[1], p[0] ) ;
+                phi += TWO_PI * floor( ( phi0 - phi ) / TWO_PI + 0.5 ) ;
+                const double sp2 = ( st2 > 0.0 ) ? p[1] / st2 : 0.0 ;
+                const double cp2 = ( st2 > 0.0 ) ? p[0] / st2 : 1.0 ;
+                position.rho(   r, c, rho ) ;
+                position.theta( r, c, atan2( st2, ct2 ) ) ;
+                position.phi(   r, c, phi ) ;
+                ndirection.rho( r, c, d[0] * p[0] + d[1] * p[1] + d[2] * p[2] ) ;
+                ndirection.theta( r, c,
+                    d[0] * ct2 * cp2 + d[1] * ct2 * sp2 - d[2] * st2 ) ;
+                ndirection.phi( r, c, d[1] * cp2 - d[0] * sp2 ) ;
+                distance( r, c ) = distance( r, 0 ) ;
+            }
+
+            // copy ocean profile elements from the first column
+
+            sound_speed( r, c ) = workspace.sound_speed( r, 0 ) ;
+            sound_gradient.rho(   r, c, workspace.sound_gradient.rho(   r, 0 ) ) ;
+            sound_gradient.theta( r, c, workspace.sound_gradient.theta( r, 0 ) ) ;
+            sound_gradient.phi(   r, c, workspace.sound_gradient.phi(   r, 0 ) ) ;
+            std::copy( workspace.attenuation.data().begin() + r * num_freq,
+                       workspace.attenuation.data().begin() + ( r + 1 ) * num_freq,
+                       attenuation.data().begin() + ( r * cols + c ) * num_freq ) ;
+        }
+    }
+    phase.clear() ;
+
+    // compute derivatives and target distances for the whole fan
+
+    compute_derivatives() ;
+    if ( targets && _cache_distance ) compute_target_distance();
+}
+
+namespace {
+
+/**
+ * Weighted sum of four elements of a row major array.
+ */
+inline double mix( const double* data, const size_t* index, const double* weight ) {
+    return weight[0] * data[index[0]] + weight[1] * data[index[1]]
+         + weight[2] * data[index[2]] + weight[3] * data[index[3]] ;
+}
+
+}   // end of anonymous namespace
+
+/**
+ * Fill this wavefront by interpolating the D/E rows of another wavefront.
+ */
+void wave_front::resample( const wave_front& from, const size_t* rows,
+                           const double* weights )
+{
+    const size_t cols = num_az() ;
+    const size_t num_freq = _frequencies->size() ;
+
+    // wvector components of both wavefronts, in the same order
+
+    const double* in[21] = {
+        from.position.rho().data().begin(),
+        from.position.theta().data().begin(),
+        from.position.phi().data().begin(),
+        from.pos_gradient.rho().data().begin(),
+        from.pos_gradient.theta().data().begin(),
+        from.pos_gradient.phi().data().begin(),
+        from.ndirection.rho().data().begin(),
+        from.ndirection.theta().data().begin(),
+        from.ndirection.phi().data().begin(),
+        from.ndir_gradient.rho().data().begin(),
+        from.ndir_gradient.theta().data().begin(),
+        from.ndir_gradient.phi().data().begin(),
+        from.sound_gradient.rho().data().begin(),
+        from.sound_gradient.theta().data().begin(),
+        from.sound_gradient.phi().data().begin(),
+        from._dc_c.rho().data().begin(),
+        from._dc_c.theta().data().begin(),
+        from._dc_c.phi().data().begin(),
+        from.sound_speed.data().begin(),
+        from.distance.data().begin(),
+        from.path_length.data().begin() } ;
+    double* out[21] = {
+        position.rho_data(), position.theta_data(), position.phi_data(),
+        pos_gradient.rho_data(), pos_gradient.theta_data(), pos_gradient.phi_data(),
+        ndirection.rho_data(), ndirection.theta_data(), ndirection.phi_data(),
+        ndir_gradient.rho_data(), ndir_gradient.theta_data(), ndir_gradient.phi_data(),
+        sound_gradient.rho_data(), sound_gradient.theta_data(), sound_gradient.phi_data(),
+        _dc_c.rho_data(), _dc_c.theta_data(), _dc_c.phi_data(),
+        sound_speed.data().begin(), distance.data().begin(),
+        path_length.data().begin() } ;
+
+    for ( size_t r=0 ; r < num_de() ; ++r ) {
+        const size_t* row = rows + 4 * r ;
+        const double* weight = weights + 4 * r ;
+        const size_t largest = std::max_element( weight, weight + 4 ) - weight ;
+        for ( size_t c=0 ; c < cols ; ++c ) {
+            const size_t i = r * cols + c ;
+            const size_t index[4] = {
+                row[0] * cols + c, row[1] * cols + c,
+                row[2] * cols + c, row[3] * cols + c } ;
+            for ( size_t k=0 ; k < 21 ; ++k ) {
+                out[k][i] = mix( in[k], index, weight ) ;
+            }
+            _sin_theta.data()[i] = sin( position.theta().data()[i] ) ;
+            _cot_theta.data()[i] = cos( position.theta().data()[i] )
+                                 / _sin_theta.data()[i] ;
+
+            // spectra are interpolated one frequency at a time
+
+            const double* atten = from.attenuation.data().data().begin() ;
+            const double* phs = from.phase.data().data().begin() ;
+            for ( size_t f=0 ; f < num_freq ; ++f ) {
+                const size_t spectral[4] = {
+                    index[0] * num_freq + f, index[1] * num_freq + f,
+                    index[2] * num_freq + f, index[3] * num_freq + f } ;
+                attenuation.data()[ i * num_freq + f ] = mix( atten, spectral, weight ) ;
+                phase.data()[ i * num_freq + f ] = mix( phs, spectral, weight ) ;
+            }
+
+            // counts can not be interpolated
+
+            const size_t n = index[largest] ;
+            surface.data()[i] = from.surface.data()[n] ;
+            bottom.data()[i] = from.bottom.data()[n] ;
+            caustic.data()[i] = from.caustic.data()[n] ;
+            upper.data()[i] = from.upper.data()[n] ;
+            lower.data()[i] = from.lower.data()[n] ;
+        }
+    }
+
+    if ( targets && _cache_distance ) compute_target_distance();
 }
 
 /**
@@ -216,14 +487,32 @@ void wave_front::find_edges() {
 void wave_front::compute_target_distance() {
     for ( size_t n1=0 ; n1 < targets->size1() ; ++n1 ) {
         for ( size_t n2=0 ; n2 < targets->size2() ; ++n2 ) {
-            wvector1 from( *targets, n1, n2 ) ;
-            noalias(distance2(n1,n2)) = abs(
-                abs2(position.rho()) + from.rho()*from.rho() - 2.0 * from.rho()
-                * element_prod( position.rho(), 1.0 - 2.0 * (
-                abs2(0.5*(position.theta()-from.theta()))
-                + (*_target_sin_theta)(n1,n2) * element_prod( _sin_theta,
-                abs2(0.5*(position.phi()-from.phi())) )) ) );
+            matrix<double>& to = distance2(n1,n2) ;
+            for ( size_t de=0 ; de < num_de() ; ++de ) {
+                for ( size_t az=0 ; az < num_az() ; ++az ) {
+                    to(de,az) = compute_target_distance( n1, n2, de, az ) ;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Controls whether target distances are stored in distance2.
+ */
+void wave_front::cache_target_distance( bool cache ) {
+    if ( targets == NULL || cache == _cache_distance ) return ;
+    _cache_distance = cache ;
+    if ( cache ) {
+        distance2.resize( targets->size1(), targets->size2() ) ;
+        for ( size_t n1=0 ; n1 < targets->size1() ; ++n1 ) {
+            for ( size_t n2=0 ; n2 < targets->size2() ; ++n2 ) {
+                distance2(n1,n2).resize( num_de(), num_az() ) ;
+            }
         }
+        compute_target_distance() ;
+    } else {
+        distance2.resize( 0, 0 ) ;
     }
 }
 
@@ -231,11 +520,36 @@ void wave_front::compute_target_distance() {
  * Compute terms in the sound speed profile as fast as possible.
  */
 void wave_front::compute_profile() {
-    _ocean.profile().sound_speed( position, &sound_speed, &sound_gradient);
+    _ocean.profile().sound_speed( position, &sound_speed, &sound_gradient,
+            &_profile_hints );
     _ocean.profile().attenuation( position, *_frequencies, distance, &attenuation);
-    for (size_t de = 0; de < position.size1(); ++de) {
-        for (size_t az = 0; az < position.size2(); ++az) {
-            phase(de, az).clear();
-        }
-    }
+    phase.clear();
+}
+
+/**
+ * Compute the Adams-Bashforth derivatives for the whole wavefront.
+ */
+void wave_front::compute_derivatives() {
+    wave_front_kernel::terms args ;
+    args.rho = position.rho().data().begin() ;
+    args.theta = position.theta().data().begin() ;
+    args.ndir_rho = ndirection.rho().data().begin() ;
+    args.ndir_theta = ndirection.theta().data().begin() ;
+    args.ndir_phi = ndirection.phi().data().begin() ;
+    args.sound_speed = sound_speed.data().begin() ;
+    args.grad_rho = sound_gradient.rho().data().begin() ;
+    args.grad_theta = sound_gradient.theta().data().begin() ;
+    args.grad_phi = sound_gradient.phi().data().begin() ;
+    args.pos_grad_rho = pos_gradient.rho_data() ;
+    args.pos_grad_theta = pos_gradient.theta_data() ;
+    args.pos_grad_phi = pos_gradient.phi_data() ;
+    args.ndir_grad_rho = ndir_gradient.rho_data() ;
+    args.ndir_grad_theta = ndir_gradient.theta_data() ;
+    args.ndir_grad_phi = ndir_gradient.phi_data() ;
+    args.dc_c_rho = _dc_c.rho_data() ;
+    args.dc_c_theta = _dc_c.theta_data() ;
+    args.dc_c_phi = _dc_c.phi_data() ;
+    args.sin_theta = _sin_theta.data().begin() ;
+    args.cot_theta = _cot_theta.data().begin() ;
+    wave_front_kernel::compute( args, num_de() * num_az() ) ;
 }
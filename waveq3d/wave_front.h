@@ -5,6 +5,7 @@
 #pragma once
 
 #include <usml/ocean/ocean.h>
+#include <usml/waveq3d/wave_front_kernel.h>
 
 namespace usml {
 namespace waveq3d {
@@ -60,6 +61,8 @@ using boost::numeric::ublas::vector;
  * In this implementation, many of the intermediate terms are cached
  * as private data members in the wave_front object to reduce the
  * number of times that common terms need to be re-allocated in memory.
+ * The derivatives and these intermediate terms are computed in a single
+ * pass over the wavefront by the wave_front_kernel class.
  *
  * @xref S.M. Reilly, G. Potty, Sonar Propagation Modeling using Hybrid
  * Gaussian Beams in Spherical/Time Coordinates, January 2012.
@@ -129,6 +132,118 @@ class USML_DECLSPEC wave_front {
          */
         void update() ;
 
+        /**
+         * Update wave element properties for a block of D/E rows.
+         * Produces the same results as update() for those rows. Copies
+         * the position, direction, and distance of the rows into a
+         * smaller workspace wavefront, updates the workspace, and copies
+         * the results back into this wavefront. Blocks that do not
+         * overlap can be updated at the same time in different threads,
+         * as long as the ocean profile can be shared between threads.
+         *
+         * @param  first        First D/E row to update.
+         * @param  workspace    Wavefront with the same number of AZ angles,
+         *                      frequencies, and targets as this one. The
+         *                      number of D/E angles in the workspace
+         *                      defines the number of rows updated.
+         */
+        void update( size_t first, wave_front& workspace ) ;
+
+        /**
+         * Update wave element properties for a list of rays.
+         * Produces the same results as update() for those rays. Gathers
+         * the position, direction, and distance of each ray into a
+         * workspace wavefront with a single AZ column, updates the
+         * workspace, and scatters the results back into this wavefront.
+         * Used by the wave_queue to update only the rays that are still
+         * active.  Lists that do not overlap can be updated at the same
+         * time in different threads.
+         *
+         * @param  index        Row major index (de*num_az()+az) of each
+         *                      ray to update.
+         * @param  workspace    Wavefront with one AZ angle, and the same
+         *                      frequencies and targets as this one. The
+         *                      number of D/E angles in the workspace
+         *                      defines the number of entries in index.
+         */
+        void update( const size_t* index, wave_front& workspace ) ;
+
+        /**
+         * Update wave element properties for an azimuthally symmetric
+         * ocean, where the sound speed, attenuation, and boundaries only
+         * depend on depth.  In such an ocean, every AZ column of the ray
+         * fan is a rotation of the first column around the vertical axis
+         * through the source. The first column is updated in a workspace,
+         * just like update( index, workspace ). The position and direction
+         * of the other columns are then replaced by rotations of the first
+         * column, and their sound speed, attenuation, phase, and distance
+         * are copied from the same D/E row of the first column. Finally,
+         * the Adams-Bashforth derivatives and target distances are
+         * computed for the whole fan, because they depend on the
+         * position of each ray in spherical earth coordinates.
+         *
+         * @param  workspace    Wavefront with one AZ angle, the same
+         *                      number of D/E angles, and the same
+         *                      frequencies and targets as this one.
+         * @param  rotation     Row major 3x3 rotation matrix, in earth
+         *                      centered Cartesian coordinates, for each
+         *                      AZ column. Rotates the first column into
+         *                      that column.
+         */
+        void update_symmetric( wave_front& workspace, const double* rotation ) ;
+
+        /**
+         * Fill this wavefront by interpolating the D/E rows of another
+         * wavefront.  Used by the wave_queue to add rays to, or remove
+         * rays from, a ray fan that is already propagating.  Each row of
+         * this wavefront is a weighted sum of four rows of the other
+         * wavefront.  The position, direction, derivatives, ocean profile
+         * elements, accumulated attenuation and phase, and path lengths
+         * are interpolated at each AZ. The reflection and caustic counts
+         * are copied from the row with the largest weight.  The target
+         * distances and the trigonometric terms are recomputed from
+         * the interpolated positions, but find_edges() is not called.
+         *
+         * @param  from         Wavefront with the same number of AZ
+         *                      angles, frequencies, and targets as this one.
+         * @param  rows         Four rows of the other wavefront for
+         *                      each row of this one.
+         * @param  weights      Weight of each of those four rows.
+         */
+        void resample( const wave_front& from, const size_t* rows,
+                       const double* weights ) ;
+
+        /**
+         * Controls whether the distance from every target to every point
+         * on the wavefront is stored in the distance2 attribute.  Defaults
+         * to true when targets are defined.  Turning this off releases the
+         * distance2 matrices, and target_distance2() computes distances
+         * on demand instead.  Turning it back on recomputes the distances
+         * for the current wavefront positions.
+         *
+         * @param  cache        Store distances in distance2 if true.
+         */
+        void cache_target_distance( bool cache ) ;
+
+        /**
+         * Fast approximation of the distance squared from one target to
+         * one point on the wavefront.  Returns the stored distance2 value
+         * if distances are cached, otherwise computes it with the same
+         * equation used to fill distance2.
+         *
+         * @param  n1           Row number of the target.
+         * @param  n2           Column number of the target.
+         * @param  de           D/E angle index number.
+         * @param  az           AZ angle index number.
+         * @return              Distance squared (meters^2).
+         */
+        inline double target_distance2(
+            size_t n1, size_t n2, size_t de, size_t az ) const
+        {
+            if ( _cache_distance ) return distance2(n1,n2)(de,az) ;
+            return compute_target_distance( n1, n2, de, az ) ;
+        }
+
         /**
          * Search for points on either side of wavefront folds. 
          * When reflection or refraction causes the wavefront to fold, the distance
@@ -186,15 +301,17 @@ class USML_DECLSPEC wave_front {
          * Non-spreading component of propagation loss in dB.
          * Stores the cumulative result of interface reflection losses
          * and losses that result from the attenuation of sound in sea water.
+         * The spectra for all rays are stored in one contiguous buffer.
          */
-        matrix< vector< double > > attenuation ;
+        spectral_matrix attenuation ;
 
         /**
          * Non-spreading component of phase change in radians.
          * Stores the cumulative result of the phase changes from
          * interface reflections and caustics.
+         * The spectra for all rays are stored in one contiguous buffer.
          */
-        matrix< vector< double > > phase ;
+        spectral_matrix phase ;
 
         /**
          * Distance from old location to this location.
@@ -277,11 +394,6 @@ class USML_DECLSPEC wave_front {
          */
         wvector _dc_c ;
 
-        /**
-         * Square of the speed of sound divided by rho (cached intermediate term).
-         */
-        matrix<double> _c2_r ;
-
         /**
          * Sine of colatitude (cached intermediate term).
          */
@@ -292,12 +404,26 @@ class USML_DECLSPEC wave_front {
          */
         matrix<double> _cot_theta ;
 
+        /**
+         * Interval index of each ray along each axis of the sound speed
+         * profile, from the last call to compute_profile().  Starting
+         * point for the next search, because the rays only move
+         * a small distance on each time step.
+         */
+        std::vector<size_t> _profile_hints ;
+
         /**
          * Sin of colatitude for targets (cached intermediate term).
          * Not used if eigenrays are not being computed.
          */
         const matrix<double>* _target_sin_theta ;
 
+        /**
+         * True if the distance from every target to every point on
+         * the wavefront is stored in distance2.
+         */
+        bool _cache_distance ;
+
         /**
          * Compute a fast approximation of the distance squared from each
          * target to each point on the wavefront.  The speed-up process uses
@@ -318,6 +444,31 @@ class USML_DECLSPEC wave_front {
          */
         void compute_target_distance() ;
 
+        /**
+         * Compute the fast approximation of distance squared between
+         * a single target and a single point on the wavefront.
+         * Used by compute_target_distance() to fill distance2, and by
+         * target_distance2() when distances are not cached.
+         *
+         * @param  n1           Row number of the target.
+         * @param  n2           Column number of the target.
+         * @param  de           D/E angle index number.
+         * @param  az           AZ angle index number.
+         * @return              Distance squared (meters^2).
+         */
+        inline double compute_target_distance(
+            size_t n1, size_t n2, size_t de, size_t az ) const
+        {
+            const double rho = position.rho(de,az) ;
+            const double from_rho = targets->rho(n1,n2) ;
+            const double dtheta = 0.5 * ( position.theta(de,az) - targets->theta(n1,n2) ) ;
+            const double dphi = 0.5 * ( position.phi(de,az) - targets->phi(n1,n2) ) ;
+            return abs( rho * rho + from_rho * from_rho - 2.0 * from_rho
+                * ( rho * ( 1.0 - 2.0 * ( dtheta * dtheta
+                + (*_target_sin_theta)(n1,n2) * ( _sin_theta(de,az)
+                * ( dphi * dphi ) ) ) ) ) ) ;
+        }
+
         /**
          * Compute the sound_speed, sound_gradient, and attenuation
          * elements of the ocean profile.  It also clears the phase of the
@@ -327,6 +478,13 @@ class USML_DECLSPEC wave_front {
          */
         void compute_profile() ;
 
+        /**
+         * Compute the Adams-Bashforth derivatives, Reilly eqns. 36-41,
+         * from the current position, direction, and ocean profile
+         * elements of the wavefront.
+         */
+        void compute_derivatives() ;
+
 };
 
 /// @}
@@ -0,0 +1,255 @@
+/**
+ * @file wave_front_kernel.cc
+ * Fused computation of the wavefront propagation derivatives.
+ */
+#include <usml/waveq3d/wave_front_kernel.h>
+#include <cmath>
+
+#if ( defined(__GNUC__) || defined(__clang__) ) \
+    && ( defined(__x86_64__) || defined(__i386__) )
+    #define USML_WAVE_FRONT_X86
+    #include <immintrin.h>
+#endif
+
+using namespace usml::waveq3d ;
+
+namespace {
+
+/**
+ * Scalar version of the kernel for elements [first,last).  Uses the same
+ * order of operations as the uBLAS form of the equations.  Also used for
+ * the elements left over at the end of the vector versions.
+ */
+void compute_scalar( const wave_front_kernel::terms& a,
+                     size_t first, size_t last )
+{
+    for ( size_t n=first ; n < last ; ++n ) {
+        const double rho = a.rho[n] ;
+        const double c = a.sound_speed[n] ;
+        const double nr = a.ndir_rho[n] ;
+        const double nt = a.ndir_theta[n] ;
+        const double np = a.ndir_phi[n] ;
+
+        const double dc_c_rho = a.grad_rho[n] / c ;
+        const double dc_c_theta = a.grad_theta[n] / c ;
+        const double dc_c_phi = a.grad_phi[n] / c ;
+        const double sin_theta = std::sin( a.theta[n] ) ;
+        const double cot_theta = std::cos( a.theta[n] ) / sin_theta ;
+
+        // Reilly eqns. 36-38
+
+        const double c2 = c * c ;
+        const double c2_r = c2 / rho ;
+        a.pos_grad_rho[n] = c2 * nr ;
+        a.pos_grad_theta[n] = c2_r * nt ;
+        a.pos_grad_phi[n] = ( c2_r / sin_theta ) * np ;
+
+        // Reilly eqns. 39-41
+
+        a.ndir_grad_rho[n] = c2_r * ( nt * nt + np * np ) - dc_c_rho ;
+        a.ndir_grad_theta[n] = -c2_r * ( nr * nt - np * np * cot_theta )
+            - dc_c_theta / rho ;
+        a.ndir_grad_phi[n] = -c2_r * ( np * ( nr + nt * cot_theta ) )
+            - dc_c_phi / ( rho * sin_theta ) ;
+
+        a.dc_c_rho[n] = dc_c_rho ;
+        a.dc_c_theta[n] = dc_c_theta ;
+        a.dc_c_phi[n] = dc_c_phi ;
+        a.sin_theta[n] = sin_theta ;
+        a.cot_theta[n] = cot_theta ;
+    }
+}
+
+#ifdef USML_WAVE_FRONT_X86
+
+/**
+ * AVX2/FMA version of the kernel, 4 rays per iteration.
+ * There are no vector sine and cosine instructions, so those terms
+ * are computed with the standard library before each vector step.
+ */
+__attribute__((target("avx2,fma")))
+void compute_avx2( const wave_front_kernel::terms& a, size_t size ) {
+    const size_t last = size - size % 4 ;
+    const __m256d one = _mm256_set1_pd( 1.0 ) ;
+    double sin_t[4], cos_t[4] ;
+    for ( size_t n=0 ; n < last ; n += 4 ) {
+        for ( size_t k=0 ; k < 4 ; ++k ) {
+            sin_t[k] = std::sin( a.theta[n+k] ) ;
+            cos_t[k] = std::cos( a.theta[n+k] ) ;
+        }
+        const __m256d sin_theta = _mm256_loadu_pd( sin_t ) ;
+        const __m256d cot_theta = _mm256_div_pd( _mm256_loadu_pd( cos_t ), sin_theta ) ;
+        const __m256d rho = _mm256_loadu_pd( a.rho + n ) ;
+        const __m256d c = _mm256_loadu_pd( a.sound_speed + n ) ;
+        const __m256d nr = _mm256_loadu_pd( a.ndir_rho + n ) ;
+        const __m256d nt = _mm256_loadu_pd( a.ndir_theta + n ) ;
+        const __m256d np = _mm256_loadu_pd( a.ndir_phi + n ) ;
+
+        const __m256d inv_c = _mm256_div_pd( one, c ) ;
+        const __m256d dc_c_rho = _mm256_mul_pd( _mm256_loadu_pd( a.grad_rho + n ), inv_c ) ;
+        const __m256d dc_c_theta = _mm256_mul_pd( _mm256_loadu_pd( a.grad_theta + n ), inv_c ) ;
+        const __m256d dc_c_phi = _mm256_mul_pd( _mm256_loadu_pd( a.grad_phi + n ), inv_c ) ;
+
+        // Reilly eqns. 36-38
+
+        const __m256d c2 = _mm256_mul_pd( c, c ) ;
+        const __m256d inv_rho = _mm256_div_pd( one, rho ) ;
+        const __m256d c2_r = _mm256_mul_pd( c2, inv_rho ) ;
+        const __m256d c2_rs = _mm256_div_pd( c2_r, sin_theta ) ;
+        _mm256_storeu_pd( a.pos_grad_rho + n, _mm256_mul_pd( c2, nr ) ) ;
+        _mm256_storeu_pd( a.pos_grad_theta + n, _mm256_mul_pd( c2_r, nt ) ) ;
+        _mm256_storeu_pd( a.pos_grad_phi + n, _mm256_mul_pd( c2_rs, np ) ) ;
+
+        // Reilly eqns. 39-41
+
+        const __m256d np2 = _mm256_mul_pd( np, np ) ;
+        _mm256_storeu_pd( a.ndir_grad_rho + n, _mm256_fmsub_pd(
+            c2_r, _mm256_fmadd_pd( nt, nt, np2 ), dc_c_rho ) ) ;
+        _mm256_storeu_pd( a.ndir_grad_theta + n, _mm256_fnmsub_pd(
+            c2_r, _mm256_fnmadd_pd( np2, cot_theta, _mm256_mul_pd( nr, nt ) ),
+            _mm256_mul_pd( dc_c_theta, inv_rho ) ) ) ;
+        _mm256_storeu_pd( a.ndir_grad_phi + n, _mm256_fnmsub_pd(
+            c2_r, _mm256_mul_pd( np, _mm256_fmadd_pd( nt, cot_theta, nr ) ),
+            _mm256_div_pd( _mm256_mul_pd( dc_c_phi, inv_rho ), sin_theta ) ) ) ;
+
+        _mm256_storeu_pd( a.dc_c_rho + n, dc_c_rho ) ;
+        _mm256_storeu_pd( a.dc_c_theta + n, dc_c_theta ) ;
+        _mm256_storeu_pd( a.dc_c_phi + n, dc_c_phi ) ;
+        _mm256_storeu_pd( a.sin_theta + n, sin_theta ) ;
+        _mm256_storeu_pd( a.cot_theta + n, cot_theta ) ;
+    }
+    compute_scalar( a, last, size ) ;
+}
+
+/**
+ * AVX-512 version of the kernel, 8 rays per iteration.
+ */
+__attribute__((target("avx512f")))
+void compute_avx512( const wave_front_kernel::terms& a, size_t size ) {
+    const size_t last = size - size % 8 ;
+    const __m512d one = _mm512_set1_pd( 1.0 ) ;
+    double sin_t[8], cos_t[8] ;
+    for ( size_t n=0 ; n < last ; n += 8 ) {
+        for ( size_t k=0 ; k < 8 ; ++k ) {
+            sin_t[k] = std::sin( a.theta[n+k] ) ;
+            cos_t[k] = std::cos( a.theta[n+k] ) ;
+        }
+        const __m512d sin_theta = _mm512_loadu_pd( sin_t ) ;
+        const __m512d cot_theta = _mm512_div_pd( _mm512_loadu_pd( cos_t ), sin_theta ) ;
+        const __m512d rho = _mm512_loadu_pd( a.rho + n ) ;
+        const __m512d c = _mm512_loadu_pd( a.sound_speed + n ) ;
+        const __m512d nr = _mm512_loadu_pd( a.ndir_rho + n ) ;
+        const __m512d nt = _mm512_loadu_pd( a.ndir_theta + n ) ;
+        const __m512d np = _mm512_loadu_pd( a.ndir_phi + n ) ;
+
+        const __m512d inv_c = _mm512_div_pd( one, c ) ;
+        const __m512d dc_c_rho = _mm512_mul_pd( _mm512_loadu_pd( a.grad_rho + n ), inv_c ) ;
+        const __m512d dc_c_theta = _mm512_mul_pd( _mm512_loadu_pd( a.grad_theta + n ), inv_c ) ;
+        const __m512d dc_c_phi = _mm512_mul_pd( _mm512_loadu_pd( a.grad_phi + n ), inv_c ) ;
+
+        // Reilly eqns. 36-38
+
+        const __m512d c2 = _mm512_mul_pd( c, c ) ;
+        const __m512d inv_rho = _mm512_div_pd( one, rho ) ;
+        const __m512d c2_r = _mm512_mul_pd( c2, inv_rho ) ;
+        const __m512d c2_rs = _mm512_div_pd( c2_r, sin_theta ) ;
+        _mm512_storeu_pd( a.pos_grad_rho + n, _mm512_mul_pd( c2, nr ) ) ;
+        _mm512_storeu_pd( a.pos_grad_theta + n, _mm512_mul_pd( c2_r, nt ) ) ;
+        _mm512_storeu_pd( a.pos_grad_phi + n, _mm512_mul_pd( c2_rs, np ) ) ;
+
+        // Reilly eqns. 39-41
+
+        const __m512d np2 = _mm512_mul_pd( np, np ) ;
+        _mm512_storeu_pd( a.ndir_grad_rho + n, _mm512_fmsub_pd(
+            c2_r, _mm512_fmadd_pd( nt, nt, np2 ), dc_c_rho ) ) ;
+        _mm512_storeu_pd( a.ndir_grad_theta + n, _mm512_fnmsub_pd(
+            c2_r, _mm512_fnmadd_pd( np2, cot_theta, _mm512_mul_pd( nr, nt ) ),
+            _mm512_mul_pd( dc_c_theta, inv_rho ) ) ) ;
+        _mm512_storeu_pd( a.ndir_grad_phi + n, _mm512_fnmsub_pd(
+            c2_r, _mm512_mul_pd( np, _mm512_fmadd_pd( nt, cot_theta, nr ) ),
+            _mm512_div_pd( _mm512_mul_pd( dc_c_phi, inv_rho ), sin_theta ) ) ) ;
+
+        _mm512_storeu_pd( a.dc_c_rho + n, dc_c_rho ) ;
+        _mm512_storeu_pd( a.dc_c_theta + n, dc_c_theta ) ;
+        _mm512_storeu_pd( a.dc_c_phi + n, dc_c_phi ) ;
+        _mm512_storeu_pd( a.sin_theta + n, sin_theta ) ;
+        _mm512_storeu_pd( a.cot_theta + n, cot_theta ) ;
+    }
+    compute_scalar( a, last, size ) ;
+}
+
+#endif
+
+}  // end of anonymous namespace
+
+/**
+ * Instruction set used by compute().
+ */
+wave_front_kernel::instruction_set wave_front_kernel::_active
+    = wave_front_kernel::supported() ;
+
+/**
+ * Computes the derivatives using the active instruction set.
+ */
+void wave_front_kernel::compute( const terms& args, size_t size ) {
+    compute( args, size, _active ) ;
+}
+
+/**
+ * Computes the derivatives using a specific instruction set.
+ */
+void wave_front_kernel::compute( const terms& args, size_t size,
+                                 instruction_set isa )
+{
+    if ( isa > supported() ) isa = supported() ;
+    switch ( isa ) {
+        #ifdef USML_WAVE_FRONT_X86
+            case AVX512:
+                compute_avx512( args, size ) ;
+                break ;
+            case AVX2:
+                compute_avx2( args, size ) ;
+                break ;
+        #endif
+        default:
+            compute_scalar( args, 0, size ) ;
+            break ;
+    }
+}
+
+/**
+ * Most capable instruction set supported by this processor.
+ */
+wave_front_kernel::instruction_set wave_front_kernel::supported() {
+    #ifdef USML_WAVE_FRONT_X86
+        __builtin_cpu_init() ;  // may be called before main()
+        static const instruction_set isa =
+            __builtin_cpu_supports( "avx512f" ) ? AVX512 :
+            ( __builtin_cpu_supports( "avx2" )
+              && __builtin_cpu_supports( "fma" ) ) ? AVX2 : SCALAR ;
+        return isa ;
+    #else
+        return SCALAR ;
+    #endif
+}
+
+/**
+ * Selects the instruction set used by compute().
+ */
+wave_front_kernel::instruction_set wave_front_kernel::active(
+    instruction_set isa )
+{
+    _active = ( isa > supported() ) ? supported() : isa ;
+    return _active ;
+}
+
+/**
+ * Human readable name for an instruction set.
+ */
+const char* wave_front_kernel::name( instruction_set isa ) {
+    switch ( isa ) {
+        case AVX512: return "avx512" ;
+        case AVX2: return "avx2" ;
+        default: return "scalar" ;
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * @file wave_front_kernel.h
+ * Fused computation of the wavefront propagation derivatives.
+ */
+#pragma once
+
+#include <usml/usml_config.h>
+#include <cstddef>
+
+namespace usml {
+namespace waveq3d {
+
+using std::size_t ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Computes the Reilly eqns. 36-41 derivatives for every point on a
+ * wavefront in a single pass over memory.  The uBLAS form of these
+ * equations makes several temporary passes over each matrix.  This kernel
+ * reads the position, direction, and sound speed of each ray once, and
+ * writes all of the derivatives and cached intermediate terms in the
+ * same loop iteration.
+ *
+ * On x86 processors, compiled with gcc or clang, the kernel processes
+ * 4 rays at a time with AVX2/FMA instructions, or 8 rays at a time with
+ * AVX-512 instructions.  The instruction set is selected at run time
+ * from the features of the processor, so the library itself does not
+ * need to be compiled with -mavx2.  All other platforms use the scalar
+ * version.  Because the vector versions use fused multiply-add
+ * operations, their results may differ from the scalar version in
+ * the last few bits.
+ *
+ * All arrays must have the same number of elements and must not overlap.
+ *
+ * @xref S.M. Reilly, G. Potty, Sonar Propagation Modeling using Hybrid
+ * Gaussian Beams in Spherical/Time Coordinates, January 2012.
+ */
+class USML_DECLSPEC wave_front_kernel {
+
+  public:
+
+    /** Instruction sets supported by this kernel. */
+    enum instruction_set {
+        SCALAR = 0,     ///< portable C++ implementation
+        AVX2 = 1,       ///< 4 rays at a time using AVX2 and FMA
+        AVX512 = 2      ///< 8 rays at a time using AVX-512F
+    };
+
+    /**
+     * Inputs and outputs for the derivative calculation.
+     * Each pointer refers to the row-major storage of a num_de x num_az
+     * matrix.
+     */
+    struct terms {
+        const double* rho ;             ///< position.rho()
+        const double* theta ;           ///< position.theta()
+        const double* ndir_rho ;        ///< ndirection.rho()
+        const double* ndir_theta ;      ///< ndirection.theta()
+        const double* ndir_phi ;        ///< ndirection.phi()
+        const double* sound_speed ;     ///< sound_speed
+        const double* grad_rho ;        ///< sound_gradient.rho()
+        const double* grad_theta ;      ///< sound_gradient.theta()
+        const double* grad_phi ;        ///< sound_gradient.phi()
+        double* pos_grad_rho ;          ///< pos_gradient.rho() result
+        double* pos_grad_theta ;        ///< pos_gradient.theta() result
+        double* pos_grad_phi ;          ///< pos_gradient.phi() result
+        double* ndir_grad_rho ;         ///< ndir_gradient.rho() result
+        double* ndir_grad_theta ;       ///< ndir_gradient.theta() result
+        double* ndir_grad_phi ;         ///< ndir_gradient.phi() result
+        double* dc_c_rho ;              ///< sound gradient / sound speed
+        double* dc_c_theta ;            ///< sound gradient / sound speed
+        double* dc_c_phi ;              ///< sound gradient / sound speed
+        double* sin_theta ;             ///< sin(theta) result
+        double* cot_theta ;             ///< cot(theta) result
+    };
+
+    /**
+     * Computes the derivatives using the active instruction set.
+     *
+     * @param  args     Inputs and outputs of the calculation.
+     * @param  size     Number of elements in each array.
+     */
+    static void compute( const terms& args, size_t size ) ;
+
+    /**
+     * Computes the derivatives using a specific instruction set.
+     * Falls back to the scalar version if the processor does not
+     * support the requested instruction set.
+     *
+     * @param  args     Inputs and outputs of the calculation.
+     * @param  size     Number of elements in each array.
+     * @param  isa      Instruction set to use.
+     */
+    static void compute( const terms& args, size_t size,
+                         instruction_set isa ) ;
+
+    /**
+     * Most capable instruction set supported by this processor.
+     */
+    static instruction_set supported() ;
+
+    /**
+     * Instruction set used by compute().  Defaults to supported().
+     */
+    static instruction_set active() {
+        return _active ;
+    }
+
+    /**
+     * Selects the instruction set used by compute().  Requests for
+     * instruction sets that this processor does not support are limited
+     * to supported().  Intended for benchmarks and regression tests;
+     * it must not be called while other threads are updating wavefronts.
+     *
+     * @param  isa      Requested instruction set.
+     * @return          Instruction set actually selected.
+     */
+    static instruction_set active( instruction_set isa ) ;
+
+    /**
+     * Human readable name for an instruction set.
+     */
+    static const char* name( instruction_set isa ) ;
+
+  private:
+
+    /** Instruction set used by compute(). */
+    static instruction_set _active ;
+};
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
@@ -0,0 +1,104 @@
+/**
+ * @file wave_partition.cc
+ * Splits the rows of a ray fan into blocks that are processed in parallel.
+ */
+#include <usml/waveq3d/wave_partition.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+using namespace usml::waveq3d ;
+
+/**
+ * Creates worker threads for a fan with a specific number of rows.
+ */
+wave_partition::wave_partition( size_t num_rows, size_t num_blocks ) :
+    _num_rows( num_rows ),
+    _num_blocks( std::max( (size_t) 1, std::min( num_rows, num_blocks ) ) ),
+    _task( NULL ),
+    _generation( 0 ),
+    _remaining( 0 ),
+    _shutdown( false )
+{
+    for ( size_t n=1 ; n < _num_blocks ; ++n ) {
+        _threads.create_thread( boost::bind( &wave_partition::worker, this, n ) ) ;
+    }
+}
+
+/**
+ * Terminates the worker threads.
+ */
+wave_partition::~wave_partition() {
+    {
+        boost::lock_guard<boost::mutex> lock( _mutex ) ;
+        _shutdown = true ;
+    }
+    _start.notify_all() ;
+    try {
+        _threads.join_all() ;
+    } catch( ... ) {
+        // suppress all exceptions
+    }
+}
+
+/**
+ * Applies an operation to every block, and waits for all of them.
+ */
+void wave_partition::run( block_task& task ) {
+    {
+        boost::lock_guard<boost::mutex> lock( _mutex ) ;
+        _task = &task ;
+        _error = boost::exception_ptr() ;
+        _remaining = _num_blocks - 1 ;
+        ++_generation ;
+    }
+    _start.notify_all() ;
+
+    run_block( 0 ) ;
+
+    boost::unique_lock<boost::mutex> lock( _mutex ) ;
+    while ( _remaining > 0 ) {
+        _done.wait( lock ) ;
+    }
+    _task = NULL ;
+    if ( _error ) {
+        boost::exception_ptr error = _error ;
+        _error = boost::exception_ptr() ;
+        lock.unlock() ;
+        boost::rethrow_exception( error ) ;
+    }
+}
+
+/**
+ * Loop executed by each worker thread.
+ */
+void wave_partition::worker( size_t block ) {
+    size_t generation = 0 ;
+    while ( true ) {
+        {
+            boost::unique_lock<boost::mutex> lock( _mutex ) ;
+            while ( !_shutdown && _generation == generation ) {
+                _start.wait( lock ) ;
+            }
+            if ( _shutdown ) return ;
+            generation = _generation ;
+        }
+        run_block( block ) ;
+        {
+            boost::lock_guard<boost::mutex> lock( _mutex ) ;
+            --_remaining ;
+        }
+        _done.notify_one() ;
+    }
+}
+
+/**
+ * Applies the current task to one block, and saves any exception.
+ */
+void wave_partition::run_block( size_t block ) {
+    try {
+        _task->run_block( block, first(block), last(block) ) ;
+    } catch( ... ) {
+        boost::lock_guard<boost::mutex> lock( _mutex ) ;
+        if ( !_error ) _error = boost::current_exception() ;
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file wave_partition.h
+ * Splits the rows of a ray fan into blocks that are processed in parallel.
+ */
+#pragma once
+
+#include <usml/usml_config.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/exception_ptr.hpp>
+#include <cstddef>
+
+namespace usml {
+namespace waveq3d {
+
+using std::size_t ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Splits the D/E rows of a ray fan into contiguous blocks and runs the
+ * same operation on each block in parallel. Used by the wave_queue to
+ * spread the work of each propagation step across multiple processors.
+ *
+ * Unlike the thread_pool, whose tasks run independently of the caller,
+ * this class keeps a fixed set of worker threads that are released
+ * together by run() and it does not return until every block has finished.
+ * The calling thread processes the first block itself, so a partition
+ * with N blocks only creates N-1 worker threads.  Worker threads are
+ * private to each partition. This prevents a wave_queue, that is itself
+ * running inside of a thread_pool task, from waiting on a shared pool
+ * that is busy running other wave_queue tasks.
+ *
+ * Blocks cover the rows [first(n),last(n)), and the row count of
+ * neighbouring blocks differs by at most one.
+ */
+class USML_DECLSPEC wave_partition {
+
+  public:
+
+    /**
+     * Operation applied to each block of rows.  Implementations must
+     * only write data that belongs to their own block.
+     */
+    class block_task {
+      public:
+
+        /** Virtual destructor. */
+        virtual ~block_task() {}
+
+        /**
+         * Process a single block of rows.
+         *
+         * @param  block    Block number in the range [0,num_blocks).
+         * @param  first    First row in this block.
+         * @param  last     One past the last row in this block.
+         */
+        virtual void run_block( size_t block, size_t first, size_t last ) = 0 ;
+    };
+
+    /**
+     * Creates worker threads for a fan with a specific number of rows.
+     *
+     * @param  num_rows     Number of D/E rows in the ray fan.
+     * @param  num_blocks   Number of blocks to split the rows into,
+     *                      limited to the range [1,num_rows].
+     */
+    wave_partition( size_t num_rows, size_t num_blocks ) ;
+
+    /**
+     * Terminates the worker threads.
+     */
+    ~wave_partition() ;
+
+    /** Number of blocks in this partition. */
+    inline size_t num_blocks() const {
+        return _num_blocks ;
+    }
+
+    /** First row in a block. */
+    inline size_t first( size_t block ) const {
+        return block * _num_rows / _num_blocks ;
+    }
+
+    /** One past the last row in a block. */
+    inline size_t last( size_t block ) const {
+        return ( block + 1 ) * _num_rows / _num_blocks ;
+    }
+
+    /**
+     * Applies an operation to every block, and waits for all of them
+     * to complete. If any block throws an exception, it is re-thrown in
+     * the calling thread after all blocks are done.
+     *
+     * @param  task     Operation to apply to each block.
+     */
+    void run( block_task& task ) ;
+
+  private:
+
+    /** Number of D/E rows in the ray fan. */
+    const size_t _num_rows ;
+
+    /** Number of blocks in this partition. */
+    const size_t _num_blocks ;
+
+    /** Worker threads for blocks 1 to num_blocks-1. */
+    boost::thread_group _threads ;
+
+    /** Protects all of the state used to synchronize workers. */
+    boost::mutex _mutex ;
+
+    /** Signals workers that a new task is available. */
+    boost::condition_variable _start ;
+
+    /** Signals the caller that workers have finished. */
+    boost::condition_variable _done ;
+
+    /** Task currently being processed. */
+    block_task* _task ;
+
+    /** Incremented each time a new task is released to the workers. */
+    size_t _generation ;
+
+    /** Number of workers that have not finished the current task. */
+    size_t _remaining ;
+
+    /** Tells workers to exit. */
+    bool _shutdown ;
+
+    /** First exception thrown by a block of the current task. */
+    boost::exception_ptr _error ;
+
+    /**
+     * Loop executed by each worker thread.
+     *
+     * @param  block    Block number processed by this worker.
+     */
+    void worker( size_t block ) ;
+
+    /**
+     * Applies the current task to one block, and saves any exception.
+     *
+     * @param  block    Block number to process.
+     */
+    void run_block( size_t block ) ;
+};
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
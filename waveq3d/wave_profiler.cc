@@ -0,0 +1,190 @@
+/**
+ * @file wave_profiler.cc
+ * Counts the time spent in each phase of the wavefront propagation.
+ */
+#include <usml/waveq3d/wave_profiler.h>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+    #include <intrin.h>
+    #define USML_PROFILER_RDTSC
+#elif defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+    #include <x86intrin.h>
+    #define USML_PROFILER_RDTSC
+#endif
+
+using namespace usml::waveq3d ;
+
+boost::atomic<bool> wave_profiler::_enabled( false ) ;
+boost::atomic<size_t> wave_profiler::_calls[wave_profiler::NUM_PHASES] ;
+boost::atomic<wave_profiler::ticks_type> wave_profiler::_ticks[wave_profiler::NUM_PHASES] ;
+boost::atomic<wave_profiler::ticks_type> wave_profiler::_max_ticks[wave_profiler::NUM_PHASES] ;
+boost::atomic<size_t> wave_profiler::_events[wave_profiler::NUM_EVENTS] ;
+
+namespace {
+
+typedef boost::posix_time::microsec_clock clock_type ;
+
+/** Protects the calibration of the cycle counter. */
+boost::mutex calibration_mutex ;
+
+/** Cycle counter at the last reset. */
+wave_profiler::ticks_type calibration_ticks = 0 ;
+
+/** System clock at the last reset. */
+boost::posix_time::ptime calibration_time = clock_type::universal_time() ;
+
+/** Names of each phase in the JSON output. */
+const char* phase_names[wave_profiler::NUM_PHASES] = {
+    "wave_update",
+    "detect_reflections",
+    "detect_eigenrays",
+    "build_eigenray",
+    "spreading",
+    "build_eigenverb",
+    "wavefront_task",
+    "envelope_task"
+} ;
+
+/** Names of each event in the JSON output. */
+const char* event_names[wave_profiler::NUM_EVENTS] = {
+    "wave_steps",
+    "surface_reflections",
+    "bottom_reflections",
+    "eigenrays",
+    "eigenverbs",
+    "envelope_contributions",
+    "step_rejections",
+    "ray_splits",
+    "ray_merges"
+} ;
+
+}   // end of anonymous namespace
+
+/**
+ * Turns the counters on or off.
+ */
+void wave_profiler::enable( bool flag ) {
+    _enabled.store( flag, boost::memory_order_relaxed ) ;
+}
+
+/**
+ * Sets all counters to zero.
+ */
+void wave_profiler::reset() {
+    for ( size_t n=0 ; n < NUM_PHASES ; ++n ) {
+        _calls[n].store( 0, boost::memory_order_relaxed ) ;
+        _ticks[n].store( 0, boost::memory_order_relaxed ) ;
+        _max_ticks[n].store( 0, boost::memory_order_relaxed ) ;
+    }
+    for ( size_t n=0 ; n < NUM_EVENTS ; ++n ) {
+        _events[n].store( 0, boost::memory_order_relaxed ) ;
+    }
+    boost::lock_guard<boost::mutex> lock( calibration_mutex ) ;
+    calibration_ticks = ticks() ;
+    calibration_time = clock_type::universal_time() ;
+}
+
+/**
+ * Current value of the cycle counter.
+ */
+wave_profiler::ticks_type wave_profiler::ticks() {
+    #ifdef USML_PROFILER_RDTSC
+        return (ticks_type) __rdtsc() ;
+    #else
+        static const boost::posix_time::ptime epoch( boost::gregorian::date(1970,1,1) ) ;
+        return (ticks_type) ( clock_type::universal_time() - epoch ).total_microseconds() ;
+    #endif
+}
+
+/**
+ * Adds a single call to a phase.
+ */
+void wave_profiler::add_call( phase_type phase, ticks_type elapsed ) {
+    if ( ! enabled() ) return ;
+    _calls[phase].fetch_add( 1, boost::memory_order_relaxed ) ;
+    _ticks[phase].fetch_add( elapsed, boost::memory_order_relaxed ) ;
+    ticks_type longest = _max_ticks[phase].load( boost::memory_order_relaxed ) ;
+    while ( elapsed > longest
+        && ! _max_ticks[phase].compare_exchange_weak( longest, elapsed,
+            boost::memory_order_relaxed ) )
+    {
+    }
+}
+
+/**
+ * Snapshot of all counters.
+ */
+wave_profiler::statistics_type wave_profiler::statistics() {
+    statistics_type stats ;
+    stats.enabled = enabled() ;
+
+    // compare the cycle counter to the system clock since the last reset
+
+    #ifdef USML_PROFILER_RDTSC
+    {
+        boost::lock_guard<boost::mutex> lock( calibration_mutex ) ;
+        const double elapsed = 1e-6 * ( clock_type::universal_time()
+            - calibration_time ).total_microseconds() ;
+        stats.ticks_per_second = ( elapsed > 0.0 ) ?
+            (double) ( ticks() - calibration_ticks ) / elapsed : 0.0 ;
+    }
+    #else
+        stats.ticks_per_second = 1e6 ;
+    #endif
+    const double scale = ( stats.ticks_per_second > 0.0 ) ?
+        1.0 / stats.ticks_per_second : 0.0 ;
+
+    for ( size_t n=0 ; n < NUM_PHASES ; ++n ) {
+        phase_statistics& phase = stats.phases[n] ;
+        phase.calls = _calls[n].load( boost::memory_order_relaxed ) ;
+        phase.ticks = _ticks[n].load( boost::memory_order_relaxed ) ;
+        phase.seconds = scale * (double) phase.ticks ;
+        phase.max_seconds = scale
+            * (double) _max_ticks[n].load( boost::memory_order_relaxed ) ;
+    }
+    for ( size_t n=0 ; n < NUM_EVENTS ; ++n ) {
+        stats.events[n] = _events[n].load( boost::memory_order_relaxed ) ;
+    }
+    return stats ;
+}
+
+/**
+ * Writes a snapshot of all counters as a JSON document.
+ */
+void wave_profiler::write_json( std::ostream& os ) {
+    const statistics_type stats = statistics() ;
+    os << "{ \"enabled\": " << ( stats.enabled ? "true" : "false" )
+       << ", \"ticks_per_second\": " << stats.ticks_per_second
+       << ",\n  \"phases\": {" ;
+    for ( size_t n=0 ; n < NUM_PHASES ; ++n ) {
+        const phase_statistics& phase = stats.phases[n] ;
+        os << ( n ? ",\n    \"" : "\n    \"" ) << phase_names[n]
+           << "\": { \"calls\": " << phase.calls
+           << ", \"ticks\": " << phase.ticks
+           << ", \"seconds\": " << phase.seconds
+           << ", \"max_seconds\": " << phase.max_seconds << " }" ;
+    }
+    os << " },\n  \"events\": {" ;
+    for ( size_t n=0 ; n < NUM_EVENTS ; ++n ) {
+        os << ( n ? ", \"" : " \"" ) << event_names[n]
+           << "\": " << stats.events[n] ;
+    }
+    os << " } }" << std::endl ;
+}
+
+/**
+ * Name of a phase in the JSON output.
+ */
+const char* wave_profiler::phase_name( phase_type phase ) {
+    return phase_names[phase] ;
+}
+
+/**
+ * Name of an event in the JSON output.
+ */
+const char* wave_profiler::event_name( event_type event ) {
+    return event_names[event] ;
+}
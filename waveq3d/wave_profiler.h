@@ -0,0 +1,244 @@
+/**
+ * @file wave_profiler.h
+ * Counts the time spent in each phase of the wavefront propagation.
+ */
+#pragma once
+
+#include <usml/usml_config.h>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+#include <iostream>
+
+namespace usml {
+namespace waveq3d {
+
+using std::size_t ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Process wide counters for the hot paths of the wave_queue, the
+ * wavefront_generator, and the envelope_generator.  Each phase keeps
+ * the number of calls, and the total and longest time spent inside
+ * those calls, measured with the processor's cycle counter.  Events,
+ * like reflections and eigenrays, keep a simple count.  Phases nest, so
+ * the time in BUILD_EIGENRAY is also included in DETECT_EIGENRAYS.
+ *
+ * The counters are compiled into the library, but are disabled by default.
+ * When disabled, each instrumentation point costs a single relaxed
+ * atomic load.  When enabled, the counters are updated with atomic
+ * operations, so that wave_queue objects running in different threads
+ * can share them.
+ *
+ * <pre>
+ *      wave_profiler::reset() ;
+ *      wave_profiler::enable( true ) ;
+ *      while ( wave.time() < 90.0 ) wave.step() ;
+ *      wave_profiler::enable( false ) ;
+ *      wave_profiler::write_json( std::cout ) ;
+ * </pre>
+ *
+ * Cycle counts are converted to seconds by comparing the cycle counter
+ * to the system clock over the time since the last reset(). On processors
+ * without a cycle counter, microseconds from the system clock are used.
+ */
+class USML_DECLSPEC wave_profiler {
+
+public:
+
+    /** Value of the cycle counter. */
+    typedef boost::uint64_t ticks_type ;
+
+    /** Instrumented sections of code. */
+    enum phase_type {
+        WAVE_UPDATE = 0,        ///< wave_front::update() for the next step
+        DETECT_REFLECTIONS,     ///< wave_queue::detect_reflections()
+        DETECT_EIGENRAYS,       ///< wave_queue::detect_eigenrays()
+        BUILD_EIGENRAY,         ///< wave_queue::build_eigenray()
+        SPREADING,              ///< spreading_model::intensity()
+        BUILD_EIGENVERB,        ///< wave_queue::build_eigenverb()
+        WAVEFRONT_TASK,         ///< wavefront_generator::run()
+        ENVELOPE_TASK,          ///< envelope_generator::run()
+        NUM_PHASES
+    } ;
+
+    /** Events counted along the hot paths. */
+    enum event_type {
+        WAVE_STEPS = 0,         ///< calls to wave_queue::step()
+        SURFACE_REFLECTIONS,    ///< rays reflected by the ocean surface
+        BOTTOM_REFLECTIONS,     ///< rays reflected by the ocean bottom
+        EIGENRAYS,              ///< eigenrays sent to listeners
+        EIGENVERBS,             ///< eigenverbs sent to listeners
+        ENVELOPE_CONTRIBUTIONS, ///< eigenverb pairs added to envelopes
+        STEP_REJECTIONS,        ///< steps repeated by the adaptive time step
+        RAY_SPLITS,             ///< D/E rows added by the fan refinement
+        RAY_MERGES,             ///< D/E rows removed by the fan refinement
+        NUM_EVENTS
+    } ;
+
+    /**
+     * Counters for a single phase.
+     */
+    struct phase_statistics {
+
+        /** Number of times that the phase was entered. */
+        size_t calls ;
+
+        /** Total cycles spent in the phase. */
+        ticks_type ticks ;
+
+        /** Total time spent in the phase (sec). */
+        double seconds ;
+
+        /** Longest time spent in a single call (sec). */
+        double max_seconds ;
+    } ;
+
+    /**
+     * Snapshot of all counters.
+     */
+    struct statistics_type {
+
+        /** True if the counters were enabled when the snapshot was taken. */
+        bool enabled ;
+
+        /** Cycle counter rate used to convert ticks to seconds. */
+        double ticks_per_second ;
+
+        /** Counters for each phase, indexed by phase_type. */
+        phase_statistics phases[NUM_PHASES] ;
+
+        /** Counts for each event, indexed by event_type. */
+        size_t events[NUM_EVENTS] ;
+    } ;
+
+    /**
+     * Turns the counters on or off. Counters keep their values
+     * while disabled.
+     */
+    static void enable( bool flag ) ;
+
+    /**
+     * True if the counters are being updated.
+     */
+    static bool enabled() {
+        return _enabled.load( boost::memory_order_relaxed ) ;
+    }
+
+    /**
+     * Sets all counters to zero, and restarts the
+     * calibration of the cycle counter.
+     */
+    static void reset() ;
+
+    /**
+     * Current value of the cycle counter.
+     */
+    static ticks_type ticks() ;
+
+    /**
+     * Adds a single call to a phase. Does nothing if disabled.
+     *
+     * @param   phase       Section of code that was called.
+     * @param   elapsed     Cycles spent in that call.
+     */
+    static void add_call( phase_type phase, ticks_type elapsed ) ;
+
+    /**
+     * Adds to the count for an event. Does nothing if disabled.
+     *
+     * @param   event       Event that occurred.
+     * @param   count       Number of times that it occurred.
+     */
+    static void add_event( event_type event, size_t count = 1 ) {
+        if ( enabled() ) {
+            _events[event].fetch_add( count, boost::memory_order_relaxed ) ;
+        }
+    }
+
+    /**
+     * Snapshot of all counters.
+     */
+    static statistics_type statistics() ;
+
+    /**
+     * Writes a snapshot of all counters as a JSON document
+     * of the form:
+     * <pre>
+     *  { "enabled": true, "ticks_per_second": 2.9e9,
+     *    "phases": {
+     *      "wave_update": { "calls": 900, "ticks": ...,
+     *                       "seconds": ..., "max_seconds": ... },
+     *      ... },
+     *    "events": { "wave_steps": 900, ... } }
+     * </pre>
+     *
+     * @param   os          Stream to write to.
+     */
+    static void write_json( std::ostream& os ) ;
+
+    /**
+     * Name of a phase in the JSON output.
+     */
+    static const char* phase_name( phase_type phase ) ;
+
+    /**
+     * Name of an event in the JSON output.
+     */
+    static const char* event_name( event_type event ) ;
+
+    /**
+     * Measures the time from construction to destruction
+     * as a single call to a phase.  Does nothing if the counters
+     * are disabled when it is constructed.
+     */
+    class scoped_timer {
+    public:
+
+        /** Starts the clock if the counters are enabled. */
+        scoped_timer( phase_type phase ) :
+            _phase( phase ), _running( enabled() ),
+            _start( _running ? ticks() : 0 )
+        {
+        }
+
+        /** Adds the elapsed time to the phase. */
+        ~scoped_timer() {
+            if ( _running ) add_call( _phase, ticks() - _start ) ;
+        }
+
+    private:
+        const phase_type _phase ;
+        const bool _running ;
+        const ticks_type _start ;
+
+        scoped_timer( const scoped_timer& ) ;
+        scoped_timer& operator=( const scoped_timer& ) ;
+    } ;
+
+private:
+
+    /** True if the counters are being updated. */
+    static boost::atomic<bool> _enabled ;
+
+    /** Number of calls to each phase. */
+    static boost::atomic<size_t> _calls[NUM_PHASES] ;
+
+    /** Total cycles spent in each phase. */
+    static boost::atomic<ticks_type> _ticks[NUM_PHASES] ;
+
+    /** Longest single call to each phase, in cycles. */
+    static boost::atomic<ticks_type> _max_ticks[NUM_PHASES] ;
+
+    /** Count of each event. */
+    static boost::atomic<size_t> _events[NUM_EVENTS] ;
+
+    /** Hide constructor to prevent instances of this class. */
+    wave_profiler() {}
+} ;
+
+/// @}
+}   // end of namespace waveq3d
+}   // end of namespace usml
@@ -4,6 +4,7 @@
  */
 #include <usml/waveq3d/wave_queue.h>
 #include <usml/waveq3d/ode_integ.h>
+#include <usml/waveq3d/wave_profiler.h>
 #include <usml/waveq3d/reflection_model.h>
 #include <usml/waveq3d/spreading_ray.h>
 #include <usml/waveq3d/spreading_hybrid_gaussian.h>
@@ -13,6 +14,7 @@
 #include <boost/numeric/ublas/lu.hpp>
 
 #include <iomanip>
+#include <algorithm>
 
 //#define DEBUG_EIGENRAYS_DETAIL
 //#define DEBUG_EIGENRAYS
@@ -20,6 +22,12 @@
 
 using namespace usml::waveq3d ;
 
+/**
+ * Number of rays around each live ray that are integrated
+ * even when they are dead.
+ */
+const size_t wave_queue::active_halo ;
+
 /**
  * Initialize a propagation scenario.
  */
@@ -42,10 +50,29 @@ wave_queue::wave_queue(
     _max_de( de.size()-1 ),
     _max_az( az.size()-1 ),
     _time_step( time_step ),
+    _prev_step( time_step ),
+    _past_step( time_step ),
+    _step_tolerance( 0.0 ),
+    _min_step( time_step ),
+    _max_step( time_step ),
+    _step_proposal( time_step ),
+    _num_rejected( 0 ),
     _time( 0.0 ),
     _targets( targets ),
     _run_id(run_id),
-    _nc_file( NULL )
+    _partition( NULL ),
+    _target_tree( NULL ),
+    _use_active_set( false ),
+    _num_retiring( 0 ),
+    _use_symmetry( false ),
+    _symmetry_workspace( NULL ),
+    _fan_tolerance( 0.0 ),
+    _min_de_spacing( 0.0 ),
+    _max_fan_de( 0 ),
+    _num_splits( 0 ),
+    _num_merges( 0 ),
+    _nc_file( NULL ),
+    _num_recorders( 0 )
 {
     _az_boundary = false ;
     if( _source_az->size() > 1 ) {
@@ -80,11 +107,24 @@ wave_queue::wave_queue(
 
     _curr->init_wave( pos, de, az ) ;
     _curr->update() ;
+    _source_speed = _curr->sound_speed(0,0) ;
     init_wavefronts() ;
     _reflection_model = new reflection_model( *this ) ;
     _spreading_model = NULL ;
+    _spreading_type = type ;
+    make_spreading_model() ;
+}
+
+/**
+ * Creates the spreading model for the current ray fan.
+ */
+void wave_queue::make_spreading_model() {
+    if ( _spreading_model ) {
+        delete _spreading_model ;
+        _spreading_model = NULL ;
+    }
     if ( _source_de->size() >= 3 && _source_az->size() >= 3 ) {
-		switch( type ) {
+		switch( _spreading_type ) {
 			case HYBRID_GAUSSIAN :
 				_spreading_model = new spreading_hybrid_gaussian( *this ) ;
 				break ;
@@ -97,6 +137,10 @@ wave_queue::wave_queue(
 
 /** Destroy all temporary memory. */
 wave_queue::~wave_queue() {
+    use_active_set( false ) ;
+    use_azimuthal_symmetry( false ) ;
+    num_threads( 1 ) ;
+    use_target_index( false ) ;
     if ( _spreading_model ) delete _spreading_model ;
     delete _reflection_model ;
     delete _source_de ;
@@ -107,6 +151,446 @@ wave_queue::~wave_queue() {
     delete _next ;
 }
 
+/**
+ * Applies wave_front::update() to one block of the partition.
+ */
+class wave_queue::update_task : public wave_partition::block_task {
+  public:
+    update_task( wave_front* wave, std::vector<wave_front*>& workspace ) :
+        _wave( wave ), _workspace( workspace )
+    {
+    }
+
+    virtual void run_block( size_t block, size_t first, size_t last ) {
+        _wave->update( first, *_workspace[block] ) ;
+    }
+
+  private:
+    wave_front* _wave ;
+    std::vector<wave_front*>& _workspace ;
+};
+
+/**
+ * Applies find_eigenrays() to one block of the partition.
+ */
+class wave_queue::eigenray_task : public wave_partition::block_task {
+  public:
+    eigenray_task( const wave_queue& queue, size_t num_blocks ) :
+        found( num_blocks ), _queue( queue )
+    {
+    }
+
+    virtual void run_block( size_t block, size_t first, size_t last ) {
+        _queue.find_eigenrays( first, last, &found[block] ) ;
+    }
+
+    /** Closest points of approach found in each block. */
+    std::vector< std::vector<eigenray_candidate> > found ;
+
+  private:
+    const wave_queue& _queue ;
+};
+
+/**
+ * Applies wave_front::update() to one block of the active rays.
+ */
+class wave_queue::active_update_task : public wave_partition::block_task {
+  public:
+    active_update_task( wave_front* wave, const std::vector<size_t>& active,
+        std::vector<wave_front*>& workspace ) :
+        _wave( wave ), _active( active ), _workspace( workspace )
+    {
+    }
+
+    virtual void run_block( size_t block, size_t first, size_t last ) {
+        if ( block >= _workspace.size() ) return ;
+        const size_t offset = block * _active.size() / _workspace.size() ;
+        _wave->update( &_active[offset], *_workspace[block] ) ;
+    }
+
+  private:
+    wave_front* _wave ;
+    const std::vector<size_t>& _active ;
+    std::vector<wave_front*>& _workspace ;
+};
+
+/**
+ * Number of threads used to process each propagation step.
+ */
+void wave_queue::num_threads( size_t num ) {
+    if ( _partition ) {
+        delete _partition ;
+        _partition = NULL ;
+    }
+    for ( size_t n=0 ; n < _workspace.size() ; ++n ) {
+        delete _workspace[n] ;
+    }
+    _workspace.clear() ;
+    if ( num <= 1 || num_de() <= 1 ) {
+        if ( _use_active_set ) compact_rays() ;
+        return ;
+    }
+
+    _partition = new wave_partition( num_de(), num ) ;
+    for ( size_t n=0 ; n < _partition->num_blocks() ; ++n ) {
+        const size_t rows = _partition->last(n) - _partition->first(n) ;
+        _workspace.push_back( new wave_front( _ocean, _frequencies,
+            rows, num_az(), _targets, &_targets_sin_theta ) ) ;
+        _workspace.back()->cache_target_distance( _target_tree == NULL ) ;
+    }
+    if ( _use_active_set ) compact_rays() ;
+}
+
+/**
+ * Controls the use of a spatial index in the eigenray search.
+ */
+void wave_queue::use_target_index( bool enable ) {
+    if ( _target_tree ) {
+        delete _target_tree ;
+        _target_tree = NULL ;
+    }
+    _branch_targets.clear() ;
+    if ( enable && _targets ) {
+        _target_tree = new target_index( *_targets ) ;
+        for ( size_t t1=0 ; t1 < _targets->size1() ; ++t1 ) {
+            for ( size_t t2=0 ; t2 < _targets->size2() ; ++t2 ) {
+                if ( is_de_branch(t1,t2) ) {
+                    _branch_targets.push_back( t1 * _targets->size2() + t2 ) ;
+                }
+            }
+        }
+    }
+    const bool cache = ( _target_tree == NULL ) ;
+    _past->cache_target_distance( cache ) ;
+    _prev->cache_target_distance( cache ) ;
+    _curr->cache_target_distance( cache ) ;
+    _next->cache_target_distance( cache ) ;
+    for ( size_t n=0 ; n < _workspace.size() ; ++n ) {
+        _workspace[n]->cache_target_distance( cache ) ;
+    }
+    for ( size_t n=0 ; n < _active_workspace.size() ; ++n ) {
+        _active_workspace[n]->cache_target_distance( cache ) ;
+    }
+}
+
+/**
+ * Controls the retirement of rays that can no longer contribute.
+ */
+void wave_queue::use_active_set( bool enable ) {
+    _use_active_set = enable ;
+    if ( enable ) {
+        if ( _use_symmetry ) use_azimuthal_symmetry( false ) ;
+        const size_t cols = num_az() ;
+        _dead.assign( num_de() * cols, false ) ;
+        for ( size_t n=0 ; n < _dead.size() ; ++n ) {
+            _dead[n] = is_dead( n / cols, n % cols ) ;
+        }
+        compact_rays() ;
+    } else {
+        for ( size_t n=0 ; n < _active_workspace.size() ; ++n ) {
+            delete _active_workspace[n] ;
+        }
+        _active_workspace.clear() ;
+        _active.clear() ;
+        _live.clear() ;
+        _dead.clear() ;
+        _num_retiring = 0 ;
+    }
+}
+
+/**
+ * Controls the azimuthally symmetric fast path.
+ */
+void wave_queue::use_azimuthal_symmetry( bool enable ) {
+    if ( _symmetry_workspace ) {
+        delete _symmetry_workspace ;
+        _symmetry_workspace = NULL ;
+    }
+    _az_rotation.clear() ;
+    _symmetry_index.clear() ;
+    _use_symmetry = enable ;
+    if ( ! enable ) return ;
+    if ( _use_active_set ) use_active_set( false ) ;
+
+    // rays in the first AZ column
+
+    const size_t rows = num_de() ;
+    const size_t cols = num_az() ;
+    _symmetry_index.resize( rows ) ;
+    for ( size_t r=0 ; r < rows ; ++r ) {
+        _symmetry_index[r] = r * cols ;
+    }
+    _symmetry_workspace = new wave_front( _ocean, _frequencies, rows, 1, NULL, NULL ) ;
+
+    // Rodrigues rotation around the vertical axis through the source,
+    // a positive AZ change is a clockwise rotation when seen from above
+
+    const double u[3] = {
+        sin( _source_pos.theta() ) * cos( _source_pos.phi() ),
+        sin( _source_pos.theta() ) * sin( _source_pos.phi() ),
+        cos( _source_pos.theta() ) } ;
+    const double cross[9] = {
+        0.0,  -u[2], u[1],
+        u[2],  0.0, -u[0],
+       -u[1],  u[0], 0.0 } ;
+    _az_rotation.resize( 9 * cols ) ;
+    for ( size_t c=0 ; c < cols ; ++c ) {
+        const double beta = - to_radians( (*_source_az)(c) - (*_source_az)(0) ) ;
+        const double cb = cos( beta ) ;
+        const double sb = sin( beta ) ;
+        double* R = &_az_rotation[9*c] ;
+        for ( size_t i=0 ; i < 3 ; ++i ) {
+            for ( size_t j=0 ; j < 3 ; ++j ) {
+                R[3*i+j] = sb * cross[3*i+j] + ( 1.0 - cb ) * u[i] * u[j]
+                         + ( ( i == j ) ? cb : 0.0 ) ;
+            }
+        }
+    }
+}
+
+/**
+ * True if the ocean only depends on depth.
+ */
+bool wave_queue::is_range_independent( ocean_model& ocean ) {
+    profile_model* profile = &ocean.profile() ;
+    if ( ! dynamic_cast<profile_linear*>( profile )
+      && ! dynamic_cast<profile_munk*>( profile )
+      && ! dynamic_cast<profile_n2*>( profile )
+      && ! dynamic_cast<profile_catenary*>( profile )
+      && ! dynamic_cast< profile_grid<double,1>* >( profile ) )
+    {
+        return false ;
+    }
+    if ( ! dynamic_cast<boundary_flat*>( &ocean.surface() )
+      || ! dynamic_cast<boundary_flat*>( &ocean.bottom() ) )
+    {
+        return false ;
+    }
+    for ( size_t n=0 ; n < ocean.num_volume() ; ++n ) {
+        if ( ! dynamic_cast<volume_flat*>( &ocean.volume(n) ) ) return false ;
+    }
+    return true ;
+}
+
+/**
+ * True if a ray on the current wavefront can no longer produce
+ * eigenrays or eigenverbs.
+ */
+bool wave_queue::is_dead( size_t de, size_t az ) {
+    if ( above_bounce_threshold( _curr, de, az ) ) return true ;
+    if ( has_eigenverb_listeners() ) return false ;
+    return ! above_intensity_threshold( _curr->attenuation(de,az) ) ;
+}
+
+/**
+ * Marks the live rays that have died on this step.
+ */
+void wave_queue::retire_rays() {
+    const size_t cols = num_az() ;
+    for ( size_t n=0 ; n < _live.size() ; ++n ) {
+        const size_t i = _live[n] ;
+        if ( ! _dead[i] && is_dead( i / cols, i % cols ) ) {
+            _dead[i] = true ;
+            ++_num_retiring ;
+        }
+    }
+    if ( _num_retiring > 0 && 8 * _num_retiring >= _live.size() ) {
+        compact_rays() ;
+    }
+}
+
+/**
+ * Rebuilds the lists of live and active rays.
+ */
+void wave_queue::compact_rays() {
+    const size_t rows = num_de() ;
+    const size_t cols = num_az() ;
+    const int halo = (int) active_halo ;
+
+    // mark the live rays, and the dead rays within active_halo of them,
+    // wrapping around in AZ if the first and last AZ are the same ray
+
+    const int period = (int) ( ( _az_boundary ) ? cols - 1 : cols ) ;
+    std::vector<bool> keep( rows * cols, false ) ;
+    _live.clear() ;
+    for ( size_t de=0 ; de < rows ; ++de ) {
+        for ( size_t az=0 ; az < cols ; ++az ) {
+            if ( _dead[de*cols+az] ) continue ;
+            _live.push_back( de * cols + az ) ;
+            const size_t d_first = ( de > active_halo ) ? de - active_halo : 0 ;
+            const size_t d_last = std::min( rows - 1, de + active_halo ) ;
+            for ( size_t d=d_first ; d <= d_last ; ++d ) {
+                for ( int k=-halo ; k <= halo ; ++k ) {
+                    int a = (int) az + k ;
+                    if ( _az_boundary ) {
+                        a = ( ( a % period ) + period ) % period ;
+                        if ( a == 0 ) keep[d*cols+cols-1] = true ;
+                    } else if ( a < 0 || a >= (int) cols ) {
+                        continue ;
+                    }
+                    keep[d*cols+a] = true ;
+                }
+            }
+        }
+    }
+    _active.clear() ;
+    for ( size_t n=0 ; n < keep.size() ; ++n ) {
+        if ( keep[n] ) _active.push_back( n ) ;
+    }
+    _num_retiring = 0 ;
+
+    // split the active rays into one workspace for each thread
+
+    for ( size_t n=0 ; n < _active_workspace.size() ; ++n ) {
+        delete _active_workspace[n] ;
+    }
+    _active_workspace.clear() ;
+    const size_t blocks = std::min( num_threads(), _active.size() ) ;
+    for ( size_t n=0 ; n < blocks ; ++n ) {
+        const size_t count = ( n + 1 ) * _active.size() / blocks
+                           - n * _active.size() / blocks ;
+        _active_workspace.push_back( new wave_front( _ocean, _frequencies,
+            count, 1, _targets, &_targets_sin_theta ) ) ;
+        _active_workspace.back()->cache_target_distance( _target_tree == NULL ) ;
+    }
+}
+
+/**
+ * Update the environmental parameters of a wavefront.
+ */
+void wave_queue::update( wave_front* wave ) {
+    if ( _use_symmetry ) {
+        wave->update_symmetric( *_symmetry_workspace, &_az_rotation[0] ) ;
+    } else if ( _use_active_set ) {
+        if ( _active_workspace.size() > 1 ) {
+            active_update_task task( wave, _active, _active_workspace ) ;
+            _partition->run( task ) ;
+        } else if ( ! _active_workspace.empty() ) {
+            wave->update( &_active[0], *_active_workspace[0] ) ;
+        }
+    } else if ( _partition ) {
+        update_task task( wave, _workspace ) ;
+        _partition->run( task ) ;
+    } else {
+        wave->update() ;
+    }
+}
+
+/**
+ * Estimate the next wavefront with the Adams-Bashforth algorithm.
+ */
+void wave_queue::integrate_next() {
+    const std::vector<size_t>* index = NULL ;
+    if ( _use_symmetry ) {
+        index = &_symmetry_index ;
+    } else if ( _use_active_set ) {
+        index = &_active ;
+    }
+
+    if ( _past_step == _prev_step && _prev_step == _time_step ) {
+        if ( index ) {
+            ode_integ::ab3_pos(  _time_step, _past, _prev, _curr, _next, *index ) ;
+            ode_integ::ab3_ndir( _time_step, _past, _prev, _curr, _next, *index ) ;
+        } else {
+            ode_integ::ab3_pos(  _time_step, _past, _prev, _curr, _next ) ;
+            ode_integ::ab3_ndir( _time_step, _past, _prev, _curr, _next ) ;
+        }
+    } else {
+        double weight[3] ;
+        ode_integ::ab3_weights( _time_step, _prev_step, _past_step, weight ) ;
+        if ( index ) {
+            ode_integ::ab3_pos(  weight, _past, _prev, _curr, _next, *index ) ;
+            ode_integ::ab3_ndir( weight, _past, _prev, _curr, _next, *index ) ;
+        } else {
+            ode_integ::ab3_pos(  weight, _past, _prev, _curr, _next ) ;
+            ode_integ::ab3_ndir( weight, _past, _prev, _curr, _next ) ;
+        }
+    }
+
+    wave_profiler::scoped_timer timer( wave_profiler::WAVE_UPDATE ) ;
+    update( _next ) ;
+}
+
+/**
+ * Largest local position error of the rays in the next wavefront.
+ */
+double wave_queue::step_error() const {
+    const std::vector<size_t>* index = NULL ;
+    if ( _use_symmetry ) {
+        index = &_symmetry_index ;
+    } else if ( _use_active_set ) {
+        index = &_active ;
+    }
+    const size_t count = ( index ) ? index->size() : num_de() * num_az() ;
+
+    // weights for the quadratic extrapolation of the derivatives
+
+    const double h = _time_step ;
+    const double a = _prev_step ;
+    const double b = _past_step ;
+    const double e2 = ( h + a ) * ( h + a + b ) / ( a * ( a + b ) ) ;
+    const double e1 = - h * ( h + a + b ) / ( a * b ) ;
+    const double e0 = h * ( h + a ) / ( b * ( a + b ) ) ;
+
+    const double* g0[3] = { _past->pos_gradient.rho_data(),
+        _past->pos_gradient.theta_data(), _past->pos_gradient.phi_data() } ;
+    const double* g1[3] = { _prev->pos_gradient.rho_data(),
+        _prev->pos_gradient.theta_data(), _prev->pos_gradient.phi_data() } ;
+    const double* g2[3] = { _curr->pos_gradient.rho_data(),
+        _curr->pos_gradient.theta_data(), _curr->pos_gradient.phi_data() } ;
+    const double* g3[3] = { _next->pos_gradient.rho_data(),
+        _next->pos_gradient.theta_data(), _next->pos_gradient.phi_data() } ;
+    const double* rho = _curr->position.rho_data() ;
+    const double* theta = _curr->position.theta_data() ;
+
+    double largest = 0.0 ;
+    for ( size_t n=0 ; n < count ; ++n ) {
+        const size_t i = ( index ) ? (*index)[n] : n ;
+        double diff[3] ;
+        for ( size_t k=0 ; k < 3 ; ++k ) {
+            diff[k] = g3[k][i] - ( e2 * g2[k][i] + e1 * g1[k][i] + e0 * g0[k][i] ) ;
+        }
+        const double r_theta = rho[i] * diff[1] ;
+        const double r_phi = rho[i] * sin( theta[i] ) * diff[2] ;
+        const double error2 = diff[0] * diff[0] + r_theta * r_theta
+                            + r_phi * r_phi ;
+        if ( error2 > largest ) largest = error2 ;
+    }
+    return 3.0 / 8.0 * h * sqrt( largest ) ;
+}
+
+/**
+ * Controls the adaptive time step.
+ */
+void wave_queue::use_adaptive_step( double tolerance,
+    double min_step, double max_step )
+{
+    _step_tolerance = max( 0.0, tolerance ) ;
+    _min_step = ( min_step > 0.0 ) ? min_step : 0.1 * _time_step ;
+    _max_step = ( max_step > 0.0 ) ? max_step : 10.0 * _time_step ;
+    _step_proposal = _time_step ;
+    _num_rejected = 0 ;
+}
+
+/**
+ * Controls the adaptive refinement of the D/E ray fan.
+ */
+void wave_queue::use_fan_refinement( double tolerance,
+    double min_spacing, size_t max_de )
+{
+    double smallest = 0.0 ;
+    for ( size_t de=0 ; de < _max_de ; ++de ) {
+        const double spacing = abs( _source_de->increment(de) ) ;
+        if ( de == 0 || spacing < smallest ) smallest = spacing ;
+    }
+    _fan_tolerance = max( 0.0, tolerance ) ;
+    _min_de_spacing = ( min_spacing > 0.0 ) ? min_spacing : smallest / 16.0 ;
+    _max_fan_de = max_de ;
+    _added_de.assign( num_de(), false ) ;
+    _num_splits = 0 ;
+    _num_merges = 0 ;
+}
+
 /**
  * Initialize wavefronts at the start of propagation using a
  * 3rd order Runge-Kutta algorithm.
@@ -154,10 +638,14 @@ void wave_queue::init_wavefronts() {
  * Marches to the next integration step in the acoustic propagation.
  */
 void wave_queue::step() {
+    wave_profiler::add_event( wave_profiler::WAVE_STEPS ) ;
 
     // search for caustics and boundary reflections
 
-    detect_reflections() ;
+    {
+        wave_profiler::scoped_timer timer( wave_profiler::DETECT_REFLECTIONS ) ;
+        detect_reflections() ;
+    }
 
     // rotate wavefront queue to the next step.
 
@@ -166,33 +654,257 @@ void wave_queue::step() {
     _prev = _curr ;
     _curr = _next ;
     _next = save ;
-    _time += _time_step ;
+    _past_step = _prev_step ;
+    _prev_step = _time_step ;
+    if ( _step_tolerance > 0.0 ) _time_step = _step_proposal ;
+    _time += _prev_step ;
 
     // compute position, direction, and environment parameters for next entry
 
-    ode_integ::ab3_pos(  _time_step, _past, _prev, _curr, _next ) ;
-    ode_integ::ab3_ndir( _time_step, _past, _prev, _curr, _next ) ;
+    integrate_next() ;
 
-    _next->update() ;
-    _next->path_length = _next->distance + _curr->path_length ;
+    // repeat the integration with a smaller time step if the
+    // error is too large, and then choose the size of the next step
 
-    _next->attenuation += _curr->attenuation ;
-    _next->phase += _curr->phase ;
-    _next->surface = _curr->surface ;
-    _next->bottom = _curr->bottom ;
-    _next->upper = _curr->upper ;
-    _next->lower = _curr->lower ;
-    _next->caustic = _curr->caustic ;
+    if ( _step_tolerance > 0.0 ) {
+        double error = step_error() ;
+        while ( error > _step_tolerance && _time_step > _min_step ) {
+            const double scale = 0.9 * pow( _step_tolerance / error, 0.25 ) ;
+            _time_step = max( _min_step, _time_step * max( 0.2, scale ) ) ;
+            ++_num_rejected ;
+            wave_profiler::add_event( wave_profiler::STEP_REJECTIONS ) ;
+            integrate_next() ;
+            error = step_error() ;
+        }
+        double scale = 2.0 ;
+        if ( error > 0.0 ) {
+            scale = max( 0.5, min( 2.0, 0.9 * pow( _step_tolerance / error, 0.25 ) ) ) ;
+        }
+        _step_proposal = max( _min_step, min( _max_step, _time_step * scale ) ) ;
+    }
+
+    if ( _use_active_set ) {
+        const size_t cols = num_az() ;
+        for ( size_t n=0 ; n < _active.size() ; ++n ) {
+            const size_t de = _active[n] / cols ;
+            const size_t az = _active[n] % cols ;
+            _next->path_length(de,az) = _next->distance(de,az)
+                                      + _curr->path_length(de,az) ;
+            _next->attenuation(de,az) += _curr->attenuation(de,az) ;
+            _next->phase(de,az) += _curr->phase(de,az) ;
+            _next->surface(de,az) = _curr->surface(de,az) ;
+            _next->bottom(de,az) = _curr->bottom(de,az) ;
+            _next->upper(de,az) = _curr->upper(de,az) ;
+            _next->lower(de,az) = _curr->lower(de,az) ;
+            _next->caustic(de,az) = _curr->caustic(de,az) ;
+        }
+    } else {
+        _next->path_length = _next->distance + _curr->path_length ;
+
+        _next->attenuation += _curr->attenuation ;
+        _next->phase += _curr->phase ;
+        _next->surface = _curr->surface ;
+        _next->bottom = _curr->bottom ;
+        _next->upper = _curr->upper ;
+        _next->lower = _curr->lower ;
+        _next->caustic = _curr->caustic ;
+    }
 
     // search for eigenray collisions with acoustic targets
 
-    detect_eigenrays() ;
+    {
+        wave_profiler::scoped_timer timer( wave_profiler::DETECT_EIGENRAYS ) ;
+        detect_eigenrays() ;
+    }
+
+    // retire rays that can no longer produce eigenrays or eigenverbs
+
+    if ( _use_active_set ) retire_rays() ;
+
+    // add rays where the fan diverges, and remove them where it converges
+
+    if ( _fan_tolerance > 0.0 ) refine_fan() ;
 
     // notify listeners that this step is complete
 
     check_eigenray_listeners( _time, runID() ) ;
 }
 
+/**
+ * Splits and merges D/E rows of the ray fan.
+ */
+void wave_queue::refine_fan() {
+    const size_t rows = num_de() ;
+    if ( _nc_file || _num_recorders || rows < 3 ) return ;
+
+    // measure the gaps between neighboring rows
+
+    std::vector<double> gap( rows - 1 ) ;
+    std::vector<bool> family( rows - 1 ) ;
+    for ( size_t de=0 ; de < rows - 1 ; ++de ) {
+        gap[de] = row_gap( de ) ;
+        family[de] = same_family( de ) ;
+    }
+
+    // split gaps that are wider than the tolerance, and gaps that
+    // will soon be, so that the fan is rebuilt less often
+
+    std::vector<bool> split( rows - 1, false ) ;
+    bool too_wide = false ;
+    for ( size_t de=0 ; de < rows - 1 ; ++de ) {
+        split[de] = family[de]
+            && 0.5 * abs( _source_de->increment(de) ) >= _min_de_spacing ;
+        too_wide = too_wide || ( split[de] && gap[de] > _fan_tolerance ) ;
+    }
+    size_t splits = 0 ;
+    for ( size_t de=0 ; de < rows - 1 ; ++de ) {
+        if ( ! too_wide || gap[de] <= 0.75 * _fan_tolerance
+          || ( _max_fan_de > 0 && rows + splits >= _max_fan_de ) )
+        {
+            split[de] = false ;
+        }
+        if ( split[de] ) ++splits ;
+    }
+
+    // merge added rows whose neighbors have converged,
+    // the rows of the original fan are never removed
+
+    std::vector<bool> merge( rows, false ) ;
+    size_t merges = 0 ;
+    for ( size_t de=1 ; de < rows - 1 ; ++de ) {
+        if ( ! _added_de[de] || merge[de-1] || split[de-1] || split[de] ) {
+            continue ;
+        }
+        if ( family[de-1] && family[de]
+          && gap[de-1] + gap[de] < 0.5 * _fan_tolerance )
+        {
+            merge[de] = true ;
+            ++merges ;
+        }
+    }
+    if ( splits == 0 && merges == 0 ) return ;
+
+    // list the new rows, and the existing rows used to create them
+
+    std::vector<double> angle ;
+    std::vector<size_t> row ;
+    std::vector<double> weight ;
+    std::vector<bool> added ;
+    angle.reserve( rows + splits ) ;
+    row.reserve( 4 * ( rows + splits ) ) ;
+    weight.reserve( 4 * ( rows + splits ) ) ;
+    for ( size_t de=0 ; de < rows ; ++de ) {
+        if ( merge[de] ) continue ;
+        angle.push_back( source_de(de) ) ;
+        added.push_back( _added_de[de] ) ;
+        row.insert( row.end(), 4, de ) ;
+        weight.push_back( 1.0 ) ;
+        weight.insert( weight.end(), 3, 0.0 ) ;
+        if ( de == rows - 1 || ! split[de] ) continue ;
+
+        // cubic Lagrange interpolation if all four rows are in the
+        // same ray family, linear interpolation otherwise
+
+        const double x = 0.5 * ( source_de(de) + source_de(de+1) ) ;
+        angle.push_back( x ) ;
+        added.push_back( true ) ;
+        if ( de > 0 && de + 2 < rows && family[de-1] && family[de+1] ) {
+            for ( size_t k=0 ; k < 4 ; ++k ) {
+                const size_t n = de + k - 1 ;
+                double w = 1.0 ;
+                for ( size_t j=0 ; j < 4 ; ++j ) {
+                    if ( j == k ) continue ;
+                    const double xj = source_de( de + j - 1 ) ;
+                    w *= ( x - xj ) / ( source_de(n) - xj ) ;
+                }
+                row.push_back( n ) ;
+                weight.push_back( w ) ;
+            }
+        } else {
+            row.push_back( de ) ;
+            row.push_back( de + 1 ) ;
+            row.insert( row.end(), 2, de ) ;
+            weight.push_back( 0.5 ) ;
+            weight.push_back( 0.5 ) ;
+            weight.insert( weight.end(), 2, 0.0 ) ;
+        }
+    }
+
+    resample_fan( angle, row, weight ) ;
+    _added_de.swap( added ) ;
+    _num_splits += splits ;
+    _num_merges += merges ;
+    wave_profiler::add_event( wave_profiler::RAY_SPLITS, splits ) ;
+    wave_profiler::add_event( wave_profiler::RAY_MERGES, merges ) ;
+}
+
+/**
+ * Largest distance between neighboring D/E rows.
+ */
+double wave_queue::row_gap( size_t de ) const {
+    const size_t cols = num_az() ;
+    double largest = 0.0 ;
+    for ( size_t az=0 ; az < cols ; ++az ) {
+        if ( _use_active_set && _dead[de*cols+az] && _dead[(de+1)*cols+az] ) {
+            continue ;
+        }
+        const wvector1 lower( _next->position, de, az ) ;
+        const wvector1 upper( _next->position, de+1, az ) ;
+        largest = max( largest, lower.distance2( upper ) ) ;
+    }
+    return sqrt( largest ) ;
+}
+
+/**
+ * True if neighboring D/E rows are in the same ray family.
+ */
+bool wave_queue::same_family( size_t de ) const {
+    for ( size_t az=0 ; az < num_az() ; ++az ) {
+        if ( _next->surface(de,az) != _next->surface(de+1,az)
+          || _next->bottom(de,az) != _next->bottom(de+1,az)
+          || _next->caustic(de,az) != _next->caustic(de+1,az) )
+        {
+            return false ;
+        }
+    }
+    return true ;
+}
+
+/**
+ * Replaces the ray fan with a new set of D/E rows.
+ */
+void wave_queue::resample_fan( const std::vector<double>& angle,
+    const std::vector<size_t>& row, const std::vector<double>& weight )
+{
+    const size_t rows = angle.size() ;
+    const bool cache = ( _target_tree == NULL ) ;
+    wave_front** queue[4] = { &_past, &_prev, &_curr, &_next } ;
+    for ( size_t n=0 ; n < 4 ; ++n ) {
+        wave_front* wave = new wave_front( _ocean, _frequencies, rows,
+            num_az(), _targets, &_targets_sin_theta ) ;
+        wave->cache_target_distance( cache ) ;
+        wave->resample( **queue[n], &row[0], &weight[0] ) ;
+        wave->find_edges() ;
+        delete *queue[n] ;
+        *queue[n] = wave ;
+    }
+
+    // rebuild everything that depends on the number of rows
+
+    const size_t threads = num_threads() ;
+    const bool active = _use_active_set ;
+    const bool symmetry = _use_symmetry ;
+    if ( active ) use_active_set( false ) ;
+    if ( symmetry ) use_azimuthal_symmetry( false ) ;
+    delete _source_de ;
+    _source_de = new seq_data( &angle[0], rows ) ;
+    _max_de = rows - 1 ;
+    num_threads( threads ) ;
+    if ( active ) use_active_set( true ) ;
+    if ( symmetry ) use_azimuthal_symmetry( true ) ;
+    make_spreading_model() ;
+}
+
 /**
  * Detect and process boundary reflections and caustics.
  */
@@ -201,14 +913,15 @@ void wave_queue::detect_reflections() {
     // process all surface and bottom reflections, and vertices
     // note that multiple rays can reflect in the same time step
 
-    for (size_t de = 0; de < num_de(); ++de) {
-        for (size_t az = 0; az < num_az(); ++az) {
-            detect_volume_scattering(de,az) ;
-            if ( !detect_reflections_surface(de,az) ) {
-                if( !detect_reflections_bottom(de,az) ) {
-                    detect_vertices(de,az) ;
-                    detect_caustics(de,az) ;
-                }
+    if ( _use_active_set ) {
+        const size_t cols = num_az() ;
+        for ( size_t n=0 ; n < _active.size() ; ++n ) {
+            detect_reflections( _active[n] / cols, _active[n] % cols ) ;
+        }
+    } else {
+        for (size_t de = 0; de < num_de(); ++de) {
+            for (size_t az = 0; az < num_az(); ++az) {
+                detect_reflections( de, az ) ;
             }
         }
     }
@@ -218,6 +931,19 @@ void wave_queue::detect_reflections() {
     _next->find_edges() ;
 }
 
+/**
+ * Detect and process reflections, vertices, and caustics for a single ray.
+ */
+void wave_queue::detect_reflections( size_t de, size_t az ) {
+    detect_volume_scattering(de,az) ;
+    if ( !detect_reflections_surface(de,az) ) {
+        if( !detect_reflections_bottom(de,az) ) {
+            detect_vertices(de,az) ;
+            detect_caustics(de,az) ;
+        }
+    }
+}
+
 /**
  * Detect and process reflection for a single (DE,AZ) combination.
  */
@@ -225,6 +951,7 @@ bool wave_queue::detect_reflections_surface( size_t de, size_t az ) {
     if (_next->position.altitude(de,az) > 0.0) {
         if (_reflection_model->surface_reflection(de,az)) {
             _next->surface(de,az) += 1;
+            wave_profiler::add_event( wave_profiler::SURFACE_REFLECTIONS ) ;
             _curr->surface(de,az) = _prev->surface(de,az)
                     = _past->surface(de,az) = _next->surface(de,az) ;
             detect_volume_scattering(de,az);
@@ -246,6 +973,7 @@ bool wave_queue::detect_reflections_bottom( size_t de, size_t az ) {
     if ( depth > 0.0 ) {
         if ( _reflection_model->bottom_reflection( de, az, depth ) ) {
             _next->bottom(de,az) += 1 ;
+            wave_profiler::add_event( wave_profiler::BOTTOM_REFLECTIONS ) ;
             _curr->bottom(de,az) = _prev->bottom(de,az)
                     = _past->bottom(de,az) = _next->bottom(de,az) ;
             detect_volume_scattering(de,az);
@@ -338,51 +1066,315 @@ void wave_queue::detect_volume_scattering(size_t de, size_t az) {
 void wave_queue::detect_eigenrays() {
     if ( _targets == NULL ) return ;
 
-    double distance2[3][3][3] ;
-    double& center = distance2[1][1][1] ;
-    double az_start = (_az_boundary) ? 0 : 1 ;
+    // search for closest point of approach to each target
+
+    std::vector<eigenray_candidate> found ;
+    if ( _partition ) {
+        eigenray_task task( *this, _partition->num_blocks() ) ;
+        _partition->run( task ) ;
+        for ( size_t n=0 ; n < task.found.size() ; ++n ) {
+            found.insert( found.end(), task.found[n].begin(), task.found[n].end() ) ;
+        }
+    } else {
+        find_eigenrays( 0, num_de(), &found ) ;
+    }
+    if ( _partition || _target_tree ) {
+        std::sort( found.begin(), found.end() ) ;
+    }
+
+    // build eigenrays in target, D/E, AZ order
+
+    for ( size_t n=0 ; n < found.size() ; ++n ) {
+        eigenray_candidate& cpa = found[n] ;
+        build_eigenray( cpa.t1, cpa.t2, cpa.de, cpa.az, cpa.distance2 ) ;
+    }
+}
+
+/**
+ * Search a block of D/E rows for closest point of approach to each target.
+ */
+void wave_queue::find_eigenrays( size_t first, size_t last,
+    std::vector<eigenray_candidate>* found ) const
+{
+    if ( _target_tree ) {
+        find_eigenrays_indexed( first, last, found ) ;
+        return ;
+    }
+    eigenray_candidate cpa ;
+    size_t az_start = (_az_boundary) ? 0 : 1 ;
+    first = std::max( first, (size_t) 1 ) ;
+    last = std::min( last, _max_de ) ;
+
+    // loop over live rays only, if dead rays have been retired
+
+    if ( _use_active_set ) {
+        const size_t cols = num_az() ;
+        std::vector<size_t>::const_iterator begin, end ;
+        live_range( first, last, &begin, &end ) ;
+        for ( size_t t1=0 ; t1 < _targets->size1() ; ++t1 ) {
+            for ( size_t t2=0 ; t2 < _targets->size2() ; ++t2 ) {
+                const bool de_branch = is_de_branch(t1,t2) ;
+                for ( std::vector<size_t>::const_iterator iter = begin ;
+                      iter != end ; ++iter )
+                {
+                    const size_t de = *iter / cols ;
+                    const size_t az = *iter % cols ;
+                    if ( az < az_start || az >= _max_az ) continue ;
+                    if ( is_cpa(t1,t2,de,az,de_branch,&cpa) ) {
+                        found->push_back( cpa ) ;
+                    }
+                }
+            }
+        }
+        return ;
+    }
 
     // loop over all targets
     for ( size_t t1=0 ; t1 < _targets->size1() ; ++t1 ) {
         for ( size_t t2=0 ; t2 < _targets->size2() ; ++t2 ) {
-            _de_branch = false ;
-            if ( abs(_source_pos.latitude() - _targets->latitude(t1,t2)) < 1e-4 &&
-                 abs(_source_pos.longitude() - _targets->longitude(t1,t2)) < 1e-4 ) {
-                _de_branch = true ;
-            }
+            const bool de_branch = is_de_branch(t1,t2) ;
 
             // Loop over all rays
-            for ( size_t de=1 ; de < _max_de ; ++de ) {
+            for ( size_t de=first ; de < last ; ++de ) {
                 for ( size_t az=az_start ; az < _max_az ; ++az ) {
+                    if ( is_cpa(t1,t2,de,az,de_branch,&cpa) ) {
+                        found->push_back( cpa ) ;
+                    }
+                }   // end az loop
+            }   // end de loop
+        }   // end t2 loop
+    }   // end t1 loop
+}
 
-                    // *******************************************
-                    // When central ray is at the edge of ray family
-                    // it prevents edges from acting as CPA, if so, go to next de/az
-                    // Also check to see if this ray is a duplicate.
+/**
+ * Search a block of D/E rows using the spatial index of targets.
+ */
+void wave_queue::find_eigenrays_indexed( size_t first, size_t last,
+    std::vector<eigenray_candidate>* found ) const
+{
+    size_t az_start = (_az_boundary) ? 0 : 1 ;
+    first = std::max( first, (size_t) 1 ) ;
+    last = std::min( last, _max_de ) ;
+    std::vector<size_t> nearby ;
+
+    // loop over live rays only, if dead rays have been retired
+
+    if ( _use_active_set ) {
+        const size_t cols = num_az() ;
+        std::vector<size_t>::const_iterator begin, end ;
+        live_range( first, last, &begin, &end ) ;
+        for ( std::vector<size_t>::const_iterator iter = begin ;
+              iter != end ; ++iter )
+        {
+            const size_t az = *iter % cols ;
+            if ( az < az_start || az >= _max_az ) continue ;
+            search_target_index( *iter / cols, az, nearby, found ) ;
+        }
+        return ;
+    }
 
-                    if ( _curr->on_edge(de,az) ) { continue; }
+    // Loop over all rays
+    for ( size_t de=first ; de < last ; ++de ) {
+        for ( size_t az=az_start ; az < _max_az ; ++az ) {
+            search_target_index( de, az, nearby, found ) ;
+        }   // end az loop
+    }   // end de loop
+}
 
-                    // get the central ray for testing
-                    center = _curr->distance2(t1,t2)(de,az) ;
+/**
+ * Search for closest points of approach at a single ray
+ * using the spatial index of targets.
+ */
+void wave_queue::search_target_index( size_t de, size_t az,
+    std::vector<size_t>& nearby, std::vector<eigenray_candidate>* found ) const
+{
+    if ( _curr->on_edge(de,az) ) return ;
+    eigenray_candidate cpa ;
+    const size_t num_targets = _targets->size1() * _targets->size2() ;
+    const size_t cols = _targets->size2() ;
+    double center[3] ;
+
+    // test every target if the cell can not be bounded,
+    // otherwise just the ones near this cell
+
+    const double radius = cpa_search_radius( de, az, center ) ;
+    if ( radius < 0.0 ) {
+        for ( size_t n=0 ; n < num_targets ; ++n ) {
+            const size_t t1 = n / cols ;
+            const size_t t2 = n % cols ;
+            if ( is_cpa(t1,t2,de,az,is_de_branch(t1,t2),&cpa) ) {
+                found->push_back( cpa ) ;
+            }
+        }
+        return ;
+    }
+    nearby.clear() ;
+    _target_tree->query( center, radius, &nearby ) ;
+    for ( size_t n=0 ; n < nearby.size() ; ++n ) {
+        const size_t t1 = nearby[n] / cols ;
+        const size_t t2 = nearby[n] % cols ;
+        if ( is_de_branch(t1,t2) ) continue ;
+        if ( is_cpa(t1,t2,de,az,false,&cpa) ) {
+            found->push_back( cpa ) ;
+        }
+    }
 
-                    distance2[2][1][1] = _next->distance2(t1,t2)(de,az) ;
-                    if ( distance2[2][1][1] <= center ) {
-                        continue;
-                    }
+    // targets above or below the source are always tested
 
-                    distance2[0][1][1] = _prev->distance2(t1,t2)(de,az) ;
-                    if ( distance2[0][1][1] < center ) {
-                        continue;
-                    }
+    for ( size_t n=0 ; n < _branch_targets.size() ; ++n ) {
+        const size_t t1 = _branch_targets[n] / cols ;
+        const size_t t2 = _branch_targets[n] % cols ;
+        if ( is_cpa(t1,t2,de,az,true,&cpa) ) {
+            found->push_back( cpa ) ;
+        }
+    }
+}
 
-                    // *******************************************
-                    if ( is_closest_ray(t1,t2,de,az,center,distance2) ) {
-                        build_eigenray(t1,t2,de,az,distance2) ;
-                    }
-                }   // end az loop
-            }   // end de loop
-        }   // end t2 loop
-    }   // end t1 loop
+/**
+ * Range of live rays inside of a block of D/E rows.
+ */
+void wave_queue::live_range( size_t first, size_t last,
+    std::vector<size_t>::const_iterator* begin,
+    std::vector<size_t>::const_iterator* end ) const
+{
+    const size_t cols = num_az() ;
+    *begin = std::lower_bound( _live.begin(), _live.end(), first * cols ) ;
+    *end = std::lower_bound( *begin, _live.end(), std::max( first, last ) * cols ) ;
+}
+
+/**
+ * Tests a single ray as the closest point of approach to a single target.
+ */
+bool wave_queue::is_cpa( size_t t1, size_t t2, size_t de, size_t az,
+    bool de_branch, eigenray_candidate* cpa ) const
+{
+    // *******************************************
+    // When central ray is at the edge of ray family
+    // it prevents edges from acting as CPA, if so, go to next de/az
+    // Also check to see if this ray is a duplicate.
+
+    if ( _curr->on_edge(de,az) ) { return false; }
+
+    // get the central ray for testing
+    double& center = cpa->distance2[1][1][1] ;
+    center = _curr->target_distance2(t1,t2,de,az) ;
+
+    cpa->distance2[2][1][1] = _next->target_distance2(t1,t2,de,az) ;
+    if ( cpa->distance2[2][1][1] <= center ) {
+        return false;
+    }
+
+    cpa->distance2[0][1][1] = _prev->target_distance2(t1,t2,de,az) ;
+    if ( cpa->distance2[0][1][1] < center ) {
+        return false;
+    }
+
+    // *******************************************
+    if ( is_closest_ray(t1,t2,de,az,center,cpa->distance2,de_branch) ) {
+        cpa->t1 = t1 ;
+        cpa->t2 = t2 ;
+        cpa->de = de ;
+        cpa->az = az ;
+        return true ;
+    }
+    return false ;
+}
+
+/**
+ * Size of the region where targets can have a closest point of
+ * approach at a specific ray.
+ */
+double wave_queue::cpa_search_radius(
+    size_t de, size_t az, double center[3] ) const
+{
+    // search all targets if is_closest_ray() skips any neighbor
+
+    for ( size_t nde=0 ; nde < 3 ; ++nde ) {
+        for ( size_t naz=0 ; naz < 3 ; ++naz ) {
+            if ( nde == 1 && naz == 1 ) continue ;
+            size_t d = de + nde - 1 ;
+            size_t a = az + naz - 1 ;
+            if ( _az_boundary ) {
+                if ( az + naz == 0 ) {	// aka if a < 0
+                    a = num_az() - 2 ;
+                } else if( a >= _max_az ) {
+                    a = 0 ;
+                }
+            }
+            if ( a == 0 && ! _az_boundary ) return -1.0 ;
+            if ( a == _max_az ) return -1.0 ;
+            if ( nde != 1 && _curr->on_edge(d,a) ) return -1.0 ;
+        }
+    }
+
+    // offsets to the six nearest neighbors, stored in pairs
+    // that are on opposite sides of the center
+
+    size_t az_prev = az - 1 ;
+    size_t az_next = az + 1 ;
+    if ( _az_boundary ) {
+        if ( az == 0 ) az_prev = num_az() - 2 ;
+        if ( az_next >= _max_az ) az_next = 0 ;
+    }
+    const wave_front* wave[6] = { _prev, _next, _curr, _curr, _curr, _curr } ;
+    const size_t row[6] = { de, de, de-1, de+1, de, de } ;
+    const size_t col[6] = { az, az, az, az, az_prev, az_next } ;
+
+    target_index::cartesian( _curr->position.rho(de,az),
+        _curr->position.theta(de,az), _curr->position.phi(de,az), center ) ;
+    double v[6][3] ;
+    double max_length2 = 0.0 ;
+    double min_length2 = 0.0 ;
+    for ( size_t n=0 ; n < 6 ; ++n ) {
+        const wposition& pos = wave[n]->position ;
+        target_index::cartesian( pos.rho(row[n],col[n]),
+            pos.theta(row[n],col[n]), pos.phi(row[n],col[n]), v[n] ) ;
+        double length2 = 0.0 ;
+        for ( size_t i=0 ; i < 3 ; ++i ) {
+            v[n][i] -= center[i] ;
+            length2 += v[n][i] * v[n][i] ;
+        }
+        max_length2 = std::max( max_length2, length2 ) ;
+        min_length2 = ( n == 0 ) ? length2 : std::min( min_length2, length2 ) ;
+    }
+    if ( min_length2 <= 0.0 ) return -1.0 ;
+
+    // distance from the center to each face of the octahedron,
+    // faces must all have the same orientation to enclose the center
+
+    double inner = 0.0 ;
+    int orientation = 0 ;
+    for ( size_t n=0 ; n < 8 ; ++n ) {
+        const double* a = v[ 0 + ( n & 1 ) ] ;
+        const double* b = v[ 2 + ( ( n >> 1 ) & 1 ) ] ;
+        const double* c = v[ 4 + ( ( n >> 2 ) & 1 ) ] ;
+        const int parity = ( ( n & 1 ) + ( ( n >> 1 ) & 1 ) + ( ( n >> 2 ) & 1 ) ) % 2 ;
+        double det = a[0] * ( b[1] * c[2] - b[2] * c[1] )
+                   + a[1] * ( b[2] * c[0] - b[0] * c[2] )
+                   + a[2] * ( b[0] * c[1] - b[1] * c[0] ) ;
+        if ( parity == 0 ) det = -det ;
+        const int sign = ( det > 0.0 ) ? 1 : ( det < 0.0 ) ? -1 : 0 ;
+        if ( sign == 0 ) return -1.0 ;
+        if ( orientation == 0 ) {
+            orientation = sign ;
+        } else if ( sign != orientation ) {
+            return -1.0 ;
+        }
+        double normal[3] ;
+        normal[0] = ( b[1] - a[1] ) * ( c[2] - a[2] ) - ( b[2] - a[2] ) * ( c[1] - a[1] ) ;
+        normal[1] = ( b[2] - a[2] ) * ( c[0] - a[0] ) - ( b[0] - a[0] ) * ( c[2] - a[2] ) ;
+        normal[2] = ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( b[1] - a[1] ) * ( c[0] - a[0] ) ;
+        const double h = abs(det) / sqrt( normal[0] * normal[0]
+            + normal[1] * normal[1] + normal[2] * normal[2] ) ;
+        inner = ( n == 0 ) ? h : std::min( inner, h ) ;
+    }
+
+    // reject distorted cells where the bound is much larger
+    // than the distance to the closest neighbor
+
+    const double radius = max_length2 / ( 2.0 * inner ) ;
+    if ( radius * radius > 256.0 * min_length2 ) return -1.0 ;
+    return 2.0 * radius ;
 }
 
 /**
@@ -393,8 +1385,9 @@ bool wave_queue::is_closest_ray(
    size_t t1, size_t t2,
    size_t de, size_t az,
    const double& center,
-   double distance2[3][3][3]
-) {
+   double distance2[3][3][3],
+   bool de_branch
+) const {
 	// test all neighbors that are not the central ray
 
 	for ( size_t nde=0 ; nde < 3 ; ++nde ) {
@@ -413,16 +1406,16 @@ bool wave_queue::is_closest_ray(
 				}
 			}
 
-			distance2[0][nde][naz] = _prev->distance2(t1,t2)(d,a) ;
-			distance2[1][nde][naz] = _curr->distance2(t1,t2)(d,a) ;
-			distance2[2][nde][naz] = _next->distance2(t1,t2)(d,a) ;
+			distance2[0][nde][naz] = _prev->target_distance2(t1,t2,d,a) ;
+			distance2[1][nde][naz] = _curr->target_distance2(t1,t2,d,a) ;
+			distance2[2][nde][naz] = _next->target_distance2(t1,t2,d,a) ;
 
 			// skip to next iteration if tested ray is on edge of ray family
 			// allows extrapolation outside of ray family
 
 			if ( a == 0 && ! _az_boundary ) continue;
 			if ( a == _max_az ) continue;
-			if ( _de_branch ) {
+			if ( de_branch ) {
 				if ( _curr->on_edge(d,a) ) continue ;
 			} else {
 				if ( nde != 1 ) {
@@ -433,7 +1426,7 @@ bool wave_queue::is_closest_ray(
 			// test to see if the center value is the smallest
 
 			if ( nde == 2 || naz == 2 ) {
-				if ( _de_branch ) {
+				if ( de_branch ) {
 					if ( az == 0 ) {
 						if ( distance2[1][nde][naz] < center ) return false ;
 					} else { return false ; }
@@ -460,6 +1453,7 @@ void wave_queue::build_eigenray(
    double distance2[3][3][3] )
 {
 	if ( above_bounce_threshold( _curr, de, az ) ) return ;
+    wave_profiler::scoped_timer timer( wave_profiler::BUILD_EIGENRAY ) ;
     #ifdef DEBUG_EIGENRAYS_DETAIL
         //cout << "*** wave_queue::step: time=" << time() << endl ;
         wposition1 tgt( *(_curr->targets), t1, t2 ) ;
@@ -525,6 +1519,7 @@ void wave_queue::build_eigenray(
         }
     }
 
+    uniform_stencil( de, distance2 ) ;
     compute_offsets(t1,t2,de,az,distance2,delta,offset,distance);
 
     // build basic eigenray products
@@ -543,9 +1538,12 @@ void wave_queue::build_eigenray(
 
     // compute spreading components of intensity
 
-    const vector<double> spread_intensity =
-        _spreading_model->intensity(
+    vector<double> spread_intensity ;
+    {
+        wave_profiler::scoped_timer spreading( wave_profiler::SPREADING ) ;
+        spread_intensity = _spreading_model->intensity(
             wposition1( *(_curr->targets), t1, t2 ), de, az, offset, distance );
+    }
     for ( size_t i = 0; i < ray.intensity.size(); ++i) {
         if ( isnan(spread_intensity(i)) ) {
             #ifdef USML_DEBUG
@@ -562,7 +1560,7 @@ void wave_queue::build_eigenray(
 
     // compute attenuation components of intensity
 
-    double dt = offset(0) / _time_step ;
+    double dt = offset(0) / stencil_step( offset(0) ) ;
     if ( dt >= 0.0 ) {
         ray.intensity = ray.intensity
             + _curr->attenuation(de,az) * ( 1.0 - dt )
@@ -611,6 +1609,7 @@ void wave_queue::build_eigenray(
     double center ;
     c_vector<double,3> gradient ;
     c_matrix<double,3,3> hessian ;
+    uniform_stencil( de, distance2 ) ;
     make_taylor_coeff( distance2, delta, center, gradient, hessian ) ;
     ray.target_de = center + inner_prod( gradient, offset )
                   + 0.5 * inner_prod( offset, prod( hessian, offset ) ) ;
@@ -645,6 +1644,7 @@ void wave_queue::build_eigenray(
 		}
 	}
 
+    uniform_stencil( de, distance2 ) ;
     make_taylor_coeff( distance2, delta, center, gradient, hessian ) ;
     ray.target_az = center + inner_prod( gradient, offset )
                   + 0.5 * inner_prod( offset, prod( hessian, offset ) ) ;
@@ -657,6 +1657,7 @@ void wave_queue::build_eigenray(
     #endif
     // Add eigenray to those objects which requested them
     notify_eigenray_listeners(t1,t2,ray,runID());
+    wave_profiler::add_event( wave_profiler::EIGENRAYS ) ;
 
 }
 
@@ -911,6 +1912,38 @@ void wave_queue::make_taylor_coeff(
     gradient(2) = ( value[1][1][2] - value[1][1][0] ) / d2 ;
 }
 
+/**
+ * Convert the previous wavefront values in a 3x3x3 stencil
+ * to equal time steps.
+ */
+void wave_queue::uniform_stencil( size_t de, double value[3][3][3] ) const {
+    if ( _prev_step != _time_step ) {
+        for ( size_t nde=0 ; nde < 3 ; ++nde ) {
+            for ( size_t naz=0 ; naz < 3 ; ++naz ) {
+                value[0][nde][naz] = uniform_prev( value[0][nde][naz],
+                    value[1][nde][naz], value[2][nde][naz] ) ;
+            }
+        }
+    }
+
+    // move the lower D/E angle to the spacing of the upper one,
+    // using the same quadratic as uniform_prev()
+
+    if ( _fan_tolerance <= 0.0 ) return ;
+    const double a = _source_de->increment(de-1) ;
+    const double b = _source_de->increment(de) ;
+    if ( a == b ) return ;
+    const double w0 = 2.0 * b * b / ( a * ( a + b ) ) ;
+    const double w1 = 2.0 * ( a - b ) / a ;
+    const double w2 = ( b - a ) / ( a + b ) ;
+    for ( size_t nt=0 ; nt < 3 ; ++nt ) {
+        for ( size_t naz=0 ; naz < 3 ; ++naz ) {
+            value[nt][0][naz] = w0 * value[nt][0][naz]
+                + w1 * value[nt][1][naz] + w2 * value[nt][2][naz] ;
+        }
+    }
+}
+
 /**
  * Compute the precise location and direction at the point of collision.
  */
@@ -923,14 +1956,32 @@ void wave_queue::collision_location(
     const double time2 = _time_step * _time_step ;
     const double dtime2 = time_water * time_water ;
 
+    // values on the previous wavefront, moved to -_time_step
+    // if the previous time step was different
+
+    const double prev_speed = uniform_prev( _prev->sound_speed(de,az),
+        _curr->sound_speed(de,az), _next->sound_speed(de,az) ) ;
+    const double prev_rho = uniform_prev( _prev->position.rho(de,az),
+        _curr->position.rho(de,az), _next->position.rho(de,az) ) ;
+    const double prev_theta = uniform_prev( _prev->position.theta(de,az),
+        _curr->position.theta(de,az), _next->position.theta(de,az) ) ;
+    const double prev_phi = uniform_prev( _prev->position.phi(de,az),
+        _curr->position.phi(de,az), _next->position.phi(de,az) ) ;
+    const double prev_ndir_rho = uniform_prev( _prev->ndirection.rho(de,az),
+        _curr->ndirection.rho(de,az), _next->ndirection.rho(de,az) ) ;
+    const double prev_ndir_theta = uniform_prev( _prev->ndirection.theta(de,az),
+        _curr->ndirection.theta(de,az), _next->ndirection.theta(de,az) ) ;
+    const double prev_ndir_phi = uniform_prev( _prev->ndirection.phi(de,az),
+        _curr->ndirection.phi(de,az), _next->ndirection.phi(de,az) ) ;
+
     // second order Taylor series for sound speed
 
     drho = ( _next->sound_speed(de,az)
-        - _prev->sound_speed(de,az) )
+        - prev_speed )
         / time1 ;
 
     d2rho = ( _next->sound_speed(de,az)
-        + _prev->sound_speed(de,az)
+        + prev_speed
         - 2.0 * _curr->sound_speed(de,az) )
         / time2 ;
 
@@ -940,25 +1991,25 @@ void wave_queue::collision_location(
     // second order Taylor series for position
 
     drho = ( _next->position.rho(de,az)
-        - _prev->position.rho(de,az) )
+        - prev_rho )
         / time1 ;
     dtheta = ( _next->position.theta(de,az)
-        - _prev->position.theta(de,az) )
+        - prev_theta )
         / time1 ;
     dphi = ( _next->position.phi(de,az)
-        - _prev->position.phi(de,az) )
+        - prev_phi )
         / time1 ;
 
     d2rho = ( _next->position.rho(de,az)
-        + _prev->position.rho(de,az)
+        + prev_rho
         - 2.0 * _curr->position.rho(de,az) )
         / time2 ;
     d2theta = ( _next->position.theta(de,az)
-        + _prev->position.theta(de,az)
+        + prev_theta
         - 2.0 * _curr->position.theta(de,az) )
         / time2 ;
     d2phi = ( _next->position.phi(de,az)
-        + _prev->position.phi(de,az)
+        + prev_phi
         - 2.0 * _curr->position.phi(de,az) )
         / time2 ;
 
@@ -972,25 +2023,25 @@ void wave_queue::collision_location(
     // second order Taylor series for ndirection
 
     drho = ( _next->ndirection.rho(de,az)
-        - _prev->ndirection.rho(de,az) )
+        - prev_ndir_rho )
         / time1 ;
     dtheta = ( _next->ndirection.theta(de,az)
-        - _prev->ndirection.theta(de,az) )
+        - prev_ndir_theta )
         / time1 ;
     dphi = ( _next->ndirection.phi(de,az)
-        - _prev->ndirection.phi(de,az) )
+        - prev_ndir_phi )
         / time1 ;
 
     d2rho = ( _next->ndirection.rho(de,az)
-        + _prev->ndirection.rho(de,az)
+        + prev_ndir_rho
         - 2.0 * _curr->ndirection.rho(de,az) )
         / time2 ;
     d2theta = ( _next->ndirection.theta(de,az)
-        + _prev->ndirection.theta(de,az)
+        + prev_ndir_theta
         - 2.0 * _curr->ndirection.theta(de,az) )
         / time2 ;
     d2phi = ( _next->ndirection.phi(de,az)
-        + _prev->ndirection.phi(de,az)
+        + prev_ndir_phi
         - 2.0 * _curr->ndirection.phi(de,az) )
         / time2 ;
 
@@ -1018,6 +2069,7 @@ void wave_queue::build_eigenverb(
 			|| (this->_az_boundary && az == this->_max_az)
 			|| abs(source_de(de)) > 89.9)
 		return;
+	wave_profiler::scoped_timer timer( wave_profiler::BUILD_EIGENVERB ) ;
 	#ifdef DEBUG_EIGENVERBS
 		cout << "wave_queue::build_eigenverb() " << endl ;
 	#endif
@@ -1102,4 +2154,5 @@ void wave_queue::build_eigenverb(
 			<< " caustic=" << verb.caustic << endl;
 	#endif
 	notify_eigenverb_listeners(verb, type) ;
+	wave_profiler::add_event( wave_profiler::EIGENVERBS ) ;
 }
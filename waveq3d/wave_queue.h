@@ -6,6 +6,8 @@
 
 #include <usml/ocean/ocean.h>
 #include <usml/waveq3d/wave_front.h>
+#include <usml/waveq3d/wave_partition.h>
+#include <usml/waveq3d/target_index.h>
 #include <usml/waveq3d/wave_thresholds.h>
 #include <usml/waveq3d/eigenray_notifier.h>
 #include <usml/eigenverb/eigenverb_notifier.h>
@@ -70,6 +72,7 @@ class USML_DECLSPEC wave_queue :
     friend class reflection_model ;
     friend class spreading_ray ;
     friend class spreading_hybrid_gaussian ;
+    friend class wavefront_recorder ;
 
   public:
 
@@ -171,7 +174,9 @@ class USML_DECLSPEC wave_queue :
     }
 
     /**
-     * Propagation step size (seconds).
+     * Propagation step size (seconds), from the current to the next
+     * element in the wavefront.  Changes from step to step if
+     * use_adaptive_step() is enabled.
      */
     inline double time_step() const {
         return _time_step ;
@@ -273,6 +278,284 @@ class USML_DECLSPEC wave_queue :
         return _run_id ;
     }
 
+    /**
+     * Number of threads used to process each propagation step.
+     * Defaults to one, which processes the whole ray fan in the calling
+     * thread. Larger values split the D/E rows of the fan into that many
+     * blocks. The environmental update of each new wavefront, and the
+     * search for eigenray closest point of approach, are then run on all
+     * blocks in parallel.  Reflections, caustics, and the construction
+     * of eigenrays and eigenverbs remain serial, and eigenrays are
+     * delivered to listeners in the same order as the serial case, so
+     * the results do not depend on the number of threads.
+     *
+     * The ocean profile and attenuation models must be safe to call
+     * from multiple threads when this is greater than one.  The grid and
+     * analytic profiles in the ocean package meet this requirement.
+     *
+     * @param   num     Number of threads (limited to the number of D/E rows).
+     */
+    void num_threads( size_t num ) ;
+
+    /**
+     * Number of threads used to process each propagation step.
+     */
+    inline size_t num_threads() const {
+        return ( _partition ) ? _partition->num_blocks() : 1 ;
+    }
+
+    /**
+     * Controls the use of a spatial index in the eigenray search.
+     * By default, the distance from every target to every point on the
+     * wavefront is computed and stored on each time step, and every
+     * ray is tested as a closest point of approach (CPA) to every target.
+     * This cost grows as the product of the number of targets and rays.
+     *
+     * When the index is used, target distances are no longer stored.
+     * Instead, the targets are stored in an R-tree, and for each ray,
+     * the search is limited to targets near the cell formed by that ray
+     * and its neighbors in time, D/E, and AZ.  A target can only be
+     * a CPA for a ray if it is closer to that ray than to any of those
+     * neighbors, which bounds the region that needs to be searched.
+     * Rays next to the edges of a ray family, where eigenrays are
+     * extrapolated beyond the edge, and cells that are too distorted to
+     * be bounded reliably, still test every target. Targets directly
+     * above or below the source are also tested for every ray. The
+     * eigenrays produced are identical to the exhaustive search.
+     *
+     * @param   enable  Use the spatial index if true.
+     */
+    void use_target_index( bool enable ) ;
+
+    /**
+     * True if the eigenray search uses a spatial index of the targets.
+     */
+    inline bool use_target_index() const {
+        return _target_tree != NULL ;
+    }
+
+    /**
+     * Controls the retirement of rays that can no longer contribute
+     * to the results.  By default, every ray in the fan is integrated,
+     * updated, and searched for eigenrays on every step, even after it
+     * has exceeded max_bottom(), max_surface(), or the other bounce
+     * thresholds.  When this is enabled, these rays are marked as dead.
+     * If there are no eigenverb listeners, rays whose attenuation alone
+     * is weaker than the intensity_threshold() are also marked as dead.
+     * Because bounce counts and attenuation never decrease, a dead ray
+     * can never produce another eigenray or eigenverb.
+     *
+     * Dead rays still act as neighbors in the edge, caustic, and closest
+     * point of approach stencils of the live rays around them. So they
+     * are only retired when there are no live rays within active_halo
+     * rays in the D/E or AZ direction. Retired rays keep the values they
+     * had on the step that they were retired.  The list of rays being
+     * integrated is compacted each time the number of newly dead rays
+     * grows to one eighth of the live rays. The Adams-Bashforth
+     * integration, the environmental update, reflection processing,
+     * and the eigenray search then iterate over only the compacted list.
+     *
+     * The spreading_hybrid_gaussian model can sum the contributions of
+     * rays that are farther than active_halo from the target, so
+     * its results can differ slightly from those without retirement.
+     * The spreading_ray model gives the same results.  Should be
+     * enabled before the first call to step().
+     *
+     * @param   enable  Retire dead rays if true.
+     */
+    void use_active_set( bool enable ) ;
+
+    /**
+     * True if rays that can no longer contribute to the results
+     * are being retired.
+     */
+    inline bool use_active_set() const {
+        return _use_active_set ;
+    }
+
+    /**
+     * Number of rays integrated on each step.  Equal to the number
+     * of rays in the fan unless use_active_set() is enabled.
+     */
+    inline size_t num_active() const {
+        return ( _use_active_set ) ? _active.size() : num_de() * num_az() ;
+    }
+
+    /**
+     * Number of rays that have not yet been marked as dead.
+     * Equal to the number of rays in the fan unless use_active_set()
+     * is enabled. Updated each time the active rays are compacted.
+     */
+    inline size_t num_live() const {
+        return ( _use_active_set ) ? _live.size() : num_de() * num_az() ;
+    }
+
+    /**
+     * Number of rays around each live ray, in the D/E and AZ directions,
+     * that are integrated even when they are dead.  Three rays are
+     * needed so that wave_front::find_edges() can mark the edges of
+     * the neighbors used by the closest point of approach search.
+     */
+    static const size_t active_halo = 3 ;
+
+    /**
+     * Controls the azimuthally symmetric fast path.  In an ocean whose
+     * sound speed, attenuation, and boundaries only depend on depth,
+     * every AZ column of the ray fan is a rotation of the first column
+     * around the vertical axis through the source.  When this is enabled,
+     * only the first AZ column is integrated and run through the
+     * ocean profile on each step.  The other columns are then rotated
+     * copies of the first column, see wave_front::update_symmetric().
+     * Reflections, caustics, and the eigenray and eigenverb searches
+     * still run on the whole fan, so eigenrays are found for targets
+     * at every azimuth.
+     *
+     * The caller is responsible for checking that the ocean really is
+     * range independent, for example with is_range_independent().
+     * The results are wrong if it is not.  Turns off use_active_set(),
+     * because the rotated columns must all stay in lock step.
+     * Should be enabled before the first call to step().
+     *
+     * @param   enable  Only integrate the first AZ column if true.
+     */
+    void use_azimuthal_symmetry( bool enable ) ;
+
+    /**
+     * True if only the first AZ column is integrated on each step.
+     */
+    inline bool use_azimuthal_symmetry() const {
+        return _use_symmetry ;
+    }
+
+    /**
+     * True if the sound speed profile and boundaries of an ocean
+     * only depend on depth.  Recognizes the profile_linear, profile_munk,
+     * profile_n2, profile_catenary, and one dimensional profile_grid
+     * profiles; boundary_flat surfaces and bottoms; and volume_flat
+     * layers. Any other model, including models hidden behind a
+     * profile_lock or boundary_lock, is assumed to be range dependent.
+     * This check can not see reflection loss models whose values vary
+     * with position, like reflect_loss_netcdf, on a flat boundary.
+     *
+     * @param   ocean   Ocean to be tested.
+     * @return          True if use_azimuthal_symmetry() can be used.
+     */
+    static bool is_range_independent( ocean_model& ocean ) ;
+
+    /**
+     * Controls the adaptive time step.  By default, the wavefront marches
+     * with the fixed time step given to the constructor, which must be
+     * small enough for the strongest gradients and the boundary
+     * interactions in the whole run.  When this is enabled, the third
+     * order Adams-Bashforth integration uses weights for unequal
+     * time steps, and the step is adjusted after each integration.
+     *
+     * The local position error of each ray is estimated, in meters, from
+     * the difference between the derivative at the new wavefront and
+     * the derivative extrapolated from the previous three wavefronts.
+     * If the largest error exceeds the tolerance, the step is repeated
+     * with a smaller time step.  Otherwise, the next step grows or shrinks,
+     * by at most a factor of two, so that its error should be near
+     * the tolerance.  The time step is kept within [min_step,max_step].
+     *
+     * Reflections, caustics, eigenrays, and eigenverbs interpolate
+     * between the previous, current, and next wavefronts with the
+     * actual times of those wavefronts.  The results are identical
+     * to those of a fixed time step while the step is unchanged.
+     * Should be enabled before the first call to step().
+     *
+     * @param   tolerance   Largest position error allowed in each step
+     *                      (meters). Zero disables the adaptive time step.
+     * @param   min_step    Smallest time step (seconds). Defaults
+     *                      to one tenth of the initial time step.
+     * @param   max_step    Largest time step (seconds). Defaults
+     *                      to ten times the initial time step.
+     */
+    void use_adaptive_step( double tolerance, double min_step = 0.0,
+                            double max_step = 0.0 ) ;
+
+    /**
+     * Largest position error allowed in each step (meters),
+     * zero if the time step is fixed.
+     */
+    inline double step_tolerance() const {
+        return _step_tolerance ;
+    }
+
+    /**
+     * Number of steps that were repeated with a smaller time step
+     * since the adaptive time step was enabled.
+     */
+    inline size_t num_rejected() const {
+        return _num_rejected ;
+    }
+
+    /**
+     * Controls the adaptive refinement of the D/E ray fan.  By default,
+     * the ray fan keeps the D/E angles given to the constructor, which
+     * must be dense enough for the most divergent part of the fan at
+     * the longest range of interest.  When this is enabled, the fan is
+     * checked at the end of each step.  Wherever the rays in neighboring
+     * D/E rows are further apart than the tolerance, at any AZ, a new row
+     * is launched half way between them.  Gaps wider than three quarters
+     * of the tolerance are split at the same time, so that the fan is
+     * rebuilt less often.  Rows that were added this way are removed
+     * again when the wavefront converges, and the gaps on either side
+     * of them add up to less than half of the tolerance.  The rows of
+     * the original fan are never removed.
+     *
+     * The past, previous, current, and next wavefronts of a new row are
+     * interpolated from its neighbors in D/E, using cubic Lagrange
+     * interpolation in the launch angle when the four nearest rows
+     * belong to the same ray family, and linear interpolation otherwise.
+     * Rows are only split or merged when all of the rows involved have
+     * the same number of surface reflections, bottom reflections, and
+     * caustics at every AZ, so new rays never straddle a fold in the
+     * wavefront.  Because the new rays start from interpolated states,
+     * they are only as accurate as that interpolation. The eigenray
+     * search may report a duplicate eigenray in the step right after
+     * a change to the fan.
+     *
+     * AZ angles are not refined.  The fan is not refined while the
+     * wavefront is being recorded to a netCDF file, by init_netcdf()
+     * or by a wavefront_recorder, because that file has a fixed number
+     * of D/E angles. Should be enabled before the first call to step().
+     *
+     * @param   tolerance   Largest distance allowed between neighboring
+     *                      D/E rows (meters). Zero disables refinement.
+     * @param   min_spacing Smallest D/E angle between neighboring rows
+     *                      (degrees).  Defaults to one sixteenth of the
+     *                      smallest spacing in the original fan.
+     * @param   max_de      Largest number of D/E angles in the fan.
+     *                      Defaults to no limit.
+     */
+    void use_fan_refinement( double tolerance, double min_spacing = 0.0,
+                             size_t max_de = 0 ) ;
+
+    /**
+     * Largest distance allowed between neighboring D/E rows (meters),
+     * zero if the ray fan is not refined.
+     */
+    inline double fan_tolerance() const {
+        return _fan_tolerance ;
+    }
+
+    /**
+     * Number of D/E rows added to the ray fan since
+     * refinement was enabled.
+     */
+    inline size_t num_splits() const {
+        return _num_splits ;
+    }
+
+    /**
+     * Number of D/E rows removed from the ray fan since
+     * refinement was enabled.
+     */
+    inline size_t num_merges() const {
+        return _num_merges ;
+    }
+
     /**
      * Marches to the next integration step in the acoustic propagation.
      * Uses the third order Adams-Bashforth algorithm to estimate the position
@@ -337,16 +620,37 @@ class USML_DECLSPEC wave_queue :
     /**
      * Maximum index for source_de
      */
-    const size_t _max_de ;
+    size_t _max_de ;
 
     /**
      * Maximum index for source_az
      */
     const size_t _max_az ;
 
-    /** Propagation step size (seconds). */
+    /** Propagation step size from _curr to _next (seconds). */
     double _time_step ;
 
+    /** Propagation step size from _prev to _curr (seconds). */
+    double _prev_step ;
+
+    /** Propagation step size from _past to _prev (seconds). */
+    double _past_step ;
+
+    /** Largest position error allowed in each step, zero if fixed (meters). */
+    double _step_tolerance ;
+
+    /** Smallest adaptive time step (seconds). */
+    double _min_step ;
+
+    /** Largest adaptive time step (seconds). */
+    double _max_step ;
+
+    /** Time step to be used for the next call to step() (seconds). */
+    double _step_proposal ;
+
+    /** Number of steps repeated with a smaller time step. */
+    size_t _num_rejected ;
+
     /** Time for current entry in the wave_front circular queue (seconds). */
     double _time ;
 
@@ -376,6 +680,12 @@ class USML_DECLSPEC wave_queue :
      */
     spreading_model* _spreading_model ;
 
+    /** Type of spreading model requested by the constructor. */
+    spreading_type _spreading_type ;
+
+    /** Speed of sound at the source, at the start of propagation. */
+    double _source_speed ;
+
     /**
      * Circular queue of wavefront elements needed by the
      * third order Adams-Bashforth algorithm.
@@ -396,10 +706,211 @@ class USML_DECLSPEC wave_queue :
     bool _az_boundary ;
 
     /**
-     * Treat all targets that are slightly away from directly above the
-     * source as special cases.
+     * Splits the ray fan into blocks of D/E rows that are processed
+     * in parallel. NULL if the ray fan is processed in a single thread.
      */
-    bool _de_branch ;
+    wave_partition* _partition ;
+
+    /**
+     * Workspace wavefronts used to update each block of the partition.
+     * Empty if the ray fan is processed in a single thread.
+     */
+    std::vector<wave_front*> _workspace ;
+
+    /**
+     * Spatial index of target locations used by the eigenray search.
+     * NULL if every ray is tested against every target.
+     */
+    target_index* _target_tree ;
+
+    /**
+     * Row major index of targets that are directly above or below the
+     * source.  These targets are always tested against every ray when
+     * the spatial index is used.
+     */
+    std::vector<size_t> _branch_targets ;
+
+    /**
+     * True if rays that can no longer contribute to the results
+     * are being retired.
+     */
+    bool _use_active_set ;
+
+    /**
+     * Row major index (de*num_az()+az) of the rays integrated on each
+     * step. Includes live rays and the dead rays within active_halo
+     * of them. Only used if _use_active_set is true.
+     */
+    std::vector<size_t> _active ;
+
+    /**
+     * Row major index of the rays that were not dead at the last
+     * compaction. Used to limit the eigenray search. Only used if
+     * _use_active_set is true.
+     */
+    std::vector<size_t> _live ;
+
+    /**
+     * True for each ray, in row major order, that can no longer
+     * produce eigenrays or eigenverbs.
+     */
+    std::vector<bool> _dead ;
+
+    /** Number of rays marked as dead since the last compaction. */
+    size_t _num_retiring ;
+
+    /**
+     * Workspace wavefronts used to update the active rays, one for each
+     * block of the partition.  Each workspace has a single AZ column.
+     */
+    std::vector<wave_front*> _active_workspace ;
+
+    /** True if only the first AZ column is integrated on each step. */
+    bool _use_symmetry ;
+
+    /**
+     * Row major 3x3 rotation matrix, in earth centered Cartesian
+     * coordinates, that rotates the first AZ column into each of
+     * the other columns.  Only used if _use_symmetry is true.
+     */
+    std::vector<double> _az_rotation ;
+
+    /**
+     * Row major index of the rays in the first AZ column.
+     * Only used if _use_symmetry is true.
+     */
+    std::vector<size_t> _symmetry_index ;
+
+    /**
+     * Workspace wavefront used to update the first AZ column.
+     * Only used if _use_symmetry is true.
+     */
+    wave_front* _symmetry_workspace ;
+
+    /** Largest distance allowed between neighboring D/E rows (meters). */
+    double _fan_tolerance ;
+
+    /** Smallest D/E angle between neighboring rows (degrees). */
+    double _min_de_spacing ;
+
+    /**
+     * True for each D/E row that was added by the fan refinement.
+     * Only these rows can be merged again.
+     */
+    std::vector<bool> _added_de ;
+
+    /** Largest number of D/E angles in the fan, zero if no limit. */
+    size_t _max_fan_de ;
+
+    /** Number of D/E rows added to the ray fan. */
+    size_t _num_splits ;
+
+    /** Number of D/E rows removed from the ray fan. */
+    size_t _num_merges ;
+
+    /**
+     * Closest point of approach found by the eigenray search, but not
+     * yet turned into an eigenray.  Allows the search to be run in
+     * parallel while eigenrays are built in the same order as a
+     * serial search.
+     */
+    struct eigenray_candidate {
+        size_t t1, t2, de, az ;
+        double distance2[3][3][3] ;
+
+        /** Sort in target, D/E, AZ order. */
+        bool operator<( const eigenray_candidate& other ) const {
+            if ( t1 != other.t1 ) return t1 < other.t1 ;
+            if ( t2 != other.t2 ) return t2 < other.t2 ;
+            if ( de != other.de ) return de < other.de ;
+            return az < other.az ;
+        }
+    };
+
+    /** Applies wave_front::update() to one block of the partition. */
+    class update_task ;
+    friend class update_task ;
+
+    /** Applies find_eigenrays() to one block of the partition. */
+    class eigenray_task ;
+    friend class eigenray_task ;
+
+    /** Applies wave_front::update() to one block of the active rays. */
+    class active_update_task ;
+    friend class active_update_task ;
+
+    /**
+     * Update the environmental parameters of a wavefront, using all
+     * of the blocks in the partition if one exists.
+     *
+     * @param   wave    Wavefront to update.
+     */
+    void update( wave_front* wave ) ;
+
+    /**
+     * Uses the third order Adams-Bashforth algorithm to estimate the
+     * position and direction of the next wavefront, and then updates
+     * its environmental parameters.  Uses the weights for unequal time
+     * steps if _past_step, _prev_step, and _time_step are not all equal.
+     */
+    void integrate_next() ;
+
+    /**
+     * Largest local position error (meters) of the rays in the next
+     * wavefront. Compares the derivative at the next wavefront to
+     * the quadratic extrapolation of the derivatives at the previous
+     * three wavefronts. For equal time steps, the local error of the
+     * third order Adams-Bashforth algorithm is 3/8 of the time step
+     * times this difference.
+     */
+    double step_error() const ;
+
+    /**
+     * Value at time -_time_step of the quadratic through the values on
+     * the previous, current, and next wavefronts. Used to turn the
+     * three wavefronts into a stencil with equal time steps, after
+     * the adaptive time step has changed. Returns the previous
+     * value unchanged if _prev_step equals _time_step.
+     *
+     * @param   prev        Value on the previous wavefront.
+     * @param   curr        Value on the current wavefront.
+     * @param   next        Value on the next wavefront.
+     * @return              Value at time -_time_step.
+     */
+    inline double uniform_prev( double prev, double curr, double next ) const {
+        if ( _prev_step == _time_step ) return prev ;
+        const double a = _prev_step ;
+        const double b = _time_step ;
+        return ( 2.0 * b * b / ( a * ( a + b ) ) ) * prev
+             + ( 2.0 * ( a - b ) / a ) * curr
+             + ( ( b - a ) / ( a + b ) ) * next ;
+    }
+
+    /**
+     * Applies uniform_prev() to the previous wavefront values in
+     * a 3x3x3 stencil of time, D/E, and AZ.  When use_fan_refinement()
+     * is enabled, and the D/E angle below the center of the stencil has
+     * a different spacing than the one above it, the values for the
+     * lower D/E angle are also moved to the spacing of the upper one.
+     * Fans that are not refined keep the original D/E stencil, even if
+     * their spacing is not uniform.
+     *
+     * @param   de          D/E index at the center of the stencil.
+     * @param   value       Stencil to be modified in place.
+     */
+    void uniform_stencil( size_t de, double value[3][3][3] ) const ;
+
+    /**
+     * Time between the current wavefront and the neighboring
+     * wavefront on the same side as a time offset.
+     *
+     * @param   offset      Time offset from the current wavefront.
+     * @return              _prev_step if the offset is negative,
+     *                      _time_step otherwise.
+     */
+    inline double stencil_step( double offset ) const {
+        return ( offset < 0.0 ) ? _prev_step : _time_step ;
+    }
 
     /**
      * Initialize wavefronts at the start of propagation using a
@@ -418,6 +929,77 @@ class USML_DECLSPEC wave_queue :
      */
     void init_wavefronts() ;
 
+    /**
+     * Creates the spreading model for the current ray fan, replacing
+     * any existing model.  Leaves the model NULL if the fan has
+     * fewer than three D/E or AZ angles.
+     */
+    void make_spreading_model() ;
+
+    //**************************************************
+    // ray fan refinement
+
+    /**
+     * Splits the D/E rows of the ray fan where they diverge, and merges
+     * rows that were added by an earlier split where they converge.
+     * Called at the end of each step if use_fan_refinement() is enabled.
+     */
+    void refine_fan() ;
+
+    /**
+     * Largest distance between the next wavefront of a D/E row and
+     * the row above it, over all AZ angles.  Ignores rays that have
+     * been retired by use_active_set().
+     *
+     * @param   de          Index of the lower D/E row.
+     * @return              Largest distance (meters).
+     */
+    double row_gap( size_t de ) const ;
+
+    /**
+     * True if a D/E row and the row above it have the same number of
+     * surface reflections, bottom reflections, and caustics at every AZ.
+     *
+     * @param   de          Index of the lower D/E row.
+     */
+    bool same_family( size_t de ) const ;
+
+    /**
+     * Replaces the ray fan with a new set of D/E rows, and rebuilds
+     * the workspaces and models that depend on the number of rows.
+     *
+     * @param   angle       D/E angle of each new row (degrees).
+     * @param   row         Four existing rows for each new row.
+     * @param   weight      Interpolation weight of each existing row.
+     */
+    void resample_fan( const std::vector<double>& angle,
+                       const std::vector<size_t>& row,
+                       const std::vector<double>& weight ) ;
+
+    //**************************************************
+    // active set of rays
+
+    /**
+     * True if a ray on the current wavefront can no longer produce
+     * eigenrays or eigenverbs.  See use_active_set() for details.
+     *
+     * @param   de          D/E angle index number.
+     * @param   az          AZ angle index number.
+     */
+    bool is_dead( size_t de, size_t az ) ;
+
+    /**
+     * Marks the live rays that have died on this step, and compacts
+     * the active rays when enough of them have died.
+     */
+    void retire_rays() ;
+
+    /**
+     * Rebuilds the lists of live and active rays from the dead flags,
+     * and resizes the workspaces used to update the active rays.
+     */
+    void compact_rays() ;
+
     //**************************************************
     // reflections and caustics
 
@@ -440,6 +1022,15 @@ class USML_DECLSPEC wave_queue :
      */
     void detect_reflections() ;
 
+    /**
+     * Detect and process boundary reflections, vertices, and caustics
+     * for a single (DE,AZ) combination.  Used by detect_reflections().
+     *
+     * @param   de          D/E angle index number.
+     * @param   az          AZ angle index number.
+     */
+    void detect_reflections( size_t de, size_t az ) ;
+
     /**
      * Detect and process surface reflection for a single (DE,AZ) combination.
      * The attenuation and phase of reflection loss are added to the
@@ -505,6 +1096,123 @@ class USML_DECLSPEC wave_queue :
      */
     void detect_eigenrays() ;
 
+    /**
+     * Search a block of D/E rows for rays that are the closest point of
+     * approach to each target.  Only reads wavefront data, so
+     * non-overlapping blocks can be searched at the same time.
+     *
+     * @param   first       First D/E row to search.
+     * @param   last        One past the last D/E row to search.
+     * @param   found       Closest points of approach, in target, D/E,
+     *                      AZ order, are added to this list (output).
+     */
+    void find_eigenrays( size_t first, size_t last,
+        std::vector<eigenray_candidate>* found ) const ;
+
+    /**
+     * Version of find_eigenrays() that uses the spatial index
+     * of targets to limit the number of targets tested for each ray.
+     * Closest points of approach are added to the list in D/E, AZ order.
+     *
+     * @param   first       First D/E row to search.
+     * @param   last        One past the last D/E row to search.
+     * @param   found       Closest points of approach are added
+     *                      to this list (output).
+     */
+    void find_eigenrays_indexed( size_t first, size_t last,
+        std::vector<eigenray_candidate>* found ) const ;
+
+    /**
+     * Uses the spatial index of targets to search for closest points
+     * of approach at a single ray.  Used by find_eigenrays_indexed().
+     *
+     * @param   de          D/E angle index number.
+     * @param   az          AZ angle index number.
+     * @param   nearby      Workspace for the results of the index query.
+     * @param   found       Closest points of approach are added
+     *                      to this list (output).
+     */
+    void search_target_index( size_t de, size_t az,
+        std::vector<size_t>& nearby,
+        std::vector<eigenray_candidate>* found ) const ;
+
+    /**
+     * Range of live rays, from the _live list, that are inside of a block
+     * of D/E rows, and can be searched for eigenrays.
+     *
+     * @param   first       First D/E row to search.
+     * @param   last        One past the last D/E row to search.
+     * @param   begin       First entry in _live (output).
+     * @param   end         One past the last entry in _live (output).
+     */
+    void live_range( size_t first, size_t last,
+        std::vector<size_t>::const_iterator* begin,
+        std::vector<size_t>::const_iterator* end ) const ;
+
+    /**
+     * Tests a single ray as the closest point of approach to a single
+     * target.  Skips rays on the edge of a ray family, and rays that are
+     * not a local minimum in time, before calling is_closest_ray().
+     *
+     * @param   t1          Row number of the current target.
+     * @param   t2          Column number of the current target.
+     * @param   de          D/E angle index number.
+     * @param   az          AZ angle index number.
+     * @param   de_branch   Treat targets that are slightly away from directly
+     *                      above the source as special cases.
+     * @param   cpa         Target, ray, and distances to the 27
+     *                      neighboring points if this is a CPA (output).
+     * @return  True if central point is closest point of approach.
+     */
+    bool is_cpa( size_t t1, size_t t2, size_t de, size_t az,
+        bool de_branch, eigenray_candidate* cpa ) const ;
+
+    /**
+     * True if a target is directly above or below the source.
+     * These targets use the special D/E branch point logic
+     * in is_closest_ray().
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     */
+    inline bool is_de_branch( size_t t1, size_t t2 ) const {
+        return abs(_source_pos.latitude() - _targets->latitude(t1,t2)) < 1e-4
+            && abs(_source_pos.longitude() - _targets->longitude(t1,t2)) < 1e-4 ;
+    }
+
+    /**
+     * Used by find_eigenrays_indexed() to find the size of the region
+     * where targets can have a closest point of approach at a specific
+     * ray. A target can only be a CPA if it is no farther from the center
+     * than from each of the six nearest neighbors: the same ray on the
+     * previous and next wavefronts, and the adjacent D/E and AZ rays on
+     * the current wavefront.  This is the intersection of six half spaces.
+     *
+     * Writing those neighbors as offsets v from the center, each
+     * half space is the set of offsets w for which 2 w.v <= v.v.  The
+     * intersection is bounded if the origin is inside of the octahedron
+     * formed by the six offsets, and it fits inside of a sphere whose
+     * radius is max(v.v) / (2 h), where h is the smallest distance from
+     * the origin to a face of that octahedron.
+     *
+     * The result is doubled to cover the difference between these
+     * straight line distances and the approximation used in
+     * wave_front::target_distance2().  A negative result indicates
+     * that the search should include all targets. This happens
+     * when any of the neighbors in the 3x3 D/E and AZ block is skipped by
+     * is_closest_ray(), because the region extends to infinity where
+     * eigenrays are extrapolated beyond the edge of a ray family.
+     * It also happens when the cell is too distorted for the bound
+     * to be reliable.
+     *
+     * @param   de          D/E angle index number.
+     * @param   az          AZ angle index number.
+     * @param   center      Earth centered cartesian coordinates of the
+     *                      ray on the current wavefront (output).
+     * @return              Search radius around center (meters).
+     */
+    double cpa_search_radius( size_t de, size_t az, double center[3] ) const ;
+
     /**
      * Used by detect_eigenrays() to discover if the current ray is the
      * closest point of approach (CPA) to the current target. Computes the
@@ -533,13 +1241,16 @@ class USML_DECLSPEC wave_queue :
      * @param   distance2   Distance squared to each of the 27 neighboring
      *                      points. The first index is time, the second is D/E
      *                      and the third is AZ (output).
+     * @param   de_branch   Treat targets that are slightly away from directly
+     *                      above the source as special cases.
      * @return  True if central point is closest point of approach.
      */
     bool is_closest_ray(
         size_t t1, size_t t2,
         size_t de, size_t az,
         const double &center,
-        double distance2[3][3][3] ) ;
+        double distance2[3][3][3],
+        bool de_branch ) const ;
 
     /**
      * Used by detect_eigenrays() to compute eigneray parameters and
@@ -789,6 +1500,12 @@ class USML_DECLSPEC wave_queue :
      */
     NcFile* _nc_file ;
 
+    /**
+     * Number of open wavefront_recorder objects attached to
+     * this wavefront.  The ray fan is not refined while non-zero.
+     */
+    size_t _num_recorders ;
+
     /** The netCDF variables used to record the wavefront log. */
     NcVar *_nc_time, *_nc_latitude, *_nc_longitude, *_nc_altitude,
           *_nc_surface, *_nc_bottom, *_nc_caustic, *_nc_upper,
@@ -0,0 +1,291 @@
+/**
+ * @file wavefront_recorder.cc
+ * Records wavefronts to a netCDF log on a background thread.
+ */
+#include <usml/waveq3d/wavefront_recorder.h>
+#include <netcdf.h>
+#include <stdexcept>
+
+using namespace usml::waveq3d ;
+
+namespace {
+
+/**
+ * Stores each record of a variable in its own chunk,
+ * and turns on shuffle and deflate compression.
+ */
+void compress( NcFile* file, NcVar* var, size_t num_de, size_t num_az,
+               int level )
+{
+    const size_t chunks[3] = { 1, num_de, num_az } ;
+    nc_def_var_chunking( file->id(), var->id(), NC_CHUNKED, chunks ) ;
+    nc_def_var_deflate( file->id(), var->id(), 1, 1, level ) ;
+}
+
+/**
+ * Copies the selected launch angles from a wavefront matrix.
+ */
+template<class T, class U> void select( const matrix<T>& source,
+    const std::vector<size_t>& de_index, const std::vector<size_t>& az_index,
+    std::vector<U>* dest )
+{
+    dest->resize( de_index.size() * az_index.size() ) ;
+    typename std::vector<U>::iterator iter = dest->begin() ;
+    for ( size_t d=0 ; d < de_index.size() ; ++d ) {
+        for ( size_t a=0 ; a < az_index.size() ; ++a ) {
+            *iter++ = (U) source( de_index[d], az_index[a] ) ;
+        }
+    }
+}
+
+/**
+ * Builds a launch angle index, or checks the one supplied by the caller.
+ */
+void build_index( const std::vector<size_t>* index, size_t size,
+    std::vector<size_t>* result )
+{
+    if ( index && ! index->empty() ) {
+        *result = *index ;
+        for ( size_t n=0 ; n < result->size() ; ++n ) {
+            if ( (*result)[n] >= size ) {
+                throw std::invalid_argument(
+                    "wavefront_recorder launch angle index out of range" ) ;
+            }
+        }
+    } else {
+        result->resize( size ) ;
+        for ( size_t n=0 ; n < size ; ++n ) {
+            (*result)[n] = n ;
+        }
+    }
+}
+
+}	// end of anonymous namespace
+
+/**
+ * Opens the log file and starts the writer thread.
+ */
+wavefront_recorder::wavefront_recorder( wave_queue& wave,
+    const char* filename, const char* long_name, size_t decimation,
+    const std::vector<size_t>* de_index, const std::vector<size_t>* az_index,
+    int deflate_level )
+    : _wave( wave ), _decimation( max( decimation, (size_t) 1 ) ), _count(0),
+      _nc_rec(0), _fill_index(0), _write_index(0), _closing(false)
+{
+    _full[0] = _full[1] = false ;
+    build_index( de_index, wave.num_de(), &_de_index ) ;
+    build_index( az_index, wave.num_az(), &_az_index ) ;
+
+    NcError err( NcError::verbose_nonfatal ) ;
+    _nc_file = new NcFile( filename, NcFile::Replace, NULL, 0,
+        ( deflate_level > 0 ) ? NcFile::Netcdf4 : NcFile::Classic ) ;
+    if ( ! _nc_file->is_valid() ) {
+        delete _nc_file ;
+        _nc_file = NULL ;
+        throw std::invalid_argument( "can not create wavefront log" ) ;
+    }
+    if ( long_name ) {
+        _nc_file->add_att("long_name", long_name ) ;
+    }
+    _nc_file->add_att("Conventions", "COARDS" ) ;
+
+    // dimensions
+
+    const seq_vector& frequencies = *wave.frequencies() ;
+    NcDim *freq_dim = _nc_file->add_dim( "frequency", (long) frequencies.size() ) ;
+    NcDim *de_dim   = _nc_file->add_dim( "source_de", (long) _de_index.size() ) ;
+    NcDim *az_dim   = _nc_file->add_dim( "source_az", (long) _az_index.size() ) ;
+    NcDim *time_dim = _nc_file->add_dim( "travel_time" ) ; // unlimited
+
+    // coordinates
+
+    NcVar *freq_var = _nc_file->add_var( "frequency", ncDouble, freq_dim ) ;
+    NcVar *de_var   = _nc_file->add_var( "source_de", ncDouble, de_dim ) ;
+    NcVar *az_var   = _nc_file->add_var( "source_az", ncDouble, az_dim ) ;
+    _nc_time        = _nc_file->add_var( "travel_time", ncDouble, time_dim ) ;
+    _nc_latitude    = _nc_file->add_var( "latitude", ncDouble,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_longitude   = _nc_file->add_var( "longitude", ncDouble,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_altitude    = _nc_file->add_var( "altitude", ncDouble,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_surface     = _nc_file->add_var( "surface", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_bottom      = _nc_file->add_var( "bottom", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_caustic     = _nc_file->add_var( "caustic", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_upper       = _nc_file->add_var( "upper_vertex", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_lower       = _nc_file->add_var( "lower_vertex", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_on_edge     = _nc_file->add_var( "on_edge", ncByte,
+                      time_dim, de_dim, az_dim ) ;
+
+    if ( deflate_level > 0 ) {
+        NcVar* vars[] = { _nc_latitude, _nc_longitude, _nc_altitude,
+            _nc_surface, _nc_bottom, _nc_caustic, _nc_upper, _nc_lower,
+            _nc_on_edge } ;
+        for ( size_t n=0 ; n < sizeof(vars)/sizeof(NcVar*) ; ++n ) {
+            compress( _nc_file, vars[n], _de_index.size(), _az_index.size(),
+                min( deflate_level, 9 ) ) ;
+        }
+    }
+
+    // units
+
+    freq_var->add_att("units", "hertz") ;
+    de_var->add_att("units", "degrees") ;
+    de_var->add_att("positive", "up") ;
+    az_var->add_att("units", "degrees_true") ;
+    az_var->add_att("positive", "clockwise") ;
+    _nc_time->add_att("units", "seconds") ;
+    _nc_latitude->add_att("units", "degrees_north") ;
+    _nc_longitude->add_att("units", "degrees_east") ;
+    _nc_altitude->add_att("units", "meters") ;
+    _nc_altitude->add_att("positive", "up") ;
+    _nc_surface->add_att("units", "count") ;
+    _nc_bottom->add_att("units", "count") ;
+    _nc_caustic->add_att("units", "count") ;
+    _nc_upper->add_att("units", "count") ;
+    _nc_lower->add_att("units", "count") ;
+    _nc_on_edge->add_att("units", "bool") ;
+
+    // coordinate data
+
+    std::vector<double> values ;
+    values.assign( frequencies.data().begin(), frequencies.data().end() ) ;
+    freq_var->put( &values[0], (long) values.size() ) ;
+    values.resize( _de_index.size() ) ;
+    for ( size_t n=0 ; n < _de_index.size() ; ++n ) {
+        values[n] = wave.source_de( _de_index[n] ) ;
+    }
+    de_var->put( &values[0], (long) values.size() ) ;
+    values.resize( _az_index.size() ) ;
+    for ( size_t n=0 ; n < _az_index.size() ; ++n ) {
+        values[n] = wave.source_az( _az_index[n] ) ;
+    }
+    az_var->put( &values[0], (long) values.size() ) ;
+
+    // the file is only used by the writer thread from now on,
+    // and the number of D/E angles must not change until it is closed
+
+    _writer = boost::thread( &wavefront_recorder::run, this ) ;
+    ++_wave._num_recorders ;
+}
+
+/**
+ * Writes any remaining snapshots and closes the file.
+ */
+wavefront_recorder::~wavefront_recorder() {
+    close() ;
+}
+
+/**
+ * Snapshot the current wavefront for recording.
+ */
+void wavefront_recorder::record() {
+    if ( _closing || ( _count++ % _decimation ) != 0 ) return ;
+
+    // wait for the writer thread to release the next buffer
+
+    {
+        boost::unique_lock<boost::mutex> guard( _mutex ) ;
+        while ( _full[_fill_index] ) {
+            _changed.wait( guard ) ;
+        }
+    }
+
+    // copy the wavefront without holding the lock,
+    // the writer thread does not use buffers that are not full
+
+    snapshot& data = _buffer[_fill_index] ;
+    const wave_front* curr = _wave.curr() ;
+    data.time = _wave.time() ;
+    select( curr->position.rho(), _de_index, _az_index, &data.rho ) ;
+    select( curr->position.theta(), _de_index, _az_index, &data.theta ) ;
+    select( curr->position.phi(), _de_index, _az_index, &data.phi ) ;
+    select( curr->surface, _de_index, _az_index, &data.surface ) ;
+    select( curr->bottom, _de_index, _az_index, &data.bottom ) ;
+    select( curr->caustic, _de_index, _az_index, &data.caustic ) ;
+    select( curr->upper, _de_index, _az_index, &data.upper ) ;
+    select( curr->lower, _de_index, _az_index, &data.lower ) ;
+    select( curr->on_edge, _de_index, _az_index, &data.on_edge ) ;
+
+    // hand it off to the writer thread
+
+    {
+        boost::lock_guard<boost::mutex> guard( _mutex ) ;
+        _full[_fill_index] = true ;
+        _fill_index = 1 - _fill_index ;
+    }
+    _changed.notify_all() ;
+}
+
+/**
+ * Writes any remaining snapshots, and closes the file.
+ */
+void wavefront_recorder::close() {
+    if ( _nc_file == NULL ) return ;
+    {
+        boost::lock_guard<boost::mutex> guard( _mutex ) ;
+        _closing = true ;
+    }
+    _changed.notify_all() ;
+    _writer.join() ;
+    delete _nc_file ; // destructor frees all netCDF temp variables
+    _nc_file = NULL ;
+    --_wave._num_recorders ;
+}
+
+/**
+ * Writer thread main loop.  Exits after the last
+ * full buffer has been written, once close() is called.
+ */
+void wavefront_recorder::run() {
+    while ( true ) {
+        {
+            boost::unique_lock<boost::mutex> guard( _mutex ) ;
+            while ( ! _full[_write_index] && ! _closing ) {
+                _changed.wait( guard ) ;
+            }
+            if ( ! _full[_write_index] ) return ;
+        }
+        write( _buffer[_write_index] ) ;
+        {
+            boost::lock_guard<boost::mutex> guard( _mutex ) ;
+            _full[_write_index] = false ;
+            _write_index = 1 - _write_index ;
+            ++_nc_rec ;
+        }
+        _changed.notify_all() ;
+    }
+}
+
+/**
+ * Writes a snapshot to the next record in the file.
+ */
+void wavefront_recorder::write( const snapshot& data ) {
+    NcError err( NcError::verbose_nonfatal ) ;
+    const size_t N = data.rho.size() ;
+    std::vector<double> values( N ) ;
+    for ( size_t n=0 ; n < N ; ++n ) {
+        values[n] = to_latitude( data.theta[n] ) ;
+    }
+    _nc_latitude->put_rec( &values[0], _nc_rec ) ;
+    for ( size_t n=0 ; n < N ; ++n ) {
+        values[n] = to_degrees( data.phi[n] ) ;
+    }
+    _nc_longitude->put_rec( &values[0], _nc_rec ) ;
+    for ( size_t n=0 ; n < N ; ++n ) {
+        values[n] = data.rho[n] - wposition::earth_radius ;
+    }
+    _nc_altitude->put_rec( &values[0], _nc_rec ) ;
+    _nc_time->put_rec( &data.time, _nc_rec ) ;
+    _nc_surface->put_rec( &data.surface[0], _nc_rec ) ;
+    _nc_bottom->put_rec( &data.bottom[0], _nc_rec ) ;
+    _nc_caustic->put_rec( &data.caustic[0], _nc_rec ) ;
+    _nc_upper->put_rec( &data.upper[0], _nc_rec ) ;
+    _nc_lower->put_rec( &data.lower[0], _nc_rec ) ;
+    _nc_on_edge->put_rec( &data.on_edge[0], _nc_rec ) ;
+}
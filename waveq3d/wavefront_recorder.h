@@ -0,0 +1,182 @@
+/**
+ * @file wavefront_recorder.h
+ * Records wavefronts to a netCDF log on a background thread.
+ */
+#pragma once
+
+#include <usml/waveq3d/wave_queue.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <vector>
+
+namespace usml {
+namespace waveq3d {
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Records wavefronts to a netCDF log on a background thread.  Replaces
+ * the wave_queue::init_netcdf(), wave_queue::save_netcdf(), and
+ * wave_queue::close_netcdf() routines when logging would otherwise slow
+ * down the propagation, such as when making movies of the wavefront.
+ * The file has the same structure as the wave_queue::init_netcdf() log.
+ *
+ * The record() method copies the current wavefront into one of two
+ * snapshot buffers, and returns to the propagation loop without waiting
+ * for the disk.  A writer thread converts each snapshot into geodetic
+ * coordinates and writes it to the file.  If the writer falls two
+ * snapshots behind, record() waits for one of the buffers to become free,
+ * which limits memory use no matter how long the propagation runs.
+ *
+ * The size of the log can be reduced by only recording one out of every
+ * N calls to record(), and by only recording a subset of the launch angles.
+ * If a deflate level is given, the file is written in netCDF-4 format,
+ * with one chunk per record for each variable, and with shuffle and
+ * deflate compression.  Otherwise, it is written in the netCDF classic
+ * format, like wave_queue::init_netcdf().
+ *
+ * The netCDF library is not thread safe.  Other netCDF files should not
+ * be read or written while a recorder is open.
+ *
+ * <pre>
+ *      wave_queue wave( ocean, freq, pos, de, az, time_step ) ;
+ *      wavefront_recorder recorder( wave, ncname ) ;
+ *      recorder.record() ;
+ *      while ( wave.time() < time_max ) {
+ *          wave.step() ;
+ *          recorder.record() ;
+ *      }
+ *      recorder.close() ;
+ * </pre>
+ */
+class USML_DECLSPEC wavefront_recorder {
+
+public:
+
+    /**
+     * Opens the log file and starts the writer thread.
+     *
+     * @param   wave        Wavefront to record.  Must outlive the recorder.
+     *                      Its ray fan is not refined until the
+     *                      recorder is closed.
+     * @param   filename    Name of the file to write to disk.
+     * @param   long_name   Optional global attribute for identifying data-set.
+     * @param   decimation  Record every Nth call to record().
+     *                      Records every call if this is less than two.
+     * @param   de_index    Indices of the D/E launch angles to record.
+     *                      Records all D/E angles if NULL or empty.
+     * @param   az_index    Indices of the AZ launch angles to record.
+     *                      Records all AZ angles if NULL or empty.
+     * @param   deflate_level   Compression level from 1 to 9 for netCDF-4
+     *                      output.  Uses netCDF classic output if zero.
+     * @throws  std::invalid_argument if the file can not be created,
+     *                      or a launch angle index is out of range.
+     */
+    wavefront_recorder( wave_queue& wave, const char* filename,
+        const char* long_name = NULL, size_t decimation = 1,
+        const std::vector<size_t>* de_index = NULL,
+        const std::vector<size_t>* az_index = NULL,
+        int deflate_level = 0 ) ;
+
+    /**
+     * Writes any remaining snapshots and closes the file.
+     */
+    virtual ~wavefront_recorder() ;
+
+    /**
+     * Snapshot the current wavefront for recording.  Skipped for calls
+     * that are removed by the decimation factor.  Only blocks if the
+     * writer thread is still busy with both snapshot buffers.
+     */
+    void record() ;
+
+    /**
+     * Writes any remaining snapshots, stops the writer thread,
+     * and closes the file.  Does nothing if already closed.
+     */
+    void close() ;
+
+    /**
+     * Number of records written to the file so far.
+     */
+    size_t num_records() const {
+        boost::lock_guard<boost::mutex> guard( _mutex ) ;
+        return (size_t) _nc_rec ;
+    }
+
+private:
+
+    /**
+     * Copy of the wavefront data that is needed to build a record.
+     * Positions are stored in spherical earth coordinates, and converted
+     * to geodetic coordinates by the writer thread.
+     */
+    struct snapshot {
+        double time ;
+        std::vector<double> rho, theta, phi ;
+        std::vector<int> surface, bottom, caustic, upper, lower ;
+        std::vector<ncbyte> on_edge ;
+    } ;
+
+    /** Writer thread main loop. */
+    void run() ;
+
+    /** Writes a snapshot to the next record in the file. */
+    void write( const snapshot& data ) ;
+
+    /** Wavefront to record. */
+    wave_queue& _wave ;
+
+    /** Record every Nth call to record(). */
+    const size_t _decimation ;
+
+    /** Number of calls to record() so far. */
+    size_t _count ;
+
+    /** Indices of the D/E launch angles to record. */
+    std::vector<size_t> _de_index ;
+
+    /** Indices of the AZ launch angles to record. */
+    std::vector<size_t> _az_index ;
+
+    /** The netCDF file used to record the wavefront log. */
+    NcFile* _nc_file ;
+
+    /** The netCDF variables used to record the wavefront log. */
+    NcVar *_nc_time, *_nc_latitude, *_nc_longitude, *_nc_altitude,
+          *_nc_surface, *_nc_bottom, *_nc_caustic, *_nc_upper,
+          *_nc_lower, *_nc_on_edge ;
+
+    /** Current record number in netCDF file. */
+    long _nc_rec ;
+
+    /** Snapshot buffers shared by record() and the writer thread. */
+    snapshot _buffer[2] ;
+
+    /** True if a buffer is waiting to be written. */
+    bool _full[2] ;
+
+    /** Next buffer to be filled by record(). */
+    size_t _fill_index ;
+
+    /** Next buffer to be written by the writer thread. */
+    size_t _write_index ;
+
+    /** Set to true when close() asks the writer thread to stop. */
+    bool _closing ;
+
+    /** Locks the buffer flags and the record number. */
+    mutable boost::mutex _mutex ;
+
+    /** Signals changes in the buffer flags. */
+    boost::condition_variable _changed ;
+
+    /** Thread that writes snapshots to the file. */
+    boost::thread _writer ;
+} ;
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
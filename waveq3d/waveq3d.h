@@ -89,6 +89,8 @@
 #pragma once
 
 #include <usml/waveq3d/wave_queue.h>
+#include <usml/waveq3d/wavefront_recorder.h>
+#include <usml/waveq3d/wave_profiler.h>
 #include <usml/waveq3d/wave_front.h>
 #include <usml/waveq3d/eigenray.h>
 #include <usml/waveq3d/eigenray_collection.h>